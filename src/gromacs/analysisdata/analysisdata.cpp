@@ -51,6 +51,7 @@
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/mutex.h"
 
 namespace gmx
 {
@@ -107,6 +108,14 @@ public:
      * to these objects.
      */
     HandleList handles_;
+    /*! \brief
+     * Serializes starting and finishing frames from different handles.
+     *
+     * Needed when multiple handles are used concurrently from different
+     * threads, since these calls update the storage and can notify the
+     * attached modules.
+     */
+    Mutex frameMutex_;
 };
 
 /********************************************************************
@@ -218,6 +227,7 @@ void AnalysisDataHandle::startFrame(int index, real x, real dx)
     GMX_RELEASE_ASSERT(impl_ != nullptr, "Invalid data handle used");
     GMX_RELEASE_ASSERT(impl_->currentFrame_ == nullptr,
                        "startFrame() called twice without calling finishFrame()");
+    lock_guard<Mutex> lock(impl_->data_.impl_->frameMutex_);
     impl_->currentFrame_ = &impl_->data_.impl_->storage_.startFrame(index, x, dx);
 }
 
@@ -279,6 +289,7 @@ void AnalysisDataHandle::finishFrame()
                        "finishFrame() called without calling startFrame()");
     AnalysisDataStorageFrame* frame = impl_->currentFrame_;
     impl_->currentFrame_            = nullptr;
+    lock_guard<Mutex>         lock(impl_->data_.impl_->frameMutex_);
     frame->finishFrame();
 }
 
@@ -71,8 +71,10 @@ class AnalysisDataParallelOptions;
  * When used through the trajectory analysis framework, calls to startData(),
  * finishFrameSerial(), and finishData() are handled by the framework.
  *
- * \todo
- * Parallel implementation is not complete.
+ * Different handles can be used concurrently from different threads to
+ * provide different frames.  Starting and finishing frames is serialized
+ * internally, while the values within a frame are set without locking.
+ * All other methods must be called serially.
  *
  * \if internal
  * Special note for MPI implementation: assuming that the initialization of
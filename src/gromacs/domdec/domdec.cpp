@@ -269,70 +269,101 @@ void dd_get_constraint_range(const gmx_domdec_t* dd, int* at_start, int* at_end)
     *at_end   = dd->comm->atomRanges.end(DDAtomRanges::Type::Constraints);
 }
 
-void dd_move_x(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
+/*! \brief Packs the coordinates to send in a pulse along DD dimension index \p d into \p sendBuffer */
+static void packHaloCoordinates(const gmx_domdec_t&            dd,
+                                int                            d,
+                                const gmx_domdec_ind_t&        ind,
+                                const matrix                   box,
+                                gmx::ArrayRef<const gmx::RVec> x,
+                                gmx::ArrayRef<gmx::RVec>       sendBuffer)
 {
-    wallcycle_start(wcycle, ewcMOVEX);
-
-    int                    nzone, nat_tot;
-    gmx_domdec_comm_t*     comm;
-    gmx_domdec_comm_dim_t* cd;
-    rvec                   shift = { 0, 0, 0 };
-    gmx_bool               bPBC, bScrew;
-
-    comm = dd->comm;
+    const bool bPBC   = (dd.ci[dd.dim[d]] == 0);
+    const bool bScrew = (bPBC && dd.unitCellInfo.haveScrewPBC && dd.dim[d] == XX);
+    rvec       shift  = { 0, 0, 0 };
+    if (bPBC)
+    {
+        copy_rvec(box[dd.dim[d]], shift);
+    }
 
-    nzone   = 1;
-    nat_tot = comm->atomRanges.numHomeAtoms();
-    for (int d = 0; d < dd->ndim; d++)
+    int n = 0;
+    if (!bPBC)
     {
-        bPBC   = (dd->ci[dd->dim[d]] == 0);
-        bScrew = (bPBC && dd->unitCellInfo.haveScrewPBC && dd->dim[d] == XX);
-        if (bPBC)
+        for (int j : ind.index)
         {
-            copy_rvec(box[dd->dim[d]], shift);
+            sendBuffer[n] = x[j];
+            n++;
         }
-        cd = &comm->cd[d];
-        for (const gmx_domdec_ind_t& ind : cd->ind)
+    }
+    else if (!bScrew)
+    {
+        for (int j : ind.index)
         {
-            DDBufferAccess<gmx::RVec> sendBufferAccess(comm->rvecBuffer, ind.nsend[nzone + 1]);
-            gmx::ArrayRef<gmx::RVec>& sendBuffer = sendBufferAccess.buffer;
-            int                       n          = 0;
-            if (!bPBC)
+            /* We need to shift the coordinates */
+            for (int d = 0; d < DIM; d++)
             {
-                for (int j : ind.index)
-                {
-                    sendBuffer[n] = x[j];
-                    n++;
-                }
+                sendBuffer[n][d] = x[j][d] + shift[d];
             }
-            else if (!bScrew)
+            n++;
+        }
+    }
+    else
+    {
+        for (int j : ind.index)
+        {
+            /* Shift x */
+            sendBuffer[n][XX] = x[j][XX] + shift[XX];
+            /* Rotate y and z.
+             * This operation requires a special shift force
+             * treatment, which is performed in calc_vir.
+             */
+            sendBuffer[n][YY] = box[YY][YY] - x[j][YY];
+            sendBuffer[n][ZZ] = box[ZZ][ZZ] - x[j][ZZ];
+            n++;
+        }
+    }
+}
+
+/*! \brief Copies coordinates received out of place in a pulse into \p x */
+static void unpackHaloCoordinates(const gmx_domdec_ind_t&        ind,
+                                  int                            nzone,
+                                  gmx::ArrayRef<const gmx::RVec> receiveBuffer,
+                                  gmx::ArrayRef<gmx::RVec>       x)
+{
+    int j = 0;
+    for (int zone = 0; zone < nzone; zone++)
+    {
+        for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
+        {
+            x[i] = receiveBuffer[j++];
+        }
+    }
+}
+
+/*! \brief Communicates the coordinates of all pulses, except the first when \p skipFirstPulse is true */
+static void moveHaloCoordinates(gmx_domdec_t*            dd,
+                                const matrix             box,
+                                gmx::ArrayRef<gmx::RVec> x,
+                                bool                     skipFirstPulse)
+{
+    gmx_domdec_comm_t* comm = dd->comm;
+
+    int nzone   = 1;
+    int nat_tot = comm->atomRanges.numHomeAtoms();
+    for (int d = 0; d < dd->ndim; d++)
+    {
+        gmx_domdec_comm_dim_t* cd = &comm->cd[d];
+        for (const gmx_domdec_ind_t& ind : cd->ind)
+        {
+            if (skipFirstPulse && d == 0 && &ind == &cd->ind[0])
             {
-                for (int j : ind.index)
-                {
-                    /* We need to shift the coordinates */
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        sendBuffer[n][d] = x[j][d] + shift[d];
-                    }
-                    n++;
-                }
-            }
-            else
-            {
-                for (int j : ind.index)
-                {
-                    /* Shift x */
-                    sendBuffer[n][XX] = x[j][XX] + shift[XX];
-                    /* Rotate y and z.
-                     * This operation requires a special shift force
-                     * treatment, which is performed in calc_vir.
-                     */
-                    sendBuffer[n][YY] = box[YY][YY] - x[j][YY];
-                    sendBuffer[n][ZZ] = box[ZZ][ZZ] - x[j][ZZ];
-                    n++;
-                }
+                nat_tot += ind.nrecv[nzone + 1];
+                continue;
             }
 
+            DDBufferAccess<gmx::RVec> sendBufferAccess(comm->rvecBuffer, ind.nsend[nzone + 1]);
+            gmx::ArrayRef<gmx::RVec>& sendBuffer = sendBufferAccess.buffer;
+            packHaloCoordinates(*dd, d, ind, box, x, sendBuffer);
+
             DDBufferAccess<gmx::RVec> receiveBufferAccess(
                     comm->rvecBuffer2, cd->receiveInPlace ? 0 : ind.nrecv[nzone + 1]);
 
@@ -350,132 +381,282 @@ void dd_move_x(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, g
 
             if (!cd->receiveInPlace)
             {
-                int j = 0;
-                for (int zone = 0; zone < nzone; zone++)
-                {
-                    for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
-                    {
-                        x[i] = receiveBuffer[j++];
-                    }
-                }
+                unpackHaloCoordinates(ind, nzone, receiveBuffer, x);
             }
             nat_tot += ind.nrecv[nzone + 1];
         }
         nzone += nzone;
     }
+}
+
+void dd_move_x(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, ewcMOVEX);
+
+    moveHaloCoordinates(dd, box, x, false);
 
     wallcycle_stop(wcycle, ewcMOVEX);
 }
 
-void dd_move_f(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle)
+void dd_move_x_begin(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
 {
-    wallcycle_start(wcycle, ewcMOVEF);
+    wallcycle_start(wcycle, ewcMOVEX);
+
+    gmx_domdec_comm_t&           comm    = *dd->comm;
+    DDHaloOverlap&               overlap = comm.haloOverlap;
+    /* Only pulse 0 of dimension 0 is overlapped, the other pulses
+     * are communicated blocking in dd_move_x_finish().
+     */
+    const gmx_domdec_comm_dim_t& cd      = comm.cd[0];
+    const gmx_domdec_ind_t&      ind     = cd.ind[0];
+    /* The first pulse sends only home atoms, i.e. one zone */
+    const int nzone = 1;
+
+    GMX_ASSERT(overlap.coordinateExchange.numRequests == 0 && overlap.forceExchange.numRequests == 0,
+               "Can only start a halo exchange when no other halo exchange is in flight");
+
+    overlap.sendBuffer.resize(ind.nsend[nzone + 1]);
+    packHaloCoordinates(*dd, 0, ind, box, x, overlap.sendBuffer);
+
+    gmx::ArrayRef<gmx::RVec> receiveBuffer;
+    if (cd.receiveInPlace)
+    {
+        receiveBuffer = gmx::arrayRefFromArray(x.data() + comm.atomRanges.numHomeAtoms(),
+                                               ind.nrecv[nzone + 1]);
+    }
+    else
+    {
+        overlap.receiveBuffer.resize(ind.nrecv[nzone + 1]);
+        receiveBuffer = overlap.receiveBuffer;
+    }
+    ddIsendrecv(dd, 0, dddirBackward, overlap.sendBuffer, receiveBuffer, &overlap.coordinateExchange);
+
+    wallcycle_stop(wcycle, ewcMOVEX);
+}
+
+void dd_move_x_finish(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, ewcMOVEX);
+
+    gmx_domdec_comm_t& comm    = *dd->comm;
+    DDHaloOverlap&     overlap = comm.haloOverlap;
+
+    ddWaitExchange(&overlap.coordinateExchange);
+
+    if (!comm.cd[0].receiveInPlace)
+    {
+        unpackHaloCoordinates(comm.cd[0].ind[0], 1, overlap.receiveBuffer, x);
+    }
+
+    /* The other pulses depend on the data received in the first */
+    moveHaloCoordinates(dd, box, x, true);
+
+    wallcycle_stop(wcycle, ewcMOVEX);
+}
+
+/*! \brief Packs the forces on the atoms received in a pulse into \p sendBuffer
+ *
+ * When receiving in place, the returned view refers directly to \p f,
+ * otherwise the forces are copied to \p sendBuffer and a view of that
+ * is returned.
+ */
+static gmx::ArrayRef<gmx::RVec> packHaloForces(const gmx_domdec_comm_dim_t& cd,
+                                               const gmx_domdec_ind_t&      ind,
+                                               int                          nzone,
+                                               int                          nat_tot,
+                                               gmx::ArrayRef<gmx::RVec>     f,
+                                               gmx::ArrayRef<gmx::RVec>     sendBuffer)
+{
+    if (cd.receiveInPlace)
+    {
+        return gmx::arrayRefFromArray(f.data() + nat_tot, ind.nrecv[nzone + 1]);
+    }
+
+    int j = 0;
+    for (int zone = 0; zone < nzone; zone++)
+    {
+        for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
+        {
+            sendBuffer[j++] = f[i];
+        }
+    }
 
+    return sendBuffer;
+}
+
+/*! \brief Adds the forces received in a pulse along DD dimension index \p d to the sending atoms */
+static void addHaloForces(const gmx_domdec_t&            dd,
+                          int                            d,
+                          const gmx_domdec_ind_t&        ind,
+                          gmx::ArrayRef<const gmx::RVec> receiveBuffer,
+                          gmx::ForceWithShiftForces*     forceWithShiftForces)
+{
     gmx::ArrayRef<gmx::RVec> f      = forceWithShiftForces->force();
     gmx::ArrayRef<gmx::RVec> fshift = forceWithShiftForces->shiftForces();
 
+    /* Only forces in domains near the PBC boundaries need to
+       consider PBC in the treatment of fshift */
+    const bool shiftForcesNeedPbc =
+            (forceWithShiftForces->computeVirial() && dd.ci[dd.dim[d]] == 0);
+    const bool applyScrewPbc =
+            (shiftForcesNeedPbc && dd.unitCellInfo.haveScrewPBC && dd.dim[d] == XX);
+    /* Determine which shift vector we need */
+    ivec vis       = { 0, 0, 0 };
+    vis[dd.dim[d]] = 1;
+    const int is   = IVEC2IS(vis);
+
+    int n = 0;
+    if (!shiftForcesNeedPbc)
+    {
+        for (int j : ind.index)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                f[j][d] += receiveBuffer[n][d];
+            }
+            n++;
+        }
+    }
+    else if (!applyScrewPbc)
+    {
+        for (int j : ind.index)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                f[j][d] += receiveBuffer[n][d];
+            }
+            /* Add this force to the shift force */
+            for (int d = 0; d < DIM; d++)
+            {
+                fshift[is][d] += receiveBuffer[n][d];
+            }
+            n++;
+        }
+    }
+    else
+    {
+        for (int j : ind.index)
+        {
+            /* Rotate the force */
+            f[j][XX] += receiveBuffer[n][XX];
+            f[j][YY] -= receiveBuffer[n][YY];
+            f[j][ZZ] -= receiveBuffer[n][ZZ];
+            if (shiftForcesNeedPbc)
+            {
+                /* Add this force to the shift force */
+                for (int d = 0; d < DIM; d++)
+                {
+                    fshift[is][d] += receiveBuffer[n][d];
+                }
+            }
+            n++;
+        }
+    }
+}
+
+/*! \brief Communicates the forces of all pulses, except the first when \p skipFirstPulse is true */
+static void moveHaloForces(gmx_domdec_t*              dd,
+                           gmx::ForceWithShiftForces* forceWithShiftForces,
+                           bool                       skipFirstPulse)
+{
+    gmx::ArrayRef<gmx::RVec> f = forceWithShiftForces->force();
+
     gmx_domdec_comm_t& comm    = *dd->comm;
     int                nzone   = comm.zones.n / 2;
     int                nat_tot = comm.atomRanges.end(DDAtomRanges::Type::Zones);
     for (int d = dd->ndim - 1; d >= 0; d--)
     {
-        /* Only forces in domains near the PBC boundaries need to
-           consider PBC in the treatment of fshift */
-        const bool shiftForcesNeedPbc =
-                (forceWithShiftForces->computeVirial() && dd->ci[dd->dim[d]] == 0);
-        const bool applyScrewPbc =
-                (shiftForcesNeedPbc && dd->unitCellInfo.haveScrewPBC && dd->dim[d] == XX);
-        /* Determine which shift vector we need */
-        ivec vis        = { 0, 0, 0 };
-        vis[dd->dim[d]] = 1;
-        const int is    = IVEC2IS(vis);
-
         /* Loop over the pulses */
         const gmx_domdec_comm_dim_t& cd = comm.cd[d];
         for (int p = cd.numPulses() - 1; p >= 0; p--)
         {
-            const gmx_domdec_ind_t&   ind = cd.ind[p];
-            DDBufferAccess<gmx::RVec> receiveBufferAccess(comm.rvecBuffer, ind.nsend[nzone + 1]);
-            gmx::ArrayRef<gmx::RVec>& receiveBuffer = receiveBufferAccess.buffer;
+            const gmx_domdec_ind_t& ind = cd.ind[p];
 
             nat_tot -= ind.nrecv[nzone + 1];
 
+            if (skipFirstPulse && d == dd->ndim - 1 && p == cd.numPulses() - 1)
+            {
+                continue;
+            }
+
+            DDBufferAccess<gmx::RVec> receiveBufferAccess(comm.rvecBuffer, ind.nsend[nzone + 1]);
+            gmx::ArrayRef<gmx::RVec>& receiveBuffer = receiveBufferAccess.buffer;
+
             DDBufferAccess<gmx::RVec> sendBufferAccess(
                     comm.rvecBuffer2, cd.receiveInPlace ? 0 : ind.nrecv[nzone + 1]);
 
-            gmx::ArrayRef<gmx::RVec> sendBuffer;
-            if (cd.receiveInPlace)
-            {
-                sendBuffer = gmx::arrayRefFromArray(f.data() + nat_tot, ind.nrecv[nzone + 1]);
-            }
-            else
-            {
-                sendBuffer = sendBufferAccess.buffer;
-                int j      = 0;
-                for (int zone = 0; zone < nzone; zone++)
-                {
-                    for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
-                    {
-                        sendBuffer[j++] = f[i];
-                    }
-                }
-            }
+            gmx::ArrayRef<gmx::RVec> sendBuffer =
+                    packHaloForces(cd, ind, nzone, nat_tot, f, sendBufferAccess.buffer);
             /* Communicate the forces */
             ddSendrecv(dd, d, dddirForward, sendBuffer, receiveBuffer);
             /* Add the received forces */
-            int n = 0;
-            if (!shiftForcesNeedPbc)
-            {
-                for (int j : ind.index)
-                {
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        f[j][d] += receiveBuffer[n][d];
-                    }
-                    n++;
-                }
-            }
-            else if (!applyScrewPbc)
-            {
-                for (int j : ind.index)
-                {
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        f[j][d] += receiveBuffer[n][d];
-                    }
-                    /* Add this force to the shift force */
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        fshift[is][d] += receiveBuffer[n][d];
-                    }
-                    n++;
-                }
-            }
-            else
-            {
-                for (int j : ind.index)
-                {
-                    /* Rotate the force */
-                    f[j][XX] += receiveBuffer[n][XX];
-                    f[j][YY] -= receiveBuffer[n][YY];
-                    f[j][ZZ] -= receiveBuffer[n][ZZ];
-                    if (shiftForcesNeedPbc)
-                    {
-                        /* Add this force to the shift force */
-                        for (int d = 0; d < DIM; d++)
-                        {
-                            fshift[is][d] += receiveBuffer[n][d];
-                        }
-                    }
-                    n++;
-                }
-            }
+            addHaloForces(*dd, d, ind, receiveBuffer, forceWithShiftForces);
         }
         nzone /= 2;
     }
+}
+
+void dd_move_f(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, ewcMOVEF);
+
+    moveHaloForces(dd, forceWithShiftForces, false);
+
     wallcycle_stop(wcycle, ewcMOVEF);
 }
 
+void dd_move_f_begin(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, ewcMOVEF);
+
+    gmx_domdec_comm_t&           comm    = *dd->comm;
+    DDHaloOverlap&               overlap = comm.haloOverlap;
+    /* Only the last pulse of the last dimension is overlapped, the other
+     * pulses are communicated blocking in dd_move_f_finish().
+     */
+    const int                    d       = dd->ndim - 1;
+    const gmx_domdec_comm_dim_t& cd      = comm.cd[d];
+    const gmx_domdec_ind_t&      ind     = cd.ind[cd.numPulses() - 1];
+    const int                    nzone   = comm.zones.n / 2;
+    const int nat_tot = comm.atomRanges.end(DDAtomRanges::Type::Zones) - ind.nrecv[nzone + 1];
+
+    GMX_ASSERT(overlap.coordinateExchange.numRequests == 0 && overlap.forceExchange.numRequests == 0,
+               "Can only start a halo exchange when no other halo exchange is in flight");
+
+    overlap.receiveBuffer.resize(ind.nsend[nzone + 1]);
+    overlap.sendBuffer.resize(cd.receiveInPlace ? 0 : ind.nrecv[nzone + 1]);
+
+    gmx::ArrayRef<gmx::RVec> sendBuffer =
+            packHaloForces(cd, ind, nzone, nat_tot, forceWithShiftForces->force(), overlap.sendBuffer);
+    ddIsendrecv(dd, d, dddirForward, sendBuffer, overlap.receiveBuffer, &overlap.forceExchange);
+
+    wallcycle_stop(wcycle, ewcMOVEF);
+}
+
+void dd_move_f_finish(gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, ewcMOVEF);
+
+    gmx_domdec_comm_t&           comm    = *dd->comm;
+    DDHaloOverlap&               overlap = comm.haloOverlap;
+    const int                    d       = dd->ndim - 1;
+    const gmx_domdec_comm_dim_t& cd      = comm.cd[d];
+
+    ddWaitExchange(&overlap.forceExchange);
+
+    addHaloForces(*dd, d, cd.ind[cd.numPulses() - 1], overlap.receiveBuffer, forceWithShiftForces);
+
+    /* The other pulses send forces that include the forces received in the first */
+    moveHaloForces(dd, forceWithShiftForces, true);
+
+    wallcycle_stop(wcycle, ewcMOVEF);
+}
+
+bool ddUsesOverlappedHaloExchange(const gmx_domdec_t& dd)
+{
+    return dd.comm->ddSettings.useOverlappedHaloExchange;
+}
+
 /* Convenience function for extracting a real buffer from an rvec buffer
  *
  * To reduce the number of temporary communication buffers and avoid
@@ -2895,6 +3076,8 @@ static DDSettings getDDSettings(const gmx::MDLogger&     mdlog,
     ddSettings.nstDDDumpGrid       = dd_getenv(mdlog, "GMX_DD_NST_DUMP_GRID", 0);
     ddSettings.DD_debug            = dd_getenv(mdlog, "GMX_DD_DEBUG", 0);
 
+    ddSettings.useOverlappedHaloExchange = (dd_getenv(mdlog, "GMX_DD_OVERLAP_HALO", 0) != 0);
+
     if (ddSettings.useSendRecv2)
     {
         GMX_LOG(mdlog.info)
@@ -2904,6 +3087,14 @@ static DDSettings getDDSettings(const gmx::MDLogger&     mdlog,
                         "communication");
     }
 
+    if (ddSettings.useOverlappedHaloExchange)
+    {
+        GMX_LOG(mdlog.info)
+                .appendText(
+                        "Will overlap the first pulse of the CPU halo exchanges with local "
+                        "force computation");
+    }
+
     if (ddSettings.eFlop)
     {
         GMX_LOG(mdlog.info).appendText("Will load balance based on FLOP count");
@@ -217,6 +217,46 @@ void dd_move_x(struct gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVe
  */
 void dd_move_f(struct gmx_domdec_t* dd, gmx::ForceWithShiftForces* forceWithShiftForces, gmx_wallcycle* wcycle);
 
+/*! \brief Returns whether the CPU halo exchanges can be split in a begin and finish call
+ *
+ * This is set with the environment variable GMX_DD_OVERLAP_HALO.
+ * Only one pulse of each exchange is overlapped, see dd_move_x_begin()
+ * and dd_move_f_begin().
+ */
+bool ddUsesOverlappedHaloExchange(const gmx_domdec_t& dd);
+
+/*! \brief Start the coordinate communication of dd_move_x() without blocking
+ *
+ * Only the first pulse along the first DD dimension is started, as all
+ * other pulses depend on it. All other pulses and dimensions are
+ * communicated blocking in dd_move_x_finish(), so with multiple pulses
+ * or dimensions only part of the communication is overlapped.
+ * Between this call and dd_move_x_finish() only the home atom
+ * coordinates in \p x can be accessed.
+ */
+void dd_move_x_begin(struct gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle);
+
+/*! \brief Complete the coordinate communication started by dd_move_x_begin() */
+void dd_move_x_finish(struct gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle);
+
+/*! \brief Start the force communication of dd_move_f() without blocking
+ *
+ * Only the last pulse along the last DD dimension, which is the first
+ * one communicated, is started, as all other pulses depend on it.
+ * All other pulses and dimensions are communicated blocking in
+ * dd_move_f_finish(). This should be called when all forces on
+ * non-home atoms have been computed. Until dd_move_f_finish() has been
+ * called, only forces on home atoms can be added.
+ */
+void dd_move_f_begin(struct gmx_domdec_t*       dd,
+                     gmx::ForceWithShiftForces* forceWithShiftForces,
+                     gmx_wallcycle*             wcycle);
+
+/*! \brief Complete the force communication started by dd_move_f_begin() */
+void dd_move_f_finish(struct gmx_domdec_t*       dd,
+                      gmx::ForceWithShiftForces* forceWithShiftForces,
+                      gmx_wallcycle*             wcycle);
+
 /*! \brief Communicate a real for each atom to the neighboring cells. */
 void dd_atom_spread_real(struct gmx_domdec_t* dd, real v[]);
 
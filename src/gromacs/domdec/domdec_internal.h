@@ -46,6 +46,7 @@
 #include "config.h"
 
 #include "gromacs/domdec/domdec.h"
+#include "gromacs/domdec/domdec_network.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/mdlib/updategroupscog.h"
 #include "gromacs/timing/cyclecounter.h"
@@ -484,6 +485,9 @@ struct DDSettings
     //! Whether we should record the load
     bool recordLoad = false;
 
+    //! Whether to overlap the first pulse of the halo exchanges with computation
+    bool useOverlappedHaloExchange = false;
+
     /* Debugging */
     //! Step interval for dumping the local+non-local atoms to pdb
     int nstDDDump = 0;
@@ -496,6 +500,25 @@ struct DDSettings
     DlbState initialDlbState = DlbState::offCanTurnOn;
 };
 
+/*! \brief Storage for a halo exchange pulse that overlaps with computation
+ *
+ * Only the first coordinate pulse, along the first DD dimension, and the
+ * first force pulse, along the last DD dimension, have send data that
+ * does not depend on data received in other pulses. Only these are
+ * started early, all other pulses are communicated when finishing.
+ */
+struct DDHaloOverlap
+{
+    //! Send buffer for the pulse in flight
+    std::vector<gmx::RVec> sendBuffer;
+    //! Receive buffer for the pulse in flight, unused when receiving in place
+    std::vector<gmx::RVec> receiveBuffer;
+    //! The coordinate pulse in flight
+    DDPendingExchange coordinateExchange;
+    //! The force pulse in flight
+    DDPendingExchange forceExchange;
+};
+
 /*! \brief Information on how the DD ranks are set up */
 struct DDRankSetup
 {
@@ -663,6 +686,9 @@ struct gmx_domdec_comm_t // NOLINT (clang-analyzer-optin.performance.Padding)
     /**< Another rvec comm. buffer */
     DDBuffer<gmx::RVec> rvecBuffer2;
 
+    /**< Buffers and requests for halo exchange overlapping with computation */
+    DDHaloOverlap haloOverlap;
+
     /* Communication buffers for local redistribution */
     /**< Charge group flag comm. buffers */
     std::array<std::vector<int>, DIM * 2> cggl_flag;
@@ -51,6 +51,7 @@
 #include <cstring>
 
 #include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/gmxmpi.h"
 
 #include "domdec_internal.h"
@@ -132,6 +133,54 @@ template void ddSendrecv(const gmx_domdec_t*, int, int, gmx::ArrayRef<real>, gmx
 //! Specialization of extern template for gmx::RVec
 template void ddSendrecv(const gmx_domdec_t*, int, int, gmx::ArrayRef<gmx::RVec>, gmx::ArrayRef<gmx::RVec>);
 
+void ddIsendrecv(const gmx_domdec_t*      dd,
+                 int                      ddDimensionIndex,
+                 int                      direction,
+                 gmx::ArrayRef<gmx::RVec> sendBuffer,
+                 gmx::ArrayRef<gmx::RVec> receiveBuffer,
+                 DDPendingExchange*       exchange)
+{
+    GMX_ASSERT(exchange->numRequests == 0, "Can only have one exchange in flight");
+
+#if GMX_MPI
+    int sendRank    = dd->neighbor[ddDimensionIndex][direction == dddirForward ? 0 : 1];
+    int receiveRank = dd->neighbor[ddDimensionIndex][direction == dddirForward ? 1 : 0];
+
+    /* Use a different tag than ddSendrecv, so we can not match
+     * with blocking messages sent while this exchange is in flight.
+     */
+    constexpr int mpiTag = 2;
+    if (!receiveBuffer.empty())
+    {
+        MPI_Irecv(receiveBuffer.data(), receiveBuffer.size() * sizeof(gmx::RVec), MPI_BYTE,
+                  receiveRank, mpiTag, dd->mpi_comm_all, &exchange->requests[exchange->numRequests++]);
+    }
+    if (!sendBuffer.empty())
+    {
+        MPI_Isend(sendBuffer.data(), sendBuffer.size() * sizeof(gmx::RVec), MPI_BYTE, sendRank,
+                  mpiTag, dd->mpi_comm_all, &exchange->requests[exchange->numRequests++]);
+    }
+#else  // GMX_MPI
+    GMX_UNUSED_VALUE(dd);
+    GMX_UNUSED_VALUE(ddDimensionIndex);
+    GMX_UNUSED_VALUE(direction);
+    GMX_UNUSED_VALUE(sendBuffer);
+    GMX_UNUSED_VALUE(receiveBuffer);
+#endif // GMX_MPI
+}
+
+void ddWaitExchange(DDPendingExchange* exchange)
+{
+#if GMX_MPI
+    if (exchange->numRequests > 0)
+    {
+        MPI_Waitall(exchange->numRequests, exchange->requests.data(),
+                    MPI_STATUSES_IGNORE); //NOLINT(clang-analyzer-optin.mpi.MPI-Checker)
+    }
+#endif
+    exchange->numRequests = 0;
+}
+
 void dd_sendrecv2_rvec(const struct gmx_domdec_t gmx_unused* dd,
                        int gmx_unused ddimind,
                        rvec gmx_unused* buf_s_fw,
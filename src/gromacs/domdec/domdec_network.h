@@ -49,8 +49,11 @@
 #ifndef GMX_DOMDEC_DOMDEC_NETWORK_H
 #define GMX_DOMDEC_DOMDEC_NETWORK_H
 
+#include <array>
+
 #include "gromacs/math/vectypes.h"
 #include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/gmxmpi.h"
 
 struct gmx_domdec_t;
 
@@ -141,6 +144,39 @@ extern template void ddSendrecv<gmx::RVec>(const gmx_domdec_t*      dd,
                                            gmx::ArrayRef<gmx::RVec> sendBuffer,
                                            gmx::ArrayRef<gmx::RVec> receiveBuffer);
 
+/*! \brief Requests of a non-blocking exchange started with ddIsendrecv()
+ *
+ * The exchange should be completed with ddWaitExchange() before
+ * the send buffer is reused or the receive buffer is read.
+ */
+struct DDPendingExchange
+{
+    //! The MPI requests, a receive and a send at most
+    std::array<MPI_Request, 2> requests;
+    //! The number of active requests
+    int numRequests = 0;
+};
+
+/*! \brief Start moving a view of gmx::RVec values in the communication
+ * region one cell along the domain decomposition without blocking
+ *
+ * Moves in the dimension indexed by ddDimensionIndex, either forward
+ * (direction=dddirFoward) or backward (direction=dddirBackward).
+ * The buffers should not be accessed until ddWaitExchange() has been
+ * called on \p exchange. A separate message tag is used, so
+ * blocking communication calls along the domain decomposition can
+ * be made while the exchange is in flight.
+ */
+void ddIsendrecv(const gmx_domdec_t*      dd,
+                 int                      ddDimensionIndex,
+                 int                      direction,
+                 gmx::ArrayRef<gmx::RVec> sendBuffer,
+                 gmx::ArrayRef<gmx::RVec> receiveBuffer,
+                 DDPendingExchange*       exchange);
+
+//! Waits for completion of the non-blocking \p exchange
+void ddWaitExchange(DDPendingExchange* exchange);
+
 /*! \brief Move revc's in the comm. region one cell along the domain decomposition
  *
  * Moves in dimension indexed by ddimind, simultaneously in the forward
@@ -721,6 +721,18 @@ gmx_pme_t* gmx_pme_init(const t_commrec*         cr,
     delete pme->boxScaler;
     pme->boxScaler = new EwaldBoxZScaler(*ir);
 
+    /* Colored spreading writes directly into the FFT grid, which is only
+     * supported with a single PME rank, and it needs at least two blocks
+     * of pme_order grid lines along x and y.
+     */
+    pme->useColoredSpread = (getenv("GMX_PME_COLORED_SPREAD") != nullptr && pme->bUseThreads
+                             && pme->nnodes == 1 && pme->nkx >= 2 * pme->pme_order
+                             && pme->nky >= 2 * pme->pme_order);
+    if (pme->useColoredSpread)
+    {
+        GMX_LOG(mdlog.info).appendText("Using colored PME spreading directly on the FFT grid");
+    }
+
     /* If we violate restrictions, generate a fatal error here */
     gmx_pme_check_restrictions(pme->pme_order, pme->nkx, pme->nky, pme->nkz, pme->nnodes_major,
                                pme->bUseThreads, true);
@@ -1107,6 +1119,13 @@ int gmx_pme_do(struct gmx_pme_t*              pme,
     /* If we are doing LJ-PME with LB, we only do Q here */
     max_grid_index = (pme->ljpme_combination_rule == eljpmeLB) ? DO_Q : DO_Q_AND_LJ;
 
+    /* With Coulomb and geometric LJ-PME without free-energy on a single rank,
+     * we gather the forces from both grids in a single pass after the LJ grid
+     * is ready. The coefficients are then the unmodified input arrays.
+     */
+    const bool fuseGatherQAndLJ = (bCalcF && pme->doCoulomb && pme->doLJ && !pme->bFEP
+                                   && pme->ljpme_combination_rule != eljpmeLB && pme->nnodes == 1);
+
     for (grid_index = 0; grid_index < max_grid_index; ++grid_index)
     {
         /* Check if we should do calculations at this grid_index
@@ -1301,20 +1320,43 @@ int gmx_pme_do(struct gmx_pme_t*              pme,
              */
             lambda  = grid_index < DO_Q ? lambda_q : lambda_lj;
             bClearF = (bFirst && PAR(cr));
-#pragma omp parallel for num_threads(pme->nthread) schedule(static)
-            for (thread = 0; thread < pme->nthread; thread++)
+            if (fuseGatherQAndLJ && grid_index == PME_GRID_QA)
             {
-                try
+                /* The Coulomb forces are gathered together with LJ */
+            }
+            else if (fuseGatherQAndLJ && grid_index == PME_GRID_C6A)
+            {
+                const real* gridQ = pme->pmegrid[PME_GRID_QA].grid.grid;
+#pragma omp parallel for num_threads(pme->nthread) schedule(static)
+                for (thread = 0; thread < pme->nthread; thread++)
                 {
-                    gather_f_bsplines(pme, grid, bClearF, &atc, &atc.spline[thread],
-                                      pme->bFEP ? (grid_index % 2 == 0 ? 1.0 - lambda : lambda) : 1.0);
+                    try
+                    {
+                        gather_f_bsplines_q_lj(pme, gridQ, grid, PAR(cr), &atc, chargeA, c6A,
+                                               &atc.spline[thread]);
+                    }
+                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
                 }
-                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
-            }
 
+                inc_nrnb(nrnb, eNR_GATHERFBSP,
+                         2 * pme->pme_order * pme->pme_order * pme->pme_order * atc.numAtoms());
+            }
+            else
+            {
+#pragma omp parallel for num_threads(pme->nthread) schedule(static)
+                for (thread = 0; thread < pme->nthread; thread++)
+                {
+                    try
+                    {
+                        gather_f_bsplines(pme, grid, bClearF, &atc, &atc.spline[thread],
+                                          pme->bFEP ? (grid_index % 2 == 0 ? 1.0 - lambda : lambda) : 1.0);
+                    }
+                    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+                }
 
-            inc_nrnb(nrnb, eNR_GATHERFBSP,
-                     pme->pme_order * pme->pme_order * pme->pme_order * atc.numAtoms());
+                inc_nrnb(nrnb, eNR_GATHERFBSP,
+                         pme->pme_order * pme->pme_order * pme->pme_order * atc.numAtoms());
+            }
             /* Note: this wallcycle region is opened above inside an OpenMP
                region, so take care if refactoring code here. */
             wallcycle_stop(wcycle, ewcPME_GATHER);
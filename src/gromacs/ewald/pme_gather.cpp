@@ -52,6 +52,140 @@
 
 using namespace gmx; // TODO: Remove when this file is moved into gmx namespace
 
+/*! \brief Gathers the force contributions of one atom from \p numGrids grids
+ *
+ * All grids share the same spline weights, so the weights are loaded once.
+ * Returns in \p f[g] the force in grid units for grid g.
+ * With SIMD4 support, z is processed in aligned chunks of 4 grid points
+ * with zero-padded weights, which works for any order, but requires
+ * the grid z-stride to be a multiple of 4.
+ */
+template<int order, int numGrids>
+static inline void gatherAtomFromGrids(const real* const* grids,
+                                       const int          gridNY,
+                                       const int          gridNZ,
+                                       const int*         idxptr,
+                                       const real*        thx,
+                                       const real*        thy,
+                                       const real*        thz,
+                                       const real*        dthx,
+                                       const real*        dthy,
+                                       const real*        dthz,
+                                       RVec*              f)
+{
+    const int idxX = idxptr[XX];
+    const int idxY = idxptr[YY];
+    const int idxZ = idxptr[ZZ];
+
+#ifdef PME_SIMD4_SPREAD_GATHER
+    GMX_ASSERT(gridNZ % 4 == 0,
+               "For aligned SIMD4 operations the grid size has to be padded up to a multiple of 4");
+
+    /* The maximum number of chunks needed for any alignment offset */
+    constexpr int c_maxNumChunks = (order + 3 + 3) / 4;
+
+    const int offset    = idxZ & 3;
+    const int numChunks = (offset + order + 3) / 4;
+
+    alignas(GMX_SIMD_ALIGNMENT) real tzBuffer[c_maxNumChunks * GMX_SIMD4_WIDTH]  = { 0 };
+    alignas(GMX_SIMD_ALIGNMENT) real dtzBuffer[c_maxNumChunks * GMX_SIMD4_WIDTH] = { 0 };
+    for (int ithz = 0; ithz < order; ithz++)
+    {
+        tzBuffer[offset + ithz]  = thz[ithz];
+        dtzBuffer[offset + ithz] = dthz[ithz];
+    }
+    Simd4Real tz_S[c_maxNumChunks];
+    Simd4Real dz_S[c_maxNumChunks];
+    for (int c = 0; c < c_maxNumChunks; c++)
+    {
+        tz_S[c] = load4(tzBuffer + c * GMX_SIMD4_WIDTH);
+        dz_S[c] = load4(dtzBuffer + c * GMX_SIMD4_WIDTH);
+    }
+
+    Simd4Real fx_S[numGrids];
+    Simd4Real fy_S[numGrids];
+    Simd4Real fz_S[numGrids];
+    for (int g = 0; g < numGrids; g++)
+    {
+        fx_S[g] = setZero();
+        fy_S[g] = setZero();
+        fz_S[g] = setZero();
+    }
+
+    for (int ithx = 0; ithx < order; ithx++)
+    {
+        const int       index_x = (idxX + ithx) * gridNY * gridNZ;
+        const Simd4Real tx_S    = Simd4Real(thx[ithx]);
+        const Simd4Real dx_S    = Simd4Real(dthx[ithx]);
+
+        for (int ithy = 0; ithy < order; ithy++)
+        {
+            const int       index_xy = index_x + (idxY + ithy) * gridNZ + idxZ - offset;
+            const Simd4Real ty_S     = Simd4Real(thy[ithy]);
+            const Simd4Real dy_S     = Simd4Real(dthy[ithy]);
+            const Simd4Real dxty_S   = dx_S * ty_S;
+            const Simd4Real txdy_S   = tx_S * dy_S;
+            const Simd4Real txty_S   = tx_S * ty_S;
+
+            for (int g = 0; g < numGrids; g++)
+            {
+                Simd4Real fxy1_S = setZero();
+                Simd4Real fz1_S  = setZero();
+                for (int c = 0; c < numChunks; c++)
+                {
+                    const Simd4Real gval_S = load4(grids[g] + index_xy + c * GMX_SIMD4_WIDTH);
+
+                    fxy1_S = fma(tz_S[c], gval_S, fxy1_S);
+                    fz1_S  = fma(dz_S[c], gval_S, fz1_S);
+                }
+                fx_S[g] = fma(dxty_S, fxy1_S, fx_S[g]);
+                fy_S[g] = fma(txdy_S, fxy1_S, fy_S[g]);
+                fz_S[g] = fma(txty_S, fz1_S, fz_S[g]);
+            }
+        }
+    }
+
+    for (int g = 0; g < numGrids; g++)
+    {
+        f[g] = { reduce(fx_S[g]), reduce(fy_S[g]), reduce(fz_S[g]) };
+    }
+#else
+    for (int g = 0; g < numGrids; g++)
+    {
+        f[g] = { 0, 0, 0 };
+    }
+
+    for (int ithx = 0; ithx < order; ithx++)
+    {
+        const int  index_x = (idxX + ithx) * gridNY * gridNZ;
+        const real tx      = thx[ithx];
+        const real dx      = dthx[ithx];
+
+        for (int ithy = 0; ithy < order; ithy++)
+        {
+            const int  index_xy = index_x + (idxY + ithy) * gridNZ + idxZ;
+            const real ty       = thy[ithy];
+            const real dy       = dthy[ithy];
+
+            for (int g = 0; g < numGrids; g++)
+            {
+                real fxy1 = 0, fz1 = 0;
+
+                for (int ithz = 0; ithz < order; ithz++)
+                {
+                    const real gval = grids[g][index_xy + ithz];
+                    fxy1 += thz[ithz] * gval;
+                    fz1 += dthz[ithz] * gval;
+                }
+                f[g][XX] += dx * ty * fxy1;
+                f[g][YY] += tx * dy * fxy1;
+                f[g][ZZ] += tx * ty * fz1;
+            }
+        }
+    }
+#endif
+}
+
 /* Spline function. Goals: 1) Force compiler to instantiate function separately
    for each compile-time value of order and once more for any possible (runtime)
    value. 2) Allow overloading for specific compile-time values.
@@ -283,6 +417,27 @@ struct do_fspline
         return { reduce(fx_S), reduce(fy_S), reduce(fz_S) };
     }
 #endif
+
+#ifdef PME_SIMD4_SPREAD_GATHER
+    /* Gather with aligned SIMD4 chunks along z for pme_order > 5 */
+    template<int Order>
+    std::enable_if_t<(Order > 5), RVec> operator()(std::integral_constant<int, Order> /*unused*/) const
+    {
+        const int norder = nn * Order;
+
+        const real* grids[1] = { grid };
+        RVec        f;
+        gatherAtomFromGrids<Order, 1>(grids, gridNY, gridNZ, idxptr,
+                                      spline->theta.coefficients[XX] + norder,
+                                      spline->theta.coefficients[YY] + norder,
+                                      spline->theta.coefficients[ZZ] + norder,
+                                      spline->dtheta.coefficients[XX] + norder,
+                                      spline->dtheta.coefficients[YY] + norder,
+                                      spline->dtheta.coefficients[ZZ] + norder, &f);
+
+        return f;
+    }
+#endif
 private:
     const gmx_pme_t* const pme;
     const real* const gmx_restrict grid;
@@ -327,8 +482,12 @@ void gather_f_bsplines(const gmx_pme_t*    pme,
     /* Note that unrolling this loop by templating this function on order
      * deteriorates performance significantly with gcc5/6/7.
      */
-    for (int nn = 0; nn < spline->n; nn++)
+    /* Process the atoms sorted on grid line, when available */
+    const bool useGatherOrder = (static_cast<int>(spline->gatherOrder.size()) == spline->n);
+
+    for (int i = 0; i < spline->n; i++)
     {
+        const int  nn          = (useGatherOrder ? spline->gatherOrder[i] : i);
         const int  n           = spline->ind[nn];
         const real coefficient = scale * atc->coefficient[n];
 
@@ -347,6 +506,13 @@ void gather_f_bsplines(const gmx_pme_t*    pme,
             {
                 case 4: f = spline_func(std::integral_constant<int, 4>()); break;
                 case 5: f = spline_func(std::integral_constant<int, 5>()); break;
+                case 6: f = spline_func(std::integral_constant<int, 6>()); break;
+                case 7: f = spline_func(std::integral_constant<int, 7>()); break;
+                case 8: f = spline_func(std::integral_constant<int, 8>()); break;
+                case 9: f = spline_func(std::integral_constant<int, 9>()); break;
+                case 10: f = spline_func(std::integral_constant<int, 10>()); break;
+                case 11: f = spline_func(std::integral_constant<int, 11>()); break;
+                case 12: f = spline_func(std::integral_constant<int, 12>()); break;
                 default: f = spline_func(order); break;
             }
 
@@ -366,6 +532,129 @@ void gather_f_bsplines(const gmx_pme_t*    pme,
      */
 }
 
+/*! \brief Templated implementation of gather_f_bsplines_q_lj() */
+template<int order>
+static void gatherForcesCoulombAndLJ(const gmx_pme_t*    pme,
+                                     const real*         gridQ,
+                                     const real*         gridLJ,
+                                     bool                bClearF,
+                                     const PmeAtomComm*  atc,
+                                     const real*         coefficientQ,
+                                     const real*         coefficientLJ,
+                                     const splinedata_t* spline)
+{
+    const real* const grids[2] = { gridQ, gridLJ };
+
+    const int nx = pme->nkx;
+    const int ny = pme->nky;
+    const int nz = pme->nkz;
+
+    const real rxx = pme->recipbox[XX][XX];
+    const real ryx = pme->recipbox[YY][XX];
+    const real ryy = pme->recipbox[YY][YY];
+    const real rzx = pme->recipbox[ZZ][XX];
+    const real rzy = pme->recipbox[ZZ][YY];
+    const real rzz = pme->recipbox[ZZ][ZZ];
+
+    rvec* gmx_restrict force = as_rvec_array(atc->f.data());
+
+    const bool useGatherOrder = (static_cast<int>(spline->gatherOrder.size()) == spline->n);
+
+    for (int i = 0; i < spline->n; i++)
+    {
+        const int nn = (useGatherOrder ? spline->gatherOrder[i] : i);
+        const int n  = spline->ind[nn];
+
+        if (bClearF)
+        {
+            clear_rvec(force[n]);
+        }
+        if (coefficientQ[n] == 0 && coefficientLJ[n] == 0)
+        {
+            continue;
+        }
+
+        const int norder = nn * order;
+
+        RVec f[2];
+        gatherAtomFromGrids<order, 2>(grids, pme->pmegrid_ny, pme->pmegrid_nz, atc->idx[spline->ind[nn]],
+                                      spline->theta.coefficients[XX] + norder,
+                                      spline->theta.coefficients[YY] + norder,
+                                      spline->theta.coefficients[ZZ] + norder,
+                                      spline->dtheta.coefficients[XX] + norder,
+                                      spline->dtheta.coefficients[YY] + norder,
+                                      spline->dtheta.coefficients[ZZ] + norder, f);
+
+        /* Combine the two grids, weighted by their coefficients, in grid units */
+        RVec fSum;
+        for (int d = 0; d < DIM; d++)
+        {
+            fSum[d] = coefficientQ[n] * f[0][d] + coefficientLJ[n] * f[1][d];
+        }
+
+        force[n][XX] += -(fSum[XX] * nx * rxx);
+        force[n][YY] += -(fSum[XX] * nx * ryx + fSum[YY] * ny * ryy);
+        force[n][ZZ] += -(fSum[XX] * nx * rzx + fSum[YY] * ny * rzy + fSum[ZZ] * nz * rzz);
+    }
+}
+
+void gather_f_bsplines_q_lj(const gmx_pme_t*    pme,
+                            const real*         gridQ,
+                            const real*         gridLJ,
+                            gmx_bool            bClearF,
+                            const PmeAtomComm*  atc,
+                            const real*         coefficientQ,
+                            const real*         coefficientLJ,
+                            const splinedata_t* spline)
+{
+    const int order = pme->pme_order;
+
+    switch (order)
+    {
+        case 3:
+            gatherForcesCoulombAndLJ<3>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                        coefficientLJ, spline);
+            break;
+        case 4:
+            gatherForcesCoulombAndLJ<4>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                        coefficientLJ, spline);
+            break;
+        case 5:
+            gatherForcesCoulombAndLJ<5>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                        coefficientLJ, spline);
+            break;
+        case 6:
+            gatherForcesCoulombAndLJ<6>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                        coefficientLJ, spline);
+            break;
+        case 7:
+            gatherForcesCoulombAndLJ<7>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                        coefficientLJ, spline);
+            break;
+        case 8:
+            gatherForcesCoulombAndLJ<8>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                        coefficientLJ, spline);
+            break;
+        case 9:
+            gatherForcesCoulombAndLJ<9>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                        coefficientLJ, spline);
+            break;
+        case 10:
+            gatherForcesCoulombAndLJ<10>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                         coefficientLJ, spline);
+            break;
+        case 11:
+            gatherForcesCoulombAndLJ<11>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                         coefficientLJ, spline);
+            break;
+        case 12:
+            gatherForcesCoulombAndLJ<12>(pme, gridQ, gridLJ, bClearF, atc, coefficientQ,
+                                         coefficientLJ, spline);
+            break;
+        default: GMX_RELEASE_ASSERT(false, "Unsupported PME order");
+    }
+}
+
 
 real gather_energy_bsplines(gmx_pme_t* pme, const real* grid, PmeAtomComm* atc)
 {
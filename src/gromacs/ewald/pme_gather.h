@@ -46,6 +46,22 @@ void gather_f_bsplines(const struct gmx_pme_t* pme,
                        const splinedata_t*     spline,
                        real                    scale);
 
+/*! \brief Gathers the forces from the Coulomb and the LJ grid in a single pass
+ *
+ * Computes the same forces as two calls to gather_f_bsplines() with scale 1,
+ * but loads the spline weights and iterates over the atoms only once.
+ * The coefficients are passed explicitly, as atc->coefficient can only
+ * hold one set.
+ */
+void gather_f_bsplines_q_lj(const struct gmx_pme_t* pme,
+                            const real*             gridQ,
+                            const real*             gridLJ,
+                            gmx_bool                bClearF,
+                            const PmeAtomComm*      atc,
+                            const real*             coefficientQ,
+                            const real*             coefficientLJ,
+                            const splinedata_t*     spline);
+
 real gather_energy_bsplines(struct gmx_pme_t* pme, const real* grid, PmeAtomComm* atc);
 
 #endif
@@ -496,15 +496,11 @@ void unwrap_periodic_pmegrid(struct gmx_pme_t* pme, real* pmegrid)
 void set_grid_alignment(int gmx_unused* pmegrid_nz, int gmx_unused pme_order)
 {
 #ifdef PME_SIMD4_SPREAD_GATHER
-    if (pme_order == 5
-#    if !PME_4NSIMD_GATHER
-        || pme_order == 4
-#    endif
-    )
-    {
-        /* Round nz up to a multiple of 4 to ensure alignment */
-        *pmegrid_nz = ((*pmegrid_nz + 3) & ~3);
-    }
+    /* Round nz up to a multiple of 4 to ensure alignment, this is needed
+     * for the aligned SIMD4 spreading with order 4 and 5 and for the
+     * aligned SIMD4 gather kernels, which are used for all orders.
+     */
+    *pmegrid_nz = ((*pmegrid_nz + 3) & ~3);
 #endif
 }
 
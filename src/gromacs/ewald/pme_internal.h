@@ -55,6 +55,8 @@
 
 #include "config.h"
 
+#include <vector>
+
 #include "gromacs/math/gmxcomplex.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/defaultinitializationallocator.h"
@@ -189,6 +191,33 @@ struct splinedata_t
     SplineCoefficients theta;
     SplineCoefficients dtheta;
     int                nalloc = 0;
+    //! The spline indices sorted on grid line, used to order the gather for cache reuse
+    FastVector<int> gatherOrder;
+    //! Work buffer for sorting gatherOrder
+    FastVector<int> sortWork;
+};
+
+/*! \internal
+ * \brief Atoms sorted on blocks of grid lines, used for colored spreading
+ *
+ * With colored spreading the grid is divided into an even number of blocks
+ * along x and along y. Atoms are sorted on the block that contains their
+ * lowest grid index. Blocks with the same parity of their x and y block
+ * indices, i.e. the same color, do not overlap after spreading, so these
+ * can be spread by different threads directly into the shared FFT grid.
+ */
+struct PmeColoredSpreadWork
+{
+    //! The number of blocks along x and y, both are even
+    int numBlocks[2] = { 0, 0 };
+    //! The number of atoms per thread and block, converted to the start in the sorted lists
+    std::vector<int> threadBlockCount;
+    //! The start of each block in the sorted lists, size numBlocks[0]*numBlocks[1]+1
+    std::vector<int> blockStart;
+    //! For each sorted atom, the thread index of its spline data
+    std::vector<int> splineThread;
+    //! For each sorted atom, the index in the spline data of the thread
+    std::vector<int> splineIndex;
 };
 
 /*! \brief PME slab MPI communication setup */
@@ -279,6 +308,8 @@ public:
     FastVector<int>              thread_idx;
     std::vector<AtomToThreadMap> threadMap;
     std::vector<splinedata_t>    spline;
+    //! Atom lists sorted on grid blocks, only used with colored spreading
+    PmeColoredSpreadWork coloredSpreadWork;
 };
 
 /*! \brief Data structure for a single PME grid */
@@ -329,6 +360,7 @@ struct gmx_pme_t
 
     gmx_bool bUseThreads; /* Does any of the PME ranks have nthread>1 ?  */
     int      nthread;     /* The number of threads doing PME on our rank */
+    bool     useColoredSpread; /* Spread directly on the FFT grid using colored blocks of grid lines */
 
     gmx_bool bPPnode;   /* Node also does particle-particle forces */
     bool     doCoulomb; /* Apply PME to electrostatics */
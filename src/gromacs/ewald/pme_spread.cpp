@@ -297,6 +297,97 @@ static void make_bsplines(splinevec  theta,
     }
 }
 
+
+#if GMX_SIMD_HAVE_REAL
+/*! \brief Computes the B-spline coefficients and derivatives using SIMD over atoms
+ *
+ * Computes the same quantities as make_bsplines(), but for
+ * GMX_SIMD_REAL_WIDTH atoms at once. Splines are computed for all atoms,
+ * including those with zero coefficient.
+ */
+static void make_bsplines_simd(splinevec theta, splinevec dtheta, int order, const rvec fractx[], int nr, const int ind[])
+{
+    using namespace gmx;
+
+    constexpr int c_width = GMX_SIMD_REAL_WIDTH;
+
+    alignas(GMX_SIMD_ALIGNMENT) real drBuffer[c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real thetaBuffer[PME_ORDER_MAX * c_width];
+    alignas(GMX_SIMD_ALIGNMENT) real dthetaBuffer[PME_ORDER_MAX * c_width];
+
+    const SimdReal one(1.0_real);
+
+    for (int iStart = 0; iStart < nr; iStart += c_width)
+    {
+        const int numAtoms = std::min(c_width, nr - iStart);
+
+        for (int j = 0; j < DIM; j++)
+        {
+            for (int a = 0; a < c_width; a++)
+            {
+                drBuffer[a] = (a < numAtoms ? fractx[ind[iStart + a]][j] : 0);
+            }
+            /* dr is relative offset from lower cell limit */
+            const SimdReal dr = load<SimdReal>(drBuffer);
+
+            SimdReal data[PME_ORDER_MAX];
+            for (int k = 2; k < order; k++)
+            {
+                data[k] = setZero();
+            }
+            data[1] = dr;
+            data[0]         = one - dr;
+
+            for (int k = 3; k < order; k++)
+            {
+                const SimdReal div(1.0_real / (k - 1.0_real));
+                data[k - 1] = div * dr * data[k - 2];
+                for (int l = 1; l < k - 1; l++)
+                {
+                    data[k - l - 1] = div
+                                      * ((dr + SimdReal(real(l))) * data[k - l - 2]
+                                         + (SimdReal(real(k - l)) - dr) * data[k - l - 1]);
+                }
+                data[0] = div * (one - dr) * data[0];
+            }
+            /* differentiate */
+            store(dthetaBuffer, -data[0]);
+            for (int k = 1; k < order; k++)
+            {
+                store(dthetaBuffer + k * c_width, data[k - 1] - data[k]);
+            }
+
+            const SimdReal div(1.0_real / (order - 1));
+            data[order - 1] = div * dr * data[order - 2];
+            for (int l = 1; l < order - 1; l++)
+            {
+                data[order - l - 1] = div
+                                      * ((dr + SimdReal(real(l))) * data[order - l - 2]
+                                         + (SimdReal(real(order - l)) - dr) * data[order - l - 1]);
+            }
+            data[0] = div * (one - dr) * data[0];
+
+            for (int k = 0; k < order; k++)
+            {
+                store(thetaBuffer + k * c_width, data[k]);
+            }
+
+            /* Transpose the results to the atom-major layout of the spline data */
+            for (int a = 0; a < numAtoms; a++)
+            {
+                real* thetaAtom  = theta[j] + (iStart + a) * order;
+                real* dthetaAtom = dtheta[j] + (iStart + a) * order;
+                for (int k = 0; k < order; k++)
+                {
+                    thetaAtom[k]  = thetaBuffer[k * c_width + a];
+                    dthetaAtom[k] = dthetaBuffer[k * c_width + a];
+                }
+            }
+        }
+    }
+}
+#endif
+
 #pragma GCC diagnostic pop
 
 /* This has to be a macro to enable full compiler optimization with xlC (and probably others too) */
@@ -840,6 +931,279 @@ static void sum_fftgrid_dd(const gmx_pme_t* pme, real* fftgrid, int grid_index)
     }
 }
 
+/*! \brief Sorts the spline indices on grid line for the gather
+ *
+ * Uses a two-pass counting sort, first on the y and then on the x grid
+ * index, so atoms that interpolate from the same grid lines are gathered
+ * consecutively and the lines are loaded into cache only once.
+ */
+static void sort_spline_on_grid_lines(const gmx_pme_t* pme, const PmeAtomComm* atc, splinedata_t* spline)
+{
+    const int n = spline->n;
+
+    spline->gatherOrder.resize(n);
+    spline->sortWork.resize(n + std::max(pme->pmegrid_nx, pme->pmegrid_ny) + 1);
+
+    int* order  = spline->gatherOrder.data();
+    int* sorted = spline->sortWork.data();
+    int* count  = spline->sortWork.data() + n;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        const int dim        = (pass == 0 ? YY : XX);
+        const int numBuckets = (dim == XX ? pme->pmegrid_nx : pme->pmegrid_ny);
+
+        std::fill_n(count, numBuckets + 1, 0);
+        for (int i = 0; i < n; i++)
+        {
+            const int nn = (pass == 0 ? i : order[i]);
+            count[atc->idx[spline->ind[nn]][dim] + 1]++;
+        }
+        for (int b = 0; b < numBuckets; b++)
+        {
+            count[b + 1] += count[b];
+        }
+        for (int i = 0; i < n; i++)
+        {
+            const int nn = (pass == 0 ? i : order[i]);
+
+            sorted[count[atc->idx[spline->ind[nn]][dim]]++] = nn;
+        }
+        std::copy(sorted, sorted + n, order);
+    }
+}
+
+/*! \brief Returns the number of colored spreading blocks along a grid dimension
+ *
+ * Blocks contain at least \p order grid lines, so an atom spreads at most
+ * onto its own block and the next one. The number is even, so blocks
+ * with equal parity are separated by at least one block, also over
+ * the periodic boundary.
+ */
+static int coloredSpreadNumBlocks(int gridSize, int order)
+{
+    return (gridSize / order) & ~1;
+}
+
+/*! \brief Counts the atoms in each spreading block for the atoms of spline data \p thread */
+static void count_colored_spread_blocks(const gmx_pme_t* pme, PmeAtomComm* atc, const splinedata_t& spline, int thread)
+{
+    PmeColoredSpreadWork& work      = atc->coloredSpreadWork;
+    const int             numBlocks = work.numBlocks[XX] * work.numBlocks[YY];
+    int*                  count     = work.threadBlockCount.data() + thread * numBlocks;
+
+    for (int b = 0; b < numBlocks; b++)
+    {
+        count[b] = 0;
+    }
+    for (int nn = 0; nn < spline.n; nn++)
+    {
+        const int* idxptr = atc->idx[spline.ind[nn]];
+        const int  bx     = idxptr[XX] * work.numBlocks[XX] / pme->nkx;
+        const int  by     = idxptr[YY] * work.numBlocks[YY] / pme->nky;
+        count[bx * work.numBlocks[YY] + by]++;
+    }
+}
+
+/*! \brief Spreads the coefficient of one atom directly onto the periodic FFT grid */
+template<int order>
+static inline void spread_atom_on_fftgrid(real*       fftgrid,
+                                          const ivec  gridSize,
+                                          int         fft_my,
+                                          int         fft_mz,
+                                          const int*  idxptr,
+                                          real        coefficient,
+                                          const real* thx,
+                                          const real* thy,
+                                          const real* thz)
+{
+    int xIndex[order];
+    int yIndex[order];
+    for (int ith = 0; ith < order; ith++)
+    {
+        xIndex[ith] = idxptr[XX] + ith;
+        xIndex[ith] -= (xIndex[ith] >= gridSize[XX] ? gridSize[XX] : 0);
+        yIndex[ith] = idxptr[YY] + ith;
+        yIndex[ith] -= (yIndex[ith] >= gridSize[YY] ? gridSize[YY] : 0);
+    }
+    const int  k0     = idxptr[ZZ];
+    const bool zWraps = (k0 + order > gridSize[ZZ]);
+    int        zIndex[order];
+    for (int ithz = 0; ithz < order; ithz++)
+    {
+        zIndex[ithz] = k0 + ithz - (k0 + ithz >= gridSize[ZZ] ? gridSize[ZZ] : 0);
+    }
+
+    for (int ithx = 0; ithx < order; ithx++)
+    {
+        const real valx = coefficient * thx[ithx];
+        for (int ithy = 0; ithy < order; ithy++)
+        {
+            const real valxy = valx * thy[ithy];
+            real*      line  = fftgrid + (xIndex[ithx] * fft_my + yIndex[ithy]) * fft_mz;
+            if (!zWraps)
+            {
+                for (int ithz = 0; ithz < order; ithz++)
+                {
+                    line[k0 + ithz] += valxy * thz[ithz];
+                }
+            }
+            else
+            {
+                for (int ithz = 0; ithz < order; ithz++)
+                {
+                    line[zIndex[ithz]] += valxy * thz[ithz];
+                }
+            }
+        }
+    }
+}
+
+/*! \brief Spreads the atoms of one block directly onto the FFT grid */
+template<int order>
+static void spread_block_on_fftgrid(const PmeAtomComm* atc,
+                                    int                block,
+                                    real*              fftgrid,
+                                    const ivec         gridSize,
+                                    int                fft_my,
+                                    int                fft_mz)
+{
+    const PmeColoredSpreadWork& work = atc->coloredSpreadWork;
+
+    for (int i = work.blockStart[block]; i < work.blockStart[block + 1]; i++)
+    {
+        const splinedata_t& spline      = atc->spline[work.splineThread[i]];
+        const int           nn          = work.splineIndex[i];
+        const int           n           = spline.ind[nn];
+        const real          coefficient = atc->coefficient[n];
+
+        if (coefficient != 0)
+        {
+            const int norder = nn * order;
+            spread_atom_on_fftgrid<order>(fftgrid, gridSize, fft_my, fft_mz, atc->idx[n], coefficient,
+                                          spline.theta.coefficients[XX] + norder,
+                                          spline.theta.coefficients[YY] + norder,
+                                          spline.theta.coefficients[ZZ] + norder);
+        }
+    }
+}
+
+//! Spreads the atoms of one block for a run-time spline order
+static void spread_block_on_fftgrid(const PmeAtomComm* atc,
+                                    int                order,
+                                    int                block,
+                                    real*              fftgrid,
+                                    const ivec         gridSize,
+                                    int                fft_my,
+                                    int                fft_mz)
+{
+    switch (order)
+    {
+        case 4: spread_block_on_fftgrid<4>(atc, block, fftgrid, gridSize, fft_my, fft_mz); break;
+        case 5: spread_block_on_fftgrid<5>(atc, block, fftgrid, gridSize, fft_my, fft_mz); break;
+        case 6: spread_block_on_fftgrid<6>(atc, block, fftgrid, gridSize, fft_my, fft_mz); break;
+        case 7: spread_block_on_fftgrid<7>(atc, block, fftgrid, gridSize, fft_my, fft_mz); break;
+        case 8: spread_block_on_fftgrid<8>(atc, block, fftgrid, gridSize, fft_my, fft_mz); break;
+        case 9: spread_block_on_fftgrid<9>(atc, block, fftgrid, gridSize, fft_my, fft_mz); break;
+        case 10: spread_block_on_fftgrid<10>(atc, block, fftgrid, gridSize, fft_my, fft_mz); break;
+        case 11: spread_block_on_fftgrid<11>(atc, block, fftgrid, gridSize, fft_my, fft_mz); break;
+        case 12: spread_block_on_fftgrid<12>(atc, block, fftgrid, gridSize, fft_my, fft_mz); break;
+        default: GMX_RELEASE_ASSERT(false, "Unsupported PME order for colored spreading");
+    }
+}
+
+/*! \brief Spreads all atoms directly onto the FFT grid using colored blocks
+ *
+ * The atoms, counted per block by count_colored_spread_blocks(), are sorted
+ * on block. Then the blocks of each of the four colors are spread in
+ * parallel, with a barrier between the colors. This avoids the thread-local
+ * grids and the reduction of their overlap in reduce_threadgrid_overlap().
+ * Only supported with a single PME rank.
+ */
+static void spread_on_fftgrid_colored(const gmx_pme_t* pme, PmeAtomComm* atc, real* fftgrid, int grid_index)
+{
+    ivec local_fft_ndata, local_fft_offset, local_fft_size;
+    gmx_parallel_3dfft_real_limits(pme->pfft_setup[grid_index], local_fft_ndata, local_fft_offset,
+                                   local_fft_size);
+    const int fft_my = local_fft_size[YY];
+    const int fft_mz = local_fft_size[ZZ];
+
+    PmeColoredSpreadWork& work      = atc->coloredSpreadWork;
+    const int             nthread   = pme->nthread;
+    const int             numBlocks = work.numBlocks[XX] * work.numBlocks[YY];
+
+    /* Convert the counts to start indices, ordered on block and then on thread */
+    work.blockStart.resize(numBlocks + 1);
+    int numSorted = 0;
+    for (int b = 0; b < numBlocks; b++)
+    {
+        work.blockStart[b] = numSorted;
+        for (int t = 0; t < nthread; t++)
+        {
+            int&      count      = work.threadBlockCount[t * numBlocks + b];
+            const int numInBlock = count;
+            count                = numSorted;
+            numSorted += numInBlock;
+        }
+    }
+    work.blockStart[numBlocks] = numSorted;
+    work.splineThread.resize(numSorted);
+    work.splineIndex.resize(numSorted);
+
+    const int order = pme->pme_order;
+
+#pragma omp parallel num_threads(nthread)
+    {
+        try
+        {
+            /* Sort the atoms on block */
+#pragma omp for schedule(static)
+            for (int thread = 0; thread < nthread; thread++)
+            {
+                const splinedata_t& spline = atc->spline[thread];
+                int*                start  = work.threadBlockCount.data() + thread * numBlocks;
+                for (int nn = 0; nn < spline.n; nn++)
+                {
+                    const int* idxptr = atc->idx[spline.ind[nn]];
+                    const int  bx     = idxptr[XX] * work.numBlocks[XX] / pme->nkx;
+                    const int  by     = idxptr[YY] * work.numBlocks[YY] / pme->nky;
+                    const int  i      = start[bx * work.numBlocks[YY] + by]++;
+
+                    work.splineThread[i] = thread;
+                    work.splineIndex[i]  = nn;
+                }
+            }
+
+            /* Clear the FFT grid */
+#pragma omp for schedule(static)
+            for (int x = 0; x < local_fft_ndata[XX]; x++)
+            {
+                std::fill_n(fftgrid + x * fft_my * fft_mz, fft_my * fft_mz, 0.0_real);
+            }
+
+            /* Spread all blocks, one color at a time; the implicit barrier
+             * at the end of each loop separates the colors.
+             */
+            for (int color = 0; color < 4; color++)
+            {
+                const int parityX         = color / 2;
+                const int parityY         = color % 2;
+                const int numColorBlocksY = work.numBlocks[YY] / 2;
+                const int numColorBlocks  = work.numBlocks[XX] / 2 * numColorBlocksY;
+#pragma omp for schedule(dynamic)
+                for (int colorBlock = 0; colorBlock < numColorBlocks; colorBlock++)
+                {
+                    const int bx = 2 * (colorBlock / numColorBlocksY) + parityX;
+                    const int by = 2 * (colorBlock % numColorBlocksY) + parityY;
+                    spread_block_on_fftgrid(atc, order, bx * work.numBlocks[YY] + by, fftgrid,
+                                            local_fft_ndata, fft_my, fft_mz);
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
 void spread_on_grid(const gmx_pme_t*  pme,
                     PmeAtomComm*      atc,
                     const pmegrids_t* grids,
@@ -888,6 +1252,14 @@ void spread_on_grid(const gmx_pme_t*  pme,
     cs1 += (double)c1;
 #endif
 
+    if (bSpread && pme->useColoredSpread)
+    {
+        PmeColoredSpreadWork& work = atc->coloredSpreadWork;
+        work.numBlocks[XX]         = coloredSpreadNumBlocks(pme->nkx, pme->pme_order);
+        work.numBlocks[YY]         = coloredSpreadNumBlocks(pme->nky, pme->pme_order);
+        work.threadBlockCount.resize(nthread * work.numBlocks[XX] * work.numBlocks[YY]);
+    }
+
 #ifdef PME_TIME_THREADS
     c2 = omp_cyc_start();
 #endif
@@ -923,12 +1295,32 @@ void spread_on_grid(const gmx_pme_t*  pme,
 
             if (bCalcSplines)
             {
-                make_bsplines(spline->theta.coefficients, spline->dtheta.coefficients,
-                              pme->pme_order, as_rvec_array(atc->fractx.data()), spline->n,
-                              spline->ind.data(), atc->coefficient.data(), bDoSplines);
+#if GMX_SIMD_HAVE_REAL
+                if (pme->useColoredSpread)
+                {
+                    make_bsplines_simd(spline->theta.coefficients, spline->dtheta.coefficients,
+                                       pme->pme_order, as_rvec_array(atc->fractx.data()), spline->n,
+                                       spline->ind.data());
+                }
+                else
+#endif
+                {
+                    make_bsplines(spline->theta.coefficients, spline->dtheta.coefficients,
+                                  pme->pme_order, as_rvec_array(atc->fractx.data()), spline->n,
+                                  spline->ind.data(), atc->coefficient.data(), bDoSplines);
+                }
+
+                if (grids != nullptr)
+                {
+                    sort_spline_on_grid_lines(pme, atc, spline);
+                }
             }
 
-            if (bSpread)
+            if (bSpread && pme->useColoredSpread)
+            {
+                count_colored_spread_blocks(pme, atc, *spline, thread);
+            }
+            else if (bSpread)
             {
                 /* put local atoms on grid. */
                 const pmegrid_t* grid = pme->bUseThreads ? &grids->grid_th[thread] : &grids->grid;
@@ -955,7 +1347,11 @@ void spread_on_grid(const gmx_pme_t*  pme,
     cs2 += (double)c2;
 #endif
 
-    if (bSpread && pme->bUseThreads)
+    if (bSpread && pme->useColoredSpread)
+    {
+        spread_on_fftgrid_colored(pme, atc, fftgrid, grid_index);
+    }
+    else if (bSpread && pme->bUseThreads)
     {
 #ifdef PME_TIME_THREADS
         c3 = omp_cyc_start();
@@ -0,0 +1,260 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that colored PME spreading directly on the FFT grid, enabled with
+ * GMX_PME_COLORED_SPREAD, gives the same splines and grid as the default
+ * multi-threaded spreading.
+ *
+ * \ingroup module_ewald
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/ewald/pme_internal.h"
+#include "gromacs/fft/parallel_3dfft.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/setenv.h"
+#include "testutils/testasserts.h"
+
+#include "pmetestcommon.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The spline data of all threads and the real grid after spreading
+struct SpreadOutput
+{
+    //! The atom indices of the spline data, per thread
+    std::vector<std::vector<int>> splineIndices;
+    //! The spline values, per thread and dimension
+    std::vector<std::array<std::vector<real>, DIM>> theta;
+    //! The spline derivatives, per thread and dimension
+    std::vector<std::array<std::vector<real>, DIM>> dtheta;
+    //! The real grid without padding, in x-major order
+    std::vector<real> grid;
+};
+
+//! A triclinic box
+const Matrix3x3 c_box = { { 3.0F, 0.0F, 0.0F, 0.5F, 3.5F, 0.0F, 0.2F, 0.3F, 4.0F } };
+
+/*! \brief Generates \p numAtoms coordinates in the unit cell and charges
+ *
+ * Every seventh charge is zero, as the spreading skips those atoms.
+ */
+void generateAtoms(int numAtoms, CoordinatesVector* coordinates, std::vector<real>* charges)
+{
+    DefaultRandomEngine           rng(1234);
+    UniformRealDistribution<real> fraction(0, 1);
+    UniformRealDistribution<real> charge(-1, 1);
+
+    coordinates->resize(numAtoms);
+    charges->resize(numAtoms);
+    for (int a = 0; a < numAtoms; a++)
+    {
+        const real fx = fraction(rng);
+        const real fy = fraction(rng);
+        const real fz = fraction(rng);
+        for (int d = 0; d < DIM; d++)
+        {
+            (*coordinates)[a][d] = fx * c_box[XX * DIM + d] + fy * c_box[YY * DIM + d]
+                                   + fz * c_box[ZZ * DIM + d];
+        }
+        (*charges)[a] = (a % 7 == 0) ? 0 : charge(rng);
+    }
+}
+
+/*! \brief Computes splines and spreads on the grid with \p numThreads threads
+ *
+ * With \p useColoredSpread the colored mode is requested through the
+ * environment variable, which is checked to have taken effect.
+ */
+SpreadOutput computeSpread(const t_inputrec&        inputRec,
+                           const int                numThreads,
+                           const bool               useColoredSpread,
+                           const CoordinatesVector& coordinates,
+                           const std::vector<real>& charges)
+{
+    if (useColoredSpread)
+    {
+        gmxSetenv("GMX_PME_COLORED_SPREAD", "1", 1);
+    }
+    PmeSafePointer pmeSafe =
+            pmeInitWrapper(&inputRec, CodePath::CPU, nullptr, nullptr, c_box, 1.0F, 1.0F, numThreads);
+    gmxUnsetenv("GMX_PME_COLORED_SPREAD");
+    gmx_pme_t* pme = pmeSafe.get();
+    EXPECT_EQ(useColoredSpread, pme->useColoredSpread);
+
+    pmeInitAtoms(pme, nullptr, CodePath::CPU, coordinates, charges);
+    pmePerformSplineAndSpread(pme, CodePath::CPU, true, true);
+
+    SpreadOutput       output;
+    const PmeAtomComm& atc   = pme->atc[0];
+    const int          order = pme->pme_order;
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        const splinedata_t& spline = atc.spline[thread];
+        output.splineIndices.emplace_back(spline.ind.begin(), spline.ind.begin() + spline.n);
+        output.theta.emplace_back();
+        output.dtheta.emplace_back();
+        for (int d = 0; d < DIM; d++)
+        {
+            output.theta.back()[d].assign(spline.theta.coefficients[d],
+                                          spline.theta.coefficients[d] + spline.n * order);
+            output.dtheta.back()[d].assign(spline.dtheta.coefficients[d],
+                                           spline.dtheta.coefficients[d] + spline.n * order);
+        }
+    }
+
+    IVec gridSize, gridOffsetUnused, paddedGridSize;
+    gmx_parallel_3dfft_real_limits(pme->pfft_setup[0], gridSize, gridOffsetUnused, paddedGridSize);
+    for (int x = 0; x < gridSize[XX]; x++)
+    {
+        for (int y = 0; y < gridSize[YY]; y++)
+        {
+            const real* line = pme->fftgrid[0] + (x * paddedGridSize[YY] + y) * paddedGridSize[ZZ];
+            output.grid.insert(output.grid.end(), line, line + gridSize[ZZ]);
+        }
+    }
+
+    return output;
+}
+
+/*! \brief Convenience typedef of test parameters - PME order, grid dimensions, number of threads
+ *
+ * The grid sizes give at least two blocks along x and y, with grid lines
+ * that are not divided evenly over the blocks.
+ */
+typedef std::tuple<int, IVec, int> ColoredSpreadParameters;
+
+//! Test fixture for comparing colored spreading with the default spreading
+class PmeColoredSpreadTest : public ::testing::TestWithParam<ColoredSpreadParameters>
+{
+};
+
+TEST_P(PmeColoredSpreadTest, MatchesDefaultSpread)
+{
+    int  pmeOrder;
+    IVec gridSize;
+    int  numThreads;
+    std::tie(pmeOrder, gridSize, numThreads) = GetParam();
+
+    t_inputrec inputRec;
+    inputRec.nkx         = gridSize[XX];
+    inputRec.nky         = gridSize[YY];
+    inputRec.nkz         = gridSize[ZZ];
+    inputRec.pme_order   = pmeOrder;
+    inputRec.coulombtype = eelPME;
+    inputRec.epsilon_r   = 1.0;
+
+    SCOPED_TRACE(formatString("PME order %d, grid size %d %d %d, %d threads", pmeOrder,
+                              gridSize[XX], gridSize[YY], gridSize[ZZ], numThreads));
+
+    CoordinatesVector coordinates;
+    std::vector<real> charges;
+    generateAtoms(300, &coordinates, &charges);
+
+    const SpreadOutput reference = computeSpread(inputRec, numThreads, false, coordinates, charges);
+    const SpreadOutput colored   = computeSpread(inputRec, numThreads, true, coordinates, charges);
+
+    /* The SIMD splines use the same recursion, but may differ by FMA
+     * contraction, so use the tolerance of the spline-spread test.
+     */
+    const int maxGridSize = std::max(std::max(gridSize[XX], gridSize[YY]), gridSize[ZZ]);
+    const FloatingPointTolerance splineTolerance =
+            relativeToleranceAsUlp(1.0, 4 * (pmeOrder - 2) * maxGridSize);
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        ASSERT_EQ(reference.splineIndices[thread], colored.splineIndices[thread])
+                << "for thread " << thread;
+        for (int d = 0; d < DIM; d++)
+        {
+            for (size_t i = 0; i < reference.theta[thread][d].size(); i++)
+            {
+                EXPECT_REAL_EQ_TOL(reference.theta[thread][d][i], colored.theta[thread][d][i],
+                                   splineTolerance)
+                        << "theta for thread " << thread << " dimension " << d << " index " << i;
+                EXPECT_REAL_EQ_TOL(reference.dtheta[thread][d][i], colored.dtheta[thread][d][i],
+                                   splineTolerance)
+                        << "dtheta for thread " << thread << " dimension " << d << " index " << i;
+            }
+        }
+    }
+
+    /* The grid values are sums over atoms in a different order,
+     * so compare relative to the largest grid value.
+     */
+    real maxGridValue = 0;
+    for (const real value : reference.grid)
+    {
+        maxGridValue = std::max(maxGridValue, std::fabs(value));
+    }
+    ASSERT_GT(maxGridValue, 0);
+    const FloatingPointTolerance gridTolerance =
+            relativeToleranceAsPrecisionDependentFloatingPoint(maxGridValue, 1e-5, 1e-10);
+    ASSERT_EQ(reference.grid.size(), colored.grid.size());
+    for (size_t i = 0; i < reference.grid.size(); i++)
+    {
+        EXPECT_REAL_EQ_TOL(reference.grid[i], colored.grid[i], gridTolerance)
+                << "for grid point " << i;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(SaneInput,
+                        PmeColoredSpreadTest,
+                        ::testing::Combine(::testing::Values(4, 5, 8),
+                                           ::testing::Values(IVec{ 18, 21, 16 }, IVec{ 26, 17, 19 }),
+                                           ::testing::Values(2, 4)));
+
+} // namespace
+} // namespace test
+} // namespace gmx
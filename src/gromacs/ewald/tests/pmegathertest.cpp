@@ -43,6 +43,7 @@
 #include "gmxpre.h"
 
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
@@ -73,6 +74,8 @@ std::vector<Matrix3x3> const c_sampleBoxes{
 
 //! A couple of valid inputs for grid sizes
 std::vector<IVec> const c_sampleGridSizes{ IVec{ 16, 12, 14 }, IVec{ 13, 15, 11 } };
+//! A valid grid size for high PME orders, which need at least 2*(order-1) grid points in each dimension
+std::vector<IVec> const c_sampleGridSizesHighOrder{ IVec{ 22, 24, 23 } };
 //! Random charges
 std::vector<real> const c_sampleChargesFull{ 4.95F, 3.11F, 3.97F, 1.08F, 2.09F, 1.1F,
                                              4.13F, 3.31F, 2.8F,  5.83F, 5.09F, 6.1F,
@@ -89,7 +92,7 @@ std::vector<IVec> const c_sampleGridLineIndicesFull{
 // Spline values/derivatives below are also generated randomly, so they are bogus,
 // but that should not affect the reproducibility, which we're after
 
-//! A lot of bogus input spline values - should have at list (max PME order = 5) * (DIM = 3) * (total unique atom number in all test cases = 16) values
+//! A lot of bogus input spline values - should have at least (max PME order = 12) * (DIM = 3) * (max atom count = 13) values
 std::vector<real> const c_sampleSplineValuesFull{
     0.12F, 0.81F, 0.29F, 0.22F, 0.13F, 0.19F, 0.12F, 0.8F,  0.44F, 0.38F, 0.32F, 0.36F, 0.27F,
     0.11F, 0.17F, 0.94F, 0.07F, 0.9F,  0.98F, 0.96F, 0.07F, 0.94F, 0.77F, 0.24F, 0.84F, 0.16F,
@@ -114,10 +117,21 @@ std::vector<real> const c_sampleSplineValuesFull{
     0.34F, 0.66F, 0.02F, 0.47F, 0.78F, 0.21F, 0.02F, 0.18F, 0.42F, 0.2F,  0.46F, 0.34F, 0.4F,
     0.46F, 0.96F, 0.86F, 0.25F, 0.25F, 0.22F, 0.37F, 0.59F, 0.19F, 0.45F, 0.61F, 0.04F, 0.71F,
     0.77F, 0.51F, 0.77F, 0.15F, 0.78F, 0.36F, 0.62F, 0.24F, 0.86F, 0.2F,  0.77F, 0.08F, 0.09F,
-    0.3F,  0.0F,  0.6F,  0.99F, 0.69F,
+    0.3F,  0.0F,  0.6F,  0.99F, 0.69F, 0.79F, 0.79F, 0.22F, 0.85F, 0.98F, 0.59F, 0.56F, 0.6F,
+    0.47F, 0.53F, 0.69F, 0.2F,  0.79F, 0.11F, 0.58F, 0.3F,  0.26F, 0.52F, 0.85F, 0.26F, 0.77F,
+    0.19F, 0.6F,  0.57F, 0.13F, 0.9F,  0.85F, 0.2F,  0.62F, 0.79F, 0.68F, 0.95F, 0.6F,  0.05F,
+    0.56F, 0.06F, 0.44F, 0.27F, 0.15F, 0.68F, 0.88F, 0.11F, 0.78F, 0.33F, 0.96F, 0.19F, 0.03F,
+    0.82F, 0.69F, 0.38F, 0.59F, 0.3F,  0.39F, 0.64F, 0.82F, 0.8F,  0.58F, 0.31F, 0.65F, 0.05F,
+    0.78F, 0.66F, 0.79F, 0.86F, 0.3F,  0.93F, 0.31F, 0.72F, 0.37F, 0.37F, 0.16F, 0.92F, 0.54F,
+    0.49F, 0.79F, 0.98F, 0.37F, 0.2F,  0.91F, 0.57F, 0.44F, 0.8F,  0.12F, 0.11F, 0.3F,  0.72F,
+    0.3F,  0.7F,  0.69F, 0.64F, 0.81F, 0.05F, 0.64F, 0.12F, 0.17F, 0.07F, 0.45F, 0.31F, 0.71F,
+    0.58F, 0.9F,  0.13F, 0.54F, 0.8F,  0.29F, 0.62F, 0.43F, 0.86F, 0.56F, 0.1F,  0.25F, 0.4F,
+    0.44F, 0.03F, 0.66F, 0.61F, 0.76F, 0.8F,  0.78F, 0.96F, 0.76F, 0.82F, 0.68F, 0.96F, 0.51F,
+    0.5F,  0.84F, 0.32F, 0.85F, 0.91F, 0.81F, 0.08F, 0.4F,  0.14F, 0.61F, 0.76F, 0.5F,  0.68F,
+    0.46F, 0.29F, 0.76F, 0.95F, 0.03F, 0.51F, 0.85F, 0.15F, 0.35F, 0.65F, 0.42F, 0.78F, 0.57F,
 };
 
-//! A lot of bogus input spline derivatives - should have at list (max PME order = 5) * (DIM = 3) * (total unique atom number in all test cases = 16) values
+//! A lot of bogus input spline derivatives - should have at least (max PME order = 12) * (DIM = 3) * (max atom count = 13) values
 std::vector<real> const c_sampleSplineDerivativesFull{
     0.82F, 0.88F, 0.83F, 0.11F, 0.93F, 0.32F, 0.71F, 0.37F, 0.69F, 0.88F, 0.11F, 0.38F, 0.25F,
     0.5F,  0.36F, 0.81F, 0.78F, 0.31F, 0.66F, 0.32F, 0.27F, 0.35F, 0.53F, 0.83F, 0.08F, 0.08F,
@@ -142,7 +156,18 @@ std::vector<real> const c_sampleSplineDerivativesFull{
     0.9F,  0.55F, 0.97F, 1.0F,  0.23F, 0.46F, 0.52F, 0.49F, 0.0F,  0.32F, 0.16F, 0.4F,  0.62F,
     0.36F, 0.03F, 0.63F, 0.16F, 0.58F, 0.97F, 0.03F, 0.44F, 0.07F, 0.22F, 0.75F, 0.32F, 0.61F,
     0.94F, 0.33F, 0.7F,  0.57F, 0.5F,  0.84F, 0.7F,  0.47F, 0.18F, 0.09F, 0.25F, 0.77F, 0.94F,
-    0.85F, 0.09F, 0.83F, 0.02F, 0.91F,
+    0.85F, 0.09F, 0.83F, 0.02F, 0.91F, 0.44F, 0.11F, 0.67F, 0.16F, 0.92F, 0.52F, 0.03F, 0.01F,
+    0.63F, 0.18F, 0.68F, 0.49F, 0.02F, 0.08F, 0.25F, 0.12F, 0.35F, 0.64F, 0.65F, 0.58F, 0.32F,
+    0.21F, 0.99F, 0.54F, 0.3F,  0.0F,  0.57F, 0.89F, 0.44F, 0.11F, 0.79F, 0.75F, 0.94F, 0.31F,
+    0.89F, 0.85F, 0.56F, 0.97F, 0.82F, 0.68F, 0.76F, 0.36F, 0.49F, 0.24F, 0.51F, 0.71F, 0.75F,
+    0.48F, 0.61F, 0.94F, 0.28F, 0.85F, 0.17F, 0.45F, 0.08F, 0.75F, 0.9F,  0.56F, 0.5F,  0.63F,
+    0.69F, 0.51F, 0.38F, 0.92F, 0.09F, 0.93F, 0.7F,  0.55F, 0.67F, 0.56F, 0.41F, 0.78F, 0.47F,
+    0.27F, 0.19F, 0.56F, 0.56F, 0.34F, 0.52F, 0.4F,  0.47F, 0.99F, 0.6F,  0.36F, 0.58F, 0.46F,
+    0.7F,  0.27F, 0.92F, 0.41F, 0.83F, 0.65F, 0.7F,  0.71F, 0.6F,  0.48F, 0.11F, 0.31F, 0.75F,
+    0.41F, 0.48F, 0.52F, 0.89F, 0.46F, 0.77F, 0.34F, 0.57F, 0.42F, 0.03F, 0.17F, 0.66F, 0.88F,
+    0.78F, 0.07F, 0.59F, 0.66F, 0.01F, 0.48F, 0.69F, 0.23F, 0.3F,  0.94F, 0.42F, 0.57F, 0.17F,
+    0.83F, 0.86F, 0.64F, 0.84F, 0.57F, 0.44F, 0.96F, 0.76F, 0.71F, 0.91F, 0.93F, 0.49F, 0.99F,
+    0.94F, 0.26F, 0.97F, 0.73F, 0.43F, 0.32F, 0.04F, 0.55F, 0.36F, 0.61F, 0.15F, 0.68F, 0.28F,
 };
 
 //! 2 c_sample grids - only non-zero values have to be listed
@@ -178,6 +203,8 @@ std::vector<RVec> const c_sampleForcesFull{
 
 //! PME orders to test
 std::vector<int> const pmeOrders{ 3, 4, 5 };
+//! High PME orders to test, up to the maximum supported order, with c_sampleGridSizesHighOrder
+std::vector<int> const highPmeOrders{ 8, 12 };
 //! Atom counts to test
 std::vector<size_t> const atomCounts{ 1, 2, 13 };
 
@@ -238,7 +265,9 @@ public:
             start += atomCount;
             atomData.coordinates.resize(atomCount, RVec{ 1e6, 1e7, -1e8 });
             /* The coordinates are intentionally bogus in this test - only the size matters; the gridline indices are fed directly as inputs */
-            for (auto pmeOrder : pmeOrders)
+            std::vector<int> allPmeOrders(pmeOrders);
+            allPmeOrders.insert(allPmeOrders.end(), highPmeOrders.begin(), highPmeOrders.end());
+            for (auto pmeOrder : allPmeOrders)
             {
                 AtomAndPmeOrderSizedData splineData;
                 const size_t             dimSize = atomCount * pmeOrder;
@@ -335,6 +364,85 @@ public:
             forceChecker.checkSequence(forces.begin(), forces.end(), "Forces");
         }
     }
+    //! Checks that the fused Coulomb and LJ gather gives the same forces as two separate gathers
+    void runFusedCoulombAndLJTest()
+    {
+        /* Getting the input */
+        Matrix3x3                 box;
+        int                       pmeOrder;
+        IVec                      gridSize;
+        size_t                    atomCount;
+        SparseRealGridValuesInput nonZeroGridValues;
+        PmeForceOutputHandling    inputForceTreatment;
+        std::tie(box, pmeOrder, gridSize, nonZeroGridValues, inputForceTreatment, atomCount) = GetParam();
+        auto inputAtomData       = s_inputAtomDataSets_[atomCount];
+        auto inputAtomSplineData = inputAtomData.splineDataByPmeOrder[pmeOrder];
+
+        /* The LJ grid mirrors the Coulomb grid, the LJ coefficients are the charges in reverse */
+        SparseRealGridValuesInput nonZeroGridValuesLJ;
+        for (const auto& gridValue : nonZeroGridValues)
+        {
+            const IVec mirroredIndex(gridSize[XX] - 1 - gridValue.first[XX],
+                                     gridSize[YY] - 1 - gridValue.first[YY],
+                                     gridSize[ZZ] - 1 - gridValue.first[ZZ]);
+            nonZeroGridValuesLJ[mirroredIndex] = -0.5F * gridValue.second;
+        }
+        std::vector<real> coefficientsLJ(inputAtomData.charges.rbegin(), inputAtomData.charges.rend());
+
+        t_inputrec inputRec;
+        inputRec.nkx                    = gridSize[XX];
+        inputRec.nky                    = gridSize[YY];
+        inputRec.nkz                    = gridSize[ZZ];
+        inputRec.pme_order              = pmeOrder;
+        inputRec.coulombtype            = eelPME;
+        inputRec.vdwtype                = evdwPME;
+        inputRec.ljpme_combination_rule = eljpmeGEOM;
+        inputRec.epsilon_r              = 1.0;
+
+        /* The fused gather is only implemented for the CPU */
+        const CodePath codePath = CodePath::CPU;
+        SCOPED_TRACE(formatString("Testing fused Coulomb and LJ force gathering for PME grid size %d %d %d"
+                                  ", order %d, %zu atoms, %s",
+                                  gridSize[XX], gridSize[YY], gridSize[ZZ], pmeOrder, atomCount,
+                                  (inputForceTreatment == PmeForceOutputHandling::ReduceWithInput)
+                                          ? "with reduction"
+                                          : "without reduction"));
+
+        std::vector<RVec> forcesByVariant[2];
+        for (const bool fuseGathers : { false, true })
+        {
+            PmeSafePointer pmeSafe = pmeInitWrapper(&inputRec, codePath, nullptr, nullptr, box);
+            pmeInitAtoms(pmeSafe.get(), nullptr, codePath, inputAtomData.coordinates,
+                         inputAtomData.charges);
+            pmeSetRealGrid(pmeSafe.get(), codePath, nonZeroGridValues);
+            pmeSetGridLineIndices(pmeSafe.get(), codePath, inputAtomData.gridLineIndices);
+            for (int dimIndex = 0; dimIndex < DIM; dimIndex++)
+            {
+                pmeSetSplineData(pmeSafe.get(), codePath, inputAtomSplineData.splineValues[dimIndex],
+                                 PmeSplineDataType::Values, dimIndex);
+                pmeSetSplineData(pmeSafe.get(), codePath, inputAtomSplineData.splineDerivatives[dimIndex],
+                                 PmeSplineDataType::Derivatives, dimIndex);
+            }
+
+            std::vector<RVec>& forcesStorage = forcesByVariant[fuseGathers ? 1 : 0];
+            forcesStorage.assign(c_sampleForcesFull.begin(), c_sampleForcesFull.begin() + atomCount);
+            ForcesVector forces(forcesStorage);
+            pmePerformGatherCoulombAndLJ(pmeSafe.get(), inputForceTreatment, nonZeroGridValuesLJ,
+                                         coefficientsLJ, fuseGathers, forces);
+            pmeFinalizeTest(pmeSafe.get(), codePath);
+        }
+
+        const auto ulpTolerance = 3 * pmeOrder;
+        for (size_t i = 0; i < atomCount; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_REAL_EQ_TOL(forcesByVariant[0][i][d], forcesByVariant[1][i][d],
+                                   relativeToleranceAsUlp(1.0, ulpTolerance))
+                        << "for atom " << i << " and dimension " << d;
+            }
+        }
+    }
 };
 
 // An instance of static atom data
@@ -346,6 +454,12 @@ TEST_P(PmeGatherTest, ReproducesOutputs)
     EXPECT_NO_THROW(runTest());
 }
 
+//! Test for fusing the PME Coulomb and LJ force gathering
+TEST_P(PmeGatherTest, FusedCoulombAndLJMatchesSeparateGathers)
+{
+    EXPECT_NO_THROW(runFusedCoulombAndLJTest());
+}
+
 //! Instantiation of the PME gathering test
 INSTANTIATE_TEST_CASE_P(SaneInput,
                         PmeGatherTest,
@@ -357,6 +471,17 @@ INSTANTIATE_TEST_CASE_P(SaneInput,
                                                              PmeForceOutputHandling::ReduceWithInput),
                                            ::testing::ValuesIn(atomCounts)));
 
+//! Instantiation of the PME gathering test for high orders, which need larger grids
+INSTANTIATE_TEST_CASE_P(HighOrder,
+                        PmeGatherTest,
+                        ::testing::Combine(::testing::ValuesIn(c_sampleBoxes),
+                                           ::testing::ValuesIn(highPmeOrders),
+                                           ::testing::ValuesIn(c_sampleGridSizesHighOrder),
+                                           ::testing::ValuesIn(c_sampleGrids),
+                                           ::testing::Values(PmeForceOutputHandling::Set,
+                                                             PmeForceOutputHandling::ReduceWithInput),
+                                           ::testing::ValuesIn(atomCounts)));
+
 } // namespace
 } // namespace test
 } // namespace gmx
@@ -107,7 +107,8 @@ PmeSafePointer pmeInitWrapper(const t_inputrec*        inputRec,
                               PmeGpuProgramHandle      pmeGpuProgram,
                               const Matrix3x3&         box,
                               const real               ewaldCoeff_q,
-                              const real               ewaldCoeff_lj)
+                              const real               ewaldCoeff_lj,
+                              const int                numThreads)
 {
     const MDLogger dummyLogger;
     const auto     runMode       = (mode == CodePath::CPU) ? PmeRunMode::CPU : PmeRunMode::Mixed;
@@ -115,7 +116,8 @@ PmeSafePointer pmeInitWrapper(const t_inputrec*        inputRec,
     NumPmeDomains  numPmeDomains = { 1, 1 };
     gmx_pme_t*     pmeDataRaw =
             gmx_pme_init(&dummyCommrec, numPmeDomains, inputRec, false, false, true, ewaldCoeff_q,
-                         ewaldCoeff_lj, 1, runMode, nullptr, gpuInfo, pmeGpuProgram, dummyLogger);
+                         ewaldCoeff_lj, numThreads, runMode, nullptr, gpuInfo, pmeGpuProgram,
+                         dummyLogger);
     PmeSafePointer pme(pmeDataRaw); // taking ownership
 
     // TODO get rid of this with proper matrix type
@@ -585,6 +587,70 @@ void pmeSetComplexGrid(const gmx_pme_t*                    pme,
     pmeSetGridInternal<t_complex>(pme, mode, gridOrdering, gridValues);
 }
 
+//! PME force gathering from the Coulomb and the LJ grid, either fused or as two separate gathers
+void pmePerformGatherCoulombAndLJ(gmx_pme_t*                       pme,
+                                  PmeForceOutputHandling           inputTreatment,
+                                  const SparseRealGridValuesInput& gridValuesLJ,
+                                  const ChargesVector&             coefficientsLJ,
+                                  bool                             fuseGathers,
+                                  ForcesVector&                    forces)
+{
+    PmeAtomComm* atc       = &(pme->atc[0]);
+    const index  atomCount = atc->numAtoms();
+    GMX_RELEASE_ASSERT(forces.ssize() == atomCount, "Invalid force buffer size");
+    GMX_RELEASE_ASSERT(coefficientsLJ.ssize() == atomCount, "Invalid LJ coefficient buffer size");
+    GMX_RELEASE_ASSERT(pme->doLJ, "PME should be initialized with LJ-PME");
+    const bool   forceReductionWithInput = (inputTreatment == PmeForceOutputHandling::ReduceWithInput);
+    const size_t threadIndex             = 0;
+
+    /* The Coulomb grid has been set with pmeSetRealGrid(), the LJ grid is set here */
+    IVec gridSize, gridOffsetUnused, paddedGridSize;
+    gmx_parallel_3dfft_real_limits(pme->pfft_setup[PME_GRID_C6A], gridSize, gridOffsetUnused,
+                                   paddedGridSize);
+    real* fftgridLJ = pme->fftgrid[PME_GRID_C6A];
+    std::memset(fftgridLJ, 0,
+                paddedGridSize[XX] * paddedGridSize[YY] * paddedGridSize[ZZ] * sizeof(real));
+    for (const auto& gridValue : gridValuesLJ)
+    {
+        for (int i = 0; i < DIM; i++)
+        {
+            GMX_RELEASE_ASSERT((0 <= gridValue.first[i]) && (gridValue.first[i] < gridSize[i]),
+                               "Invalid grid value index");
+        }
+        fftgridLJ[pmeGetGridPlainIndexInternal(gridValue.first, paddedGridSize, GridOrdering::XYZ)] =
+                gridValue.second;
+    }
+
+    atc->f = forces;
+    if (atc->nthread == 1)
+    {
+        // something which is normally done in serial spline computation (make_thread_local_ind())
+        atc->spline[threadIndex].n = atomCount;
+    }
+    for (const int gridIndex : { PME_GRID_QA, PME_GRID_C6A })
+    {
+        real* pmegrid = pme->pmegrid[gridIndex].grid.grid;
+        copy_fftgrid_to_pmegrid(pme, pme->fftgrid[gridIndex], pmegrid, gridIndex, pme->nthread, threadIndex);
+        unwrap_periodic_pmegrid(pme, pmegrid);
+    }
+    const real* gridQ  = pme->pmegrid[PME_GRID_QA].grid.grid;
+    const real* gridLJ = pme->pmegrid[PME_GRID_C6A].grid.grid;
+
+    if (fuseGathers)
+    {
+        gather_f_bsplines_q_lj(pme, gridQ, gridLJ, !forceReductionWithInput, atc,
+                               atc->coefficient.data(), coefficientsLJ.data(), &atc->spline[threadIndex]);
+    }
+    else
+    {
+        const ChargesVector charges = atc->coefficient;
+        gather_f_bsplines(pme, gridQ, !forceReductionWithInput, atc, &atc->spline[threadIndex], 1.0);
+        atc->coefficient = coefficientsLJ;
+        gather_f_bsplines(pme, gridLJ, false, atc, &atc->spline[threadIndex], 1.0);
+        atc->coefficient = charges;
+    }
+}
+
 //! Getting the single dimension's spline values or derivatives
 SplineParamsDimVector pmeGetSplineData(const gmx_pme_t* pme, CodePath mode, PmeSplineDataType type, int dimIndex)
 {
@@ -118,14 +118,15 @@ uint64_t getSplineModuliDoublePrecisionUlps(int splineOrder);
 
 // PME stages
 
-//! PME initialization
+//! PME initialization, \p numThreads is the number of OpenMP threads for PME on the CPU
 PmeSafePointer pmeInitWrapper(const t_inputrec*        inputRec,
                               CodePath                 mode,
                               const gmx_device_info_t* gpuInfo,
                               PmeGpuProgramHandle      pmeGpuProgram,
                               const Matrix3x3&         box,
                               real                     ewaldCoeff_q  = 1.0F,
-                              real                     ewaldCoeff_lj = 1.0F);
+                              real                     ewaldCoeff_lj = 1.0F,
+                              int                      numThreads    = 1);
 //! Simple PME initialization (no atom data)
 PmeSafePointer pmeInitEmpty(const t_inputrec*        inputRec,
                             CodePath                 mode          = CodePath::CPU,
@@ -156,6 +157,13 @@ void pmePerformGather(gmx_pme_t*             pme,
                       CodePath               mode,
                       PmeForceOutputHandling inputTreatment,
                       ForcesVector&          forces); //NOLINT(google-runtime-references)
+//! PME force gathering from the Coulomb and the LJ grid, either fused or as two separate gathers
+void pmePerformGatherCoulombAndLJ(gmx_pme_t*                       pme,
+                                  PmeForceOutputHandling           inputTreatment,
+                                  const SparseRealGridValuesInput& gridValuesLJ,
+                                  const ChargesVector&             coefficientsLJ,
+                                  bool                             fuseGathers,
+                                  ForcesVector& forces); //NOLINT(google-runtime-references)
 //! PME test finalization before fetching the outputs
 void pmeFinalizeTest(const gmx_pme_t* pme, CodePath mode);
 
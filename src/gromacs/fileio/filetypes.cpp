@@ -137,6 +137,7 @@ static const t_deffile deffile[efNR] = {
     { eftASC, ".edi", "sam", nullptr, "ED sampling input" },
     { eftASC, ".cub", "pot", nullptr, "Gaussian cube file" },
     { eftASC, ".xpm", "root", nullptr, "X PixMap compatible matrix file" },
+    { eftASC, ".csv", "bench", nullptr, "Comma-separated values file" },
     { eftASC, "", "rundir", nullptr, "Run directory" }
 };
 
@@ -83,6 +83,7 @@ enum GromacsFileType
     efEDI,
     efCUB,
     efXPM,
+    efCSV,
     efRND,
     efNR
 };
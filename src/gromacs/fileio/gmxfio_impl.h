@@ -54,6 +54,8 @@
 
    WARNING WARNING WARNING WARNING */
 
+#include <vector>
+
 #include "thread_mpi/lock.h"
 
 #include "gromacs/fileio/xdrf.h"
@@ -75,6 +77,8 @@ struct t_fileio
                               for performance reasons: in some cases every
                               single byte that gets read/written requires
                               a lock */
+    std::vector<unsigned char> xdrBuffer; /* staging buffer for reading and
+                                             writing arrays in one block */
 };
 
 /** lock the mutex associated with a fio  */
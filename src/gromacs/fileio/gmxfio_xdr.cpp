@@ -39,9 +39,11 @@
 #include "gmxfio_xdr.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 
+#include <algorithm>
 #include <limits>
 
 #include "gromacs/fileio/gmxfio.h"
@@ -125,6 +127,80 @@ static void gmx_fio_check_nitem(int eio, std::size_t nitem, const char* file, in
               desc, eio, ((eio >= 0) && (eio < eioNR)) ? eioNames[eio] : "unknown", srcfile, line);
 }
 
+/*! \brief Number of rvecs transferred per block by do_xdr_rvec_array() */
+static const std::size_t c_rvecBlockSize = 65536;
+
+/*! \brief Stores \p value as big-endian IEEE float or double, as XDR does */
+template<typename ValueType, typename BitsType>
+static inline void encode_xdr_value(real value, unsigned char* bytes)
+{
+    const ValueType typedValue = value;
+    BitsType        bits;
+    std::memcpy(&bits, &typedValue, sizeof(bits));
+    for (std::size_t b = 0; b < sizeof(bits); b++)
+    {
+        bytes[b] = static_cast<unsigned char>(bits >> (8 * (sizeof(bits) - 1 - b)));
+    }
+}
+
+/*! \brief Returns the big-endian IEEE float or double stored at \p bytes */
+template<typename ValueType, typename BitsType>
+static inline real decode_xdr_value(const unsigned char* bytes)
+{
+    BitsType bits = 0;
+    for (std::size_t b = 0; b < sizeof(bits); b++)
+    {
+        bits = (bits << 8) | bytes[b];
+    }
+    ValueType value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/*! \brief Reads or writes an array of rvecs in blocks
+ *
+ * XDR stores floats and doubles as big-endian IEEE values without any
+ * padding, so a block of rvecs can be transferred as opaque data in a
+ * single call and converted in one pass, instead of calling xdr_float
+ * or xdr_double for every element. When reading with \p item nullptr,
+ * the data is skipped without conversion.
+ */
+template<typename ValueType, typename BitsType>
+static bool_t do_xdr_rvec_array(t_fileio* fio, rvec* item, std::size_t nitem)
+{
+    const std::size_t valueSize = sizeof(ValueType);
+    bool_t            res       = 1;
+
+    for (std::size_t start = 0; start < nitem && res; start += c_rvecBlockSize)
+    {
+        const std::size_t blockSize = std::min(c_rvecBlockSize, nitem - start);
+        const std::size_t numValues = blockSize * DIM;
+
+        fio->xdrBuffer.resize(numValues * valueSize);
+        unsigned char* bytes = fio->xdrBuffer.data();
+        if (!fio->bRead)
+        {
+            const real* values = item[start];
+            for (std::size_t i = 0; i < numValues; i++)
+            {
+                encode_xdr_value<ValueType, BitsType>(values[i], bytes + i * valueSize);
+            }
+        }
+        res = xdr_opaque(fio->xdr, reinterpret_cast<char*>(bytes),
+                         static_cast<unsigned int>(numValues * valueSize));
+        if (res && fio->bRead && item)
+        {
+            real* values = item[start];
+            for (std::size_t i = 0; i < numValues; i++)
+            {
+                values[i] = decode_xdr_value<ValueType, BitsType>(bytes + i * valueSize);
+            }
+        }
+    }
+
+    return res;
+}
+
 /* This is the part that reads xdr files.  */
 
 static gmx_bool
@@ -138,7 +214,6 @@ do_xdr(t_fileio* fio, void* item, std::size_t nitem, int eio, const char* desc,
     int            m, *iptr, idum;
     int32_t        s32dum;
     int64_t        s64dum;
-    real*          ptr;
     unsigned short us;
     double         d = 0;
     float          f = 0;
@@ -320,15 +395,13 @@ do_xdr(t_fileio* fio, void* item, std::size_t nitem, int eio, const char* desc,
             }
             break;
         case eioNRVEC:
-            ptr = nullptr;
-            res = 1;
-            for (std::size_t j = 0; j < nitem && res; j++)
+            if (fio->bDouble)
             {
-                if (item)
-                {
-                    ptr = (static_cast<rvec*>(item))[j];
-                }
-                res = static_cast<bool_t>(do_xdr(fio, ptr, 1, eioRVEC, desc, srcfile, line));
+                res = do_xdr_rvec_array<double, uint64_t>(fio, static_cast<rvec*>(item), nitem);
+            }
+            else
+            {
+                res = do_xdr_rvec_array<float, uint32_t>(fio, static_cast<rvec*>(item), nitem);
             }
             break;
         case eioIVEC:
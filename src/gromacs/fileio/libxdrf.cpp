@@ -38,6 +38,7 @@
 
 #include <climits>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -81,6 +82,9 @@ static const int magicints[] = {
 /* note that magicints[FIRSTIDX-1] == 0 */
 #define LASTIDX static_cast<int>((sizeof(magicints) / sizeof(*magicints)))
 
+/* number of bytes that receivebits() may read beyond the end of the data */
+#define XTC_BUF_PADDING 8
+
 
 /*____________________________________________________________________________
  |
@@ -208,6 +212,8 @@ static int sizeofints(const int num_of_ints, const unsigned int sizes[])
  | a few integers, this is not done, because the gain in compression
  | isn't worth the effort. Note that overflowing the multiplication
  | or the byte buffer (32 bytes) is unchecked and causes bad results.
+ | When the combined integer fits in 64 bits, the multiplication is done
+ | directly on a 64-bit integer instead of byte by byte.
  |
  */
 
@@ -221,6 +227,33 @@ static void sendints(int          buf[],
     int          i, num_of_bytes, bytecnt;
     unsigned int bytes[32], tmp;
 
+    if (num_of_bits <= 64)
+    {
+        /* the combined integer fits in 64 bits, so multiply directly */
+        uint64_t combined = nums[0];
+        for (i = 1; i < num_of_ints; i++)
+        {
+            if (nums[i] >= sizes[i])
+            {
+                fprintf(stderr,
+                        "major breakdown in sendints num %u doesn't "
+                        "match size %u\n",
+                        nums[i], sizes[i]);
+                exit(1);
+            }
+            combined = combined * sizes[i] + nums[i];
+        }
+        for (i = 0; i < num_of_bits / 8; i++)
+        {
+            sendbits(buf, 8, static_cast<int>((combined >> (8 * i)) & 0xff));
+        }
+        if (num_of_bits % 8 != 0)
+        {
+            sendbits(buf, num_of_bits % 8, static_cast<int>((combined >> (8 * i)) & 0xff));
+        }
+        return;
+    }
+
     tmp          = nums[0];
     num_of_bytes = 0;
     do
@@ -277,46 +310,42 @@ static void sendints(int          buf[],
  |
  | receivebits - decode number from buf using specified number of bits
  |
- | extract the number of bits from the array buf and construct an integer
- | from it. Return that value.
+ | extract the number of bits from the byte array cbuf, starting at bit
+ | *bitpos, and construct an integer from it. Return that value and
+ | advance *bitpos. At most 32 bits can be extracted per call.
+ | Since the bits of a value span at most five bytes, these are
+ | gathered in one go and the result is cut out using a mask table,
+ | instead of processing the stream byte by byte. This requires cbuf
+ | to be readable up to XTC_BUF_PADDING bytes beyond the data.
  |
  */
 
-static int receivebits(int buf[], int num_of_bits)
+static const unsigned int receivebitsMask[33] = {
+    0x00000000U, 0x00000001U, 0x00000003U, 0x00000007U, 0x0000000fU, 0x0000001fU, 0x0000003fU,
+    0x0000007fU, 0x000000ffU, 0x000001ffU, 0x000003ffU, 0x000007ffU, 0x00000fffU, 0x00001fffU,
+    0x00003fffU, 0x00007fffU, 0x0000ffffU, 0x0001ffffU, 0x0003ffffU, 0x0007ffffU, 0x000fffffU,
+    0x001fffffU, 0x003fffffU, 0x007fffffU, 0x00ffffffU, 0x01ffffffU, 0x03ffffffU, 0x07ffffffU,
+    0x0fffffffU, 0x1fffffffU, 0x3fffffffU, 0x7fffffffU, 0xffffffffU
+};
+
+/* The bit position has to address every bit of a frame with the largest
+ * byte count that the int length field in the file can hold */
+static_assert(UINT64_MAX / CHAR_BIT >= static_cast<uint64_t>(INT_MAX) + XTC_BUF_PADDING,
+              "The bit position type is too small for the largest compressed frame");
+
+static inline int receivebits(const unsigned char* cbuf, uint64_t* bitpos, int num_of_bits)
 {
+    const unsigned char* p      = cbuf + (*bitpos >> 3);
+    const int            offset = static_cast<int>(*bitpos & 7);
 
-    int            cnt, num, lastbits;
-    unsigned int   lastbyte;
-    unsigned char* cbuf;
-    int            mask = (1 << num_of_bits) - 1;
+    uint64_t window = (static_cast<uint64_t>(p[0]) << 32) | (static_cast<uint64_t>(p[1]) << 24)
+                      | (static_cast<uint64_t>(p[2]) << 16) | (static_cast<uint64_t>(p[3]) << 8)
+                      | static_cast<uint64_t>(p[4]);
 
-    cbuf     = reinterpret_cast<unsigned char*>(buf) + 3 * sizeof(*buf);
-    cnt      = buf[0];
-    lastbits = static_cast<unsigned int>(buf[1]);
-    lastbyte = static_cast<unsigned int>(buf[2]);
+    *bitpos += num_of_bits;
 
-    num = 0;
-    while (num_of_bits >= 8)
-    {
-        lastbyte = (lastbyte << 8) | cbuf[cnt++];
-        num |= (lastbyte >> lastbits) << (num_of_bits - 8);
-        num_of_bits -= 8;
-    }
-    if (num_of_bits > 0)
-    {
-        if (lastbits < num_of_bits)
-        {
-            lastbits += 8;
-            lastbyte = (lastbyte << 8) | cbuf[cnt++];
-        }
-        lastbits -= num_of_bits;
-        num |= (lastbyte >> lastbits) & ((1 << num_of_bits) - 1);
-    }
-    num &= mask;
-    buf[0] = cnt;
-    buf[1] = lastbits;
-    buf[2] = lastbyte;
-    return num;
+    return static_cast<int>(static_cast<unsigned int>(window >> (40 - offset - num_of_bits))
+                            & receivebitsMask[num_of_bits]);
 }
 
 /*____________________________________________________________________________
@@ -327,24 +356,55 @@ static int receivebits(int buf[], int num_of_bits)
  | written to buf by calculating the remainder and doing divisions with
  | the given sizes[]. You need to specify the total number of bits to be
  | used from buf in num_of_bits.
+ | When the combined integer fits in 64 bits, which is nearly always the
+ | case, the divisions are done directly on a 64-bit integer instead of
+ | with the generic multi-byte long division.
  |
  */
 
-static void receiveints(int buf[], const int num_of_ints, int num_of_bits, const unsigned int sizes[], int nums[])
+static void receiveints(const unsigned char* cbuf,
+                        uint64_t*            bitpos,
+                        const int            num_of_ints,
+                        int                  num_of_bits,
+                        const unsigned int   sizes[],
+                        int                  nums[])
 {
     int bytes[32];
     int i, j, num_of_bytes, p, num;
 
+    if (num_of_bits <= 64)
+    {
+        uint64_t combined = 0;
+        int      shift    = 0;
+        while (num_of_bits > 8)
+        {
+            combined |= static_cast<uint64_t>(receivebits(cbuf, bitpos, 8)) << shift;
+            shift += 8;
+            num_of_bits -= 8;
+        }
+        if (num_of_bits > 0)
+        {
+            combined |= static_cast<uint64_t>(receivebits(cbuf, bitpos, num_of_bits)) << shift;
+        }
+        for (i = num_of_ints - 1; i > 0; i--)
+        {
+            nums[i] = static_cast<int>(combined % sizes[i]);
+            combined /= sizes[i];
+        }
+        nums[0] = static_cast<int>(static_cast<unsigned int>(combined));
+        return;
+    }
+
     bytes[0] = bytes[1] = bytes[2] = bytes[3] = 0;
     num_of_bytes                              = 0;
     while (num_of_bits > 8)
     {
-        bytes[num_of_bytes++] = receivebits(buf, 8);
+        bytes[num_of_bytes++] = receivebits(cbuf, bitpos, 8);
         num_of_bits -= 8;
     }
     if (num_of_bits > 0)
     {
-        bytes[num_of_bytes++] = receivebits(buf, num_of_bits);
+        bytes[num_of_bytes++] = receivebits(cbuf, bitpos, num_of_bits);
     }
     for (i = num_of_ints - 1; i > 0; i--)
     {
@@ -410,11 +470,13 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
     int          tmp, *thiscoord, prevcoord[3];
     unsigned int tmpcoord[30];
 
-    int          bufsize, lsize;
-    unsigned int bitsize;
-    float        inv_precision;
-    int          errval = 1;
-    int          rc;
+    int            bufsize, lsize;
+    unsigned int   bitsize;
+    uint64_t       bitpos;
+    unsigned char* cbuf;
+    float          inv_precision;
+    int            errval = 1;
+    int            rc;
 
     bRead         = (xdrs->x_op == XDR_DECODE);
     bitsizeint[0] = bitsizeint[1] = bitsizeint[2] = 0;
@@ -800,13 +862,14 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
 
         if (size3 <= prealloc_size)
         {
-            ip  = prealloc_ip;
-            buf = prealloc_buf;
+            ip      = prealloc_ip;
+            buf     = prealloc_buf;
+            bufsize = sizeof(prealloc_buf) / sizeof(*prealloc_buf);
         }
         else
         {
             we_should_free = 1;
-            bufsize        = static_cast<int>(size3 * 1.2);
+            bufsize        = static_cast<int>(size3 * 1.2) + XTC_BUF_PADDING / sizeof(*buf);
             ip             = reinterpret_cast<int*>(malloc(size3 * sizeof(*ip)));
             buf            = reinterpret_cast<int*>(malloc(bufsize * sizeof(*buf)));
             if (ip == nullptr || buf == nullptr)
@@ -863,7 +926,9 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
 
         /* buf[0] holds the length in bytes */
 
-        if (xdr_int(xdrs, &(buf[0])) == 0)
+        /* the data, plus the padding read by receivebits(), has to fit in buf */
+        if (xdr_int(xdrs, &(buf[0])) == 0 || buf[0] < 0
+            || static_cast<size_t>(buf[0]) + XTC_BUF_PADDING > (bufsize - 3) * sizeof(*buf))
         {
             if (we_should_free)
             {
@@ -884,8 +949,9 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
             return 0;
         }
 
-
-        buf[0] = buf[1] = buf[2] = 0;
+        cbuf = reinterpret_cast<unsigned char*>(&(buf[3]));
+        std::memset(cbuf + buf[0], 0, XTC_BUF_PADDING);
+        bitpos = 0;
 
         lfp           = fp;
         inv_precision = 1.0 / *precision;
@@ -898,13 +964,13 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
 
             if (bitsize == 0)
             {
-                thiscoord[0] = receivebits(buf, bitsizeint[0]);
-                thiscoord[1] = receivebits(buf, bitsizeint[1]);
-                thiscoord[2] = receivebits(buf, bitsizeint[2]);
+                thiscoord[0] = receivebits(cbuf, &bitpos, bitsizeint[0]);
+                thiscoord[1] = receivebits(cbuf, &bitpos, bitsizeint[1]);
+                thiscoord[2] = receivebits(cbuf, &bitpos, bitsizeint[2]);
             }
             else
             {
-                receiveints(buf, 3, bitsize, sizeint, thiscoord);
+                receiveints(cbuf, &bitpos, 3, bitsize, sizeint, thiscoord);
             }
 
             i++;
@@ -917,11 +983,11 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
             prevcoord[2] = thiscoord[2];
 
 
-            flag       = receivebits(buf, 1);
+            flag       = receivebits(cbuf, &bitpos, 1);
             is_smaller = 0;
             if (flag == 1)
             {
-                run        = receivebits(buf, 5);
+                run        = receivebits(cbuf, &bitpos, 5);
                 is_smaller = run % 3;
                 run -= is_smaller;
                 is_smaller--;
@@ -931,7 +997,7 @@ int xdr3dfcoord(XDR* xdrs, float* fp, int* size, float* precision)
                 thiscoord += 3;
                 for (k = 0; k < run; k += 3)
                 {
-                    receiveints(buf, 3, smallidx, sizesmall, thiscoord);
+                    receiveints(cbuf, &bitpos, 3, smallidx, sizesmall, thiscoord);
                     i++;
                     thiscoord[0] += prevcoord[0] - smallnum;
                     thiscoord[1] += prevcoord[1] - smallnum;
@@ -0,0 +1,263 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the index of frames in XTC and TRR trajectories.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/trajectoryframeindex.h"
+
+#include <cstdio>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/xtcio.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/textwriter.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Number of frames written to the test trajectories
+const int c_numFrames = 7;
+
+class TrajectoryFrameIndexTest : public ::testing::TestWithParam<const char*>
+{
+public:
+    TrajectoryFrameIndexTest() :
+        filename_(fileManager_.getTemporaryFilePath(std::string("traj.") + GetParam()))
+    {
+    }
+
+    /*! \brief
+     * Writes frames with varying atom counts and records their offsets.
+     *
+     * Frame \c i has step <tt>firstStep + 10 i</tt> and time <tt>firstStep / 20 + 0.5 i</tt>.
+     */
+    void writeTrajectory(int firstStep = 0)
+    {
+        offsets_.clear();
+        const matrix box   = { { 2, 0, 0 }, { 0, 2, 0 }, { 0, 0, 2 } };
+        t_fileio*    fio   = gmx_fio_open(filename_.c_str(), "w");
+        const bool   isXtc = (std::string(GetParam()) == "xtc");
+        for (int frame = 0; frame < c_numFrames; frame++)
+        {
+            // XTC stores frames of up to nine atoms uncompressed
+            const int         natoms = (frame % 2 == 0) ? 5 : 50 + frame;
+            std::vector<RVec> x(natoms);
+            for (int i = 0; i < natoms; i++)
+            {
+                x[i] = { 0.01F * i, 0.02F * frame, 0.5F };
+            }
+            offsets_.push_back(gmx_fio_ftell(fio));
+            if (isXtc)
+            {
+                write_xtc(fio, natoms, firstStep + 10 * frame, 0.05 * firstStep + 0.5 * frame, box,
+                          as_rvec_array(x.data()), 1000);
+            }
+            else
+            {
+                gmx_trr_write_frame(fio, firstStep + 10 * frame, 0.05 * firstStep + 0.5 * frame, 0,
+                                    box, natoms,
+                                    as_rvec_array(x.data()), frame % 3 == 0 ? as_rvec_array(x.data()) : nullptr,
+                                    nullptr);
+            }
+        }
+        offsets_.push_back(gmx_fio_ftell(fio));
+        gmx_fio_close(fio);
+    }
+
+    TestFileManager        fileManager_;
+    std::string            filename_;
+    std::vector<gmx_off_t> offsets_;
+};
+
+TEST_P(TrajectoryFrameIndexTest, IndexesAllFrames)
+{
+    writeTrajectory();
+    t_fileio*                  fio        = gmx_fio_open(filename_.c_str(), "r");
+    const TrajectoryFrameIndex frameIndex = TrajectoryFrameIndex::buildFromTrajectory(fio);
+    EXPECT_EQ(0, gmx_fio_ftell(fio));
+    gmx_fio_close(fio);
+
+    EXPECT_EQ(offsets_.back(), frameIndex.trajectorySize());
+    ASSERT_EQ(c_numFrames, frameIndex.numFrames());
+    for (int frame = 0; frame < c_numFrames; frame++)
+    {
+        EXPECT_EQ(10 * frame, frameIndex.frames()[frame].step);
+        EXPECT_EQ(0.5 * frame, frameIndex.frames()[frame].time);
+        EXPECT_EQ(offsets_[frame], frameIndex.frames()[frame].offset);
+    }
+}
+
+TEST_P(TrajectoryFrameIndexTest, SkipsTruncatedFrame)
+{
+    writeTrajectory();
+    // Remove the last few bytes, as if writing the last frame was interrupted
+    std::vector<char> contents(offsets_.back() - 4);
+    FILE*             fp = gmx_ffopen(filename_, "rb");
+    ASSERT_EQ(contents.size(), std::fread(contents.data(), 1, contents.size(), fp));
+    gmx_ffclose(fp);
+    fp = gmx_ffopen(filename_, "wb");
+    std::fwrite(contents.data(), 1, contents.size(), fp);
+    gmx_ffclose(fp);
+
+    t_fileio*                  fio        = gmx_fio_open(filename_.c_str(), "r");
+    const TrajectoryFrameIndex frameIndex = TrajectoryFrameIndex::buildFromTrajectory(fio);
+    gmx_fio_close(fio);
+
+    EXPECT_EQ(c_numFrames - 1, frameIndex.numFrames());
+}
+
+TEST_P(TrajectoryFrameIndexTest, FindsFramesByTime)
+{
+    writeTrajectory();
+    t_fileio*                  fio        = gmx_fio_open(filename_.c_str(), "r");
+    const TrajectoryFrameIndex frameIndex = TrajectoryFrameIndex::buildFromTrajectory(fio);
+    gmx_fio_close(fio);
+
+    EXPECT_EQ(0, frameIndex.findFirstFrameNotBefore(-1));
+    EXPECT_EQ(2, frameIndex.findFirstFrameNotBefore(1));
+    EXPECT_EQ(3, frameIndex.findFirstFrameNotBefore(1.2));
+    EXPECT_EQ(c_numFrames, frameIndex.findFirstFrameNotBefore(100));
+}
+
+TEST_P(TrajectoryFrameIndexTest, SplitsIntoRanges)
+{
+    writeTrajectory();
+    t_fileio*                  fio        = gmx_fio_open(filename_.c_str(), "r");
+    const TrajectoryFrameIndex frameIndex = TrajectoryFrameIndex::buildFromTrajectory(fio);
+    gmx_fio_close(fio);
+
+    const auto ranges = frameIndex.splitIntoRanges(3);
+    ASSERT_EQ(3U, ranges.size());
+    EXPECT_EQ(TrajectoryFrameIndex::FrameRange(0, 3), ranges[0]);
+    EXPECT_EQ(TrajectoryFrameIndex::FrameRange(3, 5), ranges[1]);
+    EXPECT_EQ(TrajectoryFrameIndex::FrameRange(5, 7), ranges[2]);
+
+    EXPECT_EQ(c_numFrames, gmx::ssize(frameIndex.splitIntoRanges(100)));
+}
+
+TEST_P(TrajectoryFrameIndexTest, IndexFileRoundTrips)
+{
+    writeTrajectory();
+    // Also registers the index file for removal after the test
+    const std::string indexFilename =
+            fileManager_.getTemporaryFilePath(std::string("traj.") + GetParam() + ".frameindex");
+    ASSERT_EQ(indexFilename, trajectoryFrameIndexFileName(filename_));
+
+    t_fileio* fio = gmx_fio_open(filename_.c_str(), "r");
+    const TrajectoryFrameIndex built = loadOrBuildTrajectoryFrameIndex(fio, true);
+    gmx_fio_close(fio);
+    ASSERT_TRUE(gmx_fexist(indexFilename));
+
+    TrajectoryFrameIndex read;
+    ASSERT_TRUE(TrajectoryFrameIndex::readFromFile(indexFilename, offsets_.back(), &read));
+    ASSERT_EQ(built.numFrames(), read.numFrames());
+    for (index frame = 0; frame < built.numFrames(); frame++)
+    {
+        EXPECT_EQ(built.frames()[frame].step, read.frames()[frame].step);
+        EXPECT_EQ(built.frames()[frame].time, read.frames()[frame].time);
+        EXPECT_EQ(built.frames()[frame].offset, read.frames()[frame].offset);
+    }
+
+    // An index written for a trajectory of a different size is not used
+    EXPECT_FALSE(TrajectoryFrameIndex::readFromFile(indexFilename, offsets_.back() + 4, &read));
+}
+
+TEST_P(TrajectoryFrameIndexTest, RebuildsIndexOfOverwrittenTrajectory)
+{
+    writeTrajectory();
+    // Also registers the index file for removal after the test
+    const std::string indexFilename = fileManager_.getTemporaryFilePath(
+            std::string("traj.") + GetParam() + ".frameindex");
+
+    t_fileio* fio = gmx_fio_open(filename_.c_str(), "r");
+    loadOrBuildTrajectoryFrameIndex(fio, true);
+    gmx_fio_close(fio);
+    ASSERT_TRUE(gmx_fexist(indexFilename));
+
+    // Overwrite the trajectory with one of the same size, but other steps and times
+    const gmx_off_t originalSize = offsets_.back();
+    writeTrajectory(1000);
+    ASSERT_EQ(originalSize, offsets_.back());
+
+    fio                                   = gmx_fio_open(filename_.c_str(), "r");
+    const TrajectoryFrameIndex frameIndex = loadOrBuildTrajectoryFrameIndex(fio, true);
+    gmx_fio_close(fio);
+    ASSERT_EQ(c_numFrames, frameIndex.numFrames());
+    EXPECT_EQ(1000, frameIndex.frames()[0].step);
+    EXPECT_EQ(50, frameIndex.frames()[0].time);
+    EXPECT_EQ(1000 + 10 * (c_numFrames - 1), frameIndex.frames()[c_numFrames - 1].step);
+
+    // The rebuilt index was stored and matches the trajectory
+    TrajectoryFrameIndex read;
+    ASSERT_TRUE(TrajectoryFrameIndex::readFromFile(indexFilename, originalSize, &read));
+    EXPECT_EQ(1000, read.frames()[0].step);
+    fio = gmx_fio_open(filename_.c_str(), "r");
+    EXPECT_TRUE(read.matchesTrajectory(fio));
+    gmx_fio_close(fio);
+}
+
+TEST_P(TrajectoryFrameIndexTest, RejectsInvalidIndexFile)
+{
+    const std::string indexFilename = fileManager_.getTemporaryFilePath("invalid.frameindex");
+    TextWriter::writeFileFromString(indexFilename, "not an index\n");
+
+    TrajectoryFrameIndex frameIndex;
+    EXPECT_FALSE(TrajectoryFrameIndex::readFromFile(indexFilename, 100, &frameIndex));
+    EXPECT_FALSE(TrajectoryFrameIndex::readFromFile(indexFilename + ".missing", 100, &frameIndex));
+}
+
+INSTANTIATE_TEST_CASE_P(TrajectoryFormats, TrajectoryFrameIndexTest, ::testing::Values("xtc", "trr"));
+
+} // namespace
+} // namespace test
+} // namespace gmx
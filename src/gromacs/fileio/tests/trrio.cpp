@@ -0,0 +1,148 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading and writing TRR trajectory frames.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/trrio.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/utility/real.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Returns \p natoms vectors with values that use all bits of the mantissa.
+std::vector<RVec> makeVectors(int natoms, real scale)
+{
+    std::vector<RVec> v(natoms);
+    for (int i = 0; i < natoms; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            v[i][d] = scale * (i - natoms / 2) / 3 + d / real(7);
+        }
+    }
+    return v;
+}
+
+class TrrIOTest : public ::testing::TestWithParam<int>
+{
+public:
+    TestFileManager fileManager_;
+};
+
+TEST_P(TrrIOTest, ReadsBackWrittenFramesExactly)
+{
+    const int         natoms   = GetParam();
+    const std::string filename = fileManager_.getTemporaryFilePath("frames.trr");
+    const matrix      box      = { { 3.1, 0, 0 }, { 0.2, 3.3, 0 }, { 0.4, 0.5, 3.7 } };
+    std::vector<RVec> x        = makeVectors(natoms, 0.01);
+    std::vector<RVec> v        = makeVectors(natoms, -0.3);
+    std::vector<RVec> f        = makeVectors(natoms, 50);
+
+    t_fileio* fio = gmx_trr_open(filename.c_str(), "w");
+    gmx_trr_write_frame(fio, 0, 0, 0.5, box, natoms, as_rvec_array(x.data()),
+                        as_rvec_array(v.data()), as_rvec_array(f.data()));
+    gmx_trr_write_frame(fio, 10, 1, 0.5, box, natoms, as_rvec_array(f.data()), nullptr,
+                        as_rvec_array(x.data()));
+    gmx_trr_close(fio);
+
+    std::vector<RVec> readX(natoms), readV(natoms), readF(natoms);
+    matrix            readBox;
+    int64_t           step;
+    real              time, lambda;
+    int               readNatoms;
+
+    fio = gmx_trr_open(filename.c_str(), "r");
+    // Skip over the velocities of the first frame
+    ASSERT_TRUE(gmx_trr_read_frame(fio, &step, &time, &lambda, readBox, &readNatoms,
+                                   as_rvec_array(readX.data()), nullptr, as_rvec_array(readF.data())));
+    EXPECT_EQ(0, step);
+    ASSERT_EQ(natoms, readNatoms);
+    for (int d = 0; d < DIM; d++)
+    {
+        for (int e = 0; e < DIM; e++)
+        {
+            EXPECT_EQ(box[d][e], readBox[d][e]);
+        }
+    }
+    for (int i = 0; i < natoms; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_EQ(x[i][d], readX[i][d]);
+            EXPECT_EQ(f[i][d], readF[i][d]);
+        }
+    }
+
+    ASSERT_TRUE(gmx_trr_read_frame(fio, &step, &time, &lambda, readBox, &readNatoms,
+                                   as_rvec_array(readX.data()), as_rvec_array(readV.data()),
+                                   as_rvec_array(readF.data())));
+    EXPECT_EQ(10, step);
+    for (int i = 0; i < natoms; i++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_EQ(f[i][d], readX[i][d]);
+            EXPECT_EQ(x[i][d], readF[i][d]);
+        }
+    }
+    EXPECT_FALSE(gmx_trr_read_frame(fio, &step, &time, &lambda, readBox, &readNatoms,
+                                    as_rvec_array(readX.data()), nullptr, nullptr));
+    gmx_trr_close(fio);
+}
+
+//! Small frames and frames that are transferred in several blocks.
+INSTANTIATE_TEST_CASE_P(AtomCounts, TrrIOTest, ::testing::Values(1, 100, 150000));
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,174 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for reading and writing compressed XTC coordinate frames.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/xtcio.h"
+
+#include <cmath>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/real.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Parameters for a round trip: number of atoms, precision and box size.
+struct XtcRoundTripParameters
+{
+    //! Number of atoms in the frame
+    int natoms;
+    //! Precision to write the coordinates with
+    real precision;
+    //! Edge length of the cubic box the coordinates are generated in
+    real boxSize;
+};
+
+class XtcRoundTripTest : public ::testing::TestWithParam<XtcRoundTripParameters>
+{
+public:
+    /*! \brief Generates water-like coordinates
+     *
+     * Each group of three atoms is a central atom with two atoms close
+     * to it, which exercises the run-length encoded small differences
+     * as well as the large jumps between molecules.
+     */
+    static std::vector<RVec> generateCoordinates(int natoms, real boxSize, int seed)
+    {
+        DefaultRandomEngine           rng(seed);
+        UniformRealDistribution<real> box(0, boxSize);
+        UniformRealDistribution<real> bond(-0.1, 0.1);
+
+        std::vector<RVec> x(natoms);
+        for (int i = 0; i < natoms; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                x[i][d] = (i % 3 == 0) ? box(rng) : x[i - i % 3][d] + bond(rng);
+            }
+        }
+        return x;
+    }
+
+    TestFileManager fileManager_;
+};
+
+TEST_P(XtcRoundTripTest, ReadsBackWrittenFrames)
+{
+    const XtcRoundTripParameters& params    = GetParam();
+    const std::string             filename  = fileManager_.getTemporaryFilePath("frames.xtc");
+    const int                     numFrames = 3;
+    const matrix                  box       = { { params.boxSize, 0, 0 },
+                               { 0, params.boxSize, 0 },
+                               { 0, 0, params.boxSize } };
+
+    std::vector<std::vector<RVec>> frames;
+    t_fileio*                      fio = open_xtc(filename.c_str(), "w");
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        frames.push_back(generateCoordinates(params.natoms, params.boxSize, frame));
+        ASSERT_TRUE(write_xtc(fio, params.natoms, frame, frame * 0.5, box,
+                              as_rvec_array(frames.back().data()), params.precision));
+    }
+    close_xtc(fio);
+
+    fio = open_xtc(filename.c_str(), "r");
+    int      natoms;
+    int64_t  step;
+    real     time;
+    matrix   readBox;
+    rvec*    x = nullptr;
+    real     precision;
+    gmx_bool bOK;
+    ASSERT_TRUE(read_first_xtc(fio, &natoms, &step, &time, readBox, &x, &precision, &bOK));
+    for (int frame = 0; frame < numFrames; frame++)
+    {
+        if (frame > 0)
+        {
+            ASSERT_TRUE(read_next_xtc(fio, natoms, &step, &time, readBox, x, &precision, &bOK));
+        }
+        ASSERT_TRUE(bOK);
+        EXPECT_EQ(frame, step);
+        ASSERT_EQ(params.natoms, natoms);
+        for (int i = 0; i < natoms; i++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                // We lose at most half the precision, plus float rounding
+                const real tolerance = 0.5 / params.precision + 4 * GMX_FLOAT_EPS * params.boxSize;
+                EXPECT_NEAR(frames[frame][i][d], x[i][d], tolerance)
+                        << "frame " << frame << ", atom " << i << ", dimension " << d;
+            }
+        }
+    }
+    sfree(x);
+    close_xtc(fio);
+}
+
+//! Parameter sets covering the different code paths of the XTC compression.
+const XtcRoundTripParameters c_xtcRoundTripParameters[] = {
+    { 5, 1000, 5 },       // too few atoms to compress
+    { 12, 1000, 5 },      // small frame using the preallocated buffers
+    { 3000, 1000, 5 },    // common precision
+    { 3000, 100000, 5 },  // combined integer fits in 64 bits
+    { 3000, 1000000, 5 }, // combined integer needs more than 64 bits
+    { 3000, 10000000, 5 } // ranges too large to be combined
+};
+
+INSTANTIATE_TEST_CASE_P(Precisions, XtcRoundTripTest, ::testing::ValuesIn(c_xtcRoundTripParameters));
+
+} // namespace
+} // namespace test
+} // namespace gmx
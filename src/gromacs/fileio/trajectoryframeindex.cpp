@@ -0,0 +1,384 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the index of frames in XTC and TRR trajectory files.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "trajectoryframeindex.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+#include <algorithm>
+
+#include "gromacs/fileio/filetypes.h"
+#include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/gmxfio_xdr.h"
+#include "gromacs/fileio/trrio.h"
+#include "gromacs/fileio/xdrf.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textreader.h"
+#include "gromacs/utility/textwriter.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Magic number at the start of each XTC frame, as in xtcio.cpp.
+const int c_xtcMagic = 1995;
+//! Size in bytes of an XDR int or float.
+const gmx_off_t c_xdrIntSize = 4;
+/*! \brief
+ * Offset of the number of atoms of the coordinate block in an XTC frame.
+ *
+ * The frame header contains the magic number, number of atoms, step and
+ * time, followed by the nine box elements.
+ */
+const gmx_off_t c_xtcCoordinateAtomCountOffset = (4 + DIM * DIM) * c_xdrIntSize;
+/*! \brief
+ * Offset of the byte count of the compressed coordinates in an XTC frame.
+ *
+ * The number of atoms is followed by the precision, the three minimum
+ * and three maximum integer coordinates and the initial small index.
+ */
+const gmx_off_t c_xtcCompressedSizeOffset = c_xtcCoordinateAtomCountOffset + (2 + 2 * DIM + 1) * c_xdrIntSize;
+//! First line of an index file, which also serves as version check.
+const char c_indexFileHeader[] = "# GROMACS trajectory frame index, version 1";
+
+/*! \brief
+ * Reads the XTC frame header at \p offset and determines where the next frame starts.
+ *
+ * \returns false when no complete header could be read.
+ */
+bool scanXtcFrame(t_fileio* fio, gmx_off_t offset, TrajectoryFrameIndexEntry* entry, gmx_off_t* nextOffset)
+{
+    XDR*  xd = gmx_fio_getxdr(fio);
+    int   magic, natoms, step, coordinateAtomCount;
+    float time;
+
+    if (xdr_int(xd, &magic) == 0 || magic != c_xtcMagic || xdr_int(xd, &natoms) == 0
+        || xdr_int(xd, &step) == 0 || xdr_float(xd, &time) == 0 || natoms < 0)
+    {
+        return false;
+    }
+    if (gmx_fio_seek(fio, offset + c_xtcCoordinateAtomCountOffset) != 0
+        || xdr_int(xd, &coordinateAtomCount) == 0 || coordinateAtomCount != natoms)
+    {
+        return false;
+    }
+    if (natoms <= 9)
+    {
+        /* Small frames are stored uncompressed */
+        *nextOffset = offset + c_xtcCoordinateAtomCountOffset + c_xdrIntSize
+                      + natoms * DIM * c_xdrIntSize;
+    }
+    else
+    {
+        int compressedSize;
+        if (gmx_fio_seek(fio, offset + c_xtcCompressedSizeOffset) != 0
+            || xdr_int(xd, &compressedSize) == 0 || compressedSize < 0)
+        {
+            return false;
+        }
+        /* The opaque data is padded to a multiple of four bytes */
+        *nextOffset = offset + c_xtcCompressedSizeOffset + c_xdrIntSize
+                      + (compressedSize + c_xdrIntSize - 1) / c_xdrIntSize * c_xdrIntSize;
+    }
+    entry->step = step;
+    entry->time = time;
+    return true;
+}
+
+/*! \brief
+ * Reads the TRR frame header at the current position and determines where the next frame starts.
+ *
+ * \returns false when no complete header could be read.
+ */
+bool scanTrrFrame(t_fileio* fio, TrajectoryFrameIndexEntry* entry, gmx_off_t* nextOffset)
+{
+    gmx_trr_header_t header;
+    gmx_bool         bOK;
+
+    if (!gmx_trr_read_frame_header(fio, &header, &bOK) || !bOK)
+    {
+        return false;
+    }
+    *nextOffset = gmx_fio_ftell(fio) + header.box_size + header.vir_size + header.pres_size
+                  + header.x_size + header.v_size + header.f_size;
+    entry->step = header.step;
+    entry->time = header.t;
+    return true;
+}
+
+/*! \brief
+ * Reads the header of the frame at \p offset and determines where the next frame starts.
+ *
+ * \returns false when no complete header could be read.
+ */
+bool scanFrame(t_fileio* fio, gmx_off_t offset, TrajectoryFrameIndexEntry* entry, gmx_off_t* nextOffset)
+{
+    if (gmx_fio_seek(fio, offset) != 0)
+    {
+        return false;
+    }
+    entry->offset = offset;
+    return (gmx_fio_getftp(fio) == efXTC) ? scanXtcFrame(fio, offset, entry, nextOffset)
+                                          : scanTrrFrame(fio, entry, nextOffset);
+}
+
+} // namespace
+
+TrajectoryFrameIndex::TrajectoryFrameIndex() : trajectorySize_(0), timesAreIncreasing_(true) {}
+
+TrajectoryFrameIndex TrajectoryFrameIndex::buildFromTrajectory(t_fileio* fio)
+{
+    const int ftp = gmx_fio_getftp(fio);
+    if (ftp != efXTC && ftp != efTRR)
+    {
+        GMX_THROW(InvalidInputError(formatString(
+                "Can only index XTC and TRR trajectories, not %s", gmx_fio_getname(fio))));
+    }
+
+    const gmx_off_t      startPosition = gmx_fio_ftell(fio);
+    FILE*                fp            = gmx_fio_getfp(fio);
+    TrajectoryFrameIndex frameIndex;
+
+    gmx_fseek(fp, 0, SEEK_END);
+    frameIndex.trajectorySize_ = gmx_ftell(fp);
+    gmx_fio_rewind(fio);
+
+    gmx_off_t offset = 0;
+    while (offset < frameIndex.trajectorySize_)
+    {
+        TrajectoryFrameIndexEntry entry;
+        gmx_off_t                 nextOffset;
+
+        /* Do not index a frame that was truncated while being written */
+        if (!scanFrame(fio, offset, &entry, &nextOffset) || nextOffset > frameIndex.trajectorySize_)
+        {
+            break;
+        }
+        frameIndex.frames_.push_back(entry);
+        offset = nextOffset;
+    }
+    frameIndex.updateTimesAreIncreasing();
+
+    gmx_fio_seek(fio, startPosition);
+
+    return frameIndex;
+}
+
+bool TrajectoryFrameIndex::matchesTrajectory(t_fileio* fio) const
+{
+    const gmx_off_t           startPosition = gmx_fio_ftell(fio);
+    TrajectoryFrameIndexEntry entry;
+    gmx_off_t                 nextOffset;
+    bool                      matches = true;
+
+    if (frames_.empty())
+    {
+        /* An empty index only matches a trajectory without complete frames */
+        matches = !scanFrame(fio, 0, &entry, &nextOffset) || nextOffset > trajectorySize_;
+    }
+    else
+    {
+        for (index frame : { index(0), numFrames() / 2, numFrames() - 1 })
+        {
+            const TrajectoryFrameIndexEntry& indexed = frames_[frame];
+            if (!scanFrame(fio, indexed.offset, &entry, &nextOffset))
+            {
+                matches = false;
+                break;
+            }
+            /* Only the last frame can be followed by a truncated frame */
+            const bool validNextOffset = (frame + 1 < numFrames())
+                                                 ? nextOffset == frames_[frame + 1].offset
+                                                 : nextOffset <= trajectorySize_;
+            if (entry.step != indexed.step || entry.time != indexed.time || !validNextOffset)
+            {
+                matches = false;
+                break;
+            }
+        }
+    }
+    gmx_fio_seek(fio, startPosition);
+
+    return matches;
+}
+
+bool TrajectoryFrameIndex::readFromFile(const std::string&    filename,
+                                        gmx_off_t             trajectorySize,
+                                        TrajectoryFrameIndex* result)
+{
+    if (!gmx_fexist(filename))
+    {
+        return false;
+    }
+
+    TrajectoryFrameIndex frameIndex;
+    TextReader           reader(filename);
+    std::string          line;
+    int64_t              numFrames;
+
+    if (!reader.readLine(&line) || stripString(line) != c_indexFileHeader || !reader.readLine(&line)
+        || std::sscanf(line.c_str(), "trajectory-size %" SCNd64, &frameIndex.trajectorySize_) != 1
+        || frameIndex.trajectorySize_ != trajectorySize || !reader.readLine(&line)
+        || std::sscanf(line.c_str(), "frames %" SCNd64, &numFrames) != 1 || numFrames < 0)
+    {
+        return false;
+    }
+    frameIndex.frames_.reserve(numFrames);
+    while (reader.readLine(&line))
+    {
+        TrajectoryFrameIndexEntry entry;
+        if (std::sscanf(line.c_str(), "%" SCNd64 " %lf %" SCNd64, &entry.step, &entry.time, &entry.offset) != 3
+            || entry.offset >= trajectorySize)
+        {
+            return false;
+        }
+        frameIndex.frames_.push_back(entry);
+    }
+    if (frameIndex.numFrames() != numFrames)
+    {
+        return false;
+    }
+    frameIndex.updateTimesAreIncreasing();
+
+    *result = std::move(frameIndex);
+    return true;
+}
+
+void TrajectoryFrameIndex::writeToFile(const std::string& filename) const
+{
+    TextWriter writer(filename);
+
+    writer.writeLine(c_indexFileHeader);
+    writer.writeLineFormatted("trajectory-size %" PRId64, static_cast<int64_t>(trajectorySize_));
+    writer.writeLineFormatted("frames %" PRId64, static_cast<int64_t>(frames_.size()));
+    for (const TrajectoryFrameIndexEntry& entry : frames_)
+    {
+        writer.writeLineFormatted("%" PRId64 " %.17g %" PRId64, entry.step, entry.time,
+                                  static_cast<int64_t>(entry.offset));
+    }
+    writer.close();
+}
+
+index TrajectoryFrameIndex::findFirstFrameNotBefore(real time) const
+{
+    const auto isBefore = [time](const TrajectoryFrameIndexEntry& entry) {
+        return static_cast<real>(entry.time) < time;
+    };
+    if (timesAreIncreasing_)
+    {
+        auto found = std::partition_point(frames_.begin(), frames_.end(), isBefore);
+        return found - frames_.begin();
+    }
+    auto found = std::find_if_not(frames_.begin(), frames_.end(), isBefore);
+    return found - frames_.begin();
+}
+
+std::vector<TrajectoryFrameIndex::FrameRange> TrajectoryFrameIndex::splitIntoRanges(int numRanges) const
+{
+    GMX_RELEASE_ASSERT(numRanges > 0, "Need at least one range");
+
+    std::vector<FrameRange> ranges;
+    const index             numUsedRanges = std::min<index>(numRanges, numFrames());
+    index                   first         = 0;
+    for (index range = 0; range < numUsedRanges; range++)
+    {
+        const index last = first + numFrames() / numUsedRanges + (range < numFrames() % numUsedRanges ? 1 : 0);
+        ranges.emplace_back(first, last);
+        first = last;
+    }
+    return ranges;
+}
+
+void TrajectoryFrameIndex::updateTimesAreIncreasing()
+{
+    timesAreIncreasing_ = std::is_sorted(frames_.begin(), frames_.end(),
+                                         [](const TrajectoryFrameIndexEntry& a,
+                                            const TrajectoryFrameIndexEntry& b) {
+                                             return a.time <= b.time;
+                                         });
+}
+
+std::string trajectoryFrameIndexFileName(const std::string& trajectoryFile)
+{
+    return trajectoryFile + ".frameindex";
+}
+
+TrajectoryFrameIndex loadOrBuildTrajectoryFrameIndex(t_fileio* fio, bool writeIndexFile)
+{
+    const std::string    indexFileName = trajectoryFrameIndexFileName(gmx_fio_getname(fio));
+    FILE*                fp            = gmx_fio_getfp(fio);
+    const gmx_off_t      position      = gmx_ftell(fp);
+    TrajectoryFrameIndex frameIndex;
+
+    gmx_fseek(fp, 0, SEEK_END);
+    const gmx_off_t trajectorySize = gmx_ftell(fp);
+    gmx_fseek(fp, position, SEEK_SET);
+
+    /* A trajectory that was overwritten with one of the same size is
+     * detected by comparing a sample of the frame headers.
+     */
+    if (TrajectoryFrameIndex::readFromFile(indexFileName, trajectorySize, &frameIndex)
+        && frameIndex.matchesTrajectory(fio))
+    {
+        return frameIndex;
+    }
+    frameIndex = TrajectoryFrameIndex::buildFromTrajectory(fio);
+    if (writeIndexFile)
+    {
+        try
+        {
+            frameIndex.writeToFile(indexFileName);
+        }
+        catch (const FileIOError&)
+        {
+            /* The index is only an optimization, so we carry on without */
+        }
+    }
+    return frameIndex;
+}
+
+} // namespace gmx
@@ -0,0 +1,197 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares an index of the frames in XTC and TRR trajectory files.
+ *
+ * The index stores the step, time and file offset of each frame, so
+ * that readers can seek directly to a frame, count frames or split a
+ * trajectory into ranges without decoding the coordinate data.
+ * It can be stored next to the trajectory in a small text file, see
+ * trajectoryFrameIndexFileName(), which is used as long as the size of
+ * the trajectory and a sample of its frame headers do not change.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_TRAJECTORYFRAMEINDEX_H
+#define GMX_FILEIO_TRAJECTORYFRAMEINDEX_H
+
+#include <cstdint>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/real.h"
+
+struct t_fileio;
+
+namespace gmx
+{
+
+/*! \libinternal \brief
+ * Location of a single trajectory frame.
+ */
+struct TrajectoryFrameIndexEntry
+{
+    //! MD step of the frame.
+    int64_t step;
+    //! Time of the frame, as stored in the trajectory.
+    double time;
+    //! Offset of the start of the frame in the trajectory file.
+    gmx_off_t offset;
+};
+
+/*! \libinternal \brief
+ * Index of the frames in an XTC or TRR trajectory file.
+ *
+ * \inlibraryapi
+ * \ingroup module_fileio
+ */
+class TrajectoryFrameIndex
+{
+public:
+    //! A range of frames [first, last) for processing by one worker.
+    using FrameRange = std::pair<index, index>;
+
+    //! Creates an empty index.
+    TrajectoryFrameIndex();
+
+    /*! \brief
+     * Builds the index by scanning the frame headers of a trajectory.
+     *
+     * Only the headers and the sizes of the frames are read, the
+     * coordinate data is skipped. Scanning stops at the first
+     * incomplete or corrupt frame. The file position of \p fio is
+     * restored afterwards.
+     *
+     * \param[in] fio  Trajectory file, opened for reading as XTC or TRR.
+     * \throws    InvalidInputError if \p fio is not an XTC or TRR file.
+     */
+    static TrajectoryFrameIndex buildFromTrajectory(t_fileio* fio);
+
+    /*! \brief
+     * Reads an index from \p filename.
+     *
+     * \param[in]  filename        Index file to read.
+     * \param[in]  trajectorySize  Current size of the trajectory in bytes.
+     * \param[out] result          The index read.
+     * \returns    false if the file does not exist, is not a valid index
+     *     or was written for a trajectory of a different size,
+     *     in which case \p result is not changed.
+     */
+    static bool readFromFile(const std::string& filename, gmx_off_t trajectorySize, TrajectoryFrameIndex* result);
+
+    /*! \brief
+     * Checks that the index describes the frames in \p fio.
+     *
+     * Compares the step, time and size of the first, middle and last
+     * indexed frames with the frame headers in the trajectory, so that
+     * a trajectory that was overwritten with one of the same size is
+     * detected. The file position of \p fio is restored afterwards.
+     *
+     * \param[in] fio  Trajectory file, opened for reading as XTC or TRR.
+     */
+    bool matchesTrajectory(t_fileio* fio) const;
+
+    /*! \brief
+     * Writes the index to \p filename.
+     *
+     * \throws FileIOError if the file can not be written.
+     */
+    void writeToFile(const std::string& filename) const;
+
+    //! Returns the frames in the index.
+    ArrayRef<const TrajectoryFrameIndexEntry> frames() const { return frames_; }
+    //! Returns the number of frames in the index.
+    index numFrames() const { return gmx::ssize(frames_); }
+    //! Returns the size of the trajectory file the index describes.
+    gmx_off_t trajectorySize() const { return trajectorySize_; }
+
+    /*! \brief
+     * Returns the first frame with time not smaller than \p time.
+     *
+     * Uses a binary search when the frame times are increasing,
+     * otherwise the frames are searched in order.
+     * Returns numFrames() when there is no such frame.
+     */
+    index findFirstFrameNotBefore(real time) const;
+
+    /*! \brief
+     * Splits the frames into at most \p numRanges contiguous ranges.
+     *
+     * The ranges have sizes that differ by at most one frame and
+     * together cover all frames. No empty ranges are returned.
+     */
+    std::vector<FrameRange> splitIntoRanges(int numRanges) const;
+
+private:
+    //! Frames in the order they are stored in the trajectory.
+    std::vector<TrajectoryFrameIndexEntry> frames_;
+    //! Size of the trajectory file in bytes.
+    gmx_off_t trajectorySize_;
+    //! Whether the frame times are strictly increasing.
+    bool timesAreIncreasing_;
+
+    //! Updates timesAreIncreasing_ after frames_ has been set.
+    void updateTimesAreIncreasing();
+};
+
+/*! \brief
+ * Returns the name of the index file that belongs to \p trajectoryFile.
+ */
+std::string trajectoryFrameIndexFileName(const std::string& trajectoryFile);
+
+/*! \brief
+ * Loads the index of \p fio from its index file, or builds it.
+ *
+ * When the index file does not exist, has a different trajectory size
+ * or does not match the sampled frame headers, the index is built by
+ * scanning the trajectory. If \p writeIndexFile is true, the
+ * new index is then written to the index file, ignoring failures to
+ * do so, e.g. in directories without write permission.
+ *
+ * \param[in] fio             Trajectory file, opened for reading as XTC or TRR.
+ * \param[in] writeIndexFile  Whether to store a newly built index.
+ */
+TrajectoryFrameIndex loadOrBuildTrajectoryFrameIndex(t_fileio* fio, bool writeIndexFile);
+
+} // namespace gmx
+
+#endif
@@ -324,13 +324,26 @@ void gmx_trr_write_frame(t_fileio*   fio,
                          const rvec* v,
                          const rvec* f)
 {
-    if (!do_trr_frame(fio, false, &step, &t, &lambda, const_cast<rvec*>(box), &natoms,
-                      const_cast<rvec*>(x), const_cast<rvec*>(v), const_cast<rvec*>(f)))
+    if (!gmx_trr_try_write_frame(fio, step, t, lambda, box, natoms, x, v, f))
     {
         gmx_file("Cannot write trajectory frame; maybe you are out of disk space?");
     }
 }
 
+gmx_bool gmx_trr_try_write_frame(t_fileio*   fio,
+                                 int64_t     step,
+                                 real        t,
+                                 real        lambda,
+                                 const rvec* box,
+                                 int         natoms,
+                                 const rvec* x,
+                                 const rvec* v,
+                                 const rvec* f)
+{
+    return do_trr_frame(fio, false, &step, &t, &lambda, const_cast<rvec*>(box), &natoms,
+                        const_cast<rvec*>(x), const_cast<rvec*>(v), const_cast<rvec*>(f));
+}
+
 
 gmx_bool gmx_trr_read_frame(t_fileio* fio,
                             int64_t*  step,
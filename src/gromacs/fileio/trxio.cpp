@@ -56,6 +56,7 @@
 #include "gromacs/fileio/timecontrol.h"
 #include "gromacs/fileio/tngio.h"
 #include "gromacs/fileio/tpxio.h"
+#include "gromacs/fileio/trajectoryframeindex.h"
 #include "gromacs/fileio/trrio.h"
 #include "gromacs/fileio/xdrf.h"
 #include "gromacs/fileio/xtcio.h"
@@ -93,6 +94,8 @@ struct t_trxstatus
     double               DT, BOX[3];
     gmx_bool             bReadBox;
     char*                persistent_line; /* Persistent line for reading g96 trajectories */
+    gmx_bool                   bUseFrameIndex; /* Seek with a frame index stored on disk */
+    gmx::TrajectoryFrameIndex* frameIndex;     /* Frame index, loaded on first use       */
 #if GMX_USE_PLUGINS
     gmx_vmdplugin_t* vmdplugin;
 #endif
@@ -166,6 +169,8 @@ static void status_init(t_trxstatus* status)
     status->tf              = 0;
     status->persistent_line = nullptr;
     status->tng             = nullptr;
+    status->bUseFrameIndex  = FALSE;
+    status->frameIndex      = nullptr;
 }
 
 
@@ -239,7 +244,17 @@ float trx_get_time_of_final_frame(t_trxstatus* status)
     gmx_bool  bOK;
     float     lasttime = -1;
 
-    if (filetype == efXTC)
+    if ((filetype == efXTC && status->bUseFrameIndex) || filetype == efTRR)
+    {
+        const gmx::TrajectoryFrameIndex& frameIndex = trx_get_frame_index(status);
+        if (frameIndex.numFrames() == 0)
+        {
+            gmx_fatal(FARGS, "Error reading last frame, no complete frames in %s.",
+                      gmx_fio_getname(stfio));
+        }
+        lasttime = frameIndex.frames().back().time;
+    }
+    else if (filetype == efXTC)
     {
         lasttime = xdr_xtc_get_last_frame_time(gmx_fio_getfp(stfio), gmx_fio_getxdr(stfio),
                                                status->natoms, &bOK);
@@ -259,11 +274,73 @@ float trx_get_time_of_final_frame(t_trxstatus* status)
     }
     else
     {
-        gmx_incons("Only supported for TNG and XTC");
+        gmx_incons("Only supported for TNG, XTC and TRR");
     }
     return lasttime;
 }
 
+/*! \brief Returns whether a frame index should be stored next to the trajectory
+ *
+ * This is the case when there already is an index file, or when the user
+ * asked for one with the GMX_TRAJECTORY_FRAME_INDEX environment variable.
+ */
+static gmx_bool use_frame_index_file(t_fileio* fio)
+{
+    const int ftp = gmx_fio_getftp(fio);
+
+    return (ftp == efXTC || ftp == efTRR)
+           && (getenv("GMX_TRAJECTORY_FRAME_INDEX") != nullptr
+               || gmx_fexist(gmx::trajectoryFrameIndexFileName(gmx_fio_getname(fio))));
+}
+
+const gmx::TrajectoryFrameIndex& trx_get_frame_index(t_trxstatus* status)
+{
+    if (status->frameIndex == nullptr)
+    {
+        if (status->fio == nullptr
+            || (gmx_fio_getftp(status->fio) != efXTC && gmx_fio_getftp(status->fio) != efTRR))
+        {
+            gmx_incons("Frame indices are only supported for XTC and TRR");
+        }
+        status->frameIndex = new gmx::TrajectoryFrameIndex(gmx::loadOrBuildTrajectoryFrameIndex(
+                status->fio, use_frame_index_file(status->fio)));
+    }
+    return *status->frameIndex;
+}
+
+gmx_bool trx_seek_frame(t_trxstatus* status, gmx::index frame)
+{
+    const gmx::TrajectoryFrameIndex& frameIndex = trx_get_frame_index(status);
+
+    if (frame < 0 || frame >= frameIndex.numFrames())
+    {
+        return FALSE;
+    }
+    initcount(status);
+
+    return gmx_fio_seek(status->fio, frameIndex.frames()[frame].offset) == 0;
+}
+
+/*! \brief Positions the trajectory at the first frame not before \p time using the frame index
+ *
+ * When there is no such frame, the trajectory is positioned at its end.
+ */
+static void seek_frame_index_time(t_trxstatus* status, real time)
+{
+    const gmx::TrajectoryFrameIndex& frameIndex = trx_get_frame_index(status);
+    const gmx::index                 frame      = frameIndex.findFirstFrameNotBefore(time);
+
+    initcount(status);
+    if (frame < frameIndex.numFrames())
+    {
+        gmx_fio_seek(status->fio, frameIndex.frames()[frame].offset);
+    }
+    else
+    {
+        gmx_fio_seek(status->fio, frameIndex.trajectorySize());
+    }
+}
+
 void clear_trxframe(t_trxframe* fr, gmx_bool bFirst)
 {
     fr->not_ok    = 0;
@@ -603,6 +680,7 @@ void close_trx(t_trxstatus* status)
         gmx_fio_close(status->fio);
     }
     sfree(status->persistent_line);
+    delete status->frameIndex;
 #if GMX_USE_PLUGINS
     sfree(status->vmdplugin);
 #endif
@@ -790,7 +868,13 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
         }
         switch (ftp)
         {
-            case efTRR: bRet = gmx_next_frame(status, fr); break;
+            case efTRR:
+                if (status->bUseFrameIndex && bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
+                {
+                    seek_frame_index_time(status, rTimeValue(TBEGIN));
+                }
+                bRet = gmx_next_frame(status, fr);
+                break;
             case efCPT:
                 /* Checkpoint files can not contain mulitple frames */
                 break;
@@ -803,7 +887,11 @@ bool read_next_frame(const gmx_output_env_t* oenv, t_trxstatus* status, t_trxfra
                 break;
             }
             case efXTC:
-                if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
+                if (status->bUseFrameIndex && bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
+                {
+                    seek_frame_index_time(status, rTimeValue(TBEGIN));
+                }
+                else if (bTimeSet(TBEGIN) && (status->tf < rTimeValue(TBEGIN)))
                 {
                     if (xtc_seek_time(status->fio, rTimeValue(TBEGIN), fr->natoms, TRUE))
                     {
@@ -905,6 +993,7 @@ bool read_first_frame(const gmx_output_env_t* oenv, t_trxstatus** status, const
     else
     {
         fio = (*status)->fio = gmx_fio_open(fn, "r");
+        (*status)->bUseFrameIndex = use_frame_index_file(fio);
     }
     switch (ftp)
     {
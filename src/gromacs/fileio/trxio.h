@@ -48,6 +48,11 @@ struct t_fileio;
 struct t_topology;
 struct t_trxframe;
 
+namespace gmx
+{
+class TrajectoryFrameIndex;
+} // namespace gmx
+
 /* a dedicated status type contains fp, etc. */
 typedef struct t_trxstatus t_trxstatus;
 
@@ -158,7 +163,22 @@ struct t_fileio* trx_get_fileio(t_trxstatus* status);
 /* get a fileio from a trxstatus */
 
 float trx_get_time_of_final_frame(t_trxstatus* status);
-/* get time of final frame. Only supported for TNG and XTC */
+/* get time of final frame. Only supported for TNG, XTC and TRR */
+
+const gmx::TrajectoryFrameIndex& trx_get_frame_index(t_trxstatus* status);
+/* Get the index of the frames in an XTC or TRR trajectory opened with
+ * read_first_frame. It is read from the index file next to the trajectory
+ * when that is up to date, otherwise it is built by scanning the frame
+ * headers. In the latter case the index file is (re)written when it
+ * existed or when the environment variable GMX_TRAJECTORY_FRAME_INDEX is set.
+ * With an index file, read_next_frame also uses it to seek to the begin time.
+ */
+
+gmx_bool trx_seek_frame(t_trxstatus* status, gmx::index frame);
+/* Position the trajectory such that the next call to read_next_frame
+ * reads frame number frame of the frame index.
+ * Returns FALSE if there is no such frame.
+ */
 
 gmx_bool bRmod_fd(double a, double b, double c, gmx_bool bDouble);
 /* Returns TRUE when (a - b) MOD c = 0, using a margin which is slightly
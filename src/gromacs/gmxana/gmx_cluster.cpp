@@ -41,6 +41,8 @@
 #include <cstring>
 
 #include <algorithm>
+#include <functional>
+#include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
@@ -62,8 +64,10 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 
@@ -314,11 +318,312 @@ static real rms_dist(int isize, real** d, real** d_r)
     return std::sqrt(r2);
 }
 
+/* Allocates a work array for the distances within one frame for calc_dist */
+static real** new_dist_work(int isize)
+{
+    real** d;
+
+    snew(d, isize);
+    for (int i = 0; i < isize; i++)
+    {
+        snew(d[i], isize);
+    }
+
+    return d;
+}
+
+static void done_dist_work(int isize, real** d)
+{
+    for (int i = 0; i < isize; i++)
+    {
+        sfree(d[i]);
+    }
+    sfree(d);
+}
+
+/* Calls storePair(i1, i2, rmsd) for all pairs of the nf frames in xx with
+ * i2 > i1, or with bFullRows for all pairs with i2 != i1. The RMSD is the
+ * RMS deviation or, with bRMSdist, the RMS distance deviation.
+ * With bFit the RMS deviation after fitting is computed directly with
+ * rmsdev_fit, without rotating a copy of the frame.
+ * The rows i1 are distributed dynamically over the OpenMP threads, since
+ * the number of pairs per row decreases with the row index. A row is
+ * handled by a single thread, so storePair can modify data for row i1
+ * without synchronization.
+ */
+template<typename StorePair>
+static void calc_rmsd_pairs(int              nf,
+                            int              isize,
+                            rvec**           xx,
+                            real*            mass,
+                            gmx_bool         bFit,
+                            gmx_bool         bRMSdist,
+                            gmx_bool         bFullRows,
+                            const StorePair& storePair)
+{
+    const int nthreads = gmx_omp_get_max_threads();
+
+#pragma omp parallel num_threads(nthreads)
+    {
+        try
+        {
+            /* Thread-local work arrays */
+            real** d1 = bRMSdist ? new_dist_work(isize) : nullptr;
+            real** d2 = bRMSdist ? new_dist_work(isize) : nullptr;
+
+#pragma omp for schedule(dynamic)
+            for (int i1 = 0; i1 < nf; i1++)
+            {
+                if (bRMSdist)
+                {
+                    calc_dist(isize, xx[i1], d1);
+                }
+                for (int i2 = (bFullRows ? 0 : i1 + 1); i2 < nf; i2++)
+                {
+                    if (i2 == i1)
+                    {
+                        continue;
+                    }
+                    /* Always pass the frames in the same order, so the RMSD
+                     * of a pair is the same in both rows with bFullRows.
+                     */
+                    const int ilo = std::min(i1, i2);
+                    const int ihi = std::max(i1, i2);
+                    real      r;
+                    if (bRMSdist)
+                    {
+                        calc_dist(isize, xx[i2], d2);
+                        r = rms_dist(isize, d1, d2);
+                    }
+                    else if (bFit)
+                    {
+                        r = rmsdev_fit(isize, mass, xx[ihi], xx[ilo]);
+                    }
+                    else
+                    {
+                        r = rmsdev(isize, mass, xx[ihi], xx[ilo]);
+                    }
+                    storePair(i1, i2, r);
+                }
+                /* Rows are handed out in order, so the rows after i1 are
+                 * (about) the ones left to compute.
+                 */
+                if (gmx_omp_get_thread_num() == 0)
+                {
+                    const int64_t nrowsLeft = nf - i1 - 1;
+                    const int64_t nrms =
+                            bFullRows ? nrowsLeft * (nf - 1) : (nrowsLeft * (nrowsLeft - 1)) / 2;
+                    fprintf(stderr,
+                            "\r# RMSD calculations left: "
+                            "%" PRId64 "   ",
+                            nrms);
+                    fflush(stderr);
+                }
+            }
+
+            if (bRMSdist)
+            {
+                done_dist_work(isize, d1);
+                done_dist_work(isize, d2);
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
+/* Computes the RMS deviation, or with bRMSdist the RMS distance deviation,
+ * between all pairs of the nf frames in xx and stores it in rms.
+ */
+static void calc_rmsd_matrix(int      nf,
+                             int      isize,
+                             rvec**   xx,
+                             real*    mass,
+                             gmx_bool bFit,
+                             gmx_bool bRMSdist,
+                             t_mat*   rms)
+{
+    calc_rmsd_pairs(nf, isize, xx, mass, bFit, bRMSdist, FALSE,
+                    [rms](int i1, int i2, real r) { rms->mat[i1][i2] = r; });
+
+    /* Set the entries serially, since this also updates the RMSD statistics */
+    for (int i1 = 0; i1 < nf; i1++)
+    {
+        for (int i2 = i1 + 1; i2 < nf; i2++)
+        {
+            set_mat_entry(rms, i1, i2, rms->mat[i1][i2]);
+        }
+    }
+}
+
 static bool rms_dist_comp(const t_dist& a, const t_dist& b)
 {
     return a.dist < b.dist;
 }
 
+//! Bin width (nm) of the RMSD histogram accumulated with -sparse
+static const real c_sparseHistogramBinWidth = 1e-5;
+
+/* RMSD neighbor lists, used instead of the RMSD matrix with -sparse.
+ * Only the neighbors used by the gromos and Jarvis-Patrick methods are
+ * stored, so the memory use scales with the number of neighbors instead
+ * of with the square of the number of frames. The statistics over all
+ * pairs are accumulated while computing, as the pairs are not kept.
+ */
+struct t_rmsd_neighbors
+{
+    /* Neighbors j of each frame with their RMSD, sorted on RMSD */
+    std::vector<std::vector<t_dist>> nb;
+    real                             minrms = 1e20;
+    real                             maxrms = 0;
+    double                           sumrms = 0;
+    /* Sum of the squared RMSD of consecutive frames, as mat_energy() */
+    double energy = 0;
+    /* Counts of the RMSD of all pairs in bins of c_sparseHistogramBinWidth */
+    std::vector<int64_t> histo;
+};
+
+/* Orders on RMSD and then on frame index, so the neighbor lists do not
+ * depend on the order in which the pairs were computed.
+ */
+static bool rms_dist_index_comp(const t_dist& a, const t_dist& b)
+{
+    return a.dist < b.dist || (a.dist == b.dist && a.j < b.j);
+}
+
+/* Computes the RMSD neighbor lists of the nf frames in xx. All neighbors
+ * within rmsdcut are stored, but at most M when M > 0. A negative rmsdcut
+ * means no cut-off, which requires M > 0.
+ */
+static void calc_rmsd_neighbors(int               nf,
+                                int               isize,
+                                rvec**            xx,
+                                real*             mass,
+                                gmx_bool          bFit,
+                                gmx_bool          bRMSdist,
+                                int               M,
+                                real              rmsdcut,
+                                t_rmsd_neighbors* nbs)
+{
+    GMX_RELEASE_ASSERT(rmsdcut >= 0 || M > 0, "Need a cut-off or a number of neighbors");
+
+    /* Thread-local statistics and neighbor pairs */
+    struct ThreadData
+    {
+        real                 minrms = 1e20;
+        real                 maxrms = 0;
+        double               sumrms = 0;
+        double               energy = 0;
+        std::vector<int64_t> histo;
+        std::vector<t_dist>  pairs;
+    };
+    std::vector<ThreadData> threadData(gmx_omp_get_max_threads());
+
+    /* Without cut-off, the M nearest neighbors of a frame can only be
+     * selected from its full row, so then each pair is computed twice.
+     */
+    const gmx_bool bFullRows = (rmsdcut < 0);
+    nbs->nb.resize(nf);
+
+    calc_rmsd_pairs(nf, isize, xx, mass, bFit, bRMSdist, bFullRows, [&](int i1, int i2, real r) {
+        ThreadData& td = threadData[gmx_omp_get_thread_num()];
+        if (i2 > i1)
+        {
+            td.minrms = std::min(td.minrms, r);
+            td.maxrms = std::max(td.maxrms, r);
+            td.sumrms += r;
+            if (i2 == i1 + 1)
+            {
+                td.energy += gmx::square(r);
+            }
+            const size_t bin = gmx::roundToInt(r / c_sparseHistogramBinWidth);
+            if (bin >= td.histo.size())
+            {
+                td.histo.resize(bin + 1);
+            }
+            td.histo[bin]++;
+        }
+        if (bFullRows)
+        {
+            /* Row i1 is only accessed by this thread. Prune it to the M
+             * nearest neighbors now and then to bound the memory use.
+             */
+            std::vector<t_dist>& row = nbs->nb[i1];
+            row.push_back({ i1, i2, r });
+            if (gmx::ssize(row) >= 2 * M)
+            {
+                std::nth_element(row.begin(), row.begin() + M, row.end(), rms_dist_index_comp);
+                row.resize(M);
+            }
+        }
+        else if (r < rmsdcut)
+        {
+            td.pairs.push_back({ i1, i2, r });
+        }
+    });
+
+    for (ThreadData& td : threadData)
+    {
+        nbs->minrms = std::min(nbs->minrms, td.minrms);
+        nbs->maxrms = std::max(nbs->maxrms, td.maxrms);
+        nbs->sumrms += td.sumrms;
+        nbs->energy += td.energy;
+        if (td.histo.size() > nbs->histo.size())
+        {
+            nbs->histo.resize(td.histo.size());
+        }
+        for (size_t bin = 0; bin < td.histo.size(); bin++)
+        {
+            nbs->histo[bin] += td.histo[bin];
+        }
+        for (const t_dist& pair : td.pairs)
+        {
+            nbs->nb[pair.i].push_back({ pair.i, pair.j, pair.dist });
+            nbs->nb[pair.j].push_back({ pair.j, pair.i, pair.dist });
+        }
+        td.pairs.clear();
+        td.pairs.shrink_to_fit();
+    }
+
+#pragma omp parallel for num_threads(gmx_omp_get_max_threads()) schedule(dynamic, 16)
+    for (int i = 0; i < nf; i++)
+    {
+        std::vector<t_dist>& row = nbs->nb[i];
+        std::sort(row.begin(), row.end(), rms_dist_index_comp);
+        if (M > 0 && gmx::ssize(row) > M)
+        {
+            row.resize(M);
+            row.shrink_to_fit();
+        }
+    }
+}
+
+/* Writes the RMSD distribution as rmsd_distribution() does, but using the
+ * histogram accumulated with -sparse.
+ */
+static void sparse_rmsd_distribution(const char*             fn,
+                                     const t_rmsd_neighbors& nbs,
+                                     const gmx_output_env_t* oenv)
+{
+    const real fac        = 100 / nbs.maxrms;
+    int64_t    histo[101] = { 0 };
+
+    for (size_t bin = 0; bin < nbs.histo.size(); bin++)
+    {
+        const int x = gmx::roundToInt(fac * bin * c_sparseHistogramBinWidth);
+        if (x <= 100)
+        {
+            histo[x] += nbs.histo[bin];
+        }
+    }
+
+    FILE* fp = xvgropen(fn, "RMS Distribution", "RMS (nm)", "counts", oenv);
+    for (int i = 0; (i < 101); i++)
+    {
+        fprintf(fp, "%10g  %10" PRId64 "\n", i / fac, histo[i]);
+    }
+    xvgrclose(fp);
+}
+
 static bool clust_id_comp(const t_clustid& a, const t_clustid& b)
 {
     return a.clust < b.clust;
@@ -458,121 +763,59 @@ static gmx_bool jp_same(int** nnb, int i, int j, int P)
     return (pp >= P);
 }
 
-static void jarvis_patrick(int n1, real** mat, int M, int P, real rmsdcut, t_clusters* clust)
+/* Clusters the n1 structures with the Jarvis-Patrick method given the
+ * nearest neighbor lists nnb, which are terminated by -1, and frees nnb.
+ */
+static void jarvis_patrick_link(int n1, int** nnb, int P, t_clusters* clust)
 {
-    t_dist*    row;
     t_clustid* c;
-    int**      nnb;
-    int        i, j, k, cid, diff, maxval;
+    int        k, cid, diff;
     gmx_bool   bChange;
-    real**     mcpy = nullptr;
 
-    if (rmsdcut < 0)
-    {
-        rmsdcut = 10000;
-    }
-
-    /* First we sort the entries in the RMSD matrix row by row.
-     * This gives us the nearest neighbor list.
+    c = new_clustid(n1);
+    fprintf(stderr, "Linking structures ");
+    /* Structures can only be linked when they have each other as neighbors,
+     * so only the neighbors j > i of each structure i need to be checked.
      */
-    snew(nnb, n1);
-    snew(row, n1);
-    for (i = 0; (i < n1); i++)
+    const int                                     nthreads = gmx_omp_get_max_threads();
+    std::vector<std::vector<std::pair<int, int>>> threadLinks(nthreads);
+#pragma omp parallel for num_threads(nthreads) schedule(dynamic, 16)
+    for (int i = 0; i < n1; i++)
     {
-        for (j = 0; (j < n1); j++)
-        {
-            row[j].j    = j;
-            row[j].dist = mat[i][j];
-        }
-        std::sort(row, row + n1, rms_dist_comp);
-        if (M > 0)
+        for (int n = 0; nnb[i][n] >= 0; n++)
         {
-            /* Put the M nearest neighbors in the list */
-            snew(nnb[i], M + 1);
-            for (j = k = 0; (k < M) && (j < n1) && (mat[i][row[j].j] < rmsdcut); j++)
+            const int j = nnb[i][n];
+            if (j > i && jp_same(nnb, i, j, P))
             {
-                if (row[j].j != i)
-                {
-                    nnb[i][k] = row[j].j;
-                    k++;
-                }
+                threadLinks[gmx_omp_get_thread_num()].emplace_back(i, j);
             }
-            nnb[i][k] = -1;
-        }
-        else
-        {
-            /* Put all neighbors nearer than rmsdcut in the list */
-            maxval = 0;
-            k      = 0;
-            for (j = 0; (j < n1) && (mat[i][row[j].j] < rmsdcut); j++)
-            {
-                if (row[j].j != i)
-                {
-                    if (k >= maxval)
-                    {
-                        maxval += 10;
-                        srenew(nnb[i], maxval);
-                    }
-                    nnb[i][k] = row[j].j;
-                    k++;
-                }
-            }
-            if (k == maxval)
-            {
-                srenew(nnb[i], maxval + 1);
-            }
-            nnb[i][k] = -1;
         }
     }
-    sfree(row);
-    if (debug)
+    std::vector<std::pair<int, int>> links;
+    for (const auto& threadLink : threadLinks)
     {
-        fprintf(debug, "Nearest neighborlist. M = %d, P = %d\n", M, P);
-        for (i = 0; (i < n1); i++)
-        {
-            fprintf(debug, "i:%5d nbs:", i);
-            for (j = 0; nnb[i][j] >= 0; j++)
-            {
-                fprintf(debug, "%5d[%5.3f]", nnb[i][j], mat[i][nnb[i][j]]);
-            }
-            fprintf(debug, "\n");
-        }
-    }
-
-    c = new_clustid(n1);
-    fprintf(stderr, "Linking structures ");
-    /* Use mcpy for temporary storage of booleans */
-    mcpy = mk_matrix(n1, n1, FALSE);
-    for (i = 0; i < n1; i++)
-    {
-        for (j = i + 1; j < n1; j++)
-        {
-            mcpy[i][j] = static_cast<real>(jp_same(nnb, i, j, P));
-        }
+        links.insert(links.end(), threadLink.begin(), threadLink.end());
     }
+    std::sort(links.begin(), links.end());
     do
     {
         fprintf(stderr, "*");
         bChange = FALSE;
-        for (i = 0; i < n1; i++)
+        for (const auto& link : links)
         {
-            for (j = i + 1; j < n1; j++)
+            const int i = link.first;
+            const int j = link.second;
+            diff        = c[j].clust - c[i].clust;
+            if (diff)
             {
-                if (mcpy[i][j] != 0.0F)
+                bChange = TRUE;
+                if (diff > 0)
                 {
-                    diff = c[j].clust - c[i].clust;
-                    if (diff)
-                    {
-                        bChange = TRUE;
-                        if (diff > 0)
-                        {
-                            c[j].clust = c[i].clust;
-                        }
-                        else
-                        {
-                            c[i].clust = c[j].clust;
-                        }
-                    }
+                    c[j].clust = c[i].clust;
+                }
+                else
+                {
+                    c[i].clust = c[j].clust;
                 }
             }
         }
@@ -610,16 +853,127 @@ static void jarvis_patrick(int n1, real** mat, int M, int P, real rmsdcut, t_clu
         }
     }
 
-    done_matrix(n1, &mcpy);
-
     sfree(c);
-    for (i = 0; (i < n1); i++)
+    for (int i = 0; (i < n1); i++)
     {
         sfree(nnb[i]);
     }
     sfree(nnb);
 }
 
+static void jarvis_patrick(int n1, real** mat, int M, int P, real rmsdcut, t_clusters* clust)
+{
+    int** nnb;
+    int   i, j;
+
+    if (rmsdcut < 0)
+    {
+        rmsdcut = 10000;
+    }
+
+    /* First we sort the entries in the RMSD matrix row by row.
+     * This gives us the nearest neighbor list.
+     */
+    snew(nnb, n1);
+#pragma omp parallel num_threads(gmx_omp_get_max_threads())
+    {
+        try
+        {
+            t_dist* row;
+            snew(row, n1);
+#pragma omp for schedule(dynamic, 16)
+            for (int i = 0; i < n1; i++)
+            {
+                int j, k;
+                for (j = 0; (j < n1); j++)
+                {
+                    row[j].j    = j;
+                    row[j].dist = mat[i][j];
+                }
+                std::sort(row, row + n1, rms_dist_comp);
+                if (M > 0)
+                {
+                    /* Put the M nearest neighbors in the list */
+                    snew(nnb[i], M + 1);
+                    for (j = k = 0; (k < M) && (j < n1) && (mat[i][row[j].j] < rmsdcut); j++)
+                    {
+                        if (row[j].j != i)
+                        {
+                            nnb[i][k] = row[j].j;
+                            k++;
+                        }
+                    }
+                    nnb[i][k] = -1;
+                }
+                else
+                {
+                    /* Put all neighbors nearer than rmsdcut in the list */
+                    int maxval = 0;
+                    k          = 0;
+                    for (j = 0; (j < n1) && (mat[i][row[j].j] < rmsdcut); j++)
+                    {
+                        if (row[j].j != i)
+                        {
+                            if (k >= maxval)
+                            {
+                                maxval += 10;
+                                srenew(nnb[i], maxval);
+                            }
+                            nnb[i][k] = row[j].j;
+                            k++;
+                        }
+                    }
+                    if (k == maxval)
+                    {
+                        srenew(nnb[i], maxval + 1);
+                    }
+                    nnb[i][k] = -1;
+                }
+            }
+            sfree(row);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+    if (debug)
+    {
+        fprintf(debug, "Nearest neighborlist. M = %d, P = %d\n", M, P);
+        for (i = 0; (i < n1); i++)
+        {
+            fprintf(debug, "i:%5d nbs:", i);
+            for (j = 0; nnb[i][j] >= 0; j++)
+            {
+                fprintf(debug, "%5d[%5.3f]", nnb[i][j], mat[i][nnb[i][j]]);
+            }
+            fprintf(debug, "\n");
+        }
+    }
+
+    jarvis_patrick_link(n1, nnb, P, clust);
+}
+
+/* Clusters with the Jarvis-Patrick method using the neighbor lists of
+ * -sparse, which are already limited to M neighbors and the cut-off.
+ */
+static void jarvis_patrick_sparse(const t_rmsd_neighbors& nbs, int P, t_clusters* clust)
+{
+    const int n1 = gmx::ssize(nbs.nb);
+    int**     nnb;
+
+    snew(nnb, n1);
+    for (int i = 0; i < n1; i++)
+    {
+        const int nnbi = gmx::ssize(nbs.nb[i]);
+        snew(nnb[i], nnbi + 1);
+        for (int k = 0; k < nnbi; k++)
+        {
+            nnb[i][k] = nbs.nb[i][k].j;
+        }
+        nnb[i][nnbi] = -1;
+    }
+
+    jarvis_patrick_link(n1, nnb, P, clust);
+}
+
 static void dump_nnb(FILE* fp, const char* title, int n1, t_nnb* nnb)
 {
     int i, j;
@@ -637,40 +991,12 @@ static void dump_nnb(FILE* fp, const char* title, int n1, t_nnb* nnb)
     }
 }
 
-static void gromos(int n1, real** mat, real rmsdcut, t_clusters* clust)
+/* Clusters the n1 structures with the gromos method given the lists nnb
+ * of neighbors within the cut-off, and frees nnb.
+ */
+static void gromos_cluster(int n1, t_nnb* nnb, t_clusters* clust)
 {
-    t_nnb* nnb;
-    int    i, j, k, j1, maxval;
-
-    /* Put all neighbors nearer than rmsdcut in the list */
-    fprintf(stderr, "Making list of neighbors within cutoff ");
-    snew(nnb, n1);
-    for (i = 0; (i < n1); i++)
-    {
-        maxval = 0;
-        k      = 0;
-        /* put all neighbors within cut-off in list */
-        for (j = 0; j < n1; j++)
-        {
-            if (mat[i][j] < rmsdcut)
-            {
-                if (k >= maxval)
-                {
-                    maxval += 10;
-                    srenew(nnb[i].nb, maxval);
-                }
-                nnb[i].nb[k] = j;
-                k++;
-            }
-        }
-        /* store nr of neighbors, we'll need that */
-        nnb[i].nr = k;
-        if (i % (1 + n1 / 100) == 0)
-        {
-            fprintf(stderr, "%3d%%\b\b\b\b", (i * 100 + 1) / n1);
-        }
-    }
-    fprintf(stderr, "%3d%%\n", 100);
+    int i, j, k, j1;
 
     /* sort neighbor list on number of neighbors, largest first */
     std::sort(nnb, nnb + n1, nrnb_comp);
@@ -737,6 +1063,74 @@ static void gromos(int n1, real** mat, real rmsdcut, t_clusters* clust)
     clust->ncl = k - 1;
 }
 
+static void gromos(int n1, real** mat, real rmsdcut, t_clusters* clust)
+{
+    t_nnb* nnb;
+
+    /* Put all neighbors nearer than rmsdcut in the list */
+    fprintf(stderr, "Making list of neighbors within cutoff ");
+    snew(nnb, n1);
+#pragma omp parallel for num_threads(gmx_omp_get_max_threads()) schedule(dynamic, 16)
+    for (int row = 0; row < n1; row++)
+    {
+        int nbMax = 0;
+        int nbNr  = 0;
+        /* put all neighbors within cut-off in list */
+        for (int col = 0; col < n1; col++)
+        {
+            if (mat[row][col] < rmsdcut)
+            {
+                if (nbNr >= nbMax)
+                {
+                    nbMax += 10;
+                    srenew(nnb[row].nb, nbMax);
+                }
+                nnb[row].nb[nbNr] = col;
+                nbNr++;
+            }
+        }
+        /* store nr of neighbors, we'll need that */
+        nnb[row].nr = nbNr;
+        if (gmx_omp_get_thread_num() == 0 && row % (1 + n1 / 100) == 0)
+        {
+            fprintf(stderr, "%3d%%\b\b\b\b", (row * 100 + 1) / n1);
+        }
+    }
+    fprintf(stderr, "%3d%%\n", 100);
+
+    gromos_cluster(n1, nnb, clust);
+}
+
+/* Clusters with the gromos method using the neighbor lists of -sparse */
+static void gromos_sparse(const t_rmsd_neighbors& nbs, real rmsdcut, t_clusters* clust)
+{
+    const int n1 = gmx::ssize(nbs.nb);
+    t_nnb*    nnb;
+
+    /* The lists of the dense matrix include the structure itself,
+     * which is at zero RMSD, and are ordered on structure index.
+     */
+    snew(nnb, n1);
+    for (int i = 0; i < n1; i++)
+    {
+        const gmx_bool bSelf = (0 < rmsdcut);
+        nnb[i].nr            = gmx::ssize(nbs.nb[i]) + (bSelf ? 1 : 0);
+        snew(nnb[i].nb, nnb[i].nr);
+        int k = 0;
+        for (const t_dist& nb : nbs.nb[i])
+        {
+            nnb[i].nb[k++] = nb.j;
+        }
+        if (bSelf)
+        {
+            nnb[i].nb[k++] = i;
+        }
+        std::sort(nnb[i].nb, nnb[i].nb + nnb[i].nr);
+    }
+
+    gromos_cluster(n1, nnb, clust);
+}
+
 static rvec** read_whole_trj(const char*             fn,
                              int                     isize,
                              const int               index[],
@@ -971,36 +1365,36 @@ static void ana_trans(t_clusters*             clust,
     sfree(axis);
 }
 
-static void analyze_clusters(int                     nf,
-                             t_clusters*             clust,
-                             real**                  rmsd,
-                             int                     natom,
-                             t_atoms*                atoms,
-                             rvec*                   xtps,
-                             real*                   mass,
-                             rvec**                  xx,
-                             real*                   time,
-                             matrix*                 boxes,
-                             int*                    frameindices,
-                             int                     ifsize,
-                             int*                    fitidx,
-                             int                     iosize,
-                             int*                    outidx,
-                             const char*             trxfn,
-                             const char*             sizefn,
-                             const char*             transfn,
-                             const char*             ntransfn,
-                             const char*             clustidfn,
-                             const char*             clustndxfn,
-                             gmx_bool                bAverage,
-                             int                     write_ncl,
-                             int                     write_nst,
-                             real                    rmsmin,
-                             gmx_bool                bFit,
-                             FILE*                   log,
-                             t_rgb                   rlo,
-                             t_rgb                   rhi,
-                             const gmx_output_env_t* oenv)
+static void analyze_clusters(int                                  nf,
+                             t_clusters*                          clust,
+                             const std::function<real(int, int)>& rmsd,
+                             int                                  natom,
+                             t_atoms*                             atoms,
+                             rvec*                                xtps,
+                             real*                                mass,
+                             rvec**                               xx,
+                             real*                                time,
+                             matrix*                              boxes,
+                             int*                                 frameindices,
+                             int                                  ifsize,
+                             int*                                 fitidx,
+                             int                                  iosize,
+                             int*                                 outidx,
+                             const char*                          trxfn,
+                             const char*                          sizefn,
+                             const char*                          transfn,
+                             const char*                          ntransfn,
+                             const char*                          clustidfn,
+                             const char*                          clustndxfn,
+                             gmx_bool                             bAverage,
+                             int                                  write_ncl,
+                             int                                  write_nst,
+                             real                                 rmsmin,
+                             gmx_bool                             bFit,
+                             FILE*                                log,
+                             t_rgb                                rlo,
+                             t_rgb                                rhi,
+                             const gmx_output_env_t*              oenv)
 {
     FILE*        size_fp = nullptr;
     FILE*        ndxfn   = nullptr;
@@ -1169,11 +1563,11 @@ static void analyze_clusters(int                     nf,
                 {
                     if (i < i1)
                     {
-                        r += rmsd[structure[i]][structure[i1]];
+                        r += rmsd(structure[i], structure[i1]);
                     }
                     else
                     {
-                        r += rmsd[structure[i1]][structure[i]];
+                        r += rmsd(structure[i1], structure[i]);
                     }
                 }
                 r /= (nstr - 1);
@@ -1259,7 +1653,7 @@ static void analyze_clusters(int                     nf,
                         {
                             if (bWrite[i1])
                             {
-                                bWrite[i] = rmsd[structure[i1]][structure[i]] > rmsmin;
+                                bWrite[i] = rmsd(structure[i1], structure[i]) > rmsmin;
                             }
                         }
                     }
@@ -1391,6 +1785,15 @@ int gmx_cluster(int argc, char* argv[])
         "file. When writing all structures, separate numbered files are made",
         "for each cluster.[PAR]",
 
+        "With [TT]-sparse[tt], the gromos and Jarvis-Patrick methods only store",
+        "the neighbors of each structure instead of the full RMSD matrix, so the",
+        "memory use scales with the number of neighbors instead of with the",
+        "square of the number of frames. The matrix [TT]-o[tt] is then not",
+        "written, the RMSD distribution is binned from a histogram with",
+        "0.00001 nm bins and the RMSDs within each cluster are recomputed for",
+        "the cluster analysis. Jarvis-Patrick without [TT]-cutoff[tt] then",
+        "computes each RMSD twice.[PAR]",
+
         "Two output files are always written:",
         "",
         " * [TT]-o[tt] writes the RMSD values in the upper left half of the matrix",
@@ -1426,11 +1829,10 @@ int gmx_cluster(int argc, char* argv[])
 
     FILE *  fp, *log;
     int     nf   = 0, i, i1, i2, j;
-    int64_t nrms = 0;
 
     matrix      box;
     matrix*     boxes = nullptr;
-    rvec *      xtps, *usextps, *x1, **xx = nullptr;
+    rvec *      xtps, *usextps, **xx = nullptr;
     const char *fn, *trx_out_fn;
     t_clusters  clust;
     t_mat *     rms, *orig = nullptr;
@@ -1443,7 +1845,7 @@ int gmx_cluster(int argc, char* argv[])
     int      isize = 0, ifsize = 0, iosize = 0;
     int *    index = nullptr, *fitidx = nullptr, *outidx = nullptr, *frameindices = nullptr;
     char*    grpname;
-    real     rmsd, **d1, **d2, *time = nullptr, time_invfac, *mass = nullptr;
+    real     *time = nullptr, time_invfac, *mass = nullptr;
     char     buf[STRLEN], buf1[80];
     gmx_bool bAnalyze, bUseRmsdCut, bJP_RMSD = FALSE, bReadMat, bReadTraj, bPBC = TRUE;
 
@@ -1469,6 +1871,7 @@ int gmx_cluster(int argc, char* argv[])
     static int   nlevels = 40, skip = 1;
     static real  scalemax = -1.0, rmsdcut = 0.1, rmsmin = 0.0;
     gmx_bool     bRMSdist = FALSE, bBinary = FALSE, bAverage = FALSE, bFit = TRUE;
+    gmx_bool     bSparse  = FALSE;
     static int   niter = 10000, nrandom = 0, seed = 0, write_ncl = 0, write_nst = 1, minstruct = 1;
     static real  kT = 1e-3;
     static int   M = 10, P = 3;
@@ -1533,6 +1936,12 @@ int gmx_cluster(int argc, char* argv[])
           etINT,
           { &P },
           "Number of identical nearest neighbors required to form a cluster" },
+        { "-sparse",
+          FALSE,
+          etBOOL,
+          { &bSparse },
+          "Only store the RMSD neighbor lists instead of the RMSD matrix, "
+          "for the gromos and jarvis-patrick methods" },
         { "-seed",
           FALSE,
           etINT,
@@ -1655,6 +2064,18 @@ int gmx_cluster(int argc, char* argv[])
     {
         fprintf(log, "Using RMSD cutoff %g nm\n", rmsdcut);
     }
+    if (bSparse)
+    {
+        if (method != m_gromos && method != m_jarvis_patrick)
+        {
+            gmx_fatal(FARGS, "-sparse can only be used with the gromos and jarvis-patrick methods");
+        }
+        if (bReadMat)
+        {
+            gmx_fatal(FARGS, "-sparse can not be used with an RMSD matrix read with -dm");
+        }
+        fprintf(log, "Only storing the RMSD neighbor lists\n");
+    }
     if (method == m_monte_carlo)
     {
         fprintf(log, "Using %d iterations\n", niter);
@@ -1751,6 +2172,7 @@ int gmx_cluster(int argc, char* argv[])
     }
 
     std::vector<t_matrix> readmat;
+    t_rmsd_neighbors      rmsdNeighbors;
     if (bReadMat)
     {
         fprintf(stderr, "Reading rms distance matrix ");
@@ -1782,91 +2204,42 @@ int gmx_cluster(int argc, char* argv[])
 
         nlevels = gmx::ssize(readmat[0].map);
     }
+    else if (bSparse)
+    {
+        rms = nullptr;
+        fprintf(stderr, "Computing RMS%sdeviation neighbor lists for %d structures\n",
+                bRMSdist ? " distance " : " ", nf);
+        calc_rmsd_neighbors(nf, isize, xx, mass, bFit, bRMSdist, method == m_jarvis_patrick ? M : 0,
+                            (method == m_gromos || bJP_RMSD) ? rmsdcut : -1, &rmsdNeighbors);
+        fprintf(stderr, "\n\n");
+    }
     else /* !bReadMat */
     {
-        rms  = init_mat(nf, method == m_diagonalize);
-        nrms = (static_cast<int64_t>(nf) * static_cast<int64_t>(nf - 1)) / 2;
-        if (!bRMSdist)
-        {
-            fprintf(stderr, "Computing %dx%d RMS deviation matrix\n", nf, nf);
-            /* Initialize work array */
-            snew(x1, isize);
-            for (i1 = 0; i1 < nf; i1++)
-            {
-                for (i2 = i1 + 1; i2 < nf; i2++)
-                {
-                    for (i = 0; i < isize; i++)
-                    {
-                        copy_rvec(xx[i1][i], x1[i]);
-                    }
-                    if (bFit)
-                    {
-                        do_fit(isize, mass, xx[i2], x1);
-                    }
-                    rmsd = rmsdev(isize, mass, xx[i2], x1);
-                    set_mat_entry(rms, i1, i2, rmsd);
-                }
-                nrms -= nf - i1 - 1;
-                fprintf(stderr,
-                        "\r# RMSD calculations left: "
-                        "%" PRId64 "   ",
-                        nrms);
-                fflush(stderr);
-            }
-            sfree(x1);
-        }
-        else /* bRMSdist */
-        {
-            fprintf(stderr, "Computing %dx%d RMS distance deviation matrix\n", nf, nf);
-
-            /* Initiate work arrays */
-            snew(d1, isize);
-            snew(d2, isize);
-            for (i = 0; (i < isize); i++)
-            {
-                snew(d1[i], isize);
-                snew(d2[i], isize);
-            }
-            for (i1 = 0; i1 < nf; i1++)
-            {
-                calc_dist(isize, xx[i1], d1);
-                for (i2 = i1 + 1; (i2 < nf); i2++)
-                {
-                    calc_dist(isize, xx[i2], d2);
-                    set_mat_entry(rms, i1, i2, rms_dist(isize, d1, d2));
-                }
-                nrms -= nf - i1 - 1;
-                fprintf(stderr,
-                        "\r# RMSD calculations left: "
-                        "%" PRId64 "   ",
-                        nrms);
-                fflush(stderr);
-            }
-            /* Clean up work arrays */
-            for (i = 0; (i < isize); i++)
-            {
-                sfree(d1[i]);
-                sfree(d2[i]);
-            }
-            sfree(d1);
-            sfree(d2);
-        }
+        rms = init_mat(nf, method == m_diagonalize);
+        fprintf(stderr, "Computing %dx%d RMS%sdeviation matrix\n", nf, nf,
+                bRMSdist ? " distance " : " ");
+        calc_rmsd_matrix(nf, isize, xx, mass, bFit, bRMSdist, rms);
         fprintf(stderr, "\n\n");
     }
-    ffprintf_gg(stderr, log, buf, "The RMSD ranges from %g to %g nm\n", rms->minrms, rms->maxrms);
-    ffprintf_g(stderr, log, buf, "Average RMSD is %g\n", 2 * rms->sumrms / (nf * (nf - 1)));
+    const real minrms = bSparse ? rmsdNeighbors.minrms : rms->minrms;
+    const real maxrms = bSparse ? rmsdNeighbors.maxrms : rms->maxrms;
+    const real sumrms = bSparse ? rmsdNeighbors.sumrms : rms->sumrms;
+    const real energy = bSparse ? rmsdNeighbors.energy : mat_energy(rms);
+    ffprintf_gg(stderr, log, buf, "The RMSD ranges from %g to %g nm\n", minrms, maxrms);
+    ffprintf_g(stderr, log, buf, "Average RMSD is %g\n",
+               2 * sumrms / (static_cast<double>(nf) * (nf - 1)));
     ffprintf_d(stderr, log, buf, "Number of structures for matrix %d\n", nf);
-    ffprintf_g(stderr, log, buf, "Energy of the matrix is %g.\n", mat_energy(rms));
-    if (bUseRmsdCut && (rmsdcut < rms->minrms || rmsdcut > rms->maxrms))
+    ffprintf_g(stderr, log, buf, "Energy of the matrix is %g.\n", energy);
+    if (bUseRmsdCut && (rmsdcut < minrms || rmsdcut > maxrms))
     {
         fprintf(stderr,
                 "WARNING: rmsd cutoff %g is outside range of rmsd values "
                 "%g to %g\n",
-                rmsdcut, rms->minrms, rms->maxrms);
+                rmsdcut, minrms, maxrms);
     }
-    if (bAnalyze && (rmsmin < rms->minrms))
+    if (bAnalyze && (rmsmin < minrms))
     {
-        fprintf(stderr, "WARNING: rmsd minimum %g is below lowest rmsd value %g\n", rmsmin, rms->minrms);
+        fprintf(stderr, "WARNING: rmsd minimum %g is below lowest rmsd value %g\n", rmsmin, minrms);
     }
     if (bAnalyze && (rmsmin > rmsdcut))
     {
@@ -1874,9 +2247,16 @@ int gmx_cluster(int argc, char* argv[])
     }
 
     /* Plot the rmsd distribution */
-    rmsd_distribution(opt2fn("-dist", NFILE, fnm), rms, oenv);
+    if (bSparse)
+    {
+        sparse_rmsd_distribution(opt2fn("-dist", NFILE, fnm), rmsdNeighbors, oenv);
+    }
+    else
+    {
+        rmsd_distribution(opt2fn("-dist", NFILE, fnm), rms, oenv);
+    }
 
-    if (bBinary)
+    if (bBinary && !bSparse)
     {
         for (i1 = 0; (i1 < nf); i1++)
         {
@@ -1924,9 +2304,25 @@ int gmx_cluster(int argc, char* argv[])
             mc_optimize(log, rms, time, niter, nrandom, seed, kT, opt2fn_null("-conv", NFILE, fnm), oenv);
             break;
         case m_jarvis_patrick:
-            jarvis_patrick(rms->nn, rms->mat, M, P, bJP_RMSD ? rmsdcut : -1, &clust);
+            if (bSparse)
+            {
+                jarvis_patrick_sparse(rmsdNeighbors, P, &clust);
+            }
+            else
+            {
+                jarvis_patrick(rms->nn, rms->mat, M, P, bJP_RMSD ? rmsdcut : -1, &clust);
+            }
+            break;
+        case m_gromos:
+            if (bSparse)
+            {
+                gromos_sparse(rmsdNeighbors, rmsdcut, &clust);
+            }
+            else
+            {
+                gromos(rms->nn, rms->mat, rmsdcut, &clust);
+            }
             break;
-        case m_gromos: gromos(rms->nn, rms->mat, rmsdcut, &clust); break;
         default: gmx_fatal(FARGS, "DEATH HORROR unknown method \"%s\"", methodname[0]);
     }
 
@@ -1937,11 +2333,12 @@ int gmx_cluster(int argc, char* argv[])
 
     if (bAnalyze)
     {
-        if (minstruct > 1)
+        /* Draw the clusters in the matrix, which is not stored with -sparse */
+        if (!bSparse && minstruct > 1)
         {
             ncluster = plot_clusters(nf, rms->mat, &clust, minstruct);
         }
-        else
+        else if (!bSparse)
         {
             mark_clusters(nf, rms->mat, rms->maxrms, &clust);
         }
@@ -1956,12 +2353,53 @@ int gmx_cluster(int argc, char* argv[])
             copy_rvec(xtps[index[i]], usextps[i]);
         }
         useatoms.nr = isize;
-        analyze_clusters(nf, &clust, rms->mat, isize, &useatoms, usextps, mass, xx, time, boxes,
+        std::function<real(int, int)> rmsd;
+        real**                        d1 = nullptr;
+        real**                        d2 = nullptr;
+        if (bSparse)
+        {
+            /* Recompute the RMSDs within the clusters. analyze_clusters only
+             * centers and fits the frames, which does not change the RMSD.
+             */
+            if (bRMSdist)
+            {
+                d1 = new_dist_work(isize);
+                d2 = new_dist_work(isize);
+            }
+            rmsd = [&](int i1, int i2) {
+                const int ilo = std::min(i1, i2);
+                const int ihi = std::max(i1, i2);
+                if (bRMSdist)
+                {
+                    calc_dist(isize, xx[ilo], d1);
+                    calc_dist(isize, xx[ihi], d2);
+                    return rms_dist(isize, d1, d2);
+                }
+                else if (bFit)
+                {
+                    return rmsdev_fit(isize, mass, xx[ihi], xx[ilo]);
+                }
+                else
+                {
+                    return rmsdev(isize, mass, xx[ihi], xx[ilo]);
+                }
+            };
+        }
+        else
+        {
+            rmsd = [rms](int i1, int i2) { return rms->mat[i1][i2]; };
+        }
+        analyze_clusters(nf, &clust, rmsd, isize, &useatoms, usextps, mass, xx, time, boxes,
                          frameindices, ifsize, fitidx, iosize, outidx,
                          bReadTraj ? trx_out_fn : nullptr, opt2fn_null("-sz", NFILE, fnm),
                          opt2fn_null("-tr", NFILE, fnm), opt2fn_null("-ntr", NFILE, fnm),
                          opt2fn_null("-clid", NFILE, fnm), opt2fn_null("-clndx", NFILE, fnm),
                          bAverage, write_ncl, write_nst, rmsmin, bFit, log, rlo_bot, rhi_bot, oenv);
+        if (bSparse && bRMSdist)
+        {
+            done_dist_work(isize, d1);
+            done_dist_work(isize, d2);
+        }
         sfree(boxes);
         sfree(frameindices);
     }
@@ -1982,32 +2420,42 @@ int gmx_cluster(int argc, char* argv[])
         }
     }
 
-    fp = opt2FILE("-o", NFILE, fnm, "w");
-    fprintf(stderr, "Writing rms distance/clustering matrix ");
-    if (bReadMat)
+    if (bSparse)
     {
-        write_xpm(fp, 0, readmat[0].title, readmat[0].legend, readmat[0].label_x,
-                  readmat[0].label_y, nf, nf, readmat[0].axis_x.data(), readmat[0].axis_y.data(),
-                  rms->mat, 0.0, rms->maxrms, rlo_top, rhi_top, &nlevels);
+        fprintf(stderr, "Not writing %s, as the RMSD matrix is not stored with -sparse\n",
+                opt2fn("-o", NFILE, fnm));
     }
     else
     {
-        auto timeLabel = output_env_get_time_label(oenv);
-        auto title = gmx::formatString("RMS%sDeviation / Cluster Index", bRMSdist ? " Distance " : " ");
-        if (minstruct > 1)
+        fp = opt2FILE("-o", NFILE, fnm, "w");
+        fprintf(stderr, "Writing rms distance/clustering matrix ");
+        if (bReadMat)
         {
-            write_xpm_split(fp, 0, title, "RMSD (nm)", timeLabel, timeLabel, nf, nf, time, time,
-                            rms->mat, 0.0, rms->maxrms, &nlevels, rlo_top, rhi_top, 0.0, ncluster,
-                            &ncluster, TRUE, rlo_bot, rhi_bot);
+            write_xpm(fp, 0, readmat[0].title, readmat[0].legend, readmat[0].label_x,
+                      readmat[0].label_y, nf, nf, readmat[0].axis_x.data(),
+                      readmat[0].axis_y.data(), rms->mat, 0.0, rms->maxrms, rlo_top, rhi_top,
+                      &nlevels);
         }
         else
         {
-            write_xpm(fp, 0, title, "RMSD (nm)", timeLabel, timeLabel, nf, nf, time, time, rms->mat,
-                      0.0, rms->maxrms, rlo_top, rhi_top, &nlevels);
+            auto timeLabel = output_env_get_time_label(oenv);
+            auto title     = gmx::formatString("RMS%sDeviation / Cluster Index",
+                                           bRMSdist ? " Distance " : " ");
+            if (minstruct > 1)
+            {
+                write_xpm_split(fp, 0, title, "RMSD (nm)", timeLabel, timeLabel, nf, nf, time,
+                                time, rms->mat, 0.0, rms->maxrms, &nlevels, rlo_top, rhi_top, 0.0,
+                                ncluster, &ncluster, TRUE, rlo_bot, rhi_bot);
+            }
+            else
+            {
+                write_xpm(fp, 0, title, "RMSD (nm)", timeLabel, timeLabel, nf, nf, time, time,
+                          rms->mat, 0.0, rms->maxrms, rlo_top, rhi_top, &nlevels);
+            }
         }
+        fprintf(stderr, "\n");
+        gmx_ffclose(fp);
     }
-    fprintf(stderr, "\n");
-    gmx_ffclose(fp);
     if (nullptr != orig)
     {
         fp             = opt2FILE("-om", NFILE, fnm, "w");
@@ -2020,7 +2468,10 @@ int gmx_cluster(int argc, char* argv[])
         sfree(orig);
     }
     /* now show what we've done */
-    do_view(oenv, opt2fn("-o", NFILE, fnm), "-nxy");
+    if (!bSparse)
+    {
+        do_view(oenv, opt2fn("-o", NFILE, fnm), "-nxy");
+    }
     do_view(oenv, opt2fn_null("-sz", NFILE, fnm), "-nxy");
     if (method == m_diagonalize)
     {
@@ -39,6 +39,9 @@
 #include <cmath>
 #include <cstring>
 
+#include <algorithm>
+#include <vector>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/matio.h"
@@ -57,9 +60,53 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/sysinfo.h"
 
+//! Number of frames that are buffered before they are added to the covariance matrix.
+static const int c_covarFrameBlockSize = 64;
+//! Number of matrix columns that are updated together for a block of frames.
+static const int c_covarColumnTileSize = 1024;
+
+/*! \brief
+ * Adds the outer products of a block of displacement vectors to the covariance matrix.
+ *
+ * Only the elements with a column index at or beyond the first dimension
+ * of the atom of the row are updated; the matrix is symmetrized afterwards.
+ * The rows are distributed over OpenMP threads and the columns are processed
+ * in tiles, such that a tile of a matrix row stays in cache while all frames
+ * in the block are added to it.  The frames are added to each element in
+ * the same order as when updating the matrix frame by frame.
+ *
+ * \param[in]     ndim     Number of rows and columns of the matrix.
+ * \param[in]     nframes  Number of frames in the block.
+ * \param[in]     x        Displacements, \p ndim values for each frame.
+ * \param[in,out] mat      Covariance matrix to add to.
+ */
+static void addFramesToCovariance(int64_t ndim, int nframes, const real* x, real* mat)
+{
+#pragma omp parallel for num_threads(gmx_omp_get_max_threads()) schedule(dynamic, DIM)
+    for (int64_t row = 0; row < ndim; row++)
+    {
+        real* matRow = mat + ndim * row;
+        for (int64_t tileStart = DIM * (row / DIM); tileStart < ndim;
+             tileStart += c_covarColumnTileSize)
+        {
+            const int64_t tileEnd = std::min(tileStart + c_covarColumnTileSize, ndim);
+            for (int f = 0; f < nframes; f++)
+            {
+                const real* xf   = x + ndim * f;
+                const real  xrow = xf[row];
+                for (int64_t col = tileStart; col < tileEnd; col++)
+                {
+                    matRow[col] += xf[col] * xrow;
+                }
+            }
+        }
+    }
+}
+
 int gmx_covar(int argc, char* argv[])
 {
     const char* desc[] = {
@@ -94,7 +141,11 @@ int gmx_covar(int argc, char* argv[])
         "of atoms involved. It is easy to run out of memory, in which",
         "case this tool will probably exit with a 'Segmentation fault'. You",
         "should consider carefully whether a reduced set of atoms will meet",
-        "your needs for lower costs."
+        "your needs for lower costs.",
+        "When only the largest eigenvalues are needed, either because",
+        "[TT]-last[tt] is set or because there are fewer frames than degrees",
+        "of freedom, only those eigenvalues and eigenvectors are computed,",
+        "which reduces both the memory usage and the time for the diagonalization."
     };
     static gmx_bool bFit = TRUE, bRef = FALSE, bM = FALSE, bPBC = TRUE;
     static int      end  = -1;
@@ -119,10 +170,12 @@ int gmx_covar(int argc, char* argv[])
     matrix            box, zerobox;
     real *            sqrtm, *mat, *eigenvalues, sum, trace, inv_nframes;
     real              t, tstart, tend, **mat2;
-    real              xj, *w_rls = nullptr;
+    int               nvec;
+    std::vector<real> frameBlock;
+    real*             w_rls = nullptr;
     real              min, max, *axis;
     int               natoms, nat, nframes0, nframes, nlevels;
-    int64_t           ndim, i, j, k, l;
+    int64_t           ndim, i, j, k;
     int               WriteXref;
     const char *      fitfile, *trxfile, *ndxfile;
     const char *      eigvalfile, *eigvecfile, *averfile, *logfile;
@@ -298,6 +351,10 @@ int gmx_covar(int argc, char* argv[])
 
     fprintf(stderr, "Constructing covariance matrix (%dx%d) ...\n", static_cast<int>(ndim),
             static_cast<int>(ndim));
+    /* The displacements of a block of frames are buffered, such that the matrix
+     * is only traversed once for each block of frames.
+     */
+    frameBlock.resize(c_covarFrameBlockSize * ndim);
     nframes = 0;
     nat     = read_first_x(oenv, &status, trxfile, &t, &xread, box);
     tstart  = t;
@@ -315,39 +372,35 @@ int gmx_covar(int argc, char* argv[])
             reset_x(nfit, ifit, nat, nullptr, xread, w_rls);
             do_fit(nat, w_rls, xref, xread);
         }
+        rvec* xblock = reinterpret_cast<rvec*>(frameBlock.data()
+                                               + ndim * ((nframes - 1) % c_covarFrameBlockSize));
         if (bRef)
         {
             for (i = 0; i < natoms; i++)
             {
-                rvec_sub(xread[index[i]], xref[index[i]], x[i]);
+                rvec_sub(xread[index[i]], xref[index[i]], xblock[i]);
             }
         }
         else
         {
             for (i = 0; i < natoms; i++)
             {
-                rvec_sub(xread[index[i]], xav[i], x[i]);
+                rvec_sub(xread[index[i]], xav[i], xblock[i]);
             }
         }
 
-        for (j = 0; j < natoms; j++)
+        if (nframes % c_covarFrameBlockSize == 0)
         {
-            for (dj = 0; dj < DIM; dj++)
-            {
-                k  = ndim * (DIM * j + dj);
-                xj = x[j][dj];
-                for (i = j; i < natoms; i++)
-                {
-                    l = k + DIM * i;
-                    for (d = 0; d < DIM; d++)
-                    {
-                        mat[l + d] += x[i][d] * xj;
-                    }
-                }
-            }
+            addFramesToCovariance(ndim, c_covarFrameBlockSize, frameBlock.data(), mat);
         }
     } while (read_next_x(oenv, status, &t, xread, box) && (bRef || nframes < nframes0));
     close_trx(status);
+    if (nframes % c_covarFrameBlockSize != 0)
+    {
+        addFramesToCovariance(ndim, nframes % c_covarFrameBlockSize, frameBlock.data(), mat);
+    }
+    frameBlock.clear();
+    frameBlock.shrink_to_fit();
     gmx_rmpbc_done(gpbc);
 
     fprintf(stderr, "Read %d frames\n", nframes);
@@ -513,47 +566,73 @@ int gmx_covar(int argc, char* argv[])
     }
 
 
+    /* Set 'end', the maximum eigenvector and -value index used for output */
+    if (end == -1)
+    {
+        if (nframes - 1 < ndim)
+        {
+            end = nframes - 1;
+            fprintf(stderr,
+                    "\nWARNING: there are fewer frames in your trajectory than there are\n");
+            fprintf(stderr, "degrees of freedom in your system. Only generating the first\n");
+            fprintf(stderr, "%d out of %d eigenvectors and eigenvalues.\n", end, static_cast<int>(ndim));
+        }
+        else
+        {
+            end = ndim;
+        }
+    }
+    else if (end > ndim)
+    {
+        end = ndim;
+    }
+    /* Only compute the eigenvalues and -vectors that are written */
+    nvec = std::max(end, 1);
+
     /* call diagonalization routine */
 
     snew(eigenvalues, ndim);
-    snew(eigenvectors, ndim * ndim);
+    snew(eigenvectors, nvec * ndim);
 
-    std::memcpy(eigenvectors, mat, ndim * ndim * sizeof(real));
     fprintf(stderr, "\nDiagonalizing ...\n");
     fflush(stderr);
-    eigensolver(eigenvectors, ndim, 0, ndim, eigenvalues, mat);
-    sfree(eigenvectors);
+    /* The matrix is no longer needed, so it is overwritten by the solver */
+    eigensolver(mat, ndim, ndim - nvec, ndim - 1, eigenvalues, eigenvectors);
+    sfree(mat);
+
+    /* Reverse the order, such that the largest eigenvalue comes first */
+    std::reverse(eigenvalues, eigenvalues + nvec);
+    for (i = 0; i < nvec / 2; i++)
+    {
+        std::swap_ranges(eigenvectors + i * ndim, eigenvectors + (i + 1) * ndim,
+                         eigenvectors + (nvec - 1 - i) * ndim);
+    }
 
     /* now write the output */
 
     sum = 0;
-    for (i = 0; i < ndim; i++)
+    for (i = 0; i < nvec; i++)
     {
         sum += eigenvalues[i];
     }
-    fprintf(stderr, "\nSum of the eigenvalues: %g (%snm^2)\n", sum, bM ? "u " : "");
-    if (std::abs(trace - sum) > 0.01 * trace)
-    {
-        fprintf(stderr,
-                "\nWARNING: eigenvalue sum deviates from the trace of the covariance matrix\n");
-    }
-
-    /* Set 'end', the maximum eigenvector and -value index used for output */
-    if (end == -1)
+    if (nvec == ndim)
     {
-        if (nframes - 1 < ndim)
+        fprintf(stderr, "\nSum of the eigenvalues: %g (%snm^2)\n", sum, bM ? "u " : "");
+        if (std::abs(trace - sum) > 0.01 * trace)
         {
-            end = nframes - 1;
             fprintf(stderr,
-                    "\nWARNING: there are fewer frames in your trajectory than there are\n");
-            fprintf(stderr, "degrees of freedom in your system. Only generating the first\n");
-            fprintf(stderr, "%d out of %d eigenvectors and eigenvalues.\n", end, static_cast<int>(ndim));
-        }
-        else
-        {
-            end = ndim;
+                    "\nWARNING: eigenvalue sum deviates from the trace of the covariance matrix\n");
         }
     }
+    else
+    {
+        fprintf(stderr, "\nSum of the %d largest eigenvalues: %g (%snm^2)\n", nvec, sum,
+                bM ? "u " : "");
+        fprintf(stderr,
+                "Note: only %d of the %d eigenvalues were computed, so their sum was not\n"
+                "      checked against the trace of the covariance matrix\n",
+                nvec, static_cast<int>(ndim));
+    }
 
     fprintf(stderr, "\nWriting eigenvalues to %s\n", eigvalfile);
 
@@ -561,7 +640,7 @@ int gmx_covar(int argc, char* argv[])
     out = xvgropen(eigvalfile, "Eigenvalues of the covariance matrix", "Eigenvector index", str, oenv);
     for (i = 0; (i < end); i++)
     {
-        fprintf(out, "%10d %g\n", static_cast<int>(i + 1), eigenvalues[ndim - 1 - i]);
+        fprintf(out, "%10d %g\n", static_cast<int>(i + 1), eigenvalues[i]);
     }
     xvgrclose(out);
 
@@ -587,8 +666,8 @@ int gmx_covar(int argc, char* argv[])
         WriteXref = eWXR_NOFIT;
     }
 
-    write_eigenvectors(eigvecfile, natoms, mat, TRUE, 1, end, WriteXref, x, bDiffMass1, xproj, bM,
-                       eigenvalues);
+    write_eigenvectors(eigvecfile, natoms, eigenvectors, FALSE, 1, end, WriteXref, x, bDiffMass1,
+                       xproj, bM, eigenvalues);
 
     out = gmx_ffopen(logfile, "w");
 
@@ -629,7 +708,18 @@ int gmx_covar(int argc, char* argv[])
     fprintf(out, "Diagonalized the %dx%d covariance matrix\n", static_cast<int>(ndim),
             static_cast<int>(ndim));
     fprintf(out, "Trace of the covariance matrix before diagonalizing: %g\n", trace);
-    fprintf(out, "Trace of the covariance matrix after diagonalizing: %g\n\n", sum);
+    if (nvec == ndim)
+    {
+        fprintf(out, "Trace of the covariance matrix after diagonalizing: %g\n\n", sum);
+    }
+    else
+    {
+        fprintf(out, "Sum of the %d largest eigenvalues: %g\n", nvec, sum);
+        fprintf(out,
+                "Only %d of the %d eigenvalues were computed, so the check of their sum\n"
+                "against the trace of the covariance matrix was skipped\n\n",
+                nvec, static_cast<int>(ndim));
+    }
 
     fprintf(out, "Wrote %d eigenvalues to %s\n", static_cast<int>(end), eigvalfile);
     if (WriteXref == eWXR_YES)
@@ -161,6 +161,26 @@ typedef struct
      */
 } t_hbond;
 
+/* The hbonds of one donor. Only donor-acceptor pairs that have been
+ * found within the cut-off are stored, in order of increasing acceptor
+ * index, so the memory use does not scale with #donors x #acceptors.
+ */
+typedef struct
+{
+    int       nr, maxnr;
+    int*      acc; /* Acceptor indices of the hbonds */
+    t_hbond** hb;  /* The hbonds                     */
+} t_hbrow;
+
+/* A hydrogen bond or contact found by a thread in the current frame */
+typedef struct
+{
+    int id;  /* Donor index                   */
+    int ia;  /* Acceptor index                */
+    int h;   /* Hydrogen index on the donor   */
+    int ihb; /* hbHB or hbDist                */
+} t_hbfound;
+
 typedef struct
 {
     int  nra, max_nra;
@@ -194,9 +214,17 @@ typedef struct
     /* These structures are initialized from the topology at start up */
     t_donors    d;
     t_acceptors a;
-    /* This holds a matrix with all possible hydrogen bonds */
-    int        nrhb, nrdist;
-    t_hbond*** hbmap;
+    /* This holds, per donor, all hydrogen bonds found */
+    int      nrhb, nrdist;
+    t_hbrow* hbmap;
+    /* With bDeferHbmap, the hydrogen bonds found are collected in found
+     * and only added to hbmap by merge_found_hbonds() after the frame.
+     * This is used for the per-thread data, so the threads do not need
+     * to synchronize for every hydrogen bond.
+     */
+    gmx_bool   bDeferHbmap;
+    int        nfound, maxfound;
+    t_hbfound* found;
 } t_hbdata;
 
 /* Changed argument 'bMerge' into 'oneHB' below,
@@ -226,21 +254,46 @@ static t_hbdata* mk_hbdata(gmx_bool bHBmap, gmx_bool bDAnr, gmx_bool oneHB)
 
 static void mk_hbmap(t_hbdata* hb)
 {
-    int i, j;
-
     snew(hb->hbmap, hb->d.nrd);
-    for (i = 0; (i < hb->d.nrd); i++)
+}
+
+/* Returns the hbond between donor index id and acceptor index ia, or nullptr */
+static t_hbond* find_hbond(const t_hbdata* hb, int id, int ia)
+{
+    const t_hbrow* row = &hb->hbmap[id];
+    const int*     acc = std::lower_bound(row->acc, row->acc + row->nr, ia);
+
+    return (acc != row->acc + row->nr && *acc == ia) ? row->hb[acc - row->acc] : nullptr;
+}
+
+/* Returns the hbond between donor index id and acceptor index ia, adds it when not present */
+static t_hbond* find_or_add_hbond(t_hbdata* hb, int id, int ia)
+{
+    t_hbrow*  row = &hb->hbmap[id];
+    const int k   = std::lower_bound(row->acc, row->acc + row->nr, ia) - row->acc;
+
+    if (k < row->nr && row->acc[k] == ia)
     {
-        snew(hb->hbmap[i], hb->a.nra);
-        if (hb->hbmap[i] == nullptr)
-        {
-            gmx_fatal(FARGS, "Could not allocate enough memory for hbmap");
-        }
-        for (j = 0; j < hb->a.nra; j++)
-        {
-            hb->hbmap[i][j] = nullptr;
-        }
+        return row->hb[k];
     }
+    if (row->nr == row->maxnr)
+    {
+        row->maxnr = std::max(4, 2 * row->maxnr);
+        srenew(row->acc, row->maxnr);
+        srenew(row->hb, row->maxnr);
+    }
+    for (int i = row->nr; i > k; i--)
+    {
+        row->acc[i] = row->acc[i - 1];
+        row->hb[i]  = row->hb[i - 1];
+    }
+    row->nr++;
+    row->acc[k] = ia;
+    snew(row->hb[k], 1);
+    snew(row->hb[k]->h, hb->maxhydro);
+    snew(row->hb[k]->g, hb->maxhydro);
+
+    return row->hb[k];
 }
 
 static void add_frames(t_hbdata* hb, int nframes)
@@ -281,30 +334,29 @@ static gmx_bool is_hb(const unsigned int hbexist[], int frame)
     return (hbexist[OFFSET(frame)] & MASK(frame)) != 0;
 }
 
-static void set_hb(t_hbdata* hb, int id, int ih, int ia, int frame, int ihb)
+static void set_hb(t_hbond* hb, int ih, int frame, int ihb)
 {
     unsigned int* ghptr = nullptr;
 
     if (ihb == hbHB)
     {
-        ghptr = hb->hbmap[id][ia]->h[ih];
+        ghptr = hb->h[ih];
     }
     else if (ihb == hbDist)
     {
-        ghptr = hb->hbmap[id][ia]->g[ih];
+        ghptr = hb->g[ih];
     }
     else
     {
         gmx_fatal(FARGS, "Incomprehensible iValue %d in set_hb", ihb);
     }
 
-    _set_hb(ghptr, frame - hb->hbmap[id][ia]->n0, TRUE);
+    _set_hb(ghptr, frame - hb->n0, TRUE);
 }
 
-static void add_ff(t_hbdata* hbd, int id, int h, int ia, int frame, int ihb)
+static void add_ff(t_hbdata* hbd, t_hbond* hb, int id, int h, int frame, int ihb)
 {
     int      i, j, n;
-    t_hbond* hb       = hbd->hbmap[id][ia];
     int      maxhydro = std::min(hbd->maxhydro, hbd->d.nhydro[id]);
     int      wlen     = hbd->wordlen;
     int      delta    = 32 * wlen;
@@ -344,7 +396,7 @@ static void add_ff(t_hbdata* hbd, int id, int h, int ia, int frame, int ihb)
     }
     if (frame >= 0)
     {
-        set_hb(hbd, id, h, ia, frame, ihb);
+        set_hb(hb, h, frame, ihb);
     }
 }
 
@@ -423,10 +475,65 @@ static gmx_bool isInterchangable(t_hbdata* hb, int d, int a, int grpa, int grpd)
 }
 
 
+/* Adds the existence of a hydrogen bond or contact ihb between donor index id
+ * and acceptor index ia, with hydrogen index h, in frame to hbmap
+ */
+static void store_hbond(t_hbdata* hb, int id, int ia, int h, int frame, int ihb)
+{
+    t_hbond* hbond = find_or_add_hbond(hb, id, ia);
+    add_ff(hb, hbond, id, h, frame, ihb);
+
+    /* Strange construction with frame >=0 is a relic from old code
+     * for selected hbond analysis. It may be necessary again if that
+     * is made to work again.
+     */
+    if (frame >= 0)
+    {
+        const int hh = hbond->history[h];
+        if (ihb == hbHB)
+        {
+            if (!(ISHB(hh)))
+            {
+                hbond->history[h] = hh | 2;
+                hb->nrhb++;
+            }
+        }
+        else if (ihb == hbDist)
+        {
+            if (!(ISDIST(hh)))
+            {
+                hbond->history[h] = hh | 1;
+                hb->nrdist++;
+            }
+        }
+    }
+}
+
+/* Adds the hydrogen bonds found by all nthreads threads in frame to hbmap.
+ * Called by all threads, thread threadNr handles the donors with index
+ * threadNr modulo nthreads, so no two threads access the same hbmap row.
+ * The counts of new hbonds are added to p_hb[threadNr].
+ */
+static void merge_found_hbonds(t_hbdata** p_hb, int nthreads, int threadNr, int frame)
+{
+    for (int t = 0; t < nthreads; t++)
+    {
+        const t_hbdata* hbt = p_hb[t];
+        for (int i = 0; i < hbt->nfound; i++)
+        {
+            const t_hbfound& found = hbt->found[i];
+            if (found.id % nthreads == threadNr)
+            {
+                store_hbond(p_hb[threadNr], found.id, found.ia, found.h, frame, found.ihb);
+            }
+        }
+    }
+}
+
 static void
 add_hbond(t_hbdata* hb, int d, int a, int h, int grpd, int grpa, int frame, gmx_bool bMerge, int ihb, gmx_bool bContact)
 {
-    int      k, id, ia, hh;
+    int      k, id, ia;
     gmx_bool daSwap = FALSE;
 
     if ((id = hb->d.dptr[d]) == NOTSET)
@@ -506,69 +613,35 @@ add_hbond(t_hbdata* hb, int d, int a, int h, int grpd, int grpa, int frame, gmx_
             k = 0;
         }
 
-        if (hb->bHBmap)
+        if (hb->bDeferHbmap)
         {
-
-#pragma omp critical
+            if (hb->nfound == hb->maxfound)
             {
-                try
-                {
-                    if (hb->hbmap[id][ia] == nullptr)
-                    {
-                        snew(hb->hbmap[id][ia], 1);
-                        snew(hb->hbmap[id][ia]->h, hb->maxhydro);
-                        snew(hb->hbmap[id][ia]->g, hb->maxhydro);
-                    }
-                    add_ff(hb, id, k, ia, frame, ihb);
-                }
-                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+                hb->maxfound = std::max(256, 2 * hb->maxfound);
+                srenew(hb->found, hb->maxfound);
             }
+            hb->found[hb->nfound].id  = id;
+            hb->found[hb->nfound].ia  = ia;
+            hb->found[hb->nfound].h   = k;
+            hb->found[hb->nfound].ihb = ihb;
+            hb->nfound++;
         }
-
-        /* Strange construction with frame >=0 is a relic from old code
-         * for selected hbond analysis. It may be necessary again if that
-         * is made to work again.
-         */
-        if (frame >= 0)
+        else
         {
-            hh = hb->hbmap[id][ia]->history[k];
-            if (ihb == hbHB)
-            {
-                hb->nhb[frame]++;
-                if (!(ISHB(hh)))
-                {
-                    hb->hbmap[id][ia]->history[k] = hh | 2;
-                    hb->nrhb++;
-                }
-            }
-            else
-            {
-                if (ihb == hbDist)
-                {
-                    hb->ndist[frame]++;
-                    if (!(ISDIST(hh)))
-                    {
-                        hb->hbmap[id][ia]->history[k] = hh | 1;
-                        hb->nrdist++;
-                    }
-                }
-            }
+            store_hbond(hb, id, ia, k, frame, ihb);
         }
     }
-    else
+    if (frame >= 0)
     {
-        if (frame >= 0)
+        if (ihb == hbHB)
         {
-            if (ihb == hbHB)
-            {
-                hb->nhb[frame]++;
-            }
-            else
+            hb->nhb[frame]++;
+        }
+        else
+        {
+            if (ihb == hbDist)
             {
-                if (ihb == hbDist)
-                {
-                    hb->ndist[frame]++;
-                }
+                hb->ndist[frame]++;
             }
         }
     }
@@ -1463,7 +1536,7 @@ static void do_merge(t_hbdata* hb, int ntmp, bool htmp[], bool gtmp[], t_hbond*
 
 static void merge_hb(t_hbdata* hb, gmx_bool bTwo, gmx_bool bContact)
 {
-    int      i, inrnew, indnew, j, ii, jj, id, ia, ntmp;
+    int      i, inrnew, indnew, j, k, ii, jj, id, ia, ntmp;
     bool *   htmp, *gtmp;
     t_hbond *hb0, *hb1;
 
@@ -1482,15 +1555,16 @@ static void merge_hb(t_hbdata* hb, gmx_bool bTwo, gmx_bool bContact)
         fflush(stderr);
         id = hb->d.don[i];
         ii = hb->a.aptr[id];
-        for (j = 0; (j < hb->a.nra); j++)
+        for (k = 0; (k < hb->hbmap[i].nr); k++)
         {
+            j  = hb->hbmap[i].acc[k];
             ia = hb->a.acc[j];
             jj = hb->d.dptr[ia];
             if ((id != ia) && (ii != NOTSET) && (jj != NOTSET)
                 && (!bTwo || (hb->d.grp[i] != hb->a.grp[j])))
             {
-                hb0 = hb->hbmap[i][j];
-                hb1 = hb->hbmap[jj][ii];
+                hb0 = hb->hbmap[i].hb[k];
+                hb1 = find_hbond(hb, jj, ii);
                 if (hb0 && hb1 && ISHB(hb0->history[0]) && ISHB(hb1->history[0]))
                 {
                     do_merge(hb, ntmp, htmp, gtmp, hb0, hb1);
@@ -1572,9 +1646,9 @@ static void do_hblife(const char* fn, t_hbdata* hb, gmx_bool bMerge, gmx_bool bC
     /* Total number of hbonds analyzed here */
     for (i = 0; (i < hb->d.nrd); i++)
     {
-        for (k = 0; (k < hb->a.nra); k++)
+        for (k = 0; (k < hb->hbmap[i].nr); k++)
         {
-            hbh = hb->hbmap[i][k];
+            hbh = hb->hbmap[i].hb[k];
             if (hbh)
             {
                 if (bMerge)
@@ -1690,11 +1764,11 @@ static void dump_ac(t_hbdata* hb, gmx_bool oneHB, int nDump)
         fprintf(fp, "%10.3f", hb->time[j]);
         for (i = nd = 0; (i < hb->d.nrd) && (nd < nDump); i++)
         {
-            for (k = 0; (k < hb->a.nra) && (nd < nDump); k++)
+            for (k = 0; (k < hb->hbmap[i].nr) && (nd < nDump); k++)
             {
                 bPrint = FALSE;
                 ihb = idist = 0;
-                hbh         = hb->hbmap[i][k];
+                hbh         = hb->hbmap[i].hb[k];
                 if (oneHB)
                 {
                     if (hbh->h[0])
@@ -2064,10 +2138,10 @@ static void do_hbac(const char*             fn,
 
     for (i = 0; (i < hb->d.nrd); i++)
     {
-        for (k = 0; (k < hb->a.nra); k++)
+        for (k = 0; (k < hb->hbmap[i].nr); k++)
         {
             nhydro = 0;
-            hbh    = hb->hbmap[i][k];
+            hbh    = hb->hbmap[i].hb[k];
 
             if (hbh)
             {
@@ -2266,9 +2340,10 @@ static void analyse_donor_properties(FILE* fp, t_hbdata* hb, int nframes, real t
         {
             nb = 0;
             nhtot++;
-            for (j = 0; (j < hb->a.nra) && (nb == 0); j++)
+            for (j = 0; (j < hb->hbmap[i].nr) && (nb == 0); j++)
             {
-                if (hb->hbmap[i][j] && hb->hbmap[i][j]->h[k] && is_hb(hb->hbmap[i][j]->h[k], nframes))
+                const t_hbond* hbh = hb->hbmap[i].hb[j];
+                if (hbh->h[k] && is_hb(hbh->h[k], nframes))
                 {
                     nb = 1;
                 }
@@ -2354,12 +2429,12 @@ static void dump_hbmap(t_hbdata*      hb,
     for (i = 0; (i < hb->d.nrd); i++)
     {
         ddd = hb->d.don[i];
-        for (k = 0; (k < hb->a.nra); k++)
+        for (k = 0; (k < hb->hbmap[i].nr); k++)
         {
-            aaa = hb->a.acc[k];
+            aaa = hb->a.acc[hb->hbmap[i].acc[k]];
             for (m = 0; (m < hb->d.nhydro[i]); m++)
             {
-                if (hb->hbmap[i][k] && ISHB(hb->hbmap[i][k]->history[m]))
+                if (ISHB(hb->hbmap[i].hb[k]->history[m]))
                 {
                     sprintf(ds, "%s", mkatomname(atoms, ddd));
                     sprintf(as, "%s", mkatomname(atoms, aaa));
@@ -2913,6 +2988,8 @@ int gmx_hbond(int argc, char* argv[])
 
             p_hb[i]->nrhb   = 0;
             p_hb[i]->nrdist = 0;
+
+            p_hb[i]->bDeferHbmap = TRUE;
         }
     }
 
@@ -3129,22 +3206,36 @@ int gmx_hbond(int argc, char* argv[])
             /* Better wait for all threads to finnish using x[] before updating it. */
             k = nframes;
 #pragma omp barrier
-#pragma omp critical
+            if (bOMP && hb->hbmap)
+            {
+                try
+                {
+                    /* Add the hbonds found by all threads to hbmap, split over donors */
+                    merge_found_hbonds(p_hb, actual_nThreads, threadNr, k);
+                }
+                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+            }
+#pragma omp single
             {
                 try
                 {
                     /* Sum up histograms and counts from p_hb[] into hb */
-                    if (bOMP)
+                    for (int t = 0; bOMP && t < actual_nThreads; t++)
                     {
-                        hb->nhb[k] += p_hb[threadNr]->nhb[k];
-                        hb->ndist[k] += p_hb[threadNr]->ndist[k];
+                        hb->nhb[k] += p_hb[t]->nhb[k];
+                        hb->ndist[k] += p_hb[t]->ndist[k];
                         for (j = 0; j < max_hx; j++)
                         {
-                            hb->nhx[k][j] += p_hb[threadNr]->nhx[k][j];
+                            hb->nhx[k][j] += p_hb[t]->nhx[k][j];
                         }
                     }
                 }
                 GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+            } /* omp single */
+            if (bOMP)
+            {
+                /* All threads have merged the found hbonds after the implicit barrier of single */
+                p_hb[threadNr]->nfound = 0;
             }
 
             /* Here are a handful of single constructs
@@ -3196,6 +3287,7 @@ int gmx_hbond(int argc, char* argv[])
             }
 
             /* Free parallel datastructures */
+            sfree(p_hb[threadNr]->found);
             sfree(p_hb[threadNr]->nhb);
             sfree(p_hb[threadNr]->ndist);
             sfree(p_hb[threadNr]->nhx);
@@ -3419,23 +3511,21 @@ int gmx_hbond(int argc, char* argv[])
                 y = 0;
                 for (id = 0; (id < hb->d.nrd); id++)
                 {
-                    for (ia = 0; (ia < hb->a.nra); ia++)
+                    for (ia = 0; (ia < hb->hbmap[id].nr); ia++)
                     {
+                        const t_hbond* hbh = hb->hbmap[id].hb[ia];
                         for (hh = 0; (hh < hb->maxhydro); hh++)
                         {
-                            if (hb->hbmap[id][ia])
+                            if (ISHB(hbh->history[hh]))
                             {
-                                if (ISHB(hb->hbmap[id][ia]->history[hh]))
+                                for (x = 0; (x <= hbh->nframes); x++)
                                 {
-                                    for (x = 0; (x <= hb->hbmap[id][ia]->nframes); x++)
-                                    {
-                                        int nn0 = hb->hbmap[id][ia]->n0;
-                                        range_check(y, 0, mat.ny);
-                                        mat.matrix(x + nn0, y) = static_cast<t_matelmt>(
-                                                is_hb(hb->hbmap[id][ia]->h[hh], x));
-                                    }
-                                    y++;
+                                    int nn0 = hbh->n0;
+                                    range_check(y, 0, mat.ny);
+                                    mat.matrix(x + nn0, y) =
+                                            static_cast<t_matelmt>(is_hb(hbh->h[hh], x));
                                 }
+                                y++;
                             }
                         }
                     }
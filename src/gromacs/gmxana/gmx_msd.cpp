@@ -39,10 +39,13 @@
 #include <cmath>
 #include <cstring>
 
+#include <algorithm>
+#include <array>
 #include <memory>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
+#include "gromacs/fft/fft.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/fileio/xvgr.h"
@@ -57,9 +60,11 @@
 #include "gromacs/topology/index.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/arraysize.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 static constexpr double diffusionConversionFactor = 1000.0; /* Convert nm^2/ps to 10e-5 cm^2/s */
@@ -94,6 +99,8 @@ struct t_corr
     std::vector<std::vector<gmx::RVec>> x0;   /* original positions */
     std::vector<gmx::RVec>              com;  /* center of mass correction for each frame */
     gmx_stats_t**                       lsq;  /* fitting stats for individual molecule msds */
+    std::vector<real>                   molSlope; /* MSD slopes for individual molecules, only
+                                                     used with the FFT algorithm */
     msd_type                            type; /* the type of msd to calculate (lateral, etc.)*/
     int                                 axis; /* the axis along which to calculate */
     int                                 ncoords;
@@ -163,7 +170,7 @@ struct t_corr
     }
     ~t_corr()
     {
-        for (int i = 0; i < nrestart; i++)
+        for (int i = 0; i < nrestart && lsq != nullptr; i++)
         {
             for (int j = 0; j < nmol; j++)
             {
@@ -587,18 +594,25 @@ static void printmol(t_corr*                 curr,
     sqrtD_max  = 0;
     for (i = 0; (i < curr->nmol); i++)
     {
-        lsq1 = gmx_stats_init();
-        for (j = 0; (j < curr->nrestart); j++)
+        if (!curr->molSlope.empty())
         {
-            real xx, yy, dx, dy;
-
-            while (gmx_stats_get_point(curr->lsq[j][i], &xx, &yy, &dx, &dy, 0) == estatsOK)
+            a = curr->molSlope[i];
+        }
+        else
+        {
+            lsq1 = gmx_stats_init();
+            for (j = 0; (j < curr->nrestart); j++)
             {
-                gmx_stats_add_point(lsq1, xx, yy, dx, dy);
+                real xx, yy, dx, dy;
+
+                while (gmx_stats_get_point(curr->lsq[j][i], &xx, &yy, &dx, &dy, 0) == estatsOK)
+                {
+                    gmx_stats_add_point(lsq1, xx, yy, dx, dy);
+                }
             }
+            gmx_stats_get_ab(lsq1, elsqWEIGHT_NONE, &a, &b, nullptr, nullptr, nullptr, nullptr);
+            gmx_stats_free(lsq1);
         }
-        gmx_stats_get_ab(lsq1, elsqWEIGHT_NONE, &a, &b, nullptr, nullptr, nullptr, nullptr);
-        gmx_stats_free(lsq1);
         D = a * diffusionConversionFactor / curr->dim_factor;
         if (D < 0)
         {
@@ -650,6 +664,64 @@ static void printmol(t_corr*                 curr,
     }
 }
 
+/* prepare the coordinates of a frame for the displacement calculation
+   x = the coordinates read, made whole when bMol is set
+   xa = the coordinates to calculate displacements for, molecule centers
+        of mass with bMol
+   xaprev = xa for the previous frame, set to xa when bFirst is set
+   com(output) = the center of mass of the COM removal group, if any */
+static void prepare_frame(t_corr*                  curr,
+                          const t_topology*        top,
+                          gmx_bool                 bMol,
+                          gmx_rmpbc_t              gpbc,
+                          int                      natoms,
+                          int                      gnx[],
+                          int*                     index[],
+                          gmx::ArrayRef<const int> gnx_com,
+                          int*                     index_com[],
+                          matrix                   box,
+                          rvec                     x[],
+                          rvec                     xa[],
+                          rvec                     xaprev[],
+                          gmx_bool                 bFirst,
+                          rvec                     com)
+{
+    /* make the molecules whole */
+    if (bMol)
+    {
+        gmx_rmpbc(gpbc, natoms, box, x);
+    }
+
+    /* calculate the molecules' centers of masses and put them into xa */
+    // NOTE and WARNING! If above both COM removal and individual molecules have been
+    // requested, x and xa point to the same memory, and the coordinate
+    // data becomes overwritten by the molecule data.
+    if (bMol)
+    {
+        calc_mol_com(gnx[0], index[0], &top->mols, &top->atoms, x, xa);
+    }
+
+    /* for the first frame, the previous frame is a copy of the first frame */
+    if (bFirst)
+    {
+        std::memcpy(xaprev, xa, curr->ncoords * sizeof(xaprev[0]));
+    }
+
+    /* first remove the periodic boundary condition crossings */
+    for (int i = 0; i < curr->ngrp; i++)
+    {
+        prep_data(bMol, gnx[i], index[i], xa, xaprev, box);
+    }
+
+    /* calculate the center of mass */
+    if (!gnx_com.empty())
+    {
+        GMX_RELEASE_ASSERT(index_com != nullptr,
+                           "Center-of-mass removal must have valid index group");
+        calc_com(bMol, gnx_com[0], index_com[0], xa, xaprev, box, &top->atoms, com);
+    }
+}
+
 /* this is the main loop for the correlation type functions
  * fx and nx are file pointers to things like read_first_x and
  * read_next_x
@@ -801,41 +873,9 @@ static int corr_loop(t_corr*                  curr,
         /* set the time */
         curr->time[curr->nframes] = t - curr->t0;
 
-        /* make the molecules whole */
-        if (bMol)
-        {
-            gmx_rmpbc(gpbc, natoms, box, x[cur]);
-        }
-
-        /* calculate the molecules' centers of masses and put them into xa */
-        // NOTE and WARNING! If above both COM removal and individual molecules have been
-        // requested, x and xa point to the same memory, and the coordinate
-        // data becomes overwritten by the molecule data.
-        if (bMol)
-        {
-            calc_mol_com(gnx[0], index[0], &top->mols, &top->atoms, x[cur], xa[cur]);
-        }
-
-        /* for the first frame, the previous frame is a copy of the first frame */
-        if (bFirst)
-        {
-            std::memcpy(xa[prev], xa[cur], curr->ncoords * sizeof(xa[prev][0]));
-            bFirst = FALSE;
-        }
-
-        /* first remove the periodic boundary condition crossings */
-        for (i = 0; i < curr->ngrp; i++)
-        {
-            prep_data(bMol, gnx[i], index[i], xa[cur], xa[prev], box);
-        }
-
-        /* calculate the center of mass */
-        if (!gnx_com.empty())
-        {
-            GMX_RELEASE_ASSERT(index_com != nullptr,
-                               "Center-of-mass removal must have valid index group");
-            calc_com(bMol, gnx_com[0], index_com[0], xa[cur], xa[prev], box, &top->atoms, com);
-        }
+        prepare_frame(curr, top, bMol, gpbc, natoms, gnx, index, gnx_com, index_com, box, x[cur],
+                      xa[cur], xa[prev], bFirst, com);
+        bFirst = FALSE;
 
         /* loop over all groups in index file */
         for (i = 0; (i < curr->ngrp); i++)
@@ -863,6 +903,539 @@ static int corr_loop(t_corr*                  curr,
     return natoms;
 }
 
+/* A coordinate to compute the FFT-based MSD for */
+struct MsdFftEntry
+{
+    int  group;      /* the group this entry belongs to */
+    int  coordIndex; /* the index in the coordinates to calculate displacements for */
+    real weight;     /* the weight of this entry in the group average */
+};
+
+/* Sums over the entries of a group of the weight times the real part of
+ * the cross spectra and the per frame products of pairs of centered
+ * coordinate components. The pair index runs over curr->fftPairs.
+ */
+struct MsdFftSums
+{
+    std::vector<std::vector<double>> spectrum; /* pair index, then frequency */
+    std::vector<std::vector<double>> product;  /* pair index, then frame */
+
+    MsdFftSums(int numPairs, int numFrequencies, int numFrames) :
+        spectrum(numPairs, std::vector<double>(numFrequencies, 0.0)),
+        product(numPairs, std::vector<double>(numFrames, 0.0))
+    {
+    }
+
+    void add(const MsdFftSums& other)
+    {
+        for (size_t p = 0; p < spectrum.size(); p++)
+        {
+            for (size_t f = 0; f < spectrum[p].size(); f++)
+            {
+                spectrum[p][f] += other.spectrum[p][f];
+            }
+            for (size_t k = 0; k < product[p].size(); k++)
+            {
+                product[p][k] += other.product[p][k];
+            }
+        }
+    }
+};
+
+/* Returns the dimensions that contribute to the MSD of type curr->type */
+static std::vector<int> msd_dimensions(const t_corr* curr)
+{
+    std::vector<int> dims;
+    for (int m = 0; m < DIM; m++)
+    {
+        if ((curr->type == NORMAL) || (curr->type == LATERAL && m != curr->axis)
+            || (curr->type >= X && curr->type <= Z && m == curr->type - X))
+        {
+            dims.push_back(m);
+        }
+    }
+
+    return dims;
+}
+
+/* Converts the sums of the auto- and cross-correlations obtained from the
+ * inverse FFT of the spectrum and the sums of per frame products into the
+ * sum over all time origins of the squared displacements.
+ *
+ * With r(k) the centered coordinates at frame k and N frames, the sum over
+ * origins of (r(k+m) - r(k))^2 is sum_k [r(k+m)^2 + r(k)^2] - 2 sum_k r(k) r(k+m),
+ * where the first sum is computed recursively for increasing lag m and
+ * the second is the correlation. This is the algorithm of Calandrini et al.
+ */
+static void fft_corr_to_displacements(int                         numFrames,
+                                      int                         fftSize,
+                                      gmx::ArrayRef<const real>   correlation,
+                                      gmx::ArrayRef<const double> product,
+                                      gmx::ArrayRef<double>       displacementSum)
+{
+    double productSum = 0;
+    for (int k = 0; k < numFrames; k++)
+    {
+        productSum += 2 * product[k];
+    }
+    /* The displacement at zero lag is zero by definition, skip the rounding residue */
+    for (int m = 1; m < numFrames; m++)
+    {
+        productSum -= product[m - 1] + product[numFrames - m];
+        displacementSum[m] += productSum - 2.0 * correlation[m] / fftSize;
+    }
+}
+
+/* Computes the inverse FFT of the real spectrum in spectrum into correlation */
+static void fft_inverse_real_spectrum(gmx_fft_t                   fft,
+                                      gmx::ArrayRef<const double> spectrum,
+                                      std::vector<t_complex>*     work,
+                                      std::vector<real>*          correlation)
+{
+    for (size_t f = 0; f < spectrum.size(); f++)
+    {
+        (*work)[f].re = spectrum[f];
+        (*work)[f].im = 0;
+    }
+    int fftcode = gmx_fft_1d_real(fft, GMX_FFT_COMPLEX_TO_REAL, work->data(), correlation->data());
+    if (fftcode != 0)
+    {
+        gmx_fatal(FARGS, "gmx_fft_1d_real returned %d", fftcode);
+    }
+}
+
+/* Computes the FFT-based MSD contributions of a block of entries with
+ * coordinates stored frame-major in coords and adds them to sums.
+ * When per molecule slopes are requested, these are stored in curr->molSlope.
+ */
+static void fft_msd_block(t_corr*                                 curr,
+                          int                                     numFrames,
+                          int                                     fftSize,
+                          gmx::ArrayRef<const int>                dims,
+                          gmx::ArrayRef<const std::array<int, 2>> pairs,
+                          gmx::ArrayRef<const MsdFftEntry>        entries,
+                          gmx::ArrayRef<const gmx::RVec>          coords,
+                          std::vector<MsdFftSums>*                sums)
+{
+    const int numEntries     = entries.size();
+    const int numFrequencies = fftSize / 2 + 1;
+    const int numPairs       = pairs.size();
+
+    std::array<bool, DIM> dimIsUsed = { false, false, false };
+    for (const auto& pair : pairs)
+    {
+        dimIsUsed[pair[0]] = true;
+        dimIsUsed[pair[1]] = true;
+    }
+
+#pragma omp parallel
+    {
+        try
+        {
+            gmx_fft_t fft;
+            int       fftcode = gmx_fft_init_1d_real(&fft, fftSize, GMX_FFT_FLAG_NONE);
+            if (fftcode != 0)
+            {
+                gmx_fatal(FARGS, "gmx_fft_init_1d_real returned %d", fftcode);
+            }
+
+            /* The real arrays are padded, since the FFT might access
+             * as many elements as the complex arrays have reals.
+             */
+            std::vector<MsdFftSums> threadSums(curr->ngrp,
+                                               MsdFftSums(numPairs, numFrequencies, numFrames));
+            std::vector<std::vector<real>> series(DIM, std::vector<real>(2 * numFrequencies, 0));
+            std::vector<std::vector<t_complex>> spectrum(DIM,
+                                                         std::vector<t_complex>(numFrequencies));
+            std::vector<real>      correlation(2 * numFrequencies);
+            std::vector<double>    molSpectrum(numFrequencies);
+            std::vector<double>    molProduct(numFrames);
+            std::vector<double>    molDisplacement(numFrames);
+            std::vector<t_complex> work(numFrequencies);
+
+#pragma omp for schedule(dynamic)
+            for (int e = 0; e < numEntries; e++)
+            {
+                const MsdFftEntry& entry = entries[e];
+
+                /* Subtracting the average position, which does not affect
+                 * displacements, reduces the loss of precision in the FFTs.
+                 */
+                for (int d = 0; d < DIM; d++)
+                {
+                    if (!dimIsUsed[d])
+                    {
+                        continue;
+                    }
+                    double average = 0;
+                    for (int k = 0; k < numFrames; k++)
+                    {
+                        average += coords[k * numEntries + e][d];
+                    }
+                    average /= numFrames;
+                    for (int k = 0; k < numFrames; k++)
+                    {
+                        series[d][k] = coords[k * numEntries + e][d] - average;
+                    }
+                    fftcode = gmx_fft_1d_real(fft, GMX_FFT_REAL_TO_COMPLEX, series[d].data(),
+                                              spectrum[d].data());
+                    if (fftcode != 0)
+                    {
+                        gmx_fatal(FARGS, "gmx_fft_1d_real returned %d", fftcode);
+                    }
+                }
+
+                MsdFftSums& groupSums = threadSums[entry.group];
+                for (int p = 0; p < numPairs; p++)
+                {
+                    const int a = pairs[p][0];
+                    const int b = pairs[p][1];
+                    for (int f = 0; f < numFrequencies; f++)
+                    {
+                        groupSums.spectrum[p][f] +=
+                                entry.weight
+                                * (spectrum[a][f].re * spectrum[b][f].re
+                                   + spectrum[a][f].im * spectrum[b][f].im);
+                    }
+                    for (int k = 0; k < numFrames; k++)
+                    {
+                        groupSums.product[p][k] += entry.weight * series[a][k] * series[b][k];
+                    }
+                }
+
+                if (!curr->molSlope.empty())
+                {
+                    /* Fit the molecule MSD, weighted with the number of
+                     * origins per lag, which is equivalent to fitting
+                     * the displacements for all origins separately.
+                     */
+                    std::fill(molSpectrum.begin(), molSpectrum.end(), 0.0);
+                    std::fill(molProduct.begin(), molProduct.end(), 0.0);
+                    std::fill(molDisplacement.begin(), molDisplacement.end(), 0.0);
+                    for (int d : dims)
+                    {
+                        for (int f = 0; f < numFrequencies; f++)
+                        {
+                            molSpectrum[f] += gmx::square(spectrum[d][f].re)
+                                              + gmx::square(spectrum[d][f].im);
+                        }
+                        for (int k = 0; k < numFrames; k++)
+                        {
+                            molProduct[k] += gmx::square(series[d][k]);
+                        }
+                    }
+                    fft_inverse_real_spectrum(fft, molSpectrum, &work, &correlation);
+                    fft_corr_to_displacements(numFrames, fftSize, correlation, molProduct,
+                                              molDisplacement);
+
+                    /* As with the direct algorithm, the zero lag is not used */
+                    double sw = 0, swx = 0, swy = 0, swxx = 0, swxy = 0;
+                    for (int m = 1; m < numFrames; m++)
+                    {
+                        const real tt = curr->time[m];
+                        if (tt >= curr->beginfit && (curr->endfit < 0 || tt <= curr->endfit))
+                        {
+                            const double w = numFrames - m;
+                            const double y = molDisplacement[m] / w;
+                            sw += w;
+                            swx += w * tt;
+                            swy += w * y;
+                            swxx += w * tt * tt;
+                            swxy += w * tt * y;
+                        }
+                    }
+                    const double denominator = sw * swxx - swx * swx;
+                    curr->molSlope[entry.coordIndex] =
+                            (denominator > 0 ? (sw * swxy - swx * swy) / denominator : 0);
+                }
+            }
+
+            gmx_fft_destroy(fft);
+
+#pragma omp critical
+            {
+                for (int g = 0; g < curr->ngrp; g++)
+                {
+                    (*sums)[g].add(threadSums[g]);
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
+/* The main loop for the FFT-based MSD calculation, which uses all frames
+ * as restart points. The coordinates of all frames are stored for blocks
+ * of the selected atoms or molecules, limited to maxMemoryMB. When not
+ * all coordinates fit, the trajectory is read once for every block.
+ */
+static int corr_loop_fft(t_corr*                  curr,
+                         const char*              fn,
+                         const t_topology*        top,
+                         int                      ePBC,
+                         gmx_bool                 bMol,
+                         gmx_bool                 bMW,
+                         int                      gnx[],
+                         int*                     index[],
+                         gmx_bool                 bTen,
+                         gmx::ArrayRef<const int> gnx_com,
+                         int*                     index_com[],
+                         real                     maxMemoryMB,
+                         real                     t_pdb,
+                         rvec**                   x_pdb,
+                         matrix                   box_pdb,
+                         const gmx_output_env_t*  oenv)
+{
+    /* Set up the coordinates and weights for all groups */
+    std::vector<MsdFftEntry> entries;
+    std::vector<double>      groupWeight(curr->ngrp, 0.0);
+    for (int g = 0; g < curr->ngrp; g++)
+    {
+        for (int i = 0; i < gnx[g]; i++)
+        {
+            const int  ix     = bMol ? i : index[g][i];
+            const real weight = (bMol || bMW) ? curr->mass[ix] : 1;
+            if (weight != 0)
+            {
+                entries.push_back({ g, ix, weight });
+                groupWeight[g] += weight;
+            }
+        }
+    }
+    if (curr->nmol > 0)
+    {
+        curr->molSlope.resize(curr->nmol, 0);
+    }
+
+    const std::vector<int>          dims = msd_dimensions(curr);
+    std::vector<std::array<int, 2>> pairs;
+    if (bTen)
+    {
+        pairs = { { XX, XX }, { YY, YY }, { ZZ, ZZ }, { YY, XX }, { ZZ, XX }, { ZZ, YY } };
+    }
+    else
+    {
+        for (int d : dims)
+        {
+            pairs.push_back({ d, d });
+        }
+    }
+
+    const int64_t maxCoords = std::max(
+            static_cast<int64_t>(1),
+            static_cast<int64_t>(maxMemoryMB * 1024 * 1024 / sizeof(gmx::RVec)));
+
+    std::vector<MsdFftSums> sums;
+    std::vector<gmx::RVec>  coords;
+    rvec*                   x[2];
+    rvec*                   xa[2];
+    rvec                    com        = { 0 };
+    int                     natoms     = 0;
+    int                     numPasses  = 0;
+    int                     entryBegin = 0;
+    const int               numEntries = entries.size();
+    do
+    {
+        /* In the first pass the number of frames is not known yet,
+         * so we start with all entries and reduce when needed.
+         */
+        int blockSize = numEntries - entryBegin;
+        if (numPasses > 0)
+        {
+            blockSize = std::min(
+                    static_cast<int64_t>(blockSize),
+                    std::max(static_cast<int64_t>(1), maxCoords / curr->nframes));
+        }
+        coords.clear();
+
+        t_trxstatus* status;
+        matrix       box;
+        real         t, t_prev = 0;
+        int          cur    = 0;
+        gmx_bool     bFirst = TRUE;
+        int          frame  = 0;
+
+        natoms = read_first_x(oenv, &status, fn, &curr->t0, &(x[cur]), box);
+        snew(x[1 - cur], natoms);
+        if (bMol && gnx_com.empty())
+        {
+            curr->ncoords = curr->nmol;
+            snew(xa[0], curr->ncoords);
+            snew(xa[1], curr->ncoords);
+        }
+        else
+        {
+            curr->ncoords = natoms;
+            xa[0]         = x[0];
+            xa[1]         = x[1];
+        }
+        gmx_rmpbc_t gpbc = nullptr;
+        if (bMol)
+        {
+            gpbc = gmx_rmpbc_init(&top->idef, ePBC, natoms);
+        }
+        t = curr->t0;
+        if (x_pdb && numPasses == 0)
+        {
+            *x_pdb = nullptr;
+        }
+
+        do
+        {
+            if (numPasses == 0)
+            {
+                if (x_pdb
+                    && ((bFirst && t_pdb < t)
+                        || (!bFirst && t_pdb > t - 0.5 * (t - t_prev)
+                            && t_pdb < t + 0.5 * (t - t_prev))))
+                {
+                    if (*x_pdb == nullptr)
+                    {
+                        snew(*x_pdb, natoms);
+                    }
+                    for (int i = 0; i < natoms; i++)
+                    {
+                        copy_rvec(x[cur][i], (*x_pdb)[i]);
+                    }
+                    copy_mat(box, box_pdb);
+                }
+                curr->time.push_back(t - curr->t0);
+
+                /* Reduce the block size when we run out of memory */
+                int newBlockSize = blockSize;
+                while (newBlockSize > 1
+                       && static_cast<int64_t>(frame + 1) * newBlockSize > maxCoords)
+                {
+                    newBlockSize /= 2;
+                }
+                if (newBlockSize < blockSize)
+                {
+                    for (int k = 0; k < frame; k++)
+                    {
+                        std::copy_n(coords.begin() + k * blockSize, newBlockSize,
+                                    coords.begin() + k * newBlockSize);
+                    }
+                    coords.resize(frame * newBlockSize);
+                    blockSize = newBlockSize;
+                }
+            }
+            else if (frame >= curr->nframes)
+            {
+                gmx_fatal(FARGS, "The trajectory changed while reading it %d times", numPasses + 1);
+            }
+
+            prepare_frame(curr, top, bMol, gpbc, natoms, gnx, index, gnx_com, index_com, box,
+                          x[cur], xa[cur], xa[1 - cur], bFirst, com);
+            bFirst = FALSE;
+
+            for (int e = entryBegin; e < entryBegin + blockSize; e++)
+            {
+                gmx::RVec xe = xa[cur][entries[e].coordIndex];
+                if (!gnx_com.empty())
+                {
+                    xe -= com;
+                }
+                coords.push_back(xe);
+            }
+
+            cur    = 1 - cur;
+            t_prev = t;
+            frame++;
+        } while (read_next_x(oenv, status, &t, x[cur], box));
+
+        if (bMol)
+        {
+            gmx_rmpbc_done(gpbc);
+        }
+        close_trx(status);
+        sfree(x[1]);
+        if (bMol && gnx_com.empty())
+        {
+            sfree(xa[0]);
+            sfree(xa[1]);
+        }
+
+        if (numPasses == 0)
+        {
+            curr->nframes = frame;
+        }
+        const int fftSize = 2 * curr->nframes;
+        if (sums.empty())
+        {
+            sums.resize(curr->ngrp, MsdFftSums(pairs.size(), fftSize / 2 + 1, curr->nframes));
+        }
+
+        fft_msd_block(curr, curr->nframes, fftSize, dims, pairs,
+                      gmx::constArrayRefFromArray(entries.data() + entryBegin, blockSize), coords,
+                      &sums);
+
+        entryBegin += blockSize;
+        numPasses++;
+    } while (entryBegin < numEntries);
+
+    if (numPasses > 1)
+    {
+        fprintf(stderr, "\nRead the trajectory %d times to limit the memory usage to %g MB\n",
+                numPasses, maxMemoryMB);
+    }
+
+    /* Convert the sums to the sums over all time origins for each lag */
+    const int nframes = curr->nframes;
+    const int fftSize = 2 * nframes;
+    gmx_fft_t fft;
+    int       fftcode = gmx_fft_init_1d_real(&fft, fftSize, GMX_FFT_FLAG_NONE);
+    if (fftcode != 0)
+    {
+        gmx_fatal(FARGS, "gmx_fft_init_1d_real returned %d", fftcode);
+    }
+    std::vector<t_complex> work(fftSize / 2 + 1);
+    std::vector<real>      correlation(2 * (fftSize / 2 + 1));
+    std::vector<double>    displacement(nframes);
+    curr->nrestart = nframes;
+    for (int g = 0; g < curr->ngrp; g++)
+    {
+        curr->data[g].assign(nframes, 0);
+        curr->ndata[g].resize(nframes);
+        for (int m = 0; m < nframes; m++)
+        {
+            curr->ndata[g][m] = nframes - m;
+        }
+        if (bTen)
+        {
+            snew(curr->datam[g], nframes);
+        }
+        for (size_t p = 0; p < pairs.size(); p++)
+        {
+            std::fill(displacement.begin(), displacement.end(), 0.0);
+            fft_inverse_real_spectrum(fft, sums[g].spectrum[p], &work, &correlation);
+            fft_corr_to_displacements(nframes, fftSize, correlation, sums[g].product[p],
+                                      displacement);
+
+            const int a = pairs[p][0];
+            const int b = pairs[p][1];
+            for (int m = 0; m < nframes; m++)
+            {
+                const real value = displacement[m] / groupWeight[g];
+                if (a == b && std::find(dims.begin(), dims.end(), a) != dims.end())
+                {
+                    curr->data[g][m] += value;
+                }
+                if (bTen)
+                {
+                    curr->datam[g][m][a][b] = value;
+                }
+            }
+        }
+    }
+    gmx_fft_destroy(fft);
+
+    fprintf(stderr, "\nUsed all %d frames as restart points over %g %s\n\n", curr->nrestart,
+            output_env_conv_time(oenv, curr->time[curr->nframes - 1]),
+            output_env_get_time_unit(oenv).c_str());
+
+    return natoms;
+}
+
 static void index_atom2mol(int* n, int* index, const t_block* mols)
 {
     int nat, i, nmol, mol, j;
@@ -913,6 +1486,8 @@ static void do_corr(const char*             trx_file,
                     real                    dim_factor,
                     int                     axis,
                     real                    dt,
+                    gmx_bool                bFFT,
+                    real                    fftMemoryMB,
                     real                    beginfit,
                     real                    endfit,
                     const gmx_output_env_t* oenv)
@@ -954,9 +1529,19 @@ static void do_corr(const char*             trx_file,
     msd = std::make_unique<t_corr>(nrgrp, type, axis, dim_factor, mol_file == nullptr ? 0 : gnx[0],
                                    bTen, bMW, dt, top, beginfit, endfit);
 
-    nat_trx = corr_loop(msd.get(), trx_file, top, ePBC, mol_file ? gnx[0] != 0 : false, gnx.data(),
-                        index, (mol_file != nullptr) ? calc1_mol : (bMW ? calc1_mw : calc1_norm),
-                        bTen, gnx_com, index_com, dt, t_pdb, pdb_file ? &x : nullptr, box, oenv);
+    if (bFFT)
+    {
+        nat_trx = corr_loop_fft(msd.get(), trx_file, top, ePBC, mol_file ? gnx[0] != 0 : false, bMW,
+                                gnx.data(), index, bTen, gnx_com, index_com, fftMemoryMB, t_pdb,
+                                pdb_file ? &x : nullptr, box, oenv);
+    }
+    else
+    {
+        nat_trx = corr_loop(msd.get(), trx_file, top, ePBC, mol_file ? gnx[0] != 0 : false,
+                            gnx.data(), index,
+                            (mol_file != nullptr) ? calc1_mol : (bMW ? calc1_mw : calc1_norm), bTen,
+                            gnx_com, index_com, dt, t_pdb, pdb_file ? &x : nullptr, box, oenv);
+    }
 
     /* Correct for the number of points */
     for (j = 0; (j < msd->ngrp); j++)
@@ -1098,7 +1683,13 @@ int gmx_msd(int argc, char* argv[])
         "Option [TT]-pdb[tt] writes a [REF].pdb[ref] file with the coordinates of the frame",
         "at time [TT]-tpdb[tt] with in the B-factor field the square root of",
         "the diffusion coefficient of the molecule.",
-        "This option implies option [TT]-mol[tt]."
+        "This option implies option [TT]-mol[tt].[PAR]",
+        "With option [TT]-fft[tt] every frame is used as a reference point,",
+        "[TT]-trestart[tt] is ignored, and the MSD is computed with FFTs,",
+        "which scales as T log T instead of T^2 with the number of frames T.",
+        "This requires storing the coordinates of all frames. When these",
+        "take more memory than [TT]-fftmem[tt], the atoms or molecules are",
+        "processed in blocks, reading the trajectory once for every block."
     };
     static const char* normtype[] = { nullptr, "no", "x", "y", "z", nullptr };
     static const char* axtitle[]  = { nullptr, "no", "x", "y", "z", nullptr };
@@ -1110,6 +1701,8 @@ int gmx_msd(int argc, char* argv[])
     static gmx_bool    bTen       = FALSE;
     static gmx_bool    bMW        = TRUE;
     static gmx_bool    bRmCOMM    = FALSE;
+    static gmx_bool    bFFT       = FALSE;
+    static real        fftMemory  = 1024;
     t_pargs            pa[]       = {
         { "-type", FALSE, etENUM, { normtype }, "Compute diffusion coefficient in one direction" },
         { "-lateral",
@@ -1123,6 +1716,16 @@ int gmx_msd(int argc, char* argv[])
         { "-rmcomm", FALSE, etBOOL, { &bRmCOMM }, "Remove center of mass motion" },
         { "-tpdb", FALSE, etTIME, { &t_pdb }, "The frame to use for option [TT]-pdb[tt] (%t)" },
         { "-trestart", FALSE, etTIME, { &dt }, "Time between restarting points in trajectory (%t)" },
+        { "-fft",
+          FALSE,
+          etBOOL,
+          { &bFFT },
+          "Use all frames as restarting points and compute with FFTs" },
+        { "-fftmem",
+          FALSE,
+          etREAL,
+          { &fftMemory },
+          "Maximum memory (MB) for storing coordinates with [TT]-fft[tt]" },
         { "-beginfit",
           FALSE,
           etTIME,
@@ -1219,7 +1822,7 @@ int gmx_msd(int argc, char* argv[])
     }
 
     do_corr(trx_file, ndx_file, msd_file, mol_file, pdb_file, t_pdb, ngroup, &top, ePBC, bTen, bMW,
-            bRmCOMM, type, dim_factor, axis, dt, beginfit, endfit, oenv);
+            bRmCOMM, type, dim_factor, axis, dt, bFFT, fftMemory, beginfit, endfit, oenv);
 
     done_top(&top);
     view_all(oenv, NFILE, fnm);
@@ -0,0 +1,159 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx covar.
+ */
+
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <string>
+
+#include "gromacs/gmxana/eigio.h"
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/refdata.h"
+#include "testutils/stdiohelper.h"
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+namespace
+{
+
+using gmx::test::CommandLine;
+using gmx::test::StdioTestHelper;
+
+/*! \brief Test fixture for gmx covar
+ *
+ * covar_traj.xtc contains 101 frames of four water oxygens, so the
+ * covariance matrix is built from one full block of frames and a partial
+ * one. The reference data was generated with the full diagonalization of
+ * the covariance matrix that was used before only the written eigenvectors
+ * were computed. Each eigenvector is only defined up to its sign, so the
+ * sign is chosen such that its largest component is positive.
+ */
+class CovarTest : public gmx::test::CommandLineTestBase
+{
+public:
+    CovarTest()
+    {
+        setInputFile("-f", "covar_traj.xtc");
+        setInputFile("-s", "covar.gro");
+    }
+
+    void runTest(const CommandLine& args)
+    {
+        const std::string eigenvectorFile = fileManager().getTemporaryFilePath("eigenvec.trr");
+        {
+            StdioTestHelper stdioHelper(&fileManager());
+            stdioHelper.redirectStringToStdin("0\n");
+
+            CommandLine& cmdline = commandLine();
+            cmdline.merge(args);
+            cmdline.addOption("-fit", "no");
+            cmdline.addOption("-pbc", "no");
+            cmdline.addOption("-o", fileManager().getTemporaryFilePath("eigenval.xvg"));
+            cmdline.addOption("-v", eigenvectorFile);
+            cmdline.addOption("-av", fileManager().getTemporaryFilePath("average.pdb"));
+            cmdline.addOption("-l", fileManager().getTemporaryFilePath("covar.log"));
+            ASSERT_EQ(0, gmx_covar(cmdline.argc(), cmdline.argv()));
+        }
+
+        int      natoms;
+        gmx_bool bFit, bDMR, bDMA;
+        rvec *   xref, *xav;
+        int      nvec;
+        int*     eignr;
+        rvec**   eigvec;
+        real*    eigval;
+        read_eigenvectors(eigenvectorFile.c_str(), &natoms, &bFit, &xref, &bDMR, &xav, &bDMA, &nvec,
+                          &eignr, &eigvec, &eigval);
+
+        gmx::test::TestReferenceChecker checker(rootChecker());
+        checker.setDefaultTolerance(gmx::test::relativeToleranceAsFloatingPoint(1, 1e-4));
+        checker.checkSequenceArray(nvec, eigval, "Eigenvalues");
+        for (int v = 0; v < nvec; v++)
+        {
+            real* vec          = eigvec[v][0];
+            int   largestIndex = 0;
+            for (int i = 1; i < DIM * natoms; i++)
+            {
+                if (std::abs(vec[i]) > std::abs(vec[largestIndex]))
+                {
+                    largestIndex = i;
+                }
+            }
+            if (vec[largestIndex] < 0)
+            {
+                for (int i = 0; i < DIM * natoms; i++)
+                {
+                    vec[i] = -vec[i];
+                }
+            }
+            checker.checkSequenceArray(DIM * natoms, vec,
+                                       gmx::formatString("Eigenvector%d", v + 1).c_str());
+        }
+
+        for (int v = 0; v < nvec; v++)
+        {
+            sfree(eigvec[v]);
+        }
+        sfree(eigvec);
+        sfree(eignr);
+        sfree(eigval);
+        sfree(xav);
+        sfree(xref);
+    }
+};
+
+TEST_F(CovarTest, ComputesAllEigenvectors)
+{
+    const char* const cmdline[] = { "covar" };
+    runTest(CommandLine(cmdline));
+}
+
+// With -last, only the eigenvectors with the largest eigenvalues are computed
+TEST_F(CovarTest, ComputesLargestEigenvectorsWithLast)
+{
+    const char* const cmdline[] = { "covar", "-last", "4" };
+    runTest(CommandLine(cmdline));
+}
+
+} // namespace
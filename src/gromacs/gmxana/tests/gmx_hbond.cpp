@@ -0,0 +1,142 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx hbond.
+ */
+
+#include "gmxpre.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <string>
+
+#include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/gmxpreprocess/grompp.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/path.h"
+
+#include "testutils/cmdlinetest.h"
+#include "testutils/refdata.h"
+#include "testutils/stdiohelper.h"
+#include "testutils/testfilemanager.h"
+#include "testutils/xvgtest.h"
+
+namespace
+{
+
+using gmx::test::CommandLine;
+using gmx::test::StdioTestHelper;
+using gmx::test::XvgMatch;
+
+/*! \brief Test fixture for gmx hbond, parametrized on the number of OpenMP threads
+ *
+ * The hydrogen bonds found by the threads are merged per frame, so running
+ * with several threads checks that the merge neither loses nor reorders
+ * hydrogen bonds. All thread counts should give the same reference data.
+ */
+/* hbond_traj.xtc contains 11 frames, 0.04 ps apart, of a simulation of
+ * spc216 with about 350 hydrogen bonds per frame.
+ */
+class HbondTest : public gmx::test::CommandLineTestBase, public ::testing::WithParamInterface<int>
+{
+public:
+    HbondTest()
+    {
+        setInputFile("-f", "hbond_traj.xtc");
+        setInputFile("-n", "spc216.ndx");
+        setOutputFile("-num", "hbnum.xvg", XvgMatch());
+        XvgMatch xvg;
+        setOutputFile("-ac", "hbac.xvg",
+                      xvg.tolerance(gmx::test::relativeToleranceAsFloatingPoint(1, 1e-4)));
+    }
+
+    void runTest(const CommandLine& args)
+    {
+        std::string tpr = fileManager().getTemporaryFilePath(".tpr");
+        std::string mdp = fileManager().getTemporaryFilePath(".mdp");
+        FILE*       fp  = fopen(mdp.c_str(), "w");
+        fprintf(fp, "cutoff-scheme           = verlet\n");
+        fprintf(fp, "rcoulomb                = 0.8\n");
+        fprintf(fp, "rvdw                    = 0.8\n");
+        fprintf(fp, "verlet-buffer-tolerance = -1\n");
+        fprintf(fp, "rlist                   = 0.8\n");
+        fclose(fp);
+
+        // Prepare a .tpr file
+        {
+            CommandLine caller;
+            auto        simDB = gmx::test::TestFileManager::getTestSimulationDatabaseDirectory();
+            auto        base  = gmx::Path::join(simDB, "spc216");
+            caller.append("grompp");
+            caller.addOption("-maxwarn", 0);
+            caller.addOption("-f", mdp.c_str());
+            std::string gro = (base + ".gro");
+            caller.addOption("-c", gro.c_str());
+            std::string top = (base + ".top");
+            caller.addOption("-p", top.c_str());
+            caller.addOption("-o", tpr.c_str());
+            ASSERT_EQ(0, gmx_grompp(caller.argc(), caller.argv()));
+        }
+        // Run the hydrogen bond analysis of the waters with themselves
+        {
+            StdioTestHelper stdioHelper(&fileManager());
+            stdioHelper.redirectStringToStdin("0 0\n");
+
+            CommandLine& cmdline = commandLine();
+            cmdline.merge(args);
+            cmdline.addOption("-s", tpr.c_str());
+            /* gmx hbond uses at most the maximum number of OpenMP threads,
+             * so raise it to also test several threads on a single core.
+             */
+            const int numThreads = GetParam();
+            cmdline.addOption("-nthreads", numThreads);
+            gmx_omp_set_num_threads(numThreads);
+            ASSERT_EQ(0, gmx_hbond(cmdline.argc(), cmdline.argv()));
+            checkOutputFiles();
+        }
+    }
+};
+
+TEST_P(HbondTest, NumberAndAutocorrelationWork)
+{
+    const char* const cmdline[] = { "hbond" };
+    runTest(CommandLine(cmdline));
+}
+
+INSTANTIATE_TEST_CASE_P(WithThreads, HbondTest, ::testing::Values(1, 4));
+
+} // namespace
@@ -188,4 +188,34 @@ TEST_F(MsdMolTest, diffMolSelected)
     runTest(CommandLine(cmdline), "spc5_3.ndx", "spc5");
 }
 
+/* gmx msd keeps its option values in static variables, so the FFT tests
+ * are in separate test cases that run after the tests above and set all
+ * options that these change.
+ */
+using MsdFftTest    = MsdTest;
+using MsdMolFftTest = MsdMolTest;
+
+/* The FFT algorithm uses all frames as restart points, so it should
+ * produce the same results as the direct algorithm with -trestart 1
+ */
+TEST_F(MsdFftTest, threeDimensionalDiffusion)
+{
+    const char* const cmdline[] = { "msd", "-mw", "no", "-type", "no", "-lateral", "no", "-fft" };
+    runTest(CommandLine(cmdline));
+}
+
+// With a memory limit of less than a frame, every atom is processed separately
+TEST_F(MsdFftTest, oneDimensionalDiffusionInBlocks)
+{
+    const char* const cmdline[] = { "msd", "-mw", "no", "-type", "x", "-fft", "-fftmem", "0" };
+    runTest(CommandLine(cmdline));
+}
+
+// Test the diffusion per molecule output with the FFT algorithm
+TEST_F(MsdMolFftTest, diffMol)
+{
+    const char* const cmdline[] = { "msd", "-mw", "yes", "-type", "no", "-fft", "-fftmem", "1024" };
+    runTest(CommandLine(cmdline), "spc5.ndx", "spc5");
+}
+
 } // namespace
@@ -41,6 +41,7 @@
 #include <cmath>
 
 #include <algorithm>
+#include <type_traits>
 
 #include "gromacs/gmxlib/nrnb.h"
 #include "gromacs/gmxlib/nonbonded/nb_kernel.h"
@@ -50,6 +51,8 @@
 #include "gromacs/mdtypes/forceoutput.h"
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/simd/simd_math.h"
 #include "gromacs/utility/fatalerror.h"
 
 
@@ -77,6 +80,15 @@ struct SoftCoreReal<SoftCoreTreatment::RPower48>
     using Real = double;
 };
 
+/*! \brief Whether a SIMD kernel is available for the soft-core treatment
+ *
+ * The SIMD kernel computes all soft-core terms in real precision,
+ * so treatments that require double are only supported in double precision.
+ */
+template<SoftCoreTreatment softCoreTreatment>
+using HaveSimdKernel =
+        std::integral_constant<bool, GMX_SIMD_HAVE_REAL && std::is_same<typename SoftCoreReal<softCoreTreatment>::Real, real>::value>;
+
 //! Computes r^(1/p) and 1/r^(1/p) for the standard p=6
 template<SoftCoreTreatment softCoreTreatment>
 static inline void pthRoot(const real r, real* pthRoot, real* invPthRoot)
@@ -104,6 +116,26 @@ inline void pthRoot<SoftCoreTreatment::RPower48>(const double r, real* pthRoot,
     *invPthRoot = 1 / (*pthRoot);
 }
 
+#if GMX_SIMD_HAVE_REAL
+//! Computes r^(1/p) and 1/r^(1/p) for the standard p=6, SIMD version, r should be > 0
+template<SoftCoreTreatment softCoreTreatment>
+static inline void pthRoot(const gmx::SimdReal r, gmx::SimdReal* pthRoot, gmx::SimdReal* invPthRoot)
+{
+    *invPthRoot = gmx::invsqrt(gmx::cbrt(r));
+    *pthRoot    = gmx::inv(*invPthRoot);
+}
+
+//! Computes r^(1/p) and 1/r^(1/p) for p=48, SIMD version, r should be > 0
+template<>
+inline void pthRoot<SoftCoreTreatment::RPower48>(const gmx::SimdReal r,
+                                                 gmx::SimdReal*      pthRoot,
+                                                 gmx::SimdReal*      invPthRoot)
+{
+    *pthRoot    = gmx::pow(r, gmx::SimdReal(1.0_real / 48.0_real));
+    *invPthRoot = gmx::inv(*pthRoot);
+}
+#endif
+
 template<SoftCoreTreatment softCoreTreatment>
 static inline real calculateSigmaPow(const real sigma6)
 {
@@ -869,6 +901,652 @@ static void nb_free_energy_kernel(const t_nblist* gmx_restrict nlist,
     inc_nrnb(nrnb, eNR_NBKERNEL_FREE_ENERGY, nlist->nri * 12 + nlist->jindex[nri] * 150);
 }
 
+#if GMX_SIMD_HAVE_REAL
+/*! \brief Templated free-energy non-bonded kernel, SIMD version
+ *
+ * Computes exactly the same interactions as nb_free_energy_kernel(),
+ * but processes the j-particles of each i-entry in chunks of
+ * GMX_SIMD_REAL_WIDTH. The pair parameters are collected into aligned
+ * buffers, all interactions are computed for all lanes and the conditional
+ * branches of the scalar kernel are replaced by masks. The same Ewald
+ * correction tables as in the scalar kernel are used.
+ * The j-forces are reduced with the same atomics as in the scalar kernel.
+ *
+ * Can only be used when all soft-core terms can be computed in real,
+ * see HaveSimdKernel.
+ */
+template<SoftCoreTreatment softCoreTreatment, bool scLambdasOrAlphasDiffer, bool vdwInteractionTypeIsEwald, bool elecInteractionTypeIsEwald, bool vdwModifierIsPotSwitch>
+static void nb_free_energy_kernel_simd(const t_nblist* gmx_restrict nlist,
+                                       rvec* gmx_restrict         xx,
+                                       gmx::ForceWithShiftForces* forceWithShiftForces,
+                                       const t_forcerec* gmx_restrict fr,
+                                       const t_mdatoms* gmx_restrict mdatoms,
+                                       nb_kernel_data_t* gmx_restrict kernel_data,
+                                       t_nrnb* gmx_restrict nrnb)
+{
+    using gmx::SimdBool;
+    using gmx::SimdReal;
+
+    static_assert(HaveSimdKernel<softCoreTreatment>::value,
+                  "The SIMD kernel requires soft-core computation in real");
+
+    constexpr bool useSoftCore = (softCoreTreatment != SoftCoreTreatment::None);
+
+    constexpr int simdWidth = GMX_SIMD_REAL_WIDTH;
+
+    constexpr real onetwelfth = 1.0 / 12.0;
+    constexpr real onesixth   = 1.0 / 6.0;
+    constexpr real zero       = 0.0;
+    constexpr real half       = 0.5;
+    constexpr real one        = 1.0;
+    constexpr real two        = 2.0;
+    constexpr real six        = 6.0;
+
+    /* Extract pointer to non-bonded interaction constants */
+    const interaction_const_t* ic = fr->ic;
+
+    // Extract pair list data
+    const int  nri    = nlist->nri;
+    const int* iinr   = nlist->iinr;
+    const int* jindex = nlist->jindex;
+    const int* jjnr   = nlist->jjnr;
+    const int* shift  = nlist->shift;
+    const int* gid    = nlist->gid;
+
+    const real* shiftvec      = fr->shift_vec[0];
+    const real* chargeA       = mdatoms->chargeA;
+    const real* chargeB       = mdatoms->chargeB;
+    real*       Vc            = kernel_data->energygrp_elec;
+    const int*  typeA         = mdatoms->typeA;
+    const int*  typeB         = mdatoms->typeB;
+    const int   ntype         = fr->ntype;
+    const real* nbfp          = fr->nbfp;
+    const real* nbfp_grid     = fr->ljpme_c6grid;
+    real*       Vv            = kernel_data->energygrp_vdw;
+    const real  lambda_coul   = kernel_data->lambda[efptCOUL];
+    const real  lambda_vdw    = kernel_data->lambda[efptVDW];
+    real*       dvdl          = kernel_data->dvdl;
+    const real  alpha_coul    = fr->sc_alphacoul;
+    const real  alpha_vdw     = fr->sc_alphavdw;
+    const real  lam_power     = fr->sc_power;
+    const real  sigma6_def    = fr->sc_sigma6_def;
+    const real  sigma6_min    = fr->sc_sigma6_min;
+    const bool  doForces      = ((kernel_data->flags & GMX_NONBONDED_DO_FORCE) != 0);
+    const bool  doShiftForces = ((kernel_data->flags & GMX_NONBONDED_DO_SHIFTFORCE) != 0);
+    const bool  doPotential   = ((kernel_data->flags & GMX_NONBONDED_DO_POTENTIAL) != 0);
+
+    // Extract data from interaction_const_t
+    const real facel           = ic->epsfac;
+    const real rcoulomb        = ic->rcoulomb;
+    const real krf             = ic->k_rf;
+    const real crf             = ic->c_rf;
+    const real sh_lj_ewald     = ic->sh_lj_ewald;
+    const real rvdw            = ic->rvdw;
+    const real dispersionShift = ic->dispersion_shift.cpot;
+    const real repulsionShift  = ic->repulsion_shift.cpot;
+
+    // Note that the nbnxm kernels do not support Coulomb potential switching at all
+    GMX_ASSERT(ic->coulomb_modifier != eintmodPOTSWITCH,
+               "Potential switching is not supported for Coulomb with FEP");
+
+    real vdw_swV3, vdw_swV4, vdw_swV5, vdw_swF2, vdw_swF3, vdw_swF4;
+    if (vdwModifierIsPotSwitch)
+    {
+        const real d = ic->rvdw - ic->rvdw_switch;
+        vdw_swV3     = -10.0 / (d * d * d);
+        vdw_swV4     = 15.0 / (d * d * d * d);
+        vdw_swV5     = -6.0 / (d * d * d * d * d);
+        vdw_swF2     = -30.0 / (d * d * d);
+        vdw_swF3     = 60.0 / (d * d * d * d);
+        vdw_swF4     = -30.0 / (d * d * d * d * d);
+    }
+    else
+    {
+        vdw_swV3 = vdw_swV4 = vdw_swV5 = vdw_swF2 = vdw_swF3 = vdw_swF4 = 0.0;
+    }
+
+    const bool computeExclusionReactionField = (ic->eeltype == eelCUT || EEL_RF(ic->eeltype));
+
+    real rcutoff_max2 = std::max(ic->rcoulomb, ic->rvdw);
+    rcutoff_max2      = rcutoff_max2 * rcutoff_max2;
+
+    const real* tab_ewald_F_lj           = nullptr;
+    const real* tab_ewald_V_lj           = nullptr;
+    const real* ewtab                    = nullptr;
+    real        coulombTableScale        = 0;
+    real        coulombTableScaleInvHalf = 0;
+    real        vdwTableScale            = 0;
+    real        vdwTableScaleInvHalf     = 0;
+    real        sh_ewald                 = 0;
+    if (elecInteractionTypeIsEwald || vdwInteractionTypeIsEwald)
+    {
+        sh_ewald = ic->sh_ewald;
+    }
+    if (elecInteractionTypeIsEwald)
+    {
+        const auto& coulombTables = *ic->coulombEwaldTables;
+        ewtab                     = coulombTables.tableFDV0.data();
+        coulombTableScale         = coulombTables.scale;
+        coulombTableScaleInvHalf  = half / coulombTableScale;
+    }
+    if (vdwInteractionTypeIsEwald)
+    {
+        const auto& vdwTables = *ic->vdwEwaldTables;
+        tab_ewald_F_lj        = vdwTables.tableF.data();
+        tab_ewald_V_lj        = vdwTables.tableV.data();
+        vdwTableScale         = vdwTables.scale;
+        vdwTableScaleInvHalf  = half / vdwTableScale;
+    }
+
+    GMX_RELEASE_ASSERT(!(vdwInteractionTypeIsEwald && vdwModifierIsPotSwitch),
+                       "Can not apply soft-core to switched Ewald potentials");
+
+    /* Lambda factors, see the scalar kernel */
+    real LFC[NSTATES], LFV[NSTATES];
+    LFC[STATE_A] = one - lambda_coul;
+    LFV[STATE_A] = one - lambda_vdw;
+    LFC[STATE_B] = lambda_coul;
+    LFV[STATE_B] = lambda_vdw;
+
+    real DLF[NSTATES];
+    DLF[STATE_A] = -1;
+    DLF[STATE_B] = 1;
+
+    real           lfac_coul[NSTATES], dlfac_coul[NSTATES], lfac_vdw[NSTATES], dlfac_vdw[NSTATES];
+    constexpr real sc_r_power = (softCoreTreatment == SoftCoreTreatment::RPower48 ? 48.0_real : 6.0_real);
+    for (int i = 0; i < NSTATES; i++)
+    {
+        lfac_coul[i]  = (lam_power == 2 ? (1 - LFC[i]) * (1 - LFC[i]) : (1 - LFC[i]));
+        dlfac_coul[i] = DLF[i] * lam_power / sc_r_power * (lam_power == 2 ? (1 - LFC[i]) : 1);
+        lfac_vdw[i]   = (lam_power == 2 ? (1 - LFV[i]) * (1 - LFV[i]) : (1 - LFV[i]));
+        dlfac_vdw[i]  = DLF[i] * lam_power / sc_r_power * (lam_power == 2 ? (1 - LFV[i]) : 1);
+    }
+
+    const real* x             = xx[0];
+    real* gmx_restrict f      = &(forceWithShiftForces->force()[0][0]);
+    real* gmx_restrict fshift = &(forceWithShiftForces->shiftForces()[0][0]);
+
+    /* Buffers for the j-particle data of one SIMD chunk of the pair list.
+     * Lane flags are stored as real 0/1 values, so we can convert them to SimdBool.
+     */
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t preloadJnr[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t tableIndex[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadPairIncluded[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadPairInteracts[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadIiEqualsJnr[simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadQq[NSTATES][simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadC6[NSTATES][simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadC12[NSTATES][simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         preloadC6Grid[NSTATES][simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         tableBuffer[3][simdWidth];
+    alignas(GMX_SIMD_ALIGNMENT) real         forceBuffer[DIM][simdWidth];
+
+    const SimdReal zeroS = gmx::setZero();
+
+    SimdReal dvdlCoulS = zeroS;
+    SimdReal dvdlVdwS  = zeroS;
+
+    for (int n = 0; n < nri; n++)
+    {
+        bool haveInteractionWithinCutoff = false;
+
+        const int      is3   = 3 * shift[n];
+        const int      nj0   = jindex[n];
+        const int      nj1   = jindex[n + 1];
+        const int      ii    = iinr[n];
+        const int      ii3   = 3 * ii;
+        const SimdReal ixS   = SimdReal(shiftvec[is3] + x[ii3 + 0]);
+        const SimdReal iyS   = SimdReal(shiftvec[is3 + 1] + x[ii3 + 1]);
+        const SimdReal izS   = SimdReal(shiftvec[is3 + 2] + x[ii3 + 2]);
+        const real     iqA   = facel * chargeA[ii];
+        const real     iqB   = facel * chargeB[ii];
+        const int      ntiA  = 2 * ntype * typeA[ii];
+        const int      ntiB  = 2 * ntype * typeB[ii];
+        SimdReal       vctot = zeroS;
+        SimdReal       vvtot = zeroS;
+        SimdReal       fix   = zeroS;
+        SimdReal       fiy   = zeroS;
+        SimdReal       fiz   = zeroS;
+
+        for (int k = nj0; k < nj1; k += simdWidth)
+        {
+            /* Collect the j-particle data, pad the last chunk with
+             * copies of the last j-particle which are masked out.
+             */
+            for (int s = 0; s < simdWidth; s++)
+            {
+                const bool pairIsIncluded = (k + s < nj1);
+                const int  kk             = (pairIsIncluded ? k + s : nj1 - 1);
+                const int  jnr            = jjnr[kk];
+                const int  tjA            = ntiA + 2 * typeA[jnr];
+                const int  tjB            = ntiB + 2 * typeB[jnr];
+
+                preloadJnr[s]           = jnr;
+                preloadPairIncluded[s]  = (pairIsIncluded ? one : zero);
+                preloadPairInteracts[s] = ((nlist->excl_fep == nullptr || nlist->excl_fep[kk]) ? one : zero);
+                preloadIiEqualsJnr[s]   = (ii == jnr ? one : zero);
+
+                preloadQq[STATE_A][s]  = iqA * chargeA[jnr];
+                preloadQq[STATE_B][s]  = iqB * chargeB[jnr];
+                preloadC6[STATE_A][s]  = nbfp[tjA];
+                preloadC6[STATE_B][s]  = nbfp[tjB];
+                preloadC12[STATE_A][s] = nbfp[tjA + 1];
+                preloadC12[STATE_B][s] = nbfp[tjB + 1];
+                if (vdwInteractionTypeIsEwald)
+                {
+                    preloadC6Grid[STATE_A][s] = nbfp_grid[tjA];
+                    preloadC6Grid[STATE_B][s] = nbfp_grid[tjB];
+                }
+            }
+
+            SimdReal jx, jy, jz;
+            gmx::gatherLoadUTranspose<3>(x, preloadJnr, &jx, &jy, &jz);
+
+            const SimdReal dx  = ixS - jx;
+            const SimdReal dy  = iyS - jy;
+            const SimdReal dz  = izS - jz;
+            const SimdReal rsq = dx * dx + dy * dy + dz * dz;
+
+            /* As in the scalar kernel, we skip pairs beyond the maximum cut-off */
+            const SimdBool withinCutoff =
+                    (zeroS < gmx::load<SimdReal>(preloadPairIncluded)) && (rsq < SimdReal(rcutoff_max2));
+            if (!gmx::anyTrue(withinCutoff))
+            {
+                continue;
+            }
+            haveInteractionWithinCutoff = true;
+
+            const SimdReal pairInteracts = gmx::load<SimdReal>(preloadPairInteracts);
+            const SimdBool interacts     = withinCutoff && (zeroS < pairInteracts);
+            const SimdBool bIiEqJnr      = (zeroS < gmx::load<SimdReal>(preloadIiEqualsJnr));
+
+            /* The force at r=0 is zero, because of symmetry, so rinv=0 there */
+            const SimdReal rinv = gmx::maskzInvsqrt(rsq, withinCutoff && (zeroS < rsq));
+            const SimdReal r    = rsq * rinv;
+
+            SimdReal rp, rpm2;
+            if (softCoreTreatment == SoftCoreTreatment::None)
+            {
+                rpm2 = rinv * rinv;
+                rp   = SimdReal(one);
+            }
+            if (softCoreTreatment == SoftCoreTreatment::RPower6)
+            {
+                rpm2 = rsq * rsq;  /* r4 */
+                rp   = rpm2 * rsq; /* r6 */
+            }
+            if (softCoreTreatment == SoftCoreTreatment::RPower48)
+            {
+                rp   = rsq * rsq * rsq; /* r6 */
+                rp   = rp * rp;         /* r12 */
+                rp   = rp * rp;         /* r24 */
+                rp   = rp * rp;         /* r48 */
+                rpm2 = rp * rinv * rinv; /* r46 */
+            }
+
+            SimdReal Fscal = zeroS;
+
+            SimdReal qq[NSTATES], c6[NSTATES], c12[NSTATES];
+            for (int i = 0; i < NSTATES; i++)
+            {
+                qq[i]  = gmx::load<SimdReal>(preloadQq[i]);
+                c6[i]  = gmx::load<SimdReal>(preloadC6[i]);
+                c12[i] = gmx::load<SimdReal>(preloadC12[i]);
+            }
+
+            if (gmx::anyTrue(interacts))
+            {
+                SimdReal sigma_pow[NSTATES];
+                SimdReal alpha_vdw_eff, alpha_coul_eff;
+                if (useSoftCore)
+                {
+                    for (int i = 0; i < NSTATES; i++)
+                    {
+                        /* c12 is stored scaled with 12.0 and c6 is scaled with 6.0 - correct for this */
+                        const SimdBool c6AndC12ArePositive = (zeroS < c6[i]) && (zeroS < c12[i]);
+                        SimdReal       sigma6 =
+                                SimdReal(half) * c12[i] * gmx::maskzInv(c6[i], c6AndC12ArePositive);
+                        sigma6 = gmx::max(sigma6, SimdReal(sigma6_min));
+                        sigma6 = gmx::blend(SimdReal(sigma6_def), sigma6, c6AndC12ArePositive);
+                        if (softCoreTreatment == SoftCoreTreatment::RPower6)
+                        {
+                            sigma_pow[i] = sigma6;
+                        }
+                        else
+                        {
+                            sigma_pow[i] = sigma6 * sigma6;           /* sigma^12 */
+                            sigma_pow[i] = sigma_pow[i] * sigma_pow[i]; /* sigma^24 */
+                            sigma_pow[i] = sigma_pow[i] * sigma_pow[i]; /* sigma^48 */
+                        }
+                    }
+
+                    /* only use softcore if one of the states has a zero endstate - softcore is for avoiding infinities!*/
+                    const SimdBool bothC12ArePositive = (zeroS < c12[STATE_A]) && (zeroS < c12[STATE_B]);
+                    alpha_vdw_eff  = gmx::selectByNotMask(SimdReal(alpha_vdw), bothC12ArePositive);
+                    alpha_coul_eff = gmx::selectByNotMask(SimdReal(alpha_coul), bothC12ArePositive);
+                }
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    /* Only spend time on A or B state if it is non-zero */
+                    const SimdBool stateIsNonZero =
+                            interacts && ((qq[i] != zeroS) || (c6[i] != zeroS) || (c12[i] != zeroS));
+
+                    SimdReal rinvC, rinvV, rC, rV, rpinvC, rpinvV;
+                    if (useSoftCore)
+                    {
+                        /* Masked out lanes get r=1, which keeps the math below finite */
+                        rpinvC = gmx::inv(gmx::blend(SimdReal(one),
+                                                     alpha_coul_eff * lfac_coul[i] * sigma_pow[i] + rp,
+                                                     stateIsNonZero));
+                        pthRoot<softCoreTreatment>(rpinvC, &rinvC, &rC);
+                        if (scLambdasOrAlphasDiffer)
+                        {
+                            rpinvV = gmx::inv(gmx::blend(SimdReal(one),
+                                                         alpha_vdw_eff * lfac_vdw[i] * sigma_pow[i] + rp,
+                                                         stateIsNonZero));
+                            pthRoot<softCoreTreatment>(rpinvV, &rinvV, &rV);
+                        }
+                        else
+                        {
+                            /* We can avoid one expensive pow and one / operation */
+                            rpinvV = rpinvC;
+                            rinvV  = rinvC;
+                            rV     = rC;
+                        }
+                    }
+                    else
+                    {
+                        rpinvC = SimdReal(one);
+                        rinvC  = rinv;
+                        rC     = r;
+
+                        rpinvV = SimdReal(one);
+                        rinvV  = rinv;
+                        rV     = r;
+                    }
+
+                    /* Only process the coulomb interactions if we have charges
+                     * and if we are within the cutoff.
+                     */
+                    const SimdBool computeElecInteraction =
+                            stateIsNonZero && (qq[i] != zeroS)
+                            && ((elecInteractionTypeIsEwald ? r : rC) < SimdReal(rcoulomb));
+
+                    SimdReal Vcoul, FscalC;
+                    if (elecInteractionTypeIsEwald)
+                    {
+                        Vcoul  = qq[i] * (rinvC - SimdReal(sh_ewald));
+                        FscalC = qq[i] * rinvC;
+                    }
+                    else
+                    {
+                        Vcoul  = qq[i] * (rinvC + SimdReal(krf) * rC * rC - SimdReal(crf));
+                        FscalC = qq[i] * (rinvC - SimdReal(two * krf) * rC * rC);
+                    }
+                    Vcoul  = gmx::selectByMask(Vcoul, computeElecInteraction);
+                    FscalC = gmx::selectByMask(FscalC, computeElecInteraction);
+
+                    /* Only process the VDW interactions if we have
+                     * some non-zero parameters and if we are within the cutoff.
+                     */
+                    const SimdBool computeVdwInteraction =
+                            stateIsNonZero && ((c6[i] != zeroS) || (c12[i] != zeroS))
+                            && ((vdwInteractionTypeIsEwald ? r : rV) < SimdReal(rvdw));
+
+                    SimdReal rinv6;
+                    if (softCoreTreatment == SoftCoreTreatment::RPower6)
+                    {
+                        rinv6 = rpinvV;
+                    }
+                    else
+                    {
+                        rinv6 = rinvV * rinvV;
+                        rinv6 = rinv6 * rinv6 * rinv6;
+                    }
+                    const SimdReal Vvdw6  = c6[i] * rinv6;
+                    const SimdReal Vvdw12 = c12[i] * rinv6 * rinv6;
+
+                    SimdReal Vvdw = (Vvdw12 + c12[i] * SimdReal(repulsionShift)) * SimdReal(onetwelfth)
+                                    - (Vvdw6 + c6[i] * SimdReal(dispersionShift)) * SimdReal(onesixth);
+                    SimdReal FscalV = Vvdw12 - Vvdw6;
+
+                    if (vdwInteractionTypeIsEwald)
+                    {
+                        /* Subtract the grid potential at the cut-off */
+                        Vvdw = Vvdw
+                               + gmx::load<SimdReal>(preloadC6Grid[i])
+                                         * SimdReal(sh_lj_ewald * onesixth);
+                    }
+
+                    if (vdwModifierIsPotSwitch)
+                    {
+                        const SimdReal d  = gmx::max(rV - SimdReal(ic->rvdw_switch), zeroS);
+                        const SimdReal d2 = d * d;
+                        const SimdReal sw =
+                                SimdReal(one)
+                                + d2 * d
+                                          * (SimdReal(vdw_swV3)
+                                             + d * (SimdReal(vdw_swV4) + d * SimdReal(vdw_swV5)));
+                        const SimdReal dsw =
+                                d2 * (SimdReal(vdw_swF2) + d * (SimdReal(vdw_swF3) + d * SimdReal(vdw_swF4)));
+
+                        const SimdBool withinSwitchCutoff = (rV < SimdReal(rvdw));
+                        FscalV = gmx::selectByMask(FscalV * sw - rV * Vvdw * dsw, withinSwitchCutoff);
+                        Vvdw   = gmx::selectByMask(Vvdw * sw, withinSwitchCutoff);
+                    }
+
+                    Vvdw   = gmx::selectByMask(Vvdw, computeVdwInteraction);
+                    FscalV = gmx::selectByMask(FscalV, computeVdwInteraction);
+
+                    /* FscalC (and FscalV) now contain: dV/drC * rC
+                     * Now we multiply by rC^-p, so it will be: dV/drC * rC^1-p
+                     */
+                    FscalC = FscalC * rpinvC;
+                    FscalV = FscalV * rpinvV;
+
+                    /* Assemble A and B states */
+                    vctot = vctot + SimdReal(LFC[i]) * Vcoul;
+                    vvtot = vvtot + SimdReal(LFV[i]) * Vvdw;
+
+                    Fscal = Fscal + SimdReal(LFC[i]) * FscalC * rpm2;
+                    Fscal = Fscal + SimdReal(LFV[i]) * FscalV * rpm2;
+
+                    if (useSoftCore)
+                    {
+                        dvdlCoulS = dvdlCoulS + Vcoul * SimdReal(DLF[i])
+                                    + SimdReal(LFC[i] * dlfac_coul[i]) * alpha_coul_eff * FscalC
+                                              * sigma_pow[i];
+                        dvdlVdwS = dvdlVdwS + Vvdw * SimdReal(DLF[i])
+                                   + SimdReal(LFV[i] * dlfac_vdw[i]) * alpha_vdw_eff * FscalV
+                                             * sigma_pow[i];
+                    }
+                    else
+                    {
+                        dvdlCoulS = dvdlCoulS + Vcoul * SimdReal(DLF[i]);
+                        dvdlVdwS  = dvdlVdwS + Vvdw * SimdReal(DLF[i]);
+                    }
+                }
+            }
+
+            if (computeExclusionReactionField)
+            {
+                /* For excluded pairs we don't use soft-core, see the scalar kernel */
+                const SimdBool isExcluded = withinCutoff && (pairInteracts == zeroS);
+
+                const SimdReal FF = SimdReal(-two * krf);
+                SimdReal       VV = SimdReal(krf) * rsq - SimdReal(crf);
+                VV                = gmx::blend(VV, SimdReal(half) * VV, bIiEqJnr);
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    const SimdReal qqExcl = gmx::selectByMask(qq[i], isExcluded);
+                    vctot                 = vctot + SimdReal(LFC[i]) * qqExcl * VV;
+                    Fscal                 = Fscal + SimdReal(LFC[i]) * qqExcl * FF;
+                    dvdlCoulS             = dvdlCoulS + SimdReal(DLF[i]) * qqExcl * VV;
+                }
+            }
+
+            if (elecInteractionTypeIsEwald)
+            {
+                /* See the scalar kernel, we subtract the reciprocal-space
+                 * Ewald component, here for all lanes within the Coulomb cut-off.
+                 * Masked out lanes use table index 0 to avoid out of range access.
+                 */
+                const SimdBool withinCoulombCutoff = withinCutoff && (r < SimdReal(rcoulomb));
+
+                const SimdReal ewrt = gmx::selectByMask(r, withinCoulombCutoff) * SimdReal(coulombTableScale);
+                const SimdReal eweps = ewrt - gmx::trunc(ewrt);
+                gmx::store(tableIndex, gmx::cvttR2I(ewrt));
+
+                SimdReal ewtabF, ewtabD, ewtabV, ewtabFn;
+                gmx::gatherLoadTranspose<4>(ewtab, tableIndex, &ewtabF, &ewtabD, &ewtabV, &ewtabFn);
+
+                SimdReal f_lr = ewtabF + eweps * ewtabD;
+                SimdReal v_lr = ewtabV - SimdReal(coulombTableScaleInvHalf) * eweps * (ewtabF + f_lr);
+                f_lr          = f_lr * rinv;
+
+                /* Scale the self-interaction, which occurs twice, by 50% */
+                v_lr = gmx::blend(v_lr, SimdReal(half) * v_lr, bIiEqJnr);
+
+                v_lr = gmx::selectByMask(v_lr, withinCoulombCutoff);
+                f_lr = gmx::selectByMask(f_lr, withinCoulombCutoff);
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    vctot     = vctot - SimdReal(LFC[i]) * qq[i] * v_lr;
+                    Fscal     = Fscal - SimdReal(LFC[i]) * qq[i] * f_lr;
+                    dvdlCoulS = dvdlCoulS - SimdReal(DLF[i]) * qq[i] * v_lr;
+                }
+            }
+
+            if (vdwInteractionTypeIsEwald)
+            {
+                /* See the scalar kernel, we subtract the reciprocal-space
+                 * LJ-Ewald component, here for all lanes within the VdW cut-off.
+                 * The separate F and V tables do not allow aligned SIMD loads,
+                 * so we collect the table entries per lane.
+                 */
+                const SimdBool withinVdwCutoff = withinCutoff && (r < SimdReal(rvdw));
+
+                const SimdReal rs   = gmx::selectByMask(r, withinVdwCutoff) * SimdReal(vdwTableScale);
+                const SimdReal frac = rs - gmx::trunc(rs);
+                gmx::store(tableIndex, gmx::cvttR2I(rs));
+                for (int s = 0; s < simdWidth; s++)
+                {
+                    const int ri     = tableIndex[s];
+                    tableBuffer[0][s] = tab_ewald_F_lj[ri];
+                    tableBuffer[1][s] = tab_ewald_F_lj[ri + 1];
+                    tableBuffer[2][s] = tab_ewald_V_lj[ri];
+                }
+                const SimdReal tabF0 = gmx::load<SimdReal>(tableBuffer[0]);
+                const SimdReal tabF1 = gmx::load<SimdReal>(tableBuffer[1]);
+                const SimdReal tabV0 = gmx::load<SimdReal>(tableBuffer[2]);
+
+                const SimdReal f_lr = (SimdReal(one) - frac) * tabF0 + frac * tabF1;
+                SimdReal       FF   = f_lr * rinv * SimdReal(one / six);
+                SimdReal       VV   = (tabV0 - SimdReal(vdwTableScaleInvHalf) * frac * (tabF0 + f_lr))
+                              * SimdReal(one / six);
+
+                /* Scale the self-interaction, which occurs twice, by 50% */
+                VV = gmx::blend(VV, SimdReal(half) * VV, bIiEqJnr);
+
+                FF = gmx::selectByMask(FF, withinVdwCutoff);
+                VV = gmx::selectByMask(VV, withinVdwCutoff);
+
+                for (int i = 0; i < NSTATES; i++)
+                {
+                    const SimdReal c6grid = gmx::load<SimdReal>(preloadC6Grid[i]);
+                    vvtot                 = vvtot + SimdReal(LFV[i]) * c6grid * VV;
+                    Fscal                 = Fscal + SimdReal(LFV[i]) * c6grid * FF;
+                    dvdlVdwS              = dvdlVdwS + SimdReal(DLF[i]) * c6grid * VV;
+                }
+            }
+
+            if (doForces)
+            {
+                const SimdReal tx = Fscal * dx;
+                const SimdReal ty = Fscal * dy;
+                const SimdReal tz = Fscal * dz;
+                fix               = fix + tx;
+                fiy               = fiy + ty;
+                fiz               = fiz + tz;
+                gmx::store(forceBuffer[XX], tx);
+                gmx::store(forceBuffer[YY], ty);
+                gmx::store(forceBuffer[ZZ], tz);
+
+                /* Different threads can update the same j-particles,
+                 * so we need the same atomics as in the scalar kernel.
+                 */
+                const int numPairsInChunk = std::min(simdWidth, nj1 - k);
+                for (int s = 0; s < numPairsInChunk; s++)
+                {
+                    const int j3 = 3 * preloadJnr[s];
+#    pragma omp atomic
+                    f[j3] -= forceBuffer[XX][s];
+#    pragma omp atomic
+                    f[j3 + 1] -= forceBuffer[YY][s];
+#    pragma omp atomic
+                    f[j3 + 2] -= forceBuffer[ZZ][s];
+                }
+            }
+        }
+
+        /* As in the scalar kernel, skip the expensive atomic i-reductions
+         * when there are no pairs within the cut-off.
+         */
+        if (haveInteractionWithinCutoff)
+        {
+            const real fixR = gmx::reduce(fix);
+            const real fiyR = gmx::reduce(fiy);
+            const real fizR = gmx::reduce(fiz);
+            if (doForces)
+            {
+#    pragma omp atomic
+                f[ii3] += fixR;
+#    pragma omp atomic
+                f[ii3 + 1] += fiyR;
+#    pragma omp atomic
+                f[ii3 + 2] += fizR;
+            }
+            if (doShiftForces)
+            {
+#    pragma omp atomic
+                fshift[is3] += fixR;
+#    pragma omp atomic
+                fshift[is3 + 1] += fiyR;
+#    pragma omp atomic
+                fshift[is3 + 2] += fizR;
+            }
+            if (doPotential)
+            {
+                const int  ggid   = gid[n];
+                const real vctotR = gmx::reduce(vctot);
+                const real vvtotR = gmx::reduce(vvtot);
+#    pragma omp atomic
+                Vc[ggid] += vctotR;
+#    pragma omp atomic
+                Vv[ggid] += vvtotR;
+            }
+        }
+    }
+
+    const real dvdl_coul = gmx::reduce(dvdlCoulS);
+    const real dvdl_vdw  = gmx::reduce(dvdlVdwS);
+#    pragma omp atomic
+    dvdl[efptCOUL] += dvdl_coul;
+#    pragma omp atomic
+    dvdl[efptVDW] += dvdl_vdw;
+
+    /* Estimate flops, average for free energy stuff:
+     * 12  flops per outer iteration
+     * 150 flops per inner iteration
+     */
+#    pragma omp atomic
+    inc_nrnb(nrnb, eNR_NBKERNEL_FREE_ENERGY, nlist->nri * 12 + nlist->jindex[nri] * 150);
+}
+#endif
+
 typedef void (*KernelFunction)(const t_nblist* gmx_restrict nlist,
                                rvec* gmx_restrict         xx,
                                gmx::ForceWithShiftForces* forceWithShiftForces,
@@ -877,51 +1555,90 @@ typedef void (*KernelFunction)(const t_nblist* gmx_restrict nlist,
                                nb_kernel_data_t* gmx_restrict kernel_data,
                                t_nrnb* gmx_restrict nrnb);
 
+//! Returns the SIMD kernel for the given template parameters
+template<SoftCoreTreatment softCoreTreatment, bool scLambdasOrAlphasDiffer, bool vdwInteractionTypeIsEwald, bool elecInteractionTypeIsEwald, bool vdwModifierIsPotSwitch>
+static KernelFunction simdKernel(std::true_type /* haveSimdKernel */)
+{
+#if GMX_SIMD_HAVE_REAL
+    return (nb_free_energy_kernel_simd<softCoreTreatment, scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald,
+                                       elecInteractionTypeIsEwald, vdwModifierIsPotSwitch>);
+#else
+    return nullptr;
+#endif
+}
+
+//! Returns nullptr, since there is no SIMD kernel for the given template parameters
+template<SoftCoreTreatment softCoreTreatment, bool scLambdasOrAlphasDiffer, bool vdwInteractionTypeIsEwald, bool elecInteractionTypeIsEwald, bool vdwModifierIsPotSwitch>
+static KernelFunction simdKernel(std::false_type /* haveSimdKernel */)
+{
+    return nullptr;
+}
+
+template<SoftCoreTreatment softCoreTreatment, bool scLambdasOrAlphasDiffer, bool vdwInteractionTypeIsEwald, bool elecInteractionTypeIsEwald, bool vdwModifierIsPotSwitch>
+static KernelFunction dispatchKernelOnUseSimd(const bool useSimd)
+{
+    KernelFunction kernelFunc = nullptr;
+    if (useSimd)
+    {
+        kernelFunc = simdKernel<softCoreTreatment, scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald,
+                                elecInteractionTypeIsEwald, vdwModifierIsPotSwitch>(
+                HaveSimdKernel<softCoreTreatment>());
+    }
+    if (kernelFunc == nullptr)
+    {
+        kernelFunc = nb_free_energy_kernel<softCoreTreatment, scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald,
+                                           elecInteractionTypeIsEwald, vdwModifierIsPotSwitch>;
+    }
+    return kernelFunc;
+}
+
 template<SoftCoreTreatment softCoreTreatment, bool scLambdasOrAlphasDiffer, bool vdwInteractionTypeIsEwald, bool elecInteractionTypeIsEwald>
-static KernelFunction dispatchKernelOnVdwModifier(const bool vdwModifierIsPotSwitch)
+static KernelFunction dispatchKernelOnVdwModifier(const bool vdwModifierIsPotSwitch, const bool useSimd)
 {
     if (vdwModifierIsPotSwitch)
     {
-        return (nb_free_energy_kernel<softCoreTreatment, scLambdasOrAlphasDiffer,
-                                      vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald, true>);
+        return (dispatchKernelOnUseSimd<softCoreTreatment, scLambdasOrAlphasDiffer,
+                                        vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald, true>(useSimd));
     }
     else
     {
-        return (nb_free_energy_kernel<softCoreTreatment, scLambdasOrAlphasDiffer,
-                                      vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald, false>);
+        return (dispatchKernelOnUseSimd<softCoreTreatment, scLambdasOrAlphasDiffer,
+                                        vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald, false>(useSimd));
     }
 }
 
 template<SoftCoreTreatment softCoreTreatment, bool scLambdasOrAlphasDiffer, bool vdwInteractionTypeIsEwald>
 static KernelFunction dispatchKernelOnElecInteractionType(const bool elecInteractionTypeIsEwald,
-                                                          const bool vdwModifierIsPotSwitch)
+                                                          const bool vdwModifierIsPotSwitch,
+                                                          const bool useSimd)
 {
     if (elecInteractionTypeIsEwald)
     {
         return (dispatchKernelOnVdwModifier<softCoreTreatment, scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald, true>(
-                vdwModifierIsPotSwitch));
+                vdwModifierIsPotSwitch, useSimd));
     }
     else
     {
         return (dispatchKernelOnVdwModifier<softCoreTreatment, scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald, false>(
-                vdwModifierIsPotSwitch));
+                vdwModifierIsPotSwitch, useSimd));
     }
 }
 
 template<SoftCoreTreatment softCoreTreatment, bool scLambdasOrAlphasDiffer>
 static KernelFunction dispatchKernelOnVdwInteractionType(const bool vdwInteractionTypeIsEwald,
                                                          const bool elecInteractionTypeIsEwald,
-                                                         const bool vdwModifierIsPotSwitch)
+                                                         const bool vdwModifierIsPotSwitch,
+                                                         const bool useSimd)
 {
     if (vdwInteractionTypeIsEwald)
     {
         return (dispatchKernelOnElecInteractionType<softCoreTreatment, scLambdasOrAlphasDiffer, true>(
-                elecInteractionTypeIsEwald, vdwModifierIsPotSwitch));
+                elecInteractionTypeIsEwald, vdwModifierIsPotSwitch, useSimd));
     }
     else
     {
         return (dispatchKernelOnElecInteractionType<softCoreTreatment, scLambdasOrAlphasDiffer, false>(
-                elecInteractionTypeIsEwald, vdwModifierIsPotSwitch));
+                elecInteractionTypeIsEwald, vdwModifierIsPotSwitch, useSimd));
     }
 }
 
@@ -929,17 +1646,18 @@ template<SoftCoreTreatment softCoreTreatment>
 static KernelFunction dispatchKernelOnScLambdasOrAlphasDifference(const bool scLambdasOrAlphasDiffer,
                                                                   const bool vdwInteractionTypeIsEwald,
                                                                   const bool elecInteractionTypeIsEwald,
-                                                                  const bool vdwModifierIsPotSwitch)
+                                                                  const bool vdwModifierIsPotSwitch,
+                                                                  const bool useSimd)
 {
     if (scLambdasOrAlphasDiffer)
     {
         return (dispatchKernelOnVdwInteractionType<softCoreTreatment, true>(
-                vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald, vdwModifierIsPotSwitch));
+                vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald, vdwModifierIsPotSwitch, useSimd));
     }
     else
     {
         return (dispatchKernelOnVdwInteractionType<softCoreTreatment, false>(
-                vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald, vdwModifierIsPotSwitch));
+                vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald, vdwModifierIsPotSwitch, useSimd));
     }
 }
 
@@ -947,25 +1665,26 @@ static KernelFunction dispatchKernel(const bool        scLambdasOrAlphasDiffer,
                                      const bool        vdwInteractionTypeIsEwald,
                                      const bool        elecInteractionTypeIsEwald,
                                      const bool        vdwModifierIsPotSwitch,
+                                     const bool        useSimd,
                                      const t_forcerec* fr)
 {
     if (fr->sc_alphacoul == 0 && fr->sc_alphavdw == 0)
     {
         return (dispatchKernelOnScLambdasOrAlphasDifference<SoftCoreTreatment::None>(
                 scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald,
-                vdwModifierIsPotSwitch));
+                vdwModifierIsPotSwitch, useSimd));
     }
     else if (fr->sc_r_power == 6.0_real)
     {
         return (dispatchKernelOnScLambdasOrAlphasDifference<SoftCoreTreatment::RPower6>(
                 scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald,
-                vdwModifierIsPotSwitch));
+                vdwModifierIsPotSwitch, useSimd));
     }
     else
     {
         return (dispatchKernelOnScLambdasOrAlphasDifference<SoftCoreTreatment::RPower48>(
                 scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald, elecInteractionTypeIsEwald,
-                vdwModifierIsPotSwitch));
+                vdwModifierIsPotSwitch, useSimd));
     }
 }
 
@@ -1001,7 +1720,12 @@ void gmx_nb_free_energy_kernel(const t_nblist*            nlist,
     {
         GMX_RELEASE_ASSERT(false, "Unsupported soft-core r-power");
     }
+    /* The SIMD kernel is used when SIMD kernels are enabled and available for
+     * the soft-core treatment, otherwise we fall back to the scalar kernel.
+     */
+    const bool     useSimd    = fr->use_simd_kernels;
     KernelFunction kernelFunc = dispatchKernel(scLambdasOrAlphasDiffer, vdwInteractionTypeIsEwald,
-                                               elecInteractionTypeIsEwald, vdwModifierIsPotSwitch, fr);
+                                               elecInteractionTypeIsEwald, vdwModifierIsPotSwitch,
+                                               useSimd, fr);
     kernelFunc(nlist, xx, ff, fr, mdatoms, kernel_data, nrnb);
 }
@@ -0,0 +1,450 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that the SIMD free-energy kernel agrees with the scalar kernel
+ *
+ * \ingroup module_gmxlib_nonbonded
+ */
+#include "gmxpre.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/gmxlib/nonbonded/nb_free_energy.h"
+#include "gromacs/gmxlib/nonbonded/nb_kernel.h"
+#include "gromacs/gmxlib/nonbonded/nonbonded.h"
+#include "gromacs/math/functions.h"
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/nblist.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/tables/forcetable.h"
+#include "gromacs/utility/arrayref.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+#if GMX_SIMD_HAVE_REAL
+
+//! The VdW setups tested
+enum class VdwSetup
+{
+    PotentialShift,
+    PotentialSwitch,
+    LJEwald
+};
+
+//! The soft-core setups tested
+enum class SoftCoreSetup
+{
+    None,
+    RPower6,
+    RPower48
+};
+
+//! Test parameters: electrostatics type, VdW setup, soft-core setup, whether lambdas differ
+typedef std::tuple<int, VdwSetup, SoftCoreSetup, bool> FepKernelTestParameters;
+
+//! Output of a free-energy kernel call
+struct FepKernelOutput
+{
+    //! Forces
+    std::vector<RVec> force;
+    //! Shift forces
+    std::vector<RVec> shiftForce;
+    //! Coulomb energy
+    real vCoulomb = 0;
+    //! VdW energy
+    real vVdw = 0;
+    //! dV/dlambda
+    real dvdl[efptNR] = { 0 };
+};
+
+/*! \brief Sets up a small perturbed system and runs the scalar and SIMD kernels on it
+ *
+ * Atoms are put on a jittered lattice, so we have pairs at short distance,
+ * pairs between the switch and cut-off distances and pairs beyond the cut-off.
+ * Half of the atoms are perturbed, including to a state without LJ
+ * parameters, so soft-core is active for part of the pairs.
+ */
+class FepKernelTest : public ::testing::TestWithParam<FepKernelTestParameters>
+{
+public:
+    FepKernelTest()
+    {
+        const int  latticeSize = 5;
+        const real spacing     = 0.3;
+        const int  numAtoms    = latticeSize * latticeSize * latticeSize;
+
+        x_.resizeWithPadding(numAtoms);
+        chargeA_.resize(numAtoms);
+        chargeB_.resize(numAtoms);
+        typeA_.resize(numAtoms);
+        typeB_.resize(numAtoms);
+        for (int a = 0; a < numAtoms; a++)
+        {
+            const int ix = a % latticeSize;
+            const int iy = (a / latticeSize) % latticeSize;
+            const int iz = a / (latticeSize * latticeSize);
+            // Deterministic jitter of up to 0.06 nm
+            x_[a][XX] = ix * spacing + 0.06 * std::sin(1.3 * a);
+            x_[a][YY] = iy * spacing + 0.06 * std::cos(2.1 * a);
+            x_[a][ZZ] = iz * spacing + 0.06 * std::sin(0.7 * a + 1);
+
+            chargeA_[a] = ((a % 3) - 1) * 0.4;
+            typeA_[a]   = a % (c_numTypes - 1);
+            if (a < c_numPerturbedAtoms)
+            {
+                // Alternate between decoupling and mutating
+                chargeB_[a] = (a % 2 == 0 ? 0 : -chargeA_[a]);
+                typeB_[a]   = (a % 2 == 0 ? c_numTypes - 1 : (typeA_[a] + 1) % (c_numTypes - 1));
+            }
+            else
+            {
+                chargeB_[a] = chargeA_[a];
+                typeB_[a]   = typeA_[a];
+            }
+        }
+
+        // The last type has no LJ interactions
+        const real sigma[c_numTypes]   = { 0.30, 0.25, 0.35, 0 };
+        const real epsilon[c_numTypes] = { 0.6, 0.3, 0.9, 0 };
+        nbfp_.resize(2 * c_numTypes * c_numTypes);
+        c6grid_.resize(2 * c_numTypes * c_numTypes);
+        for (int i = 0; i < c_numTypes; i++)
+        {
+            for (int j = 0; j < c_numTypes; j++)
+            {
+                const real sigmaIJ   = 0.5 * (sigma[i] + sigma[j]);
+                const real epsilonIJ = std::sqrt(epsilon[i] * epsilon[j]);
+                const real c6        = 4 * epsilonIJ * power6(sigmaIJ);
+                const real c12       = 4 * epsilonIJ * power12(sigmaIJ);
+                // nbfp stores c6 and c12 scaled with 6 and 12
+                nbfp_[2 * (i * c_numTypes + j)]     = 6 * c6;
+                nbfp_[2 * (i * c_numTypes + j) + 1] = 12 * c12;
+                // Geometric combination on the grid, also scaled with 6
+                c6grid_[2 * (i * c_numTypes + j)] =
+                        6 * 4 * std::sqrt(epsilon[i] * power6(sigma[i]) * epsilon[j] * power6(sigma[j]));
+                c6grid_[2 * (i * c_numTypes + j) + 1] = 0;
+            }
+        }
+
+        /* Set up a pair list with all pairs between perturbed atoms and
+         * all other atoms. We include the self-pair and exclude neighbours
+         * along x, as the nbnxm grid search does for excluded pairs.
+         */
+        for (int i = 0; i < c_numPerturbedAtoms; i++)
+        {
+            iinr_.push_back(i);
+            shift_.push_back(CENTRAL);
+            gid_.push_back(0);
+            jindex_.push_back(jjnr_.size());
+            for (int j = i; j < numAtoms; j++)
+            {
+                jjnr_.push_back(j);
+                exclFep_.push_back((j == i || j == i + 1) ? 0 : 1);
+            }
+        }
+        jindex_.push_back(jjnr_.size());
+
+        nlist_.nri      = iinr_.size();
+        nlist_.nrj      = jjnr_.size();
+        nlist_.iinr     = iinr_.data();
+        nlist_.gid      = gid_.data();
+        nlist_.shift    = shift_.data();
+        nlist_.jindex   = jindex_.data();
+        nlist_.jjnr     = jjnr_.data();
+        nlist_.excl_fep = exclFep_.data();
+
+        mdatoms_.chargeA = chargeA_.data();
+        mdatoms_.chargeB = chargeB_.data();
+        mdatoms_.typeA   = typeA_.data();
+        mdatoms_.typeB   = typeB_.data();
+
+        shiftVec_.resize(SHIFTS, { 0, 0, 0 });
+    }
+
+    //! Sets up the interaction parameters for the test parameters
+    void setupInteractions(int eeltype, VdwSetup vdwSetup, SoftCoreSetup softCoreSetup)
+    {
+        const real cutoff = 1.0;
+
+        ic_.cutoff_scheme = ecutsVERLET;
+        ic_.rcoulomb      = cutoff;
+        ic_.rvdw          = cutoff;
+        ic_.epsfac        = ONE_4PI_EPS0;
+        ic_.eeltype       = eeltype;
+        if (EEL_PME_EWALD(eeltype))
+        {
+            ic_.ewaldcoeff_q = calc_ewaldcoeff_q(cutoff, 1e-5);
+            ic_.sh_ewald     = std::erfc(ic_.ewaldcoeff_q * cutoff) / cutoff;
+        }
+        else
+        {
+            ic_.epsilon_rf = 60;
+            ic_.k_rf       = (ic_.epsilon_rf - 1) / ((2 * ic_.epsilon_rf + 1) * power3(cutoff));
+            ic_.c_rf       = 1 / cutoff + ic_.k_rf * cutoff * cutoff;
+        }
+
+        ic_.vdwtype      = evdwCUT;
+        ic_.vdw_modifier = eintmodPOTSHIFT;
+        ic_.dispersion_shift.cpot = -1.0 / power6(cutoff);
+        ic_.repulsion_shift.cpot  = -1.0 / power12(cutoff);
+        switch (vdwSetup)
+        {
+            case VdwSetup::PotentialShift: break;
+            case VdwSetup::PotentialSwitch:
+                ic_.vdw_modifier          = eintmodPOTSWITCH;
+                ic_.rvdw_switch           = 0.8;
+                ic_.dispersion_shift.cpot = 0;
+                ic_.repulsion_shift.cpot  = 0;
+                break;
+            case VdwSetup::LJEwald:
+                ic_.vdwtype       = evdwPME;
+                ic_.ewaldcoeff_lj = calc_ewaldcoeff_lj(cutoff, 1e-3);
+                {
+                    const real crc2 = square(ic_.ewaldcoeff_lj * cutoff);
+                    ic_.sh_lj_ewald = (std::exp(-crc2) * (1 + crc2 + 0.5 * crc2 * crc2) - 1)
+                                      / power6(cutoff);
+                }
+                break;
+        }
+
+        ic_.coulombEwaldTables = std::make_unique<EwaldCorrectionTables>();
+        ic_.vdwEwaldTables     = std::make_unique<EwaldCorrectionTables>();
+        init_interaction_const_tables(nullptr, &ic_);
+
+        fr_.ic           = &ic_;
+        fr_.ntype        = c_numTypes;
+        fr_.nbfp         = nbfp_.data();
+        fr_.ljpme_c6grid = c6grid_.data();
+        fr_.shift_vec    = as_rvec_array(shiftVec_.data());
+
+        fr_.sc_power      = 1;
+        fr_.sc_sigma6_def = power6(0.3);
+        fr_.sc_sigma6_min = power6(0.3);
+        switch (softCoreSetup)
+        {
+            case SoftCoreSetup::None:
+                fr_.sc_alphacoul = 0;
+                fr_.sc_alphavdw  = 0;
+                fr_.sc_r_power   = 6;
+                break;
+            case SoftCoreSetup::RPower6:
+                fr_.sc_alphacoul = 0.3;
+                fr_.sc_alphavdw  = 0.5;
+                fr_.sc_r_power   = 6;
+                break;
+            case SoftCoreSetup::RPower48:
+                fr_.sc_alphacoul = 0.3;
+                fr_.sc_alphavdw  = 0.5;
+                fr_.sc_r_power   = 48;
+                break;
+        }
+    }
+
+    //! Runs the kernel, SIMD or scalar, with the given lambdas
+    FepKernelOutput runKernel(bool useSimd, real lambdaCoulomb, real lambdaVdw)
+    {
+        fr_.use_simd_kernels = useSimd;
+
+        FepKernelOutput output;
+        output.force.resize(x_.size(), { 0, 0, 0 });
+        output.shiftForce.resize(SHIFTS, { 0, 0, 0 });
+
+        PaddedVector<RVec> force;
+        force.resizeWithPadding(x_.size());
+        std::fill(force.begin(), force.end(), RVec{ 0, 0, 0 });
+        ForceWithShiftForces forceWithShiftForces(force.arrayRefWithPadding(), true, output.shiftForce);
+
+        real lambda[efptNR] = { 0 };
+        lambda[efptCOUL]    = lambdaCoulomb;
+        lambda[efptVDW]     = lambdaVdw;
+
+        nb_kernel_data_t kernelData;
+        kernelData.flags = GMX_NONBONDED_DO_SR | GMX_NONBONDED_DO_FORCE | GMX_NONBONDED_DO_SHIFTFORCE
+                           | GMX_NONBONDED_DO_POTENTIAL;
+        kernelData.lambda         = lambda;
+        kernelData.dvdl           = output.dvdl;
+        kernelData.energygrp_elec = &output.vCoulomb;
+        kernelData.energygrp_vdw  = &output.vVdw;
+
+        t_nrnb nrnb = {};
+
+        gmx_nb_free_energy_kernel(&nlist_, as_rvec_array(x_.data()), &forceWithShiftForces, &fr_,
+                                  &mdatoms_, &kernelData, &nrnb);
+
+        for (index a = 0; a < x_.size(); a++)
+        {
+            output.force[a] = force[a];
+        }
+
+        return output;
+    }
+
+    //! Number of atom types, the last one has no LJ interactions
+    static constexpr int c_numTypes = 4;
+    //! Number of perturbed atoms, these are the first atoms
+    static constexpr int c_numPerturbedAtoms = 40;
+
+    //! Coordinates
+    PaddedVector<RVec> x_;
+    //! A-state charges
+    std::vector<real> chargeA_;
+    //! B-state charges
+    std::vector<real> chargeB_;
+    //! A-state types
+    std::vector<int> typeA_;
+    //! B-state types
+    std::vector<int> typeB_;
+    //! LJ parameters
+    std::vector<real> nbfp_;
+    //! LJ-PME grid parameters
+    std::vector<real> c6grid_;
+    //! Shift vectors
+    std::vector<RVec> shiftVec_;
+    //! Pair list storage
+    std::vector<int> iinr_, gid_, shift_, jindex_, jjnr_;
+    //! Pair list exclusion flags
+    std::vector<char> exclFep_;
+    //! The pair list
+    t_nblist nlist_ = {};
+    //! Atom data
+    t_mdatoms mdatoms_ = {};
+    //! Interaction constants
+    interaction_const_t ic_;
+    //! Force record
+    t_forcerec fr_;
+};
+
+TEST_P(FepKernelTest, SimdMatchesScalar)
+{
+    int           eeltype;
+    VdwSetup      vdwSetup;
+    SoftCoreSetup softCoreSetup;
+    bool          lambdasDiffer;
+    std::tie(eeltype, vdwSetup, softCoreSetup, lambdasDiffer) = GetParam();
+
+    setupInteractions(eeltype, vdwSetup, softCoreSetup);
+
+    const real lambdaCoulomb = (lambdasDiffer ? 0.3 : 0.4);
+    const real lambdaVdw     = 0.4;
+
+    const FepKernelOutput reference = runKernel(false, lambdaCoulomb, lambdaVdw);
+    const FepKernelOutput test      = runKernel(true, lambdaCoulomb, lambdaVdw);
+
+    real maxForce = 0;
+    for (const RVec& f : reference.force)
+    {
+        maxForce = std::max(maxForce, norm(f));
+    }
+
+    /* The SIMD math functions, such as cbrt and invsqrt, and the summation
+     * order differ from the scalar kernel, so we allow small deviations.
+     */
+    const FloatingPointTolerance forceTolerance =
+            relativeToleranceAsPrecisionDependentFloatingPoint(maxForce, 2e-5, 1e-10);
+    for (size_t a = 0; a < reference.force.size(); a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.force[a][d], test.force[a][d], forceTolerance)
+                    << "for atom " << a << " dim " << d;
+        }
+    }
+    for (int d = 0; d < DIM; d++)
+    {
+        EXPECT_REAL_EQ_TOL(reference.shiftForce[CENTRAL][d], test.shiftForce[CENTRAL][d], forceTolerance);
+    }
+
+    const real energyMagnitude =
+            std::max(std::abs(reference.vCoulomb), std::max(std::abs(reference.vVdw), real(1)));
+    const FloatingPointTolerance energyTolerance =
+            relativeToleranceAsPrecisionDependentFloatingPoint(energyMagnitude, 2e-5, 1e-10);
+    EXPECT_REAL_EQ_TOL(reference.vCoulomb, test.vCoulomb, energyTolerance);
+    EXPECT_REAL_EQ_TOL(reference.vVdw, test.vVdw, energyTolerance);
+    EXPECT_REAL_EQ_TOL(reference.dvdl[efptCOUL], test.dvdl[efptCOUL], energyTolerance);
+    EXPECT_REAL_EQ_TOL(reference.dvdl[efptVDW], test.dvdl[efptVDW], energyTolerance);
+}
+
+INSTANTIATE_TEST_CASE_P(ReactionField,
+                        FepKernelTest,
+                        ::testing::Combine(::testing::Values(eelRF),
+                                           ::testing::Values(VdwSetup::PotentialShift,
+                                                             VdwSetup::PotentialSwitch),
+                                           ::testing::Values(SoftCoreSetup::None,
+                                                             SoftCoreSetup::RPower6,
+                                                             SoftCoreSetup::RPower48),
+                                           ::testing::Bool()));
+
+INSTANTIATE_TEST_CASE_P(Ewald,
+                        FepKernelTest,
+                        ::testing::Combine(::testing::Values(eelPME),
+                                           ::testing::Values(VdwSetup::PotentialShift,
+                                                             VdwSetup::PotentialSwitch,
+                                                             VdwSetup::LJEwald),
+                                           ::testing::Values(SoftCoreSetup::None,
+                                                             SoftCoreSetup::RPower6,
+                                                             SoftCoreSetup::RPower48),
+                                           ::testing::Bool()));
+
+#endif // GMX_SIMD_HAVE_REAL
+
+} // namespace
+} // namespace test
+} // namespace gmx
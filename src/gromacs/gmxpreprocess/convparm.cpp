@@ -43,7 +43,10 @@
 #include <cmath>
 #include <cstring>
 
+#include <array>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "gromacs/gmxpreprocess/gpp_atomtype.h"
 #include "gromacs/gmxpreprocess/grompp_impl.h"
@@ -56,7 +59,9 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/topology.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 static int round_check(real r, int limit, int ftype, const char* name)
@@ -440,56 +445,132 @@ static int assign_param(t_functype ftype, t_iparams* newparam, gmx::ArrayRef<con
     return 0;
 }
 
-static int enter_params(gmx_ffparams_t*           ffparams,
-                        t_functype                ftype,
-                        gmx::ArrayRef<const real> forceparams,
-                        int                       comb,
-                        real                      reppow,
-                        int                       start,
-                        bool                      bAppend)
+/*! \brief Hash of the bytes of a parameter set
+ *
+ * assign_param() zeroes the whole parameter buffer, so parameter sets
+ * that compare equal bytewise also hash to the same value.
+ */
+struct IParamsHash
 {
-    t_iparams newparam;
-    int       type;
-    int       rc;
+    //! Returns the FNV-1a hash of the bytes of \p iparams
+    size_t operator()(const t_iparams& iparams) const
+    {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(&iparams);
+        size_t      hash  = 14695981039346656037ULL;
+        for (size_t i = 0; i < sizeof(t_iparams); i++)
+        {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+        return hash;
+    }
+};
 
-    if ((rc = assign_param(ftype, &newparam, forceparams, comb, reppow)) < 0)
+//! Bytewise equality of parameter sets, as used for merging identical types
+struct IParamsEqual
+{
+    //! Returns whether \p a and \p b are bytewise identical
+    bool operator()(const t_iparams& a, const t_iparams& b) const
     {
-        /* -1 means this interaction is all-zero and should not be added */
-        return rc;
+        return memcmp(&a, &b, sizeof(t_iparams)) == 0;
+    }
+};
+
+/*! \brief Parameter sets and interactions of one function type of one molecule type
+ *
+ * The type indices in \p ilist refer to \p iparams. They are shifted
+ * when the parameter sets are appended to the force-field parameters.
+ */
+struct ConvertedInteractions
+{
+    //! The distinct parameter sets, in order of first occurrence
+    std::vector<t_iparams> iparams;
+    //! The interactions with local type indices
+    InteractionList ilist;
+};
+
+static void append_interaction(InteractionList* ilist, int type, gmx::ArrayRef<const int> a)
+{
+    ilist->iatoms.push_back(type);
+    for (const auto& atom : a)
+    {
+        ilist->iatoms.push_back(atom);
     }
+}
+
+/*! \brief Converts the parameters of \p p to parameter sets of type \p ftype
+ *
+ * Identical parameter sets are merged, unless \p bAppend is set.
+ * Only touches \p converted, so different molecule types can be
+ * converted concurrently.
+ */
+static void convert_function(const InteractionsOfType* p,
+                             t_functype                ftype,
+                             int                       comb,
+                             real                      reppow,
+                             bool                      bNB,
+                             bool                      bAppend,
+                             ConvertedInteractions*    converted)
+{
+    std::unordered_map<t_iparams, int, IParamsHash, IParamsEqual> typeOfParams;
 
-    if (!bAppend)
+    for (const auto& parm : p->interactionTypes)
     {
-        for (type = start; (type < ffparams->numTypes()); type++)
+        t_iparams newparam;
+        /* -1 is used as a signal that this interaction is all-zero and should not be added. */
+        if (assign_param(ftype, &newparam, parm.forceParam(), comb, reppow) < 0)
         {
-            if (ffparams->functype[type] == ftype)
+            continue;
+        }
+
+        int type = gmx::ssize(converted->iparams);
+        if (bAppend)
+        {
+            converted->iparams.push_back(newparam);
+        }
+        else
+        {
+            const auto found = typeOfParams.emplace(newparam, type);
+            if (found.second)
             {
-                if (memcmp(&newparam, &ffparams->iparams[type], static_cast<size_t>(sizeof(newparam))) == 0)
-                {
-                    return type;
-                }
+                converted->iparams.push_back(newparam);
             }
+            type = found.first->second;
+        }
+        if (!bNB)
+        {
+            GMX_RELEASE_ASSERT(parm.atoms().ssize() == NRAL(ftype),
+                               "Need to have correct number of atoms for the parameter");
+            append_interaction(&converted->ilist, type, parm.atoms());
         }
     }
-    else
-    {
-        type = ffparams->numTypes();
-    }
+}
+
+/*! \brief Appends converted parameter sets to \p ffparams and the interactions to \p il
+ *
+ * \p il can be nullptr for non-bonded parameters.
+ */
+static void enter_converted(ConvertedInteractions* converted,
+                            t_functype             ftype,
+                            gmx_ffparams_t*        ffparams,
+                            InteractionList*       il)
+{
+    const int start = ffparams->numTypes();
 
-    ffparams->iparams.push_back(newparam);
-    ffparams->functype.push_back(ftype);
+    ffparams->iparams.insert(ffparams->iparams.end(), converted->iparams.begin(),
+                             converted->iparams.end());
+    ffparams->functype.resize(ffparams->iparams.size(), ftype);
 
     GMX_ASSERT(ffparams->iparams.size() == ffparams->functype.size(), "sizes should match");
 
-    return type;
-}
-
-static void append_interaction(InteractionList* ilist, int type, gmx::ArrayRef<const int> a)
-{
-    ilist->iatoms.push_back(type);
-    for (const auto& atom : a)
+    if (il != nullptr)
     {
-        ilist->iatoms.push_back(atom);
+        const int stride = 1 + NRAL(ftype);
+        for (size_t i = 0; i < converted->ilist.iatoms.size(); i += stride)
+        {
+            converted->ilist.iatoms[i] += start;
+        }
+        il->iatoms.insert(il->iatoms.end(), converted->ilist.iatoms.begin(),
+                          converted->ilist.iatoms.end());
     }
 }
 
@@ -502,20 +583,19 @@ static void enter_function(const InteractionsOfType* p,
                            bool                      bNB,
                            bool                      bAppend)
 {
-    int start = ffparams->numTypes();
+    ConvertedInteractions converted;
+    convert_function(p, ftype, comb, reppow, bNB, bAppend, &converted);
+    GMX_RELEASE_ASSERT(bNB || il, "Need valid interaction list");
+    enter_converted(&converted, ftype, ffparams, il);
+}
 
-    for (auto& parm : p->interactionTypes)
-    {
-        int type = enter_params(ffparams, ftype, parm.forceParam(), comb, reppow, start, bAppend);
-        /* Type==-1 is used as a signal that this interaction is all-zero and should not be added. */
-        if (!bNB && type >= 0)
-        {
-            GMX_RELEASE_ASSERT(il, "Need valid interaction list");
-            GMX_RELEASE_ASSERT(parm.atoms().ssize() == NRAL(ftype),
-                               "Need to have correct number of atoms for the parameter");
-            append_interaction(il, type, parm.atoms());
-        }
-    }
+//! Returns whether interactions of type \p ftype are stored in the molecule type interaction lists
+static bool isMoleculeTypeInteraction(int ftype)
+{
+    const unsigned long flags = interaction_function[ftype].flags;
+
+    return (ftype != F_LJ) && (ftype != F_BHAM)
+           && ((flags & IF_BOND) || (flags & IF_VSITE) || (flags & IF_CONSTRAINT));
 }
 
 void convertInteractionsOfType(int                                      atnr,
@@ -542,21 +622,43 @@ void convertInteractionsOfType(int                                      atnr,
     enter_function(&(nbtypes[F_BHAM]), static_cast<t_functype>(F_BHAM), comb, reppow, ffp, nullptr,
                    TRUE, TRUE);
 
-    for (size_t mt = 0; mt < mtop->moltype.size(); mt++)
+    /* Parameter sets are only merged within one function type of one
+     * molecule type, so the molecule types can be converted independently.
+     * The results are entered afterwards in the serial order, which gives
+     * the same parameter type numbering as a serial conversion.
+     */
+    const int numMolTypes = gmx::ssize(mtop->moltype);
+    std::vector<std::array<ConvertedInteractions, F_NRE>> converted(numMolTypes);
+#pragma omp parallel for num_threads(gmx_omp_get_max_threads()) schedule(dynamic)
+    for (int mt = 0; mt < numMolTypes; mt++)
+    {
+        try
+        {
+            gmx::ArrayRef<const InteractionsOfType> interactions = mi[mt].interactions;
+
+            for (int ftype = 0; ftype < F_NRE; ftype++)
+            {
+                if (isMoleculeTypeInteraction(ftype))
+                {
+                    convert_function(&(interactions[ftype]), static_cast<t_functype>(ftype), comb,
+                                     reppow, FALSE, (ftype == F_POSRES || ftype == F_FBPOSRES),
+                                     &converted[mt][ftype]);
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    for (int mt = 0; mt < numMolTypes; mt++)
     {
         molt = &mtop->moltype[mt];
         for (i = 0; (i < F_NRE); i++)
         {
             molt->ilist[i].iatoms.clear();
 
-            gmx::ArrayRef<const InteractionsOfType> interactions = mi[mt].interactions;
-
-            flags = interaction_function[i].flags;
-            if ((i != F_LJ) && (i != F_BHAM)
-                && ((flags & IF_BOND) || (flags & IF_VSITE) || (flags & IF_CONSTRAINT)))
+            if (isMoleculeTypeInteraction(i))
             {
-                enter_function(&(interactions[i]), static_cast<t_functype>(i), comb, reppow, ffp,
-                               &molt->ilist[i], FALSE, (i == F_POSRES || i == F_FBPOSRES));
+                enter_converted(&converted[mt][i], static_cast<t_functype>(i), ffp, &molt->ilist[i]);
             }
         }
     }
@@ -43,6 +43,8 @@
 #include <cstring>
 
 #include <algorithm>
+#include <string>
+#include <unordered_map>
 
 #include "gromacs/gmxpreprocess/grompp_impl.h"
 #include "gromacs/gmxpreprocess/notset.h"
@@ -83,8 +85,19 @@ class PreprocessingAtomTypes::Impl
 public:
     //! The number for currently loaded entries.
     size_t size() const { return types.size(); }
+    //! Rebuilds \c nameToType from \c types.
+    void rebuildNameIndex()
+    {
+        nameToType.clear();
+        for (size_t i = 0; i < types.size(); i++)
+        {
+            nameToType.emplace(*types[i].name_, i);
+        }
+    }
     //! The actual atom type data.
     std::vector<AtomTypeData> types;
+    //! Index of the first atom type with each name.
+    std::unordered_map<std::string, int> nameToType;
 };
 
 bool PreprocessingAtomTypes::isSet(int nt) const
@@ -95,15 +108,14 @@ bool PreprocessingAtomTypes::isSet(int nt) const
 int PreprocessingAtomTypes::atomTypeFromName(const std::string& str) const
 {
     /* Atom types are always case sensitive */
-    auto found = std::find_if(impl_->types.begin(), impl_->types.end(),
-                              [&str](const auto& type) { return str == *type.name_; });
-    if (found == impl_->types.end())
+    auto found = impl_->nameToType.find(str);
+    if (found == impl_->nameToType.end())
     {
         return NOTSET;
     }
     else
     {
-        return std::distance(impl_->types.begin(), found);
+        return found->second;
     }
 }
 
@@ -182,6 +194,7 @@ int PreprocessingAtomTypes::addType(t_symtab*                tab,
     if (position == NOTSET)
     {
         impl_->types.emplace_back(a, put_symtab(tab, name.c_str()), nb, bondAtomType, atomNumber);
+        impl_->nameToType.emplace(name, impl_->types.size() - 1);
         return atomTypeFromName(name);
     }
     else
@@ -203,11 +216,16 @@ int PreprocessingAtomTypes::setType(int                      nt,
         return NOTSET;
     }
 
+    const bool nameChanged         = (name != *impl_->types[nt].name_);
     impl_->types[nt].atom_         = a;
     impl_->types[nt].name_         = put_symtab(tab, name.c_str());
     impl_->types[nt].nb_           = nb;
     impl_->types[nt].bondAtomType_ = bondAtomType;
     impl_->types[nt].atomNumber_   = atomNumber;
+    if (nameChanged)
+    {
+        impl_->rebuildNameIndex();
+    }
 
     return nt;
 }
@@ -366,6 +384,7 @@ void PreprocessingAtomTypes::renumberTypes(gmx::ArrayRef<InteractionsOfType> pli
 
     impl_->types                  = new_types;
     plist[ftype].interactionTypes = nbsnew;
+    impl_->rebuildNameIndex();
 }
 
 void PreprocessingAtomTypes::copyTot_atomtypes(t_atomtypes* atomtypes) const
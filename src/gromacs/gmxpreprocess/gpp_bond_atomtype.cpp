@@ -40,7 +40,8 @@
 
 #include <cstring>
 
-#include <algorithm>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "gromacs/gmxpreprocess/notset.h"
@@ -53,21 +54,21 @@ class PreprocessingBondAtomType::Impl
 public:
     //! The atom type names.
     std::vector<char**> typeNames;
+    //! Index of each atom type name in \c typeNames.
+    std::unordered_map<std::string, int> nameToType;
 };
 
 int PreprocessingBondAtomType::bondAtomTypeFromName(const std::string& str) const
 {
     /* Atom types are always case sensitive */
-    auto found =
-            std::find_if(impl_->typeNames.begin(), impl_->typeNames.end(),
-                         [&str](const auto& type) { return str == const_cast<const char*>(*type); });
-    if (found == impl_->typeNames.end())
+    auto found = impl_->nameToType.find(str);
+    if (found == impl_->nameToType.end())
     {
         return NOTSET;
     }
     else
     {
-        return std::distance(impl_->typeNames.begin(), found);
+        return found->second;
     }
 }
 
@@ -86,6 +87,7 @@ int PreprocessingBondAtomType::addBondAtomType(t_symtab* tab, const std::string&
     if (position == NOTSET)
     {
         impl_->typeNames.emplace_back(put_symtab(tab, name.c_str()));
+        impl_->nameToType.emplace(name, impl_->typeNames.size() - 1);
         return bondAtomTypeFromName(name);
     }
     else
@@ -45,7 +45,9 @@
 #include <cstring>
 
 #include <algorithm>
+#include <functional>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include <sys/types.h>
@@ -91,6 +93,7 @@
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/pulling/pull.h"
 #include "gromacs/random/seed.h"
+#include "gromacs/timing/walltime_accounting.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/mtop_util.h"
 #include "gromacs/topology/symtab.h"
@@ -232,6 +235,41 @@ void InteractionOfType::setForceParameter(int pos, real value)
     forceParam_[pos] = value;
 }
 
+size_t AtomIndexListHash::operator()(const std::vector<int>& atoms) const
+{
+    size_t hash = atoms.size();
+    for (const int atom : atoms)
+    {
+        // Combine the hashes as done in boost::hash_combine
+        hash ^= std::hash<int>()(atom) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    }
+    return hash;
+}
+
+int InteractionsOfType::findFirstWithAtoms(const std::vector<int>& atoms) const
+{
+    /* The interaction types are only ever appended to during preprocessing,
+     * but when the list has been replaced, we start from scratch.
+     */
+    if (numIndexedTypes_ > interactionTypes.size())
+    {
+        firstWithAtoms_.clear();
+        numIndexedTypes_ = 0;
+    }
+    for (; numIndexedTypes_ < interactionTypes.size(); numIndexedTypes_++)
+    {
+        gmx::ArrayRef<const int> typeAtoms = interactionTypes[numIndexedTypes_].atoms();
+        firstWithAtoms_.emplace(std::vector<int>(typeAtoms.begin(), typeAtoms.end()),
+                                numIndexedTypes_);
+    }
+    const auto found = firstWithAtoms_.find(atoms);
+    if (found == firstWithAtoms_.end())
+    {
+        return -1;
+    }
+    return found->second;
+}
+
 void MoleculeInformation::initMolInfo()
 {
     init_block(&mols);
@@ -1626,6 +1664,40 @@ static void set_verlet_buffer(const gmx_mtop_t* mtop, t_inputrec* ir, real buffe
     }
 }
 
+//! Records the wall-clock time spent in consecutive processing phases of grompp
+class GromppPhaseTimes
+{
+public:
+    GromppPhaseTimes() : lastTime_(gmx_gettime()) {}
+
+    //! Attributes the time since the previous phase ended to \p phase
+    void endPhase(const char* phase)
+    {
+        const double now = gmx_gettime();
+        phases_.emplace_back(phase, now - lastTime_);
+        lastTime_ = now;
+    }
+
+    //! Prints the time of each phase and the total to \p fp
+    void print(FILE* fp) const
+    {
+        double total = 0;
+        fprintf(fp, "\nWall time of the grompp processing phases:\n");
+        for (const auto& phase : phases_)
+        {
+            fprintf(fp, "  %-28s %9.3f s\n", phase.first, phase.second);
+            total += phase.second;
+        }
+        fprintf(fp, "  %-28s %9.3f s\n", "total", total);
+    }
+
+private:
+    //! Name and wall time in seconds of the finished phases
+    std::vector<std::pair<const char*, double>> phases_;
+    //! The time the last phase ended
+    double lastTime_;
+};
+
 int gmx_grompp(int argc, char* argv[])
 {
     const char* desc[] = {
@@ -1794,6 +1866,8 @@ int gmx_grompp(int argc, char* argv[])
         return 0;
     }
 
+    GromppPhaseTimes phaseTimes;
+
     /* Initiate some variables */
     gmx::MDModules mdModules;
     t_inputrec     irInstance;
@@ -1818,6 +1892,7 @@ int gmx_grompp(int argc, char* argv[])
         fprintf(stderr, "checking input for internal consistency...\n");
     }
     check_ir(mdparin, mdModules.notifier(), ir, opts, wi);
+    phaseTimes.endPhase("mdp options");
 
     if (ir->ld_seed == -1)
     {
@@ -1860,6 +1935,7 @@ int gmx_grompp(int argc, char* argv[])
     new_status(fn, opt2fn_null("-pp", NFILE, fnm), opt2fn("-c", NFILE, fnm), opts, ir, bZero,
                bGenVel, bVerbose, &state, &atypes, &sys, &mi, &intermolecular_interactions,
                interactions, &comb, &reppow, &fudgeQQ, opts->bMorse, wi);
+    phaseTimes.endPhase("topology and coordinates");
 
     if (debug)
     {
@@ -1881,6 +1957,7 @@ int gmx_grompp(int argc, char* argv[])
             clean_vsite_bondeds(mi[mt].interactions, sys.moltype[mt].atoms.nr, bRmVSBds);
         }
     }
+    phaseTimes.endPhase("virtual sites");
 
     if ((count_constraints(&sys, mi, wi) != 0) && (ir->eConstrAlg == econtSHAKE))
     {
@@ -1984,6 +2061,7 @@ int gmx_grompp(int argc, char* argv[])
         }
         gen_posres(&sys, mi, fn, fnB, ir->refcoord_scaling, ir->ePBC, ir->posres_com, ir->posres_comB, wi);
     }
+    phaseTimes.endPhase("position restraints");
 
     /* If we are using CMAP, setup the pre-interpolation grid */
     if (interactions[F_CMAP].ncmap() > 0)
@@ -2007,6 +2085,7 @@ int gmx_grompp(int argc, char* argv[])
 
     /* PELA: Copy the atomtype data to the topology atomtype list */
     atypes.copyTot_atomtypes(&(sys.atomtypes));
+    phaseTimes.endPhase("atom types");
 
     if (debug)
     {
@@ -2021,6 +2100,7 @@ int gmx_grompp(int argc, char* argv[])
     const int ntype = atypes.size();
     convertInteractionsOfType(ntype, interactions, mi, intermolecular_interactions.get(), comb,
                               reppow, fudgeQQ, &sys);
+    phaseTimes.endPhase("parameter conversion");
 
     if (debug)
     {
@@ -2068,12 +2148,14 @@ int gmx_grompp(int argc, char* argv[])
     }
 
     check_warning_error(wi, FARGS);
+    phaseTimes.endPhase("topology checks");
 
     if (bVerbose)
     {
         fprintf(stderr, "initialising group options...\n");
     }
     do_index(mdparin, ftp2fn_null(efNDX, NFILE, fnm), &sys, bVerbose, mdModules.notifier(), ir, wi);
+    phaseTimes.endPhase("index groups");
 
     if (ir->cutoff_scheme == ecutsVERLET && ir->verletbuf_tol > 0)
     {
@@ -2157,6 +2239,7 @@ int gmx_grompp(int argc, char* argv[])
             }
         }
     }
+    phaseTimes.endPhase("Verlet buffer");
 
     /* Init the temperature coupling state */
     init_gtc_state(&state, ir->opts.ngtc, 0, ir->opts.nhchainlength); /* need to add nnhpres here? */
@@ -2345,6 +2428,8 @@ int gmx_grompp(int argc, char* argv[])
                 std::make_unique<gmx::KeyValueTreeObject>(internalParameterBuilder.build());
     }
 
+    phaseTimes.endPhase("other setup");
+
     if (bVerbose)
     {
         fprintf(stderr, "writing run input file...\n");
@@ -2352,10 +2437,16 @@ int gmx_grompp(int argc, char* argv[])
 
     done_warning(wi, FARGS);
     write_tpx_state(ftp2fn(efTPR, NFILE, fnm), ir, &state, &sys);
+    phaseTimes.endPhase("writing run input");
 
     /* Output IMD group, if bIMD is TRUE */
     gmx::write_IMDgroup_to_file(ir->bIMD, ir, &state, &sys, NFILE, fnm);
 
+    if (bVerbose)
+    {
+        phaseTimes.print(stderr);
+    }
+
     sfree(opts->define);
     sfree(opts->include);
     sfree(opts);
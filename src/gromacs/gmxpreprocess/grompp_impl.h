@@ -39,6 +39,8 @@
 #define GMX_GMXPREPROCESS_GROMPP_IMPL_H
 
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "gromacs/gmxpreprocess/notset.h"
 #include "gromacs/topology/atoms.h"
@@ -121,6 +123,15 @@ private:
     std::string interactionTypeName_;
 };
 
+/*! \libinternal \brief
+ * Hash function for a list of atom or atom type indices.
+ */
+struct AtomIndexListHash
+{
+    //! Returns a hash of the indices in \p atoms.
+    size_t operator()(const std::vector<int>& atoms) const;
+};
+
 /*! \libinternal \brief
  * A set of interactions of a given type
  * (found in the enumeration in ifunc.h), complete with
@@ -149,6 +160,22 @@ struct InteractionsOfType
     int ncmap() const { return cmap.size(); }
     //! Number of elements in cmapAtomTypes.
     int nct() const { return cmapAtomTypes.size(); }
+
+    /*! \brief
+     * Returns the index of the first interaction type with exactly \p atoms, -1 if none.
+     *
+     * Uses a hash table over the atoms of the interaction types, which
+     * is extended with the types that were added since the previous
+     * call. This makes the total cost of looking up all interactions
+     * of a system linear in the number of interactions and types.
+     */
+    int findFirstWithAtoms(const std::vector<int>& atoms) const;
+
+private:
+    //! Index of the first interaction type for each list of atoms, see findFirstWithAtoms().
+    mutable std::unordered_map<std::vector<int>, int, AtomIndexListHash> firstWithAtoms_;
+    //! Number of interaction types that have been entered in \c firstWithAtoms_.
+    mutable size_t numIndexedTypes_ = 0;
 };
 
 struct t_excls
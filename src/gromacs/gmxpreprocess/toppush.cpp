@@ -45,6 +45,7 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
 #include "gromacs/fileio/warninp.h"
 #include "gromacs/gmxpreprocess/gpp_atomtype.h"
@@ -1483,39 +1484,6 @@ void push_molt(t_symtab* symtab, std::vector<MoleculeInformation>* mol, char* li
     mol->back().excl_set = false;
 }
 
-static bool findIfAllNBAtomsMatch(gmx::ArrayRef<const int> atomsFromParameterArray,
-                                  gmx::ArrayRef<const int> atomsFromCurrentParameter,
-                                  const t_atoms*           at,
-                                  bool                     bB)
-{
-    if (atomsFromParameterArray.size() != atomsFromCurrentParameter.size())
-    {
-        return false;
-    }
-    else if (bB)
-    {
-        for (gmx::index i = 0; i < atomsFromCurrentParameter.ssize(); i++)
-        {
-            if (at->atom[atomsFromCurrentParameter[i]].typeB != atomsFromParameterArray[i])
-            {
-                return false;
-            }
-        }
-        return true;
-    }
-    else
-    {
-        for (gmx::index i = 0; i < atomsFromCurrentParameter.ssize(); i++)
-        {
-            if (at->atom[atomsFromCurrentParameter[i]].type != atomsFromParameterArray[i])
-            {
-                return false;
-            }
-        }
-        return true;
-    }
-}
-
 static bool default_nb_params(int                               ftype,
                               gmx::ArrayRef<InteractionsOfType> bt,
                               t_atoms*                          at,
@@ -1568,19 +1536,19 @@ static bool default_nb_params(int                               ftype,
         }
     }
 
-    gmx::ArrayRef<const int> paramAtoms = p->atoms();
     /* Search explicitly if we didnt find it */
     if (!bFound)
     {
-        auto foundParameter =
-                std::find_if(bt[ftype].interactionTypes.begin(), bt[ftype].interactionTypes.end(),
-                             [&paramAtoms, &at, &bB](const auto& param) {
-                                 return findIfAllNBAtomsMatch(param.atoms(), paramAtoms, at, bB);
-                             });
-        if (foundParameter != bt[ftype].interactionTypes.end())
+        std::vector<int> atomTypes;
+        for (const int atom : p->atoms())
+        {
+            atomTypes.push_back(bB ? at->atom[atom].typeB : at->atom[atom].type);
+        }
+        const int found = bt[ftype].findFirstWithAtoms(atomTypes);
+        if (found >= 0)
         {
             bFound = true;
-            pi     = &(*foundParameter);
+            pi     = &bt[ftype].interactionTypes[found];
         }
     }
 
@@ -1671,86 +1639,6 @@ static bool default_cmap_params(gmx::ArrayRef<InteractionsOfType> bondtype,
     return bFound;
 }
 
-/* Returns the number of exact atom type matches, i.e. non wild-card matches,
- * returns -1 when there are no matches at all.
- */
-static int natom_match(const InteractionOfType&      pi,
-                       int                           type_i,
-                       int                           type_j,
-                       int                           type_k,
-                       int                           type_l,
-                       const PreprocessingAtomTypes* atypes)
-{
-    if ((pi.ai() == -1 || atypes->bondAtomTypeFromAtomType(type_i) == pi.ai())
-        && (pi.aj() == -1 || atypes->bondAtomTypeFromAtomType(type_j) == pi.aj())
-        && (pi.ak() == -1 || atypes->bondAtomTypeFromAtomType(type_k) == pi.ak())
-        && (pi.al() == -1 || atypes->bondAtomTypeFromAtomType(type_l) == pi.al()))
-    {
-        return (pi.ai() == -1 ? 0 : 1) + (pi.aj() == -1 ? 0 : 1) + (pi.ak() == -1 ? 0 : 1)
-               + (pi.al() == -1 ? 0 : 1);
-    }
-    else
-    {
-        return -1;
-    }
-}
-
-static int findNumberOfDihedralAtomMatches(const InteractionOfType& currentParamFromParameterArray,
-                                           const InteractionOfType& parameterToAdd,
-                                           const t_atoms*           at,
-                                           const PreprocessingAtomTypes* atypes,
-                                           bool                          bB)
-{
-    if (bB)
-    {
-        return natom_match(currentParamFromParameterArray, at->atom[parameterToAdd.ai()].typeB,
-                           at->atom[parameterToAdd.aj()].typeB, at->atom[parameterToAdd.ak()].typeB,
-                           at->atom[parameterToAdd.al()].typeB, atypes);
-    }
-    else
-    {
-        return natom_match(currentParamFromParameterArray, at->atom[parameterToAdd.ai()].type,
-                           at->atom[parameterToAdd.aj()].type, at->atom[parameterToAdd.ak()].type,
-                           at->atom[parameterToAdd.al()].type, atypes);
-    }
-}
-
-static bool findIfAllParameterAtomsMatch(gmx::ArrayRef<const int>      atomsFromParameterArray,
-                                         gmx::ArrayRef<const int>      atomsFromCurrentParameter,
-                                         const t_atoms*                at,
-                                         const PreprocessingAtomTypes* atypes,
-                                         bool                          bB)
-{
-    if (atomsFromParameterArray.size() != atomsFromCurrentParameter.size())
-    {
-        return false;
-    }
-    else if (bB)
-    {
-        for (gmx::index i = 0; i < atomsFromCurrentParameter.ssize(); i++)
-        {
-            if (atypes->bondAtomTypeFromAtomType(at->atom[atomsFromCurrentParameter[i]].typeB)
-                != atomsFromParameterArray[i])
-            {
-                return false;
-            }
-        }
-        return true;
-    }
-    else
-    {
-        for (gmx::index i = 0; i < atomsFromCurrentParameter.ssize(); i++)
-        {
-            if (atypes->bondAtomTypeFromAtomType(at->atom[atomsFromCurrentParameter[i]].type)
-                != atomsFromParameterArray[i])
-            {
-                return false;
-            }
-        }
-        return true;
-    }
-}
-
 static std::vector<InteractionOfType>::iterator defaultInteractionsOfType(int ftype,
                                                                           gmx::ArrayRef<InteractionsOfType> bt,
                                                                           t_atoms* at,
@@ -1769,29 +1657,43 @@ static std::vector<InteractionOfType>::iterator defaultInteractionsOfType(int ft
     }
 
 
+    /* The bonded atom types of the atoms in the interaction */
+    std::vector<int> bondAtomTypes;
+    for (const int atom : p.atoms())
+    {
+        bondAtomTypes.push_back(
+                atypes->bondAtomTypeFromAtomType(bB ? at->atom[atom].typeB : at->atom[atom].type));
+    }
+
     nparam_found = 0;
     if (ftype == F_PDIHS || ftype == F_RBDIHS || ftype == F_IDIHS || ftype == F_PIDIHS)
     {
-        int nmatch_max = -1;
-
         /* For dihedrals we allow wildcards. We choose the first type
          * that has the most real matches, i.e. non-wildcard matches.
+         * Instead of testing all types, we look up all combinations
+         * of the atom types with wildcards.
          */
-        auto prevPos = bt[ftype].interactionTypes.end();
-        auto pos     = bt[ftype].interactionTypes.begin();
-        while (pos != bt[ftype].interactionTypes.end() && nmatch_max < 4)
-        {
-            pos = std::find_if(bt[ftype].interactionTypes.begin(), bt[ftype].interactionTypes.end(),
-                               [&p, &at, &atypes, &bB, &nmatch_max](const auto& param) {
-                                   return (findNumberOfDihedralAtomMatches(param, p, at, atypes, bB)
-                                           > nmatch_max);
-                               });
-            if (pos != bt[ftype].interactionTypes.end())
+        const int        numAtoms   = bondAtomTypes.size();
+        int              nmatch_max = -1;
+        int              bestIndex  = -1;
+        std::vector<int> wildcardTypes(numAtoms);
+        for (int wildcardMask = 0; wildcardMask < (1 << numAtoms); wildcardMask++)
+        {
+            int nmatch = 0;
+            for (int i = 0; i < numAtoms; i++)
             {
-                prevPos    = pos;
-                nmatch_max = findNumberOfDihedralAtomMatches(*pos, p, at, atypes, bB);
+                wildcardTypes[i] = ((wildcardMask & (1 << i)) ? -1 : bondAtomTypes[i]);
+                nmatch += (wildcardTypes[i] == -1 ? 0 : 1);
+            }
+            const int index = bt[ftype].findFirstWithAtoms(wildcardTypes);
+            if (index >= 0 && (nmatch > nmatch_max || (nmatch == nmatch_max && index < bestIndex)))
+            {
+                nmatch_max = nmatch;
+                bestIndex  = index;
             }
         }
+        auto prevPos = (bestIndex >= 0 ? bt[ftype].interactionTypes.begin() + bestIndex
+                                       : bt[ftype].interactionTypes.end());
 
         if (prevPos != bt[ftype].interactionTypes.end())
         {
@@ -1827,18 +1729,15 @@ static std::vector<InteractionOfType>::iterator defaultInteractionsOfType(int ft
     }
     else /* Not a dihedral */
     {
-        gmx::ArrayRef<const int> atomParam = p.atoms();
-        auto                     found     = std::find_if(
-                bt[ftype].interactionTypes.begin(), bt[ftype].interactionTypes.end(),
-                [&atomParam, &at, &atypes, &bB](const auto& param) {
-                    return findIfAllParameterAtomsMatch(param.atoms(), atomParam, at, atypes, bB);
-                });
-        if (found != bt[ftype].interactionTypes.end())
+        const int index = bt[ftype].findFirstWithAtoms(bondAtomTypes);
+        if (index >= 0)
         {
             nparam_found = 1;
+            *nparam_def  = nparam_found;
+            return bt[ftype].interactionTypes.begin() + index;
         }
         *nparam_def = nparam_found;
-        return found;
+        return bt[ftype].interactionTypes.end();
     }
 }
 
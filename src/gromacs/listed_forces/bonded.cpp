@@ -460,19 +460,20 @@ real harmonic(real kA, real kB, real xA, real xB, real x, real lambda, real* V,
 
 
 template<BondedKernelFlavor flavor>
-real bonds(int             nbonds,
-           const t_iatom   forceatoms[],
-           const t_iparams forceparams[],
-           const rvec      x[],
-           rvec4           f[],
-           rvec            fshift[],
-           const t_pbc*    pbc,
-           const t_graph*  g,
-           real            lambda,
-           real*           dvdlambda,
-           const t_mdatoms gmx_unused* md,
-           t_fcdata gmx_unused* fcd,
-           int gmx_unused* global_atom_index)
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+bonds(int             nbonds,
+      const t_iatom   forceatoms[],
+      const t_iparams forceparams[],
+      const rvec      x[],
+      rvec4           f[],
+      rvec            fshift[],
+      const t_pbc*    pbc,
+      const t_graph*  g,
+      real            lambda,
+      real*           dvdlambda,
+      const t_mdatoms gmx_unused* md,
+      t_fcdata gmx_unused* fcd,
+      int gmx_unused* global_atom_index)
 {
     int  i, ki, ai, aj, type;
     real dr, dr2, fbond, vbond, vtot;
@@ -507,6 +508,102 @@ real bonds(int             nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As bonds, but using SIMD to calculate many bonds at once.
+ * This routines does not calculate energies and shift forces.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+bonds(int             nbonds,
+      const t_iatom   forceatoms[],
+      const t_iparams forceparams[],
+      const rvec      x[],
+      rvec4           f[],
+      rvec gmx_unused fshift[],
+      const t_pbc*    pbc,
+      const t_graph gmx_unused* g,
+      real gmx_unused lambda,
+      real gmx_unused* dvdlambda,
+      const t_mdatoms gmx_unused* md,
+      t_fcdata gmx_unused* fcd,
+      int gmx_unused* global_atom_index)
+{
+    constexpr int                            nfa1 = 3;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         coeff[2 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of bonds times nfa1, here we step GMX_SIMD_REAL_WIDTH bonds */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH bonds.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s * nfa1 < nbonds)
+            {
+                coeff[s]                       = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = forceparams[type].harmonic.rA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                       = 0;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = 0;
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+
+        /* Store the non PBC corrected distances packed and aligned */
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), aj, &xj_S, &yj_S, &zj_S);
+        SimdReal dx_S = xi_S - xj_S;
+        SimdReal dy_S = yi_S - yj_S;
+        SimdReal dz_S = zi_S - zj_S;
+
+        const SimdReal k_S  = load<SimdReal>(coeff);
+        const SimdReal r0_S = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH);
+
+        pbc_correct_dx_simd(&dx_S, &dy_S, &dz_S, pbc_simd);
+
+        const SimdReal dr2_S = norm2(dx_S, dy_S, dz_S);
+
+        /* As the plain-C code, we apply no force to atoms on top of each other */
+        const SimdReal invdr_S = maskzInvsqrt(dr2_S, setZero() < dr2_S);
+        const SimdReal dr_S    = dr2_S * invdr_S;
+
+        const SimdReal fbond_S = k_S * (r0_S - dr_S) * invdr_S;
+
+        const SimdReal fx_S = fbond_S * dx_S;
+        const SimdReal fy_S = fbond_S * dy_S;
+        const SimdReal fz_S = fbond_S * dz_S;
+
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ai, fx_S, fy_S, fz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real*>(f), aj, fx_S, fy_S, fz_S);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 template<BondedKernelFlavor flavor>
 real restraint_bonds(int             nbonds,
                      const t_iatom   forceatoms[],
@@ -1148,19 +1245,20 @@ angles(int             nbonds,
 #endif // GMX_SIMD_HAVE_REAL
 
 template<BondedKernelFlavor flavor>
-real linear_angles(int             nbonds,
-                   const t_iatom   forceatoms[],
-                   const t_iparams forceparams[],
-                   const rvec      x[],
-                   rvec4           f[],
-                   rvec            fshift[],
-                   const t_pbc*    pbc,
-                   const t_graph*  g,
-                   real            lambda,
-                   real*           dvdlambda,
-                   const t_mdatoms gmx_unused* md,
-                   t_fcdata gmx_unused* fcd,
-                   int gmx_unused* global_atom_index)
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+linear_angles(int             nbonds,
+              const t_iatom   forceatoms[],
+              const t_iparams forceparams[],
+              const rvec      x[],
+              rvec4           f[],
+              rvec            fshift[],
+              const t_pbc*    pbc,
+              const t_graph*  g,
+              real            lambda,
+              real*           dvdlambda,
+              const t_mdatoms gmx_unused* md,
+              t_fcdata gmx_unused* fcd,
+              int gmx_unused* global_atom_index)
 {
     int  i, m, ai, aj, ak, t1, t2, type;
     rvec f_i, f_j, f_k;
@@ -1227,6 +1325,116 @@ real linear_angles(int             nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As linear_angles, but using SIMD to calculate many angles at once.
+ * This routines does not calculate energies and shift forces.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+linear_angles(int             nbonds,
+              const t_iatom   forceatoms[],
+              const t_iparams forceparams[],
+              const rvec      x[],
+              rvec4           f[],
+              rvec gmx_unused fshift[],
+              const t_pbc*    pbc,
+              const t_graph gmx_unused* g,
+              real gmx_unused lambda,
+              real gmx_unused* dvdlambda,
+              const t_mdatoms gmx_unused* md,
+              t_fcdata gmx_unused* fcd,
+              int gmx_unused* global_atom_index)
+{
+    constexpr int                            nfa1 = 4;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         coeff[2 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of angles times nfa1, here we step GMX_SIMD_REAL_WIDTH angles */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH angles.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+            ak[s]          = forceatoms[iu + 3];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s * nfa1 < nbonds)
+            {
+                coeff[s]                       = forceparams[type].linangle.klinA;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = forceparams[type].linangle.aA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                       = 0;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = 0;
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+        SimdReal xk_S, yk_S, zk_S;
+
+        /* Store the non PBC corrected distances packed and aligned */
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), aj, &xj_S, &yj_S, &zj_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ak, &xk_S, &yk_S, &zk_S);
+        SimdReal rijx_S = xi_S - xj_S;
+        SimdReal rijy_S = yi_S - yj_S;
+        SimdReal rijz_S = zi_S - zj_S;
+        SimdReal rkjx_S = xk_S - xj_S;
+        SimdReal rkjy_S = yk_S - yj_S;
+        SimdReal rkjz_S = zk_S - zj_S;
+
+        const SimdReal klin_S = load<SimdReal>(coeff);
+        const SimdReal a_S    = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH);
+        const SimdReal b_S    = 1.0 - a_S;
+
+        pbc_correct_dx_simd(&rijx_S, &rijy_S, &rijz_S, pbc_simd);
+        pbc_correct_dx_simd(&rkjx_S, &rkjy_S, &rkjz_S, pbc_simd);
+
+        /* The deviation of j from the weighted position of i and k, times -1 */
+        const SimdReal drx_S = -(a_S * rijx_S + b_S * rkjx_S);
+        const SimdReal dry_S = -(a_S * rijy_S + b_S * rkjy_S);
+        const SimdReal drz_S = -(a_S * rijz_S + b_S * rkjz_S);
+
+        const SimdReal fi_S = a_S * klin_S;
+        const SimdReal fk_S = b_S * klin_S;
+
+        const SimdReal f_ix_S = fi_S * drx_S;
+        const SimdReal f_iy_S = fi_S * dry_S;
+        const SimdReal f_iz_S = fi_S * drz_S;
+        const SimdReal f_kx_S = fk_S * drx_S;
+        const SimdReal f_ky_S = fk_S * dry_S;
+        const SimdReal f_kz_S = fk_S * drz_S;
+
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ai, f_ix_S, f_iy_S, f_iz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real*>(f), aj, f_ix_S + f_kx_S, f_iy_S + f_ky_S,
+                                 f_iz_S + f_kz_S);
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ak, f_kx_S, f_ky_S, f_kz_S);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 template<BondedKernelFlavor flavor>
 std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
 urey_bradley(int             nbonds,
@@ -1498,19 +1706,20 @@ urey_bradley(int             nbonds,
 #endif // GMX_SIMD_HAVE_REAL
 
 template<BondedKernelFlavor flavor>
-real quartic_angles(int             nbonds,
-                    const t_iatom   forceatoms[],
-                    const t_iparams forceparams[],
-                    const rvec      x[],
-                    rvec4           f[],
-                    rvec            fshift[],
-                    const t_pbc*    pbc,
-                    const t_graph*  g,
-                    real gmx_unused lambda,
-                    real gmx_unused* dvdlambda,
-                    const t_mdatoms gmx_unused* md,
-                    t_fcdata gmx_unused* fcd,
-                    int gmx_unused* global_atom_index)
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+quartic_angles(int             nbonds,
+               const t_iatom   forceatoms[],
+               const t_iparams forceparams[],
+               const rvec      x[],
+               rvec4           f[],
+               rvec            fshift[],
+               const t_pbc*    pbc,
+               const t_graph*  g,
+               real gmx_unused lambda,
+               real gmx_unused* dvdlambda,
+               const t_mdatoms gmx_unused* md,
+               t_fcdata gmx_unused* fcd,
+               int gmx_unused* global_atom_index)
 {
     int  i, j, ai, aj, ak, t1, t2, type;
     rvec r_ij, r_kj;
@@ -1591,47 +1800,187 @@ real quartic_angles(int             nbonds,
     return vtot;
 }
 
-
 #if GMX_SIMD_HAVE_REAL
 
-/* As dih_angle above, but calculates 4 dihedral angles at once using SIMD,
- * also calculates the pre-factor required for the dihedral force update.
- * Note that bv and buf should be register aligned.
+/* As quartic_angles, but using SIMD to calculate many angles at once.
+ * This routines does not calculate energies and shift forces.
  */
-inline void dih_angle_simd(const rvec* x,
-                           const int*  ai,
-                           const int*  aj,
-                           const int*  ak,
-                           const int*  al,
-                           const real* pbc_simd,
-                           SimdReal*   phi_S,
-                           SimdReal*   mx_S,
-                           SimdReal*   my_S,
-                           SimdReal*   mz_S,
-                           SimdReal*   nx_S,
-                           SimdReal*   ny_S,
-                           SimdReal*   nz_S,
-                           SimdReal*   nrkj_m2_S,
-                           SimdReal*   nrkj_n2_S,
-                           SimdReal*   p_S,
-                           SimdReal*   q_S)
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+quartic_angles(int             nbonds,
+               const t_iatom   forceatoms[],
+               const t_iparams forceparams[],
+               const rvec      x[],
+               rvec4           f[],
+               rvec gmx_unused fshift[],
+               const t_pbc*    pbc,
+               const t_graph gmx_unused* g,
+               real gmx_unused lambda,
+               real gmx_unused* dvdlambda,
+               const t_mdatoms gmx_unused* md,
+               t_fcdata gmx_unused* fcd,
+               int gmx_unused* global_atom_index)
 {
-    SimdReal xi_S, yi_S, zi_S;
-    SimdReal xj_S, yj_S, zj_S;
-    SimdReal xk_S, yk_S, zk_S;
-    SimdReal xl_S, yl_S, zl_S;
-    SimdReal rijx_S, rijy_S, rijz_S;
-    SimdReal rkjx_S, rkjy_S, rkjz_S;
-    SimdReal rklx_S, rkly_S, rklz_S;
-    SimdReal cx_S, cy_S, cz_S;
-    SimdReal cn_S;
-    SimdReal s_S;
-    SimdReal ipr_S;
-    SimdReal iprm_S, iprn_S;
-    SimdReal nrkj2_S, nrkj_1_S, nrkj_2_S, nrkj_S;
-    SimdReal toler_S;
-    SimdReal nrkj2_min_S;
-    SimdReal real_eps_S;
+    constexpr int                            nfa1 = 4;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         coeff[5 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of angles times nfa1, here we step GMX_SIMD_REAL_WIDTH angles */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH angles.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+            ak[s]          = forceatoms[iu + 3];
+
+            /* At the end fill the arrays with the last atoms and 0 params.
+             * We store the coefficients of dV/dtheta, i.e. j*c[j].
+             */
+            if (i + s * nfa1 < nbonds)
+            {
+                coeff[s] = forceparams[type].qangle.theta;
+                for (int j = 1; j <= 4; j++)
+                {
+                    coeff[GMX_SIMD_REAL_WIDTH * j + s] = j * forceparams[type].qangle.c[j];
+                }
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                for (int j = 0; j <= 4; j++)
+                {
+                    coeff[GMX_SIMD_REAL_WIDTH * j + s] = 0;
+                }
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+        SimdReal xk_S, yk_S, zk_S;
+
+        /* Store the non PBC corrected distances packed and aligned */
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), aj, &xj_S, &yj_S, &zj_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ak, &xk_S, &yk_S, &zk_S);
+        SimdReal rijx_S = xi_S - xj_S;
+        SimdReal rijy_S = yi_S - yj_S;
+        SimdReal rijz_S = zi_S - zj_S;
+        SimdReal rkjx_S = xk_S - xj_S;
+        SimdReal rkjy_S = yk_S - yj_S;
+        SimdReal rkjz_S = zk_S - zj_S;
+
+        const SimdReal theta0_S = load<SimdReal>(coeff) * DEG2RAD;
+        const SimdReal c1_S     = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH);
+        const SimdReal c2_S     = load<SimdReal>(coeff + 2 * GMX_SIMD_REAL_WIDTH);
+        const SimdReal c3_S     = load<SimdReal>(coeff + 3 * GMX_SIMD_REAL_WIDTH);
+        const SimdReal c4_S     = load<SimdReal>(coeff + 4 * GMX_SIMD_REAL_WIDTH);
+
+        pbc_correct_dx_simd(&rijx_S, &rijy_S, &rijz_S, pbc_simd);
+        pbc_correct_dx_simd(&rkjx_S, &rkjy_S, &rkjz_S, pbc_simd);
+
+        const SimdReal rij_rkj_S = iprod(rijx_S, rijy_S, rijz_S, rkjx_S, rkjy_S, rkjz_S);
+
+        const SimdReal nrij2_S = norm2(rijx_S, rijy_S, rijz_S);
+        const SimdReal nrkj2_S = norm2(rkjx_S, rkjy_S, rkjz_S);
+
+        const SimdReal nrij_1_S = invsqrt(nrij2_S);
+        const SimdReal nrkj_1_S = invsqrt(nrkj2_S);
+
+        constexpr real min_one_plus_eps = -1.0 + 2.0 * GMX_REAL_EPS; // Smallest number > -1
+
+        /* As in the SIMD angles kernel we limit cos to > -1, but we take
+         * no precautions for cos(0)=1.
+         */
+        const SimdReal cos_S = max(rij_rkj_S * nrij_1_S * nrkj_1_S, min_one_plus_eps);
+
+        const SimdReal theta_S  = acos(cos_S);
+        const SimdReal invsin_S = invsqrt(1.0 - cos_S * cos_S);
+        const SimdReal dt_S     = theta_S - theta0_S;
+
+        /* -dV/dtheta, evaluated with Horner's scheme */
+        const SimdReal dVdt_S = -fma(fma(fma(c4_S, dt_S, c3_S), dt_S, c2_S), dt_S, c1_S);
+
+        const SimdReal st_S  = dVdt_S * invsin_S;
+        const SimdReal sth_S = st_S * cos_S;
+
+        const SimdReal cik_S = st_S * nrij_1_S * nrkj_1_S;
+        const SimdReal cii_S = sth_S * nrij_1_S * nrij_1_S;
+        const SimdReal ckk_S = sth_S * nrkj_1_S * nrkj_1_S;
+
+        const SimdReal f_ix_S = fnma(cik_S, rkjx_S, cii_S * rijx_S);
+        const SimdReal f_iy_S = fnma(cik_S, rkjy_S, cii_S * rijy_S);
+        const SimdReal f_iz_S = fnma(cik_S, rkjz_S, cii_S * rijz_S);
+        const SimdReal f_kx_S = fnma(cik_S, rijx_S, ckk_S * rkjx_S);
+        const SimdReal f_ky_S = fnma(cik_S, rijy_S, ckk_S * rkjy_S);
+        const SimdReal f_kz_S = fnma(cik_S, rijz_S, ckk_S * rkjz_S);
+
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ai, f_ix_S, f_iy_S, f_iz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real*>(f), aj, f_ix_S + f_kx_S, f_iy_S + f_ky_S,
+                                 f_iz_S + f_kz_S);
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ak, f_kx_S, f_ky_S, f_kz_S);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
+
+#if GMX_SIMD_HAVE_REAL
+
+/* As dih_angle above, but calculates 4 dihedral angles at once using SIMD,
+ * also calculates the pre-factor required for the dihedral force update.
+ * Note that bv and buf should be register aligned.
+ */
+inline void dih_angle_simd(const rvec* x,
+                           const int*  ai,
+                           const int*  aj,
+                           const int*  ak,
+                           const int*  al,
+                           const real* pbc_simd,
+                           SimdReal*   phi_S,
+                           SimdReal*   mx_S,
+                           SimdReal*   my_S,
+                           SimdReal*   mz_S,
+                           SimdReal*   nx_S,
+                           SimdReal*   ny_S,
+                           SimdReal*   nz_S,
+                           SimdReal*   nrkj_m2_S,
+                           SimdReal*   nrkj_n2_S,
+                           SimdReal*   p_S,
+                           SimdReal*   q_S)
+{
+    SimdReal xi_S, yi_S, zi_S;
+    SimdReal xj_S, yj_S, zj_S;
+    SimdReal xk_S, yk_S, zk_S;
+    SimdReal xl_S, yl_S, zl_S;
+    SimdReal rijx_S, rijy_S, rijz_S;
+    SimdReal rkjx_S, rkjy_S, rkjz_S;
+    SimdReal rklx_S, rkly_S, rklz_S;
+    SimdReal cx_S, cy_S, cz_S;
+    SimdReal cn_S;
+    SimdReal s_S;
+    SimdReal ipr_S;
+    SimdReal iprm_S, iprn_S;
+    SimdReal nrkj2_S, nrkj_1_S, nrkj_2_S, nrkj_S;
+    SimdReal toler_S;
+    SimdReal nrkj2_min_S;
+    SimdReal real_eps_S;
 
     /* Used to avoid division by zero.
      * We take into acount that we multiply the result by real_eps_S.
@@ -2184,19 +2533,20 @@ rbdihs(int             nbonds,
 
 
 template<BondedKernelFlavor flavor>
-real idihs(int             nbonds,
-           const t_iatom   forceatoms[],
-           const t_iparams forceparams[],
-           const rvec      x[],
-           rvec4           f[],
-           rvec            fshift[],
-           const t_pbc*    pbc,
-           const t_graph*  g,
-           real            lambda,
-           real*           dvdlambda,
-           const t_mdatoms gmx_unused* md,
-           t_fcdata gmx_unused* fcd,
-           int gmx_unused* global_atom_index)
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+idihs(int             nbonds,
+      const t_iatom   forceatoms[],
+      const t_iparams forceparams[],
+      const rvec      x[],
+      rvec4           f[],
+      rvec            fshift[],
+      const t_pbc*    pbc,
+      const t_graph*  g,
+      real            lambda,
+      real*           dvdlambda,
+      const t_mdatoms gmx_unused* md,
+      t_fcdata gmx_unused* fcd,
+      int gmx_unused* global_atom_index)
 {
     int  i, type, ai, aj, ak, al;
     int  t1, t2, t3;
@@ -2253,6 +2603,112 @@ real idihs(int             nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As idihs, but using SIMD to calculate multiple dihedrals at once.
+ * This routines does not calculate energies and shift forces.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+idihs(int             nbonds,
+      const t_iatom   forceatoms[],
+      const t_iparams forceparams[],
+      const rvec      x[],
+      rvec4           f[],
+      rvec gmx_unused fshift[],
+      const t_pbc*    pbc,
+      const t_graph gmx_unused* g,
+      real gmx_unused lambda,
+      real gmx_unused* dvdlambda,
+      const t_mdatoms gmx_unused* md,
+      t_fcdata gmx_unused* fcd,
+      int gmx_unused* global_atom_index)
+{
+    constexpr int                            nfa1 = 5;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t al[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         coeff[2 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    const SimdReal pi_S(M_PI);
+    const SimdReal twoPi_S(2 * M_PI);
+
+    /* nbonds is the number of dihedrals times nfa1, here we step GMX_SIMD_REAL_WIDTH dihs */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect atoms quadruplets for GMX_SIMD_REAL_WIDTH dihedrals.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+            ak[s]          = forceatoms[iu + 3];
+            al[s]          = forceatoms[iu + 4];
+
+            /* At the end fill the arrays with the last atoms and 0 params */
+            if (i + s * nfa1 < nbonds)
+            {
+                coeff[s]                       = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = forceparams[type].harmonic.rA;
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                       = 0;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = 0;
+            }
+        }
+
+        SimdReal phi_S;
+        SimdReal mx_S, my_S, mz_S;
+        SimdReal nx_S, ny_S, nz_S;
+        SimdReal nrkj_m2_S, nrkj_n2_S;
+        SimdReal p_S, q_S;
+
+        /* Caclulate GMX_SIMD_REAL_WIDTH dihedral angles at once */
+        dih_angle_simd(x, ai, aj, ak, al, pbc_simd, &phi_S, &mx_S, &my_S, &mz_S, &nx_S, &ny_S,
+                       &nz_S, &nrkj_m2_S, &nrkj_n2_S, &p_S, &q_S);
+
+        const SimdReal k_S    = load<SimdReal>(coeff);
+        const SimdReal phi0_S = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH) * DEG2RAD;
+
+        /* As make_dp_periodic, put phi - phi0 in the interval [-pi, pi) */
+        SimdReal dp_S = phi_S - phi0_S;
+        dp_S = dp_S - selectByMask(twoPi_S, pi_S <= dp_S) + selectByMask(twoPi_S, dp_S < -pi_S);
+
+        const SimdReal mddphi_S = -k_S * dp_S;
+        const SimdReal sf_i_S   = mddphi_S * nrkj_m2_S;
+        const SimdReal msf_l_S  = mddphi_S * nrkj_n2_S;
+
+        /* After this m?_S will contain f[i] */
+        mx_S = sf_i_S * mx_S;
+        my_S = sf_i_S * my_S;
+        mz_S = sf_i_S * mz_S;
+
+        /* After this n?_S will contain -f[l] */
+        nx_S = msf_l_S * nx_S;
+        ny_S = msf_l_S * ny_S;
+        nz_S = msf_l_S * nz_S;
+
+        do_dih_fup_noshiftf_simd(ai, aj, ak, al, p_S, q_S, mx_S, my_S, mz_S, nx_S, ny_S, nz_S, f);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 /*! \brief Computes angle restraints of two different types */
 template<BondedKernelFlavor flavor>
 real low_angres(int             nbonds,
@@ -2508,19 +2964,20 @@ real unimplemented(int gmx_unused nbonds,
 }
 
 template<BondedKernelFlavor flavor>
-real restrangles(int             nbonds,
-                 const t_iatom   forceatoms[],
-                 const t_iparams forceparams[],
-                 const rvec      x[],
-                 rvec4           f[],
-                 rvec            fshift[],
-                 const t_pbc*    pbc,
-                 const t_graph*  g,
-                 real gmx_unused lambda,
-                 real gmx_unused* dvdlambda,
-                 const t_mdatoms gmx_unused* md,
-                 t_fcdata gmx_unused* fcd,
-                 int gmx_unused* global_atom_index)
+std::enable_if_t<flavor != BondedKernelFlavor::ForcesSimdWhenAvailable || !GMX_SIMD_HAVE_REAL, real>
+restrangles(int             nbonds,
+            const t_iatom   forceatoms[],
+            const t_iparams forceparams[],
+            const rvec      x[],
+            rvec4           f[],
+            rvec            fshift[],
+            const t_pbc*    pbc,
+            const t_graph*  g,
+            real gmx_unused lambda,
+            real gmx_unused* dvdlambda,
+            const t_mdatoms gmx_unused* md,
+            t_fcdata gmx_unused* fcd,
+            int gmx_unused* global_atom_index)
 {
     int    i, d, ai, aj, ak, type, m;
     int    t1, t2;
@@ -2620,6 +3077,125 @@ real restrangles(int             nbonds,
     return vtot;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/* As restrangles, but using SIMD to calculate many angles at once.
+ * This routines does not calculate energies and shift forces.
+ * Note that the plain-C code uses double precision for part of the
+ * computation, whereas here everything is computed in real precision.
+ */
+template<BondedKernelFlavor flavor>
+std::enable_if_t<flavor == BondedKernelFlavor::ForcesSimdWhenAvailable, real>
+restrangles(int             nbonds,
+            const t_iatom   forceatoms[],
+            const t_iparams forceparams[],
+            const rvec      x[],
+            rvec4           f[],
+            rvec gmx_unused fshift[],
+            const t_pbc*    pbc,
+            const t_graph gmx_unused* g,
+            real gmx_unused lambda,
+            real gmx_unused* dvdlambda,
+            const t_mdatoms gmx_unused* md,
+            t_fcdata gmx_unused* fcd,
+            int gmx_unused* global_atom_index)
+{
+    constexpr int                            nfa1 = 4;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         coeff[2 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    /* nbonds is the number of angles times nfa1, here we step GMX_SIMD_REAL_WIDTH angles */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect atoms for GMX_SIMD_REAL_WIDTH angles.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            const int type = forceatoms[iu];
+            ai[s]          = forceatoms[iu + 1];
+            aj[s]          = forceatoms[iu + 2];
+            ak[s]          = forceatoms[iu + 3];
+
+            /* At the end fill the arrays with the last atoms and 0 params.
+             * As compute_factors_restangles, we use the cosine of pi - theta0.
+             */
+            if (i + s * nfa1 < nbonds)
+            {
+                coeff[s] = forceparams[type].harmonic.krA;
+                coeff[GMX_SIMD_REAL_WIDTH + s] =
+                        std::cos(M_PI - forceparams[type].harmonic.rA * DEG2RAD);
+
+                if (iu + nfa1 < nbonds)
+                {
+                    iu += nfa1;
+                }
+            }
+            else
+            {
+                coeff[s]                       = 0;
+                coeff[GMX_SIMD_REAL_WIDTH + s] = 0;
+            }
+        }
+
+        SimdReal xi_S, yi_S, zi_S;
+        SimdReal xj_S, yj_S, zj_S;
+        SimdReal xk_S, yk_S, zk_S;
+
+        /* Store the non PBC corrected distances packed and aligned */
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ai, &xi_S, &yi_S, &zi_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), aj, &xj_S, &yj_S, &zj_S);
+        gatherLoadUTranspose<3>(reinterpret_cast<const real*>(x), ak, &xk_S, &yk_S, &zk_S);
+        SimdReal dax_S = xj_S - xi_S;
+        SimdReal day_S = yj_S - yi_S;
+        SimdReal daz_S = zj_S - zi_S;
+        SimdReal dpx_S = xk_S - xj_S;
+        SimdReal dpy_S = yk_S - yj_S;
+        SimdReal dpz_S = zk_S - zj_S;
+
+        const SimdReal k_S    = load<SimdReal>(coeff);
+        const SimdReal cos0_S = load<SimdReal>(coeff + GMX_SIMD_REAL_WIDTH);
+
+        pbc_correct_dx_simd(&dax_S, &day_S, &daz_S, pbc_simd);
+        pbc_correct_dx_simd(&dpx_S, &dpy_S, &dpz_S, pbc_simd);
+
+        const SimdReal c_ante_S = norm2(dax_S, day_S, daz_S);
+        const SimdReal c_cros_S = iprod(dax_S, day_S, daz_S, dpx_S, dpy_S, dpz_S);
+        const SimdReal c_post_S = norm2(dpx_S, dpy_S, dpz_S);
+
+        const SimdReal norm_S      = invsqrt(c_ante_S * c_post_S);
+        const SimdReal cos_S       = c_cros_S * norm_S;
+        const SimdReal sin2_S      = 1.0 - cos_S * cos_S;
+        const SimdReal ratioAnte_S = c_cros_S * inv(c_ante_S);
+        const SimdReal ratioPost_S = c_cros_S * inv(c_post_S);
+
+        const SimdReal prefactor_S = k_S * (cos0_S - cos_S) * norm_S
+                                     * fnma(cos_S, cos0_S, SimdReal(1.0)) * inv(sin2_S * sin2_S);
+
+        const SimdReal f_ix_S = prefactor_S * fms(ratioAnte_S, dax_S, dpx_S);
+        const SimdReal f_iy_S = prefactor_S * fms(ratioAnte_S, day_S, dpy_S);
+        const SimdReal f_iz_S = prefactor_S * fms(ratioAnte_S, daz_S, dpz_S);
+        const SimdReal f_kx_S = prefactor_S * fnma(ratioPost_S, dpx_S, dax_S);
+        const SimdReal f_ky_S = prefactor_S * fnma(ratioPost_S, dpy_S, day_S);
+        const SimdReal f_kz_S = prefactor_S * fnma(ratioPost_S, dpz_S, daz_S);
+
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ai, f_ix_S, f_iy_S, f_iz_S);
+        transposeScatterDecrU<4>(reinterpret_cast<real*>(f), aj, f_ix_S + f_kx_S, f_iy_S + f_ky_S,
+                                 f_iz_S + f_kz_S);
+        transposeScatterIncrU<4>(reinterpret_cast<real*>(f), ak, f_kx_S, f_ky_S, f_kz_S);
+    }
+
+    return 0;
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 
 template<BondedKernelFlavor flavor>
 real restrdihs(int             nbonds,
@@ -3005,6 +3581,209 @@ int cmap_setup_grid_index(int ip, int grid_spacing, int* ipm1, int* ipp1, int* i
     return ip;
 }
 
+#if GMX_SIMD_HAVE_REAL
+
+/*! \brief As cmap_dihs(), but using SIMD to calculate multiple CMAP terms at once
+ *
+ * Only computes forces. The dihedral angles, the bicubic interpolation and
+ * the forces are computed with SIMD; the grid coefficients are gathered
+ * separately for each SIMD lane.
+ */
+void cmap_dihs_noener_simd(int               nbonds,
+                           const t_iatom     forceatoms[],
+                           const t_iparams   forceparams[],
+                           const gmx_cmap_t* cmap_grid,
+                           const rvec        x[],
+                           rvec4             f[],
+                           const t_pbc*      pbc)
+{
+    const int                                nfa1 = 6;
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ai[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t aj[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t ak[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t al[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) std::int32_t am[GMX_SIMD_REAL_WIDTH];
+    int                                      type[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         phi1[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         phi2[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         tt[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         tu[GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         tx[16 * GMX_SIMD_REAL_WIDTH];
+    alignas(GMX_SIMD_ALIGNMENT) real         pbc_simd[9 * GMX_SIMD_REAL_WIDTH];
+    SimdReal                                 phi1_S, phi2_S;
+    SimdReal                                 m1x_S, m1y_S, m1z_S, n1x_S, n1y_S, n1z_S;
+    SimdReal                                 m2x_S, m2y_S, m2z_S, n2x_S, n2y_S, n2z_S;
+    SimdReal                                 nrkj_m21_S, nrkj_n21_S, p1_S, q1_S;
+    SimdReal                                 nrkj_m22_S, nrkj_n22_S, p2_S, q2_S;
+    SimdReal                                 tx_S[16], tc_S[16];
+
+    set_pbc_simd(pbc, pbc_simd);
+
+    const int gridSpacing = cmap_grid->grid_spacing;
+    /* The grid spacing in radians locates the grid cell,
+     * the interpolation is done in degrees, as in cmap_dihs() */
+    const real     dxRad = 2 * M_PI / gridSpacing;
+    const real     dx    = 360.0 / gridSpacing;
+    const SimdReal fac_S(RAD2DEG / dx);
+    const SimdReal two_S(2.0);
+    const SimdReal three_S(3.0);
+
+    /* nbonds is the number of CMAP terms times nfa1, here we step GMX_SIMD_REAL_WIDTH terms */
+    for (int i = 0; i < nbonds; i += GMX_SIMD_REAL_WIDTH * nfa1)
+    {
+        /* Collect the atoms of GMX_SIMD_REAL_WIDTH CMAP terms.
+         * iu indexes into forceatoms, we should not let iu go beyond nbonds.
+         */
+        int iu = i;
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            type[s] = forceatoms[iu];
+            ai[s]   = forceatoms[iu + 1];
+            aj[s]   = forceatoms[iu + 2];
+            ak[s]   = forceatoms[iu + 3];
+            al[s]   = forceatoms[iu + 4];
+            am[s]   = forceatoms[iu + 5];
+
+            if (iu + nfa1 < nbonds)
+            {
+                iu += nfa1;
+            }
+        }
+
+        /* Calculate GMX_SIMD_REAL_WIDTH angles of both torsions at once */
+        dih_angle_simd(x, ai, aj, ak, al, pbc_simd, &phi1_S, &m1x_S, &m1y_S, &m1z_S, &n1x_S,
+                       &n1y_S, &n1z_S, &nrkj_m21_S, &nrkj_n21_S, &p1_S, &q1_S);
+        dih_angle_simd(x, aj, ak, al, am, pbc_simd, &phi2_S, &m2x_S, &m2y_S, &m2z_S, &n2x_S,
+                       &n2y_S, &n2z_S, &nrkj_m22_S, &nrkj_n22_S, &p2_S, &q2_S);
+        store(phi1, phi1_S);
+        store(phi2, phi2_S);
+
+        /* Gather the grid values and derivatives around each pair of angles.
+         * At the end, lanes without a CMAP term get zero coefficients,
+         * and thereby zero forces.
+         */
+        for (int s = 0; s < GMX_SIMD_REAL_WIDTH; s++)
+        {
+            if (i + s * nfa1 >= nbonds)
+            {
+                for (int k = 0; k < 16; k++)
+                {
+                    tx[k * GMX_SIMD_REAL_WIDTH + s] = 0;
+                }
+                tt[s] = 0;
+                tu[s] = 0;
+                continue;
+            }
+
+            const int   cmapA = forceparams[type[s]].cmap.cmapA;
+            const real* cmapd = cmap_grid->cmapdata[cmapA].cmap.data();
+
+            real xphi1 = phi1[s] + M_PI;
+            real xphi2 = phi2[s] + M_PI;
+
+            /* Range mangling */
+            if (xphi1 < 0)
+            {
+                xphi1 = xphi1 + 2 * M_PI;
+            }
+            else if (xphi1 >= 2 * M_PI)
+            {
+                xphi1 = xphi1 - 2 * M_PI;
+            }
+
+            if (xphi2 < 0)
+            {
+                xphi2 = xphi2 + 2 * M_PI;
+            }
+            else if (xphi2 >= 2 * M_PI)
+            {
+                xphi2 = xphi2 - 2 * M_PI;
+            }
+
+            int       ip1m1, ip1p1, ip1p2;
+            int       ip2m1, ip2p1, ip2p2;
+            const int iphi1 = cmap_setup_grid_index(static_cast<int>(xphi1 / dxRad), gridSpacing,
+                                                    &ip1m1, &ip1p1, &ip1p2);
+            const int iphi2 = cmap_setup_grid_index(static_cast<int>(xphi2 / dxRad), gridSpacing,
+                                                    &ip2m1, &ip2p1, &ip2p2);
+
+            const int pos[4] = { iphi1 * gridSpacing + iphi2, ip1p1 * gridSpacing + iphi2,
+                                 ip1p1 * gridSpacing + ip2p1, iphi1 * gridSpacing + ip2p1 };
+            for (int c = 0; c < 4; c++)
+            {
+                tx[c * GMX_SIMD_REAL_WIDTH + s]        = cmapd[pos[c] * 4];
+                tx[(c + 4) * GMX_SIMD_REAL_WIDTH + s]  = cmapd[pos[c] * 4 + 1] * dx;
+                tx[(c + 8) * GMX_SIMD_REAL_WIDTH + s]  = cmapd[pos[c] * 4 + 2] * dx;
+                tx[(c + 12) * GMX_SIMD_REAL_WIDTH + s] = cmapd[pos[c] * 4 + 3] * dx * dx;
+            }
+
+            tt[s] = (xphi1 * RAD2DEG - iphi1 * dx) / dx;
+            tu[s] = (xphi2 * RAD2DEG - iphi2 * dx) / dx;
+        }
+
+        /* Bicubic interpolation for GMX_SIMD_REAL_WIDTH terms at once */
+        for (int k = 0; k < 16; k++)
+        {
+            tx_S[k] = load<SimdReal>(tx + k * GMX_SIMD_REAL_WIDTH);
+        }
+        for (int idx = 0; idx < 16; idx++)
+        {
+            tc_S[idx] = setZero();
+            for (int k = 0; k < 16; k++)
+            {
+                if (cmap_coeff_matrix[k * 16 + idx] != 0)
+                {
+                    tc_S[idx] = fma(SimdReal(cmap_coeff_matrix[k * 16 + idx]), tx_S[k], tc_S[idx]);
+                }
+            }
+        }
+
+        const SimdReal tt_S  = load<SimdReal>(tt);
+        const SimdReal tu_S  = load<SimdReal>(tu);
+        SimdReal       df1_S = setZero();
+        SimdReal       df2_S = setZero();
+        for (int c = 3; c >= 0; c--)
+        {
+            df1_S = fma(tu_S, df1_S,
+                        fma(fma(three_S * tc_S[c + 12], tt_S, two_S * tc_S[c + 8]), tt_S,
+                            tc_S[c + 4]));
+            df2_S = fma(tt_S, df2_S,
+                        fma(fma(three_S * tc_S[c * 4 + 3], tu_S, two_S * tc_S[c * 4 + 2]), tu_S,
+                            tc_S[c * 4 + 1]));
+        }
+        /* The negated derivatives with respect to the angles in radians */
+        const SimdReal mddphi1_S = -df1_S * fac_S;
+        const SimdReal mddphi2_S = -df2_S * fac_S;
+
+        /* Do forces - first torsion, after this m1?_S will contain f[i]
+         * and n1?_S will contain -f[l] */
+        SimdReal sf_i_S  = mddphi1_S * nrkj_m21_S;
+        SimdReal msf_l_S = mddphi1_S * nrkj_n21_S;
+        m1x_S            = sf_i_S * m1x_S;
+        m1y_S            = sf_i_S * m1y_S;
+        m1z_S            = sf_i_S * m1z_S;
+        n1x_S            = msf_l_S * n1x_S;
+        n1y_S            = msf_l_S * n1y_S;
+        n1z_S            = msf_l_S * n1z_S;
+        do_dih_fup_noshiftf_simd(ai, aj, ak, al, p1_S, q1_S, m1x_S, m1y_S, m1z_S, n1x_S, n1y_S,
+                                 n1z_S, f);
+
+        /* Do forces - second torsion */
+        sf_i_S  = mddphi2_S * nrkj_m22_S;
+        msf_l_S = mddphi2_S * nrkj_n22_S;
+        m2x_S   = sf_i_S * m2x_S;
+        m2y_S   = sf_i_S * m2y_S;
+        m2z_S   = sf_i_S * m2z_S;
+        n2x_S   = msf_l_S * n2x_S;
+        n2y_S   = msf_l_S * n2y_S;
+        n2z_S   = msf_l_S * n2z_S;
+        do_dih_fup_noshiftf_simd(aj, ak, al, am, p2_S, q2_S, m2x_S, m2y_S, m2z_S, n2x_S, n2y_S,
+                                 n2z_S, f);
+    }
+}
+
+#endif // GMX_SIMD_HAVE_REAL
+
 } // namespace
 
 real cmap_dihs(int                   nbonds,
@@ -3020,8 +3799,19 @@ real cmap_dihs(int                   nbonds,
                real gmx_unused* dvdlambda,
                const t_mdatoms gmx_unused* md,
                t_fcdata gmx_unused* fcd,
-               int gmx_unused* global_atom_index)
+               int gmx_unused*    global_atom_index,
+               BondedKernelFlavor bondedKernelFlavor)
 {
+#if GMX_SIMD_HAVE_REAL
+    if (bondedKernelFlavor == BondedKernelFlavor::ForcesSimdWhenAvailable)
+    {
+        cmap_dihs_noener_simd(nbonds, forceatoms, forceparams, cmap_grid, x, f, pbc);
+        return 0;
+    }
+#else
+    GMX_UNUSED_VALUE(bondedKernelFlavor);
+#endif
+
     int i, n;
     int ai, aj, ak, al, am;
     int a1i, a1j, a1k, a1l, a2i, a2j, a2k, a2l;
@@ -107,22 +107,6 @@ void do_dih_fup(int                   i,
 /*! \brief Make a dihedral fall in the range (-pi,pi) */
 void make_dp_periodic(real* dp);
 
-/*! \brief Compute CMAP dihedral energies and forces */
-real cmap_dihs(int                   nbonds,
-               const t_iatom         forceatoms[],
-               const t_iparams       forceparams[],
-               const gmx_cmap_t*     cmap_grid,
-               const rvec            x[],
-               rvec4                 f[],
-               rvec                  fshift[],
-               const struct t_pbc*   pbc,
-               const struct t_graph* g,
-               real gmx_unused lambda,
-               real gmx_unused* dvdlambda,
-               const t_mdatoms gmx_unused* md,
-               t_fcdata gmx_unused* fcd,
-               int gmx_unused* global_atom_index);
-
 /*! \brief For selecting which flavor of bonded kernel is used for simple bonded types */
 enum class BondedKernelFlavor
 {
@@ -153,6 +137,28 @@ static constexpr inline bool computeEnergyOrVirial(const BondedKernelFlavor flav
             || flavor == BondedKernelFlavor::ForcesAndEnergy);
 }
 
+/*! \brief Compute CMAP dihedral energies and forces
+ *
+ * With \p bondedKernelFlavor ForcesSimdWhenAvailable and SIMD support,
+ * only the forces are computed.
+ * \returns the energy or 0 when only the forces were computed.
+ */
+real cmap_dihs(int                   nbonds,
+               const t_iatom         forceatoms[],
+               const t_iparams       forceparams[],
+               const gmx_cmap_t*     cmap_grid,
+               const rvec            x[],
+               rvec4                 f[],
+               rvec                  fshift[],
+               const struct t_pbc*   pbc,
+               const struct t_graph* g,
+               real gmx_unused lambda,
+               real gmx_unused* dvdlambda,
+               const t_mdatoms gmx_unused* md,
+               t_fcdata gmx_unused* fcd,
+               int gmx_unused*    global_atom_index,
+               BondedKernelFlavor bondedKernelFlavor);
+
 /*! \brief Calculates bonded interactions for simple bonded types
  *
  * Exits with an error when the bonded type is not simple
@@ -105,6 +105,13 @@ void zero_thread_output(f_thread_t* f_t)
             }
         }
     }
+    for (int a : f_t->haloAtoms)
+    {
+        for (int d = 0; d < nelem_fa; d++)
+        {
+            f_t->f[a][d] = 0;
+        }
+    }
 
     for (int i = 0; i < SHIFTS; i++)
     {
@@ -127,59 +134,46 @@ void zero_thread_output(f_thread_t* f_t)
     }
 }
 
-/*! \brief The max thread number is arbitrary, we used a fixed number
- * to avoid memory management.  Using more than 16 threads is probably
- * never useful performance wise. */
-#define MAX_BONDED_THREADS 256
-
-/*! \brief Reduce thread-local force buffers */
-void reduce_thread_forces(int n, gmx::ArrayRef<gmx::RVec> force, const bonded_threading_t* bt, int nthreads)
+/*! \brief Reduce thread-local force buffers
+ *
+ * Each thread reduces the blocks it owns, i.e. its own full blocks,
+ * which are likely still in its cache, and the atoms in those blocks
+ * touched by other threads. As each block has a single owner,
+ * no synchronization is needed.
+ */
+void reduce_thread_forces(int n, gmx::ArrayRef<gmx::RVec> force, const bonded_threading_t* bt)
 {
-    if (nthreads > MAX_BONDED_THREADS)
-    {
-        gmx_fatal(FARGS, "Can not reduce bonded forces on more than %d threads", MAX_BONDED_THREADS);
-    }
-
     rvec* gmx_restrict f = as_rvec_array(force.data());
 
-    /* This reduction can run on any number of threads,
-     * independently of bt->nthreads.
-     * But if nthreads matches bt->nthreads (which it currently does)
-     * the uniform distribution of the touched blocks over nthreads will
-     * match the distribution of bonded over threads well in most cases,
-     * which means that threads mostly reduce their own data which increases
-     * the number of cache hits.
-     */
-#pragma omp parallel for num_threads(nthreads) schedule(static)
-    for (int b = 0; b < bt->nblock_used; b++)
+#pragma omp parallel for num_threads(bt->nthreads) schedule(static)
+    for (int t = 0; t < bt->nthreads; t++)
     {
         try
         {
-            int    ind = bt->block_index[b];
-            rvec4* fp[MAX_BONDED_THREADS];
+            const f_thread_t& threadBuffers = *bt->f_t[t];
 
-            /* Determine which threads contribute to this block */
-            int nfb = 0;
-            for (int ft = 0; ft < bt->nthreads; ft++)
+            for (int b = 0; b < threadBuffers.nblock_used; b++)
             {
-                if (bitmask_is_set(bt->mask[ind], ft))
+                int a0 = threadBuffers.block_index[b] * reduction_block_size;
+                int a1 = (threadBuffers.block_index[b] + 1) * reduction_block_size;
+                /* It would be nice if we could pad f to avoid this min */
+                a1 = std::min(a1, n);
+                for (int a = a0; a < a1; a++)
                 {
-                    fp[nfb++] = bt->f_t[ft]->f;
+                    rvec_inc(f[a], threadBuffers.f[a]);
                 }
             }
-            if (nfb > 0)
+
+            /* Add the contributions of other threads to our blocks */
+            for (int s = 0; s < bt->nthreads; s++)
             {
-                /* Reduce force buffers for threads that contribute */
-                int a0 = ind * reduction_block_size;
-                int a1 = (ind + 1) * reduction_block_size;
-                /* It would be nice if we could pad f to avoid this min */
-                a1 = std::min(a1, n);
-                for (int a = a0; a < a1; a++)
+                const f_thread_t& haloBuffers = *bt->f_t[s];
+
+                for (int i = haloBuffers.haloAtomOwnerStart[t];
+                     i < haloBuffers.haloAtomOwnerStart[t + 1]; i++)
                 {
-                    for (int fb = 0; fb < nfb; fb++)
-                    {
-                        rvec_inc(f[a], fp[fb][a]);
-                    }
+                    int a = haloBuffers.haloAtoms[i];
+                    rvec_inc(f[a], haloBuffers.f[a]);
                 }
             }
         }
@@ -201,7 +195,7 @@ void reduce_thread_output(int                        n,
     if (bt->nblock_used > 0)
     {
         /* Reduce the bonded force buffer */
-        reduce_thread_forces(n, forceWithShiftForces->force(), bt, bt->nthreads);
+        reduce_thread_forces(n, forceWithShiftForces->force(), bt);
     }
 
     rvec* gmx_restrict fshift = as_rvec_array(forceWithShiftForces->shiftForces().data());
@@ -351,7 +345,8 @@ real calc_one_bond(int                      thread,
                wallcycle needs to be extended to support calling from
                multiple threads. */
             v = cmap_dihs(nbn, iatoms + nb0, idef->iparams, idef->cmap_grid, x, f, fshift, pbc, g,
-                          lambda[efptFTYPE], &(dvdl[efptFTYPE]), md, fcd, global_atom_index);
+                          lambda[efptFTYPE], &(dvdl[efptFTYPE]), md, fcd, global_atom_index,
+                          flavor);
         }
         else
         {
@@ -44,16 +44,19 @@
 #define GMX_LISTED_FORCES_LISTED_INTERNAL_H
 
 #include <memory>
+#include <vector>
 
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/enerdata.h"
 #include "gromacs/topology/idef.h"
 #include "gromacs/topology/ifunc.h"
-#include "gromacs/utility/bitmask.h"
 
 /* We reduce the force array in blocks of 32 atoms. This is large enough
  * to not cause overhead and 32*sizeof(rvec) is a multiple of the cache-line
  * size on all systems.
+ * Each touched block is owned by the thread that contributes most atoms to it.
+ * The owner clears and reduces its blocks as a whole, other threads contributing
+ * to the block only clear and have reduced the individual atoms they touch.
  */
 static const int reduction_block_size = 32; /**< Force buffer block size in atoms*/
 static const int reduction_block_bits = 5;  /**< log2(reduction_block_size) */
@@ -95,13 +98,20 @@ struct f_thread_t
 
     ~f_thread_t();
 
-    rvec4*         f        = nullptr; /**< Force array */
-    int            f_nalloc = 0;       /**< Allocation size of f */
-    gmx_bitmask_t* mask =
-            nullptr; /**< Mask for marking which parts of f are filled, working array for constructing mask in bonded_threading_t */
-    int  nblock_used;            /**< Number of blocks touched by our thread */
-    int* block_index  = nullptr; /**< Index to touched blocks, size nblock_used */
-    int  block_nalloc = 0; /**< Allocation size of f (*reduction_block_size), mask_index, mask */
+    rvec4* f        = nullptr; /**< Force array */
+    int    f_nalloc = 0;       /**< Allocation size of f */
+    //! Number of atoms touched by our thread per block, working array for setting the block owners
+    std::vector<int> blockAtomCount;
+    //! Number of touched blocks owned by our thread
+    int nblock_used;
+    //! Index to owned touched blocks, size nblock_used
+    int* block_index = nullptr;
+    //! Allocation size of f (*reduction_block_size) and block_index
+    int block_nalloc = 0;
+    //! Atoms touched by our thread in blocks owned by other threads, sorted on owner, then atom index
+    std::vector<int> haloAtoms;
+    //! Start index in haloAtoms for each owner thread, size nthreads + 1
+    std::vector<int> haloAtomOwnerStart;
 
     rvec*             fshift;       /**< Shift force array, size SHIFTS */
     real              ener[F_NRE];  /**< Energy array */
@@ -121,10 +131,8 @@ struct bonded_threading_t
     std::vector<std::unique_ptr<f_thread_t>> f_t;
     //! The number of force blocks to reduce
     int nblock_used;
-    //! Index of size nblock_used into mask
-    std::vector<int> block_index;
-    //! Mask array, one element corresponds to a block of reduction_block_size atoms of the force array, bit corresponding to thread indices set if a thread writes to that block
-    std::vector<gmx_bitmask_t> mask;
+    //! The thread that clears and reduces each block of the force array, -1 for untouched blocks
+    std::vector<int> blockOwner;
     //! true if we have and thus need to reduce bonded forces
     bool haveBondeds;
 
@@ -54,6 +54,7 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
 
 #include "gromacs/listed_forces/gpubonded.h"
 #include "gromacs/mdlib/gmx_omp_nthreads.h"
@@ -322,48 +323,13 @@ static void divide_bondeds_over_threads(bonded_threading_t* bt, bool useGpuForBo
     }
 }
 
-//! Construct a reduction mask for which parts (blocks) of the force array are touched on which thread task
-static void calc_bonded_reduction_mask(int                       natoms,
-                                       f_thread_t*               f_thread,
-                                       const t_idef&             idef,
-                                       int                       thread,
-                                       const bonded_threading_t& bondedThreading)
+//! Calls \p func for each atom of each bonded interaction assigned to \p thread
+template<typename Func>
+static void forEachAtomOfThreadInteractions(const t_idef&             idef,
+                                            int                       thread,
+                                            const bonded_threading_t& bondedThreading,
+                                            Func&&                    func)
 {
-    static_assert(BITMASK_SIZE == GMX_OPENMP_MAX_THREADS,
-                  "For the error message below we assume these two are equal.");
-
-    if (bondedThreading.nthreads > BITMASK_SIZE)
-    {
-#pragma omp master
-        gmx_fatal(FARGS,
-                  "You are using %d OpenMP threads, which is larger than GMX_OPENMP_MAX_THREADS "
-                  "(%d). Decrease the number of OpenMP threads or rebuild GROMACS with a larger "
-                  "value for GMX_OPENMP_MAX_THREADS passed to CMake.",
-                  bondedThreading.nthreads, GMX_OPENMP_MAX_THREADS);
-#pragma omp barrier
-    }
-    GMX_ASSERT(bondedThreading.nthreads <= BITMASK_SIZE,
-               "We need at least nthreads bits in the mask");
-
-    int nblock = (natoms + reduction_block_size - 1) >> reduction_block_bits;
-
-    if (nblock > f_thread->block_nalloc)
-    {
-        f_thread->block_nalloc = over_alloc_large(nblock);
-        srenew(f_thread->mask, f_thread->block_nalloc);
-        srenew(f_thread->block_index, f_thread->block_nalloc);
-        // NOTE: It seems f_thread->f does not need to be aligned
-        sfree_aligned(f_thread->f);
-        snew_aligned(f_thread->f, f_thread->block_nalloc * reduction_block_size, 128);
-    }
-
-    gmx_bitmask_t* mask = f_thread->mask;
-
-    for (int b = 0; b < nblock; b++)
-    {
-        bitmask_clear(&mask[b]);
-    }
-
     for (int ftype = 0; ftype < F_NRE; ftype++)
     {
         if (ftype_is_bonded_potential(ftype))
@@ -380,30 +346,93 @@ static void calc_bonded_reduction_mask(int                       natoms,
                 {
                     for (int a = 1; a < nat1; a++)
                     {
-                        bitmask_set_bit(&mask[idef.il[ftype].iatoms[i + a] >> reduction_block_bits], thread);
+                        func(idef.il[ftype].iatoms[i + a]);
                     }
                 }
             }
         }
     }
+}
+
+//! Count for each part (block) of the force array how many atoms the thread task \p thread touches
+static void calc_bonded_block_atom_count(int                       natoms,
+                                         f_thread_t*               f_thread,
+                                         const t_idef&             idef,
+                                         int                       thread,
+                                         const bonded_threading_t& bondedThreading)
+{
+    int nblock = (natoms + reduction_block_size - 1) >> reduction_block_bits;
+
+    if (nblock > f_thread->block_nalloc)
+    {
+        f_thread->block_nalloc = over_alloc_large(nblock);
+        srenew(f_thread->block_index, f_thread->block_nalloc);
+        // NOTE: It seems f_thread->f does not need to be aligned
+        sfree_aligned(f_thread->f);
+        snew_aligned(f_thread->f, f_thread->block_nalloc * reduction_block_size, 128);
+    }
+
+    std::vector<int>& blockAtomCount = f_thread->blockAtomCount;
+    blockAtomCount.assign(nblock, 0);
+
+    forEachAtomOfThreadInteractions(idef, thread, bondedThreading, [&blockAtomCount](int atom) {
+        blockAtomCount[atom >> reduction_block_bits]++;
+    });
+}
+
+/*! \brief Set up the reduction for the thread task \p thread given the owners of the blocks
+ *
+ * Makes an index of the touched blocks our thread owns and a list of the atoms
+ * we touch in blocks owned by other threads, sorted on owner.
+ */
+static void setup_bonded_thread_reduction(int                       natoms,
+                                          f_thread_t*               f_thread,
+                                          const t_idef&             idef,
+                                          int                       thread,
+                                          const bonded_threading_t& bondedThreading)
+{
+    int nblock = (natoms + reduction_block_size - 1) >> reduction_block_bits;
+
+    const std::vector<int>& blockOwner = bondedThreading.blockOwner;
 
-    /* Make an index of the blocks our thread touches, so we can do fast
-     * force buffer clearing.
-     */
     f_thread->nblock_used = 0;
     for (int b = 0; b < nblock; b++)
     {
-        if (bitmask_is_set(mask[b], thread))
+        if (blockOwner[b] == thread)
         {
             f_thread->block_index[f_thread->nblock_used++] = b;
         }
     }
+
+    std::vector<int>& haloAtoms = f_thread->haloAtoms;
+    haloAtoms.clear();
+    forEachAtomOfThreadInteractions(idef, thread, bondedThreading, [&](int atom) {
+        if (blockOwner[atom >> reduction_block_bits] != thread)
+        {
+            haloAtoms.push_back(atom);
+        }
+    });
+
+    auto ownerOf = [&blockOwner](int atom) { return blockOwner[atom >> reduction_block_bits]; };
+    std::sort(haloAtoms.begin(), haloAtoms.end(), [&ownerOf](int a, int b) {
+        return ownerOf(a) < ownerOf(b) || (ownerOf(a) == ownerOf(b) && a < b);
+    });
+    haloAtoms.erase(std::unique(haloAtoms.begin(), haloAtoms.end()), haloAtoms.end());
+
+    std::vector<int>& ownerStart = f_thread->haloAtomOwnerStart;
+    ownerStart.assign(bondedThreading.nthreads + 1, 0);
+    for (int atom : haloAtoms)
+    {
+        ownerStart[ownerOf(atom) + 1]++;
+    }
+    for (int t = 0; t < bondedThreading.nthreads; t++)
+    {
+        ownerStart[t + 1] += ownerStart[t];
+    }
 }
 
 void setup_bonded_threading(bonded_threading_t* bt, int numAtoms, bool useGpuForBondeds, const t_idef& idef)
 {
-    int ctot = 0;
-
     assert(bt->nthreads >= 1);
 
     /* Divide the bonded interaction over the threads */
@@ -415,69 +444,79 @@ void setup_bonded_threading(bonded_threading_t* bt, int numAtoms, bool useGpuFor
         return;
     }
 
-    /* Determine to which blocks each thread's bonded force calculation
-     * contributes. Store this as a mask for each thread.
+    /* Determine how many atoms in each block each thread's bonded force
+     * calculation contributes to.
      */
 #pragma omp parallel for num_threads(bt->nthreads) schedule(static)
     for (int t = 0; t < bt->nthreads; t++)
     {
         try
         {
-            calc_bonded_reduction_mask(numAtoms, bt->f_t[t].get(), idef, t, *bt);
+            calc_bonded_block_atom_count(numAtoms, bt->f_t[t].get(), idef, t, *bt);
         }
         GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
     }
 
-    /* Reduce the masks over the threads and determine which blocks
-     * we need to reduce over.
+    /* Assign each touched block to the thread which contributes most atoms
+     * to it. The owner reduces the whole block, while it is still in its cache
+     * after the force calculation. Other threads only have the atoms they touch
+     * reduced. With the locality based division of bondeds over threads, most
+     * blocks are touched by a single thread only.
      */
     int nblock_tot = (numAtoms + reduction_block_size - 1) >> reduction_block_bits;
-    /* Ensure we have sufficient space for all blocks */
-    if (static_cast<size_t>(nblock_tot) > bt->block_index.size())
-    {
-        bt->block_index.resize(nblock_tot);
-    }
-    if (static_cast<size_t>(nblock_tot) > bt->mask.size())
-    {
-        bt->mask.resize(nblock_tot);
-    }
+    bt->blockOwner.resize(nblock_tot);
     bt->nblock_used = 0;
+    int ctot        = 0;
     for (int b = 0; b < nblock_tot; b++)
     {
-        gmx_bitmask_t* mask = &bt->mask[b];
-
-        /* Generate the union over the threads of the bitmask */
-        bitmask_clear(mask);
+        int owner    = -1;
+        int maxCount = 0;
+        int c        = 0;
         for (int t = 0; t < bt->nthreads; t++)
         {
-            bitmask_union(mask, bt->f_t[t]->mask[b]);
+            int count = bt->f_t[t]->blockAtomCount[b];
+            if (count > maxCount)
+            {
+                owner    = t;
+                maxCount = count;
+            }
+            if (count > 0)
+            {
+                c++;
+            }
         }
-        if (!bitmask_is_zero(*mask))
+        bt->blockOwner[b] = owner;
+        if (owner >= 0)
         {
-            bt->block_index[bt->nblock_used++] = b;
+            bt->nblock_used++;
         }
+        ctot += c;
 
-        if (debug)
+        if (debug && gmx_debug_at)
         {
-            int c = 0;
-            for (int t = 0; t < bt->nthreads; t++)
-            {
-                if (bitmask_is_set(*mask, t))
-                {
-                    c++;
-                }
-            }
-            ctot += c;
+            fprintf(debug, "block %d owner %d count %d\n", b, owner, c);
+        }
+    }
 
-            if (gmx_debug_at)
-            {
-                fprintf(debug, "block %d flags %s count %d\n", b, to_hex_string(*mask).c_str(), c);
-            }
+#pragma omp parallel for num_threads(bt->nthreads) schedule(static)
+    for (int t = 0; t < bt->nthreads; t++)
+    {
+        try
+        {
+            setup_bonded_thread_reduction(numAtoms, bt->f_t[t].get(), idef, t, *bt);
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
     }
+
     if (debug)
     {
-        fprintf(debug, "Number of %d atom blocks to reduce: %d\n", reduction_block_size, bt->nblock_used);
+        int numHaloAtoms = 0;
+        for (int t = 0; t < bt->nthreads; t++)
+        {
+            numHaloAtoms += bt->f_t[t]->haloAtoms.size();
+        }
+        fprintf(debug, "Number of %d atom blocks to reduce: %d, halo atoms to reduce: %d\n",
+                reduction_block_size, bt->nblock_used, numHaloAtoms);
         fprintf(debug, "Reduction density %.2f for touched blocks only %.2f\n",
                 ctot * reduction_block_size / static_cast<double>(numAtoms),
                 ctot / static_cast<double>(bt->nblock_used));
@@ -496,7 +535,6 @@ f_thread_t::f_thread_t(int numEnergyGroups) : grpp(numEnergyGroups)
 
 f_thread_t::~f_thread_t()
 {
-    sfree(mask);
     sfree(fshift);
     sfree(block_index);
     sfree_aligned(f);
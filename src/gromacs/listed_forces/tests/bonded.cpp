@@ -43,6 +43,7 @@
 
 #include "gromacs/listed_forces/bonded.h"
 
+#include <algorithm>
 #include <cmath>
 
 #include <memory>
@@ -58,6 +59,7 @@
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/topology/idef.h"
+#include "gromacs/utility/alignedallocator.h"
 #include "gromacs/utility/strconvert.h"
 #include "gromacs/utility/stringstream.h"
 #include "gromacs/utility/textwriter.h"
@@ -84,8 +86,8 @@ struct OutputQuantities
     real dvdlambda = 0;
     //! Shift vectors
     rvec fshift[N_IVEC] = { { 0 } };
-    //! Forces
-    rvec4 f[c_numAtoms] = { { 0 } };
+    //! Forces, aligned as the SIMD kernels require
+    alignas(4 * sizeof(real)) rvec4 f[c_numAtoms] = { { 0 } };
 };
 
 /*! \brief Utility to check the output from bonded tests
@@ -556,6 +558,54 @@ protected:
         // and bonded functions.
         EXPECT_TRUE((input_.fep || (output.dvdlambda == 0.0))) << "dvdlambda was " << output.dvdlambda;
         checkOutput(checker, output);
+        if (!input_.fep)
+        {
+            testForcesOnlyFlavors(iatoms, &mdatoms, ddgatindex.data(), output);
+        }
+    }
+    /*! \brief Checks that the forces-only kernel flavors, which
+     * can use SIMD, give the same forces as \p reference */
+    void testForcesOnlyFlavors(const std::vector<t_iatom>& iatoms,
+                               const t_mdatoms*            mdatoms,
+                               int*                        ddgatindex,
+                               const OutputQuantities&     reference)
+    {
+        // SIMD kernels can load one element beyond the coordinates of the last atom
+        std::vector<gmx::RVec> xPadded(x_);
+        xPadded.emplace_back(0, 0, 0);
+        // The forces can differ by rounding errors relative to the largest force
+        real forceMagnitude = 1;
+        for (int a = 0; a < c_numAtoms; a++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                forceMagnitude = std::max(forceMagnitude, std::abs(reference.f[a][d]));
+            }
+        }
+        const test::FloatingPointTolerance tolerance =
+                test::relativeToleranceAsPrecisionDependentFloatingPoint(
+                        forceMagnitude, input_.ftoler, input_.dtoler);
+        for (const auto flavor : { BondedKernelFlavor::ForcesSimdWhenAvailable,
+                                   BondedKernelFlavor::ForcesNoSimd })
+        {
+            SCOPED_TRACE(std::string("Testing flavor ")
+                         + (flavor == BondedKernelFlavor::ForcesSimdWhenAvailable
+                                    ? "ForcesSimdWhenAvailable"
+                                    : "ForcesNoSimd"));
+            OutputQuantities output;
+            calculateSimpleBond(input_.ftype, iatoms.size(), iatoms.data(), &input_.iparams,
+                                as_rvec_array(xPadded.data()), output.f, output.fshift, &pbc_,
+                                /* const struct t_graph *g */ nullptr, 0.0, &output.dvdlambda,
+                                mdatoms, /* struct t_fcdata * */ nullptr, ddgatindex, flavor);
+            for (int a = 0; a < c_numAtoms; a++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(reference.f[a][d], output.f[a][d], tolerance)
+                            << "for atom " << a << " dimension " << d;
+                }
+            }
+        }
     }
     void testIfunc()
     {
@@ -695,6 +745,103 @@ INSTANTIATE_TEST_CASE_P(Restraints,
                                            ::testing::ValuesIn(c_coordinatesForTests),
                                            ::testing::ValuesIn(c_pbcForTests)));
 #endif
+
+//! Number of CMAP terms for testing, more than fit in one SIMD register with most SIMD setups
+constexpr int c_numCmapTerms = 19;
+
+//! Returns CMAP grid data for a smooth analytical potential
+gmx_cmap_t makeCmapGrid()
+{
+    gmx_cmap_t cmapGrid;
+    cmapGrid.grid_spacing = 24;
+    cmapGrid.cmapdata.resize(1);
+    std::vector<real>& cmap = cmapGrid.cmapdata[0].cmap;
+    for (int i = 0; i < cmapGrid.grid_spacing; i++)
+    {
+        for (int j = 0; j < cmapGrid.grid_spacing; j++)
+        {
+            // Grid point 0 corresponds to an angle of -180 degrees
+            const real phi = -M_PI + i * 2 * M_PI / cmapGrid.grid_spacing;
+            const real psi = -M_PI + j * 2 * M_PI / cmapGrid.grid_spacing;
+            // V, dV/dphi, dV/dpsi and d2V/dphidpsi, with derivatives per degree
+            cmap.push_back(std::cos(phi) + std::sin(2 * psi) + 0.5 * std::cos(phi - psi));
+            cmap.push_back(DEG2RAD * (-std::sin(phi) - 0.5 * std::sin(phi - psi)));
+            cmap.push_back(DEG2RAD * (2 * std::cos(2 * psi) + 0.5 * std::sin(phi - psi)));
+            cmap.push_back(DEG2RAD * DEG2RAD * 0.5 * std::cos(phi - psi));
+        }
+    }
+    return cmapGrid;
+}
+
+TEST(ListedForcesCmapTest, ForcesOnlyFlavorsMatchReference)
+{
+    const gmx_cmap_t cmapGrid   = makeCmapGrid();
+    t_iparams        cmapParams = { { 0 } };
+    cmapParams.cmap.cmapA       = 0;
+    const int numAtoms          = c_numCmapTerms + 4;
+
+    std::vector<t_iatom> iatoms;
+    for (int t = 0; t < c_numCmapTerms; t++)
+    {
+        iatoms.insert(iatoms.end(), { 0, t, t + 1, t + 2, t + 3, t + 4 });
+    }
+    // A distorted helix, such that the dihedral angles cover a range of grid cells.
+    // SIMD kernels can load one element beyond the coordinates of the last atom.
+    std::vector<gmx::RVec> x;
+    for (int a = 0; a < numAtoms; a++)
+    {
+        x.emplace_back(0.1 * a, 0.15 * std::sin(1.7 * a), 0.13 * std::cos(1.1 * a));
+    }
+    x.emplace_back(0, 0, 0);
+    matrix box;
+    clear_mat(box);
+    box[XX][XX] = box[YY][YY] = box[ZZ][ZZ] = 1.5;
+
+    for (const int epbc : c_pbcForTests)
+    {
+        SCOPED_TRACE(std::string("Testing PBC ") + epbc_names[epbc]);
+        t_pbc pbc;
+        set_pbc(&pbc, epbc, box);
+
+        // Forces, aligned as the SIMD kernels require
+        std::vector<real, AlignedAllocator<real>> reference(4 * numAtoms);
+        rvec fshift[N_IVEC] = { { 0 } };
+        real dvdlambda      = 0;
+        cmap_dihs(iatoms.size(), iatoms.data(), &cmapParams, &cmapGrid, as_rvec_array(x.data()),
+                  reinterpret_cast<rvec4*>(reference.data()), fshift, &pbc, nullptr, 0, &dvdlambda,
+                  nullptr, nullptr, nullptr, BondedKernelFlavor::ForcesAndVirialAndEnergy);
+        real forceMagnitude = 1;
+        for (const real fComponent : reference)
+        {
+            forceMagnitude = std::max(forceMagnitude, std::abs(fComponent));
+        }
+        const test::FloatingPointTolerance tolerance =
+                test::relativeToleranceAsPrecisionDependentFloatingPoint(forceMagnitude, 1e-5,
+                                                                         1e-10);
+
+        for (const auto flavor :
+             { BondedKernelFlavor::ForcesSimdWhenAvailable, BondedKernelFlavor::ForcesNoSimd })
+        {
+            SCOPED_TRACE(std::string("Testing flavor ")
+                         + (flavor == BondedKernelFlavor::ForcesSimdWhenAvailable
+                                    ? "ForcesSimdWhenAvailable"
+                                    : "ForcesNoSimd"));
+            std::vector<real, AlignedAllocator<real>> f(4 * numAtoms);
+            cmap_dihs(iatoms.size(), iatoms.data(), &cmapParams, &cmapGrid, as_rvec_array(x.data()),
+                      reinterpret_cast<rvec4*>(f.data()), fshift, &pbc, nullptr, 0, &dvdlambda,
+                      nullptr, nullptr, nullptr, flavor);
+            for (int a = 0; a < numAtoms; a++)
+            {
+                for (int d = 0; d < DIM; d++)
+                {
+                    EXPECT_REAL_EQ_TOL(reference[4 * a + d], f[4 * a + d], tolerance)
+                            << "for atom " << a << " dimension " << d;
+                }
+            }
+        }
+    }
+}
+
 } // namespace
 
 } // namespace gmx
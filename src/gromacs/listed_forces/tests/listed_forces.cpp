@@ -0,0 +1,309 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests that the multi-threaded listed-force calculation and its
+ * thread-force reduction give the same output as a single thread.
+ *
+ * \ingroup module_listed_forces
+ */
+#include "gmxpre.h"
+
+#include "gromacs/listed_forces/listed_forces.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/listed_forces/manage_threading.h"
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/units.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/fcdata.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/simulation_workload.h"
+#include "gromacs/pbcutil/ishift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+namespace
+{
+
+/*! \brief Number of atoms in the test chain
+ *
+ * This spans several reduction blocks of 32 atoms and ends with
+ * a partially filled block.
+ */
+constexpr int c_numAtoms = 200;
+
+//! The output of calc_listed that should not depend on the number of threads
+struct ListedOutput
+{
+    //! The forces on all atoms
+    std::vector<RVec> forces;
+    //! The shift forces
+    std::vector<RVec> shiftForces;
+    //! The energy terms
+    std::array<real, F_NRE> energies;
+};
+
+/*! \brief A helical chain with bonds, angles and dihedrals along the chain
+ * and harmonic cross-links between atoms far apart along the chain
+ *
+ * The cross-links give every thread contributions to atoms in reduction
+ * blocks that are owned by other threads.
+ */
+class ThreadingTestSystem
+{
+public:
+    ThreadingTestSystem() : x_(c_numAtoms), idef_()
+    {
+        for (int a = 0; a < c_numAtoms; a++)
+        {
+            const real phi = a * 100 * DEG2RAD;
+            x_[a] = { 0.25_real * std::cos(phi), 0.25_real * std::sin(phi), 0.06_real * a };
+        }
+
+        t_iparams bondParams;
+        bondParams.harmonic = { 0.38, 1e4, 0.38, 1e4 };
+        t_iparams crossLinkParams;
+        crossLinkParams.harmonic = { 0.8, 500, 0.8, 500 };
+        t_iparams angleParams;
+        angleParams.harmonic = { 110, 300, 110, 300 };
+        t_iparams dihedralParams;
+        dihedralParams.pdihs = { 0, 5, 3, 0, 5 };
+        iparams_             = { bondParams, crossLinkParams, angleParams, dihedralParams };
+
+        for (int a = 0; a + 1 < c_numAtoms; a++)
+        {
+            addInteraction(F_BONDS, { 0, a, a + 1 });
+        }
+        for (int a = 0; a < c_numAtoms; a += 4)
+        {
+            const int partner = (a * 37 + 11) % c_numAtoms;
+            if (partner != a)
+            {
+                addInteraction(F_HARMONIC, { 1, a, partner });
+            }
+        }
+        for (int a = 0; a + 2 < c_numAtoms; a++)
+        {
+            addInteraction(F_ANGLES, { 2, a, a + 1, a + 2 });
+        }
+        for (int a = 0; a + 3 < c_numAtoms; a++)
+        {
+            addInteraction(F_PDIHS, { 3, a, a + 1, a + 2, a + 3 });
+        }
+
+        idef_.ntypes  = iparams_.size();
+        idef_.iparams = iparams_.data();
+        idef_.ilsort  = ilsortNO_FE;
+        for (int ftype = 0; ftype < F_NRE; ftype++)
+        {
+            idef_.il[ftype].nr              = iatoms_[ftype].size();
+            idef_.il[ftype].nr_nonperturbed = iatoms_[ftype].size();
+            idef_.il[ftype].iatoms          = iatoms_[ftype].data();
+        }
+    }
+
+    //! Returns the coordinates
+    const std::vector<RVec>& x() const { return x_; }
+    //! Returns the interaction definitions
+    const t_idef& idef() const { return idef_; }
+
+private:
+    //! Appends the interaction type and atoms in \p iatoms to the list for \p ftype
+    void addInteraction(int ftype, std::initializer_list<t_iatom> iatoms)
+    {
+        iatoms_[ftype].insert(iatoms_[ftype].end(), iatoms);
+    }
+
+    //! The coordinates
+    std::vector<RVec> x_;
+    //! The interaction parameters
+    std::vector<t_iparams> iparams_;
+    //! The interaction lists, the storage idef_ refers to
+    std::array<std::vector<t_iatom>, F_NRE> iatoms_;
+    //! The interaction definitions
+    t_idef idef_;
+};
+
+/*! \brief Returns the output of calc_listed for \p system using \p numThreads threads
+ *
+ * The bonded thread count is restored afterwards.
+ */
+ListedOutput computeListedOutput(const ThreadingTestSystem& system,
+                                 const int                  numThreads,
+                                 const bool                 computeEnergyAndVirial)
+{
+    const int numBondedThreadsSaved = gmx_omp_nthreads_get(emntBonded);
+    gmx_omp_nthreads_set(emntBonded, numThreads);
+
+    t_forcerec fr;
+    fr.ePBC             = epbcNONE;
+    fr.bMolPBC          = FALSE;
+    fr.use_simd_kernels = TRUE;
+    fr.natoms_force     = c_numAtoms;
+    fr.bondedThreading  = init_bonded_threading(nullptr, 1);
+    setup_bonded_threading(fr.bondedThreading, c_numAtoms, false, system.idef());
+
+    PaddedVector<RVec> forces(c_numAtoms, { 0, 0, 0 });
+    std::vector<RVec>  shiftForces(SHIFTS, { 0, 0, 0 });
+    ForceOutputs       forceOutputs(
+            ForceWithShiftForces(forces.arrayRefWithPadding(), computeEnergyAndVirial, shiftForces),
+            ForceWithVirial(forces.arrayRefWithPadding().unpaddedArrayRef(), computeEnergyAndVirial));
+
+    StepWorkload stepWork;
+    stepWork.computeForces = true;
+    stepWork.computeVirial = computeEnergyAndVirial;
+    stepWork.computeEnergy = computeEnergyAndVirial;
+
+    gmx_enerdata_t enerd(1, 0);
+    t_nrnb         nrnb           = {};
+    t_fcdata       fcd            = {};
+    t_mdatoms      mdatoms        = { 0 };
+    real           lambda[efptNR] = { 0 };
+
+    calc_listed(nullptr, nullptr, nullptr, &system.idef(), as_rvec_array(system.x().data()),
+                nullptr, &forceOutputs, &fr, nullptr, nullptr, nullptr, &enerd, &nrnb, lambda,
+                &mdatoms, &fcd, nullptr, stepWork);
+
+    tear_down_bonded_threading(fr.bondedThreading);
+    fr.bondedThreading = nullptr;
+    gmx_omp_nthreads_set(emntBonded, numBondedThreadsSaved);
+
+    ListedOutput output;
+    output.forces.assign(forces.begin(), forces.end());
+    output.shiftForces = shiftForces;
+    std::copy(std::begin(enerd.term), std::end(enerd.term), output.energies.begin());
+
+    return output;
+}
+
+//! Returns the largest absolute force component in \p forces
+real maxAbsoluteComponent(const std::vector<RVec>& forces)
+{
+    real maxComponent = 0;
+    for (const RVec& f : forces)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            maxComponent = std::max(maxComponent, std::fabs(f[d]));
+        }
+    }
+
+    return maxComponent;
+}
+
+//! Test fixture parameterized over the thread count and whether energies and virial are computed
+class ListedForcesThreadingTest : public ::testing::TestWithParam<std::tuple<int, bool>>
+{
+};
+
+TEST_P(ListedForcesThreadingTest, MatchesSingleThread)
+{
+    const int  numThreads             = std::get<0>(GetParam());
+    const bool computeEnergyAndVirial = std::get<1>(GetParam());
+
+    ThreadingTestSystem system;
+
+    const ListedOutput reference = computeListedOutput(system, 1, computeEnergyAndVirial);
+    const ListedOutput output    = computeListedOutput(system, numThreads, computeEnergyAndVirial);
+
+    // Summation order differs between thread counts, so compare with
+    // a tolerance relative to the largest force.
+    const test::FloatingPointTolerance forceTolerance =
+            test::relativeToleranceAsPrecisionDependentFloatingPoint(
+                    maxAbsoluteComponent(reference.forces), 1e-5, 1e-10);
+    ASSERT_GT(maxAbsoluteComponent(reference.forces), 0);
+    for (int a = 0; a < c_numAtoms; a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_REAL_EQ_TOL(reference.forces[a][d], output.forces[a][d], forceTolerance)
+                    << "for atom " << a << " dimension " << d;
+        }
+    }
+
+    if (computeEnergyAndVirial)
+    {
+        // Without PBC the shift forces are sums of forces that cancel,
+        // so they only differ by rounding of the force contributions.
+        for (int s = 0; s < SHIFTS; s++)
+        {
+            for (int d = 0; d < DIM; d++)
+            {
+                EXPECT_REAL_EQ_TOL(reference.shiftForces[s][d], output.shiftForces[s][d],
+                                   forceTolerance)
+                        << "for shift " << s << " dimension " << d;
+            }
+        }
+
+        for (int ftype : { F_BONDS, F_HARMONIC, F_ANGLES, F_PDIHS })
+        {
+            EXPECT_REAL_EQ_TOL(reference.energies[ftype], output.energies[ftype],
+                               test::relativeToleranceAsPrecisionDependentFloatingPoint(
+                                       reference.energies[ftype], 1e-5, 1e-10))
+                    << "for energy term " << interaction_function[ftype].longname;
+        }
+    }
+}
+
+/* Up to 4 threads the interactions are divided uniformly over the threads,
+ * with more threads they are divided by atom locality.
+ */
+INSTANTIATE_TEST_CASE_P(ThreadCounts,
+                        ListedForcesThreadingTest,
+                        ::testing::Combine(::testing::Values(2, 3, 4, 6), ::testing::Bool()));
+
+} // namespace
+
+} // namespace gmx
@@ -41,6 +41,8 @@
 #include <cmath>
 #include <cstdio>
 
+#include <algorithm>
+
 #include "gromacs/linearalgebra/nrjac.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/utilities.h"
@@ -290,6 +292,103 @@ void do_fit(int natoms, real* w_rls, const rvec* xp, rvec* x)
     do_fit_ndim(3, natoms, w_rls, xp, x);
 }
 
+real rmsdev_fit(int natoms, const real* w_rls, const rvec* xp, const rvec* x)
+{
+    /* Quaternion characteristic polynomial (QCP) method,
+     * D. L. Theobald, Acta Cryst. A61, 478 (2005).
+     * The minimal weighted sum of squared deviations is 2*(e0 - lambda),
+     * with lambda the largest eigenvalue of the 4x4 key matrix built
+     * from the weighted correlation matrix s of xp and x.
+     */
+    double s[DIM][DIM] = { { 0 } };
+    double g           = 0;
+    double tm          = 0;
+    for (int n = 0; n < natoms; n++)
+    {
+        const double w = w_rls[n];
+        if (w != 0)
+        {
+            for (int r = 0; r < DIM; r++)
+            {
+                const double xpr = xp[n][r];
+                const double xr  = x[n][r];
+                for (int c = 0; c < DIM; c++)
+                {
+                    s[r][c] += w * xpr * x[n][c];
+                }
+                g += w * (xpr * xpr + xr * xr);
+            }
+            tm += w;
+        }
+    }
+    if (tm == 0)
+    {
+        return 0;
+    }
+    const double e0 = 0.5 * g;
+
+    const double k[4][4] = {
+        { s[XX][XX] + s[YY][YY] + s[ZZ][ZZ], s[YY][ZZ] - s[ZZ][YY], s[ZZ][XX] - s[XX][ZZ],
+          s[XX][YY] - s[YY][XX] },
+        { s[YY][ZZ] - s[ZZ][YY], s[XX][XX] - s[YY][YY] - s[ZZ][ZZ], s[XX][YY] + s[YY][XX],
+          s[ZZ][XX] + s[XX][ZZ] },
+        { s[ZZ][XX] - s[XX][ZZ], s[XX][YY] + s[YY][XX], -s[XX][XX] + s[YY][YY] - s[ZZ][ZZ],
+          s[YY][ZZ] + s[ZZ][YY] },
+        { s[XX][YY] - s[YY][XX], s[ZZ][XX] + s[XX][ZZ], s[YY][ZZ] + s[ZZ][YY],
+          -s[XX][XX] - s[YY][YY] + s[ZZ][ZZ] }
+    };
+
+    /* The characteristic polynomial of k is lambda^4 + c2 lambda^2 + c1 lambda + c0 */
+    double c2 = 0;
+    for (int r = 0; r < DIM; r++)
+    {
+        for (int c = 0; c < DIM; c++)
+        {
+            c2 += s[r][c] * s[r][c];
+        }
+    }
+    c2 *= -2;
+    const double detS = s[XX][XX] * (s[YY][YY] * s[ZZ][ZZ] - s[YY][ZZ] * s[ZZ][YY])
+                        - s[XX][YY] * (s[YY][XX] * s[ZZ][ZZ] - s[YY][ZZ] * s[ZZ][XX])
+                        + s[XX][ZZ] * (s[YY][XX] * s[ZZ][YY] - s[YY][YY] * s[ZZ][XX]);
+    const double c1 = -8 * detS;
+    /* The determinant of k, expanded in the 2x2 minors of the first two rows */
+    const double m01 = k[0][0] * k[1][1] - k[1][0] * k[0][1];
+    const double m02 = k[0][0] * k[1][2] - k[1][0] * k[0][2];
+    const double m03 = k[0][0] * k[1][3] - k[1][0] * k[0][3];
+    const double m12 = k[0][1] * k[1][2] - k[1][1] * k[0][2];
+    const double m13 = k[0][1] * k[1][3] - k[1][1] * k[0][3];
+    const double m23 = k[0][2] * k[1][3] - k[1][2] * k[0][3];
+    const double n23 = k[2][2] * k[3][3] - k[3][2] * k[2][3];
+    const double n13 = k[2][1] * k[3][3] - k[3][1] * k[2][3];
+    const double n12 = k[2][1] * k[3][2] - k[3][1] * k[2][2];
+    const double n03 = k[2][0] * k[3][3] - k[3][0] * k[2][3];
+    const double n02 = k[2][0] * k[3][2] - k[3][0] * k[2][2];
+    const double n01 = k[2][0] * k[3][1] - k[3][0] * k[2][1];
+    const double c0  = m01 * n23 - m02 * n13 + m03 * n12 + m12 * n03 - m13 * n02 + m23 * n01;
+
+    /* Newton-Raphson from e0, which is an upper bound of lambda */
+    double lambda = e0;
+    for (int iter = 0; iter < 50; iter++)
+    {
+        const double l2 = lambda * lambda;
+        const double p  = (l2 + c2) * l2 + c1 * lambda + c0;
+        const double dp = 4 * l2 * lambda + 2 * c2 * lambda + c1;
+        if (dp == 0)
+        {
+            break;
+        }
+        const double delta = p / dp;
+        lambda -= delta;
+        if (std::fabs(delta) <= 1e-14 * std::fabs(lambda))
+        {
+            break;
+        }
+    }
+
+    return std::sqrt(std::max(0.0, 2 * (e0 - lambda) / tm));
+}
+
 void reset_x_ndim(int ndim, int ncm, const int* ind_cm, int nreset, const int* ind_reset, rvec x[], const real mass[])
 {
     int  i, m, ai;
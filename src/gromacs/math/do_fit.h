@@ -79,6 +79,14 @@ void do_fit_ndim(int ndim, int natoms, real* w_rls, const rvec* xp, rvec* x);
 void do_fit(int natoms, real* w_rls, const rvec* xp, rvec* x);
 /* Calls do_fit with ndim=3, thus fitting in 3D */
 
+real rmsdev_fit(int natoms, const real* w_rls, const rvec* xp, const rvec* x);
+/* Returns the RMS Deviation between x and xp after a least squares fit
+ * of x to xp, weighted with w_rls, as rmsdev would after do_fit.
+ * Uses the quaternion characteristic polynomial method, which only needs
+ * the minimal deviation and not the rotation, so x is not modified.
+ * As for do_fit, both xp and x should be centered round the origin.
+ */
+
 void reset_x_ndim(int ndim, int ncm, const int* ind_cm, int nreset, const int* ind_reset, rvec x[], const real mass[]);
 /* Put the center of mass of atoms in the origin for dimensions 0 to ndim.
  * The center of mass is computed from the index ind_cm.
@@ -99,4 +99,27 @@ TEST_F(StructureSimilarityTest, YieldsCorrectRhoWidthIndex)
     EXPECT_REAL_EQ_TOL(2., rhodev_ind(index_.size(), index_.data(), m_, x1_, x2_), defaultRealTolerance());
 }
 
+TEST_F(StructureSimilarityTest, RotatedStructureHasZeroRMSDAfterFit)
+{
+    reset_x(c_nAtoms, nullptr, c_nAtoms, nullptr, x1_, m_);
+    reset_x(c_nAtoms, nullptr, c_nAtoms, nullptr, x2_, m_);
+    // Structure B is structure A rotated by 120 degrees around (1,1,1)
+    EXPECT_REAL_EQ_TOL(0., rmsdev_fit(c_nAtoms, m_, x1_, x2_), gmx::test::absoluteTolerance(1e-5));
+}
+
+TEST_F(StructureSimilarityTest, RMSDAfterFitMatchesFittedRMSD)
+{
+    std::array<RVec, c_nAtoms> structureC{
+        { { 0.1, 1, 0.3 }, { -0.2, 0.2, 1 }, { 1, 0.4, -0.1 }, { 0.5, 0, 0 } }
+    };
+    rvec* x3 = gmx::as_rvec_array(structureC.data());
+    reset_x(c_nAtoms, nullptr, c_nAtoms, nullptr, x1_, m_);
+    reset_x(c_nAtoms, nullptr, c_nAtoms, nullptr, x3, m_);
+    const real rmsdAfterFit = rmsdev_fit(c_nAtoms, m_, x1_, x3);
+    do_fit(c_nAtoms, m_, x1_, x3);
+    const real rmsdFitted = rmsdev(c_nAtoms, m_, x1_, x3);
+    EXPECT_GT(rmsdFitted, 0.1);
+    EXPECT_REAL_EQ_TOL(rmsdFitted, rmsdAfterFit, gmx::test::absoluteTolerance(1e-5));
+}
+
 } // namespace
@@ -116,6 +116,7 @@ void do_force_lowlevel(t_forcerec*                         fr,
                        const t_graph*                      graph,
                        const rvec*                         mu_tot,
                        const gmx::StepWorkload&            stepWork,
+                       bool                                startHaloForceExchange,
                        const DDBalanceRegionHandler&       ddBalanceRegionHandler)
 {
     // TODO: Replace all uses of x by const coordinates
@@ -185,6 +186,16 @@ void do_force_lowlevel(t_forcerec*                         fr,
                         DOMAINDECOMP(cr) ? cr->dd->globalAtomIndices.data() : nullptr, stepWork);
     }
 
+    if (startHaloForceExchange)
+    {
+        /* All forces on non-home atoms are now computed, the long-range
+         * work below only contributes to home atoms.
+         */
+        wallcycle_stop(wcycle, ewcFORCE);
+        dd_move_f_begin(cr->dd, &forceOutputs->forceWithShiftForces(), wcycle);
+        wallcycle_start_nocount(wcycle, ewcFORCE);
+    }
+
     const bool computePmeOnCpu = (EEL_PME(fr->ic->eeltype) || EVDW_PME(fr->ic->vdwtype))
                                  && thisRankHasDuty(cr, DUTY_PME)
                                  && (pme_run_mode(fr->pmedata) == PmeRunMode::CPU);
@@ -132,6 +132,7 @@ void do_force_lowlevel(t_forcerec*                         fr,
                        const t_graph*                      graph,
                        const rvec*                         mu_tot,
                        const gmx::StepWorkload&            stepWork,
+                       bool                                startHaloForceExchange,
                        const DDBalanceRegionHandler&       ddBalanceRegionHandler);
 /* Call all the force routines */
 
@@ -76,14 +76,16 @@ static const char* modth_env_var[emntNR] = { "GMX_DEFAULT_NUM_THREADS should nev
                                              "GMX_UPDATE_NUM_THREADS",
                                              "GMX_VSITE_NUM_THREADS",
                                              "GMX_LINCS_NUM_THREADS",
-                                             "GMX_SETTLE_NUM_THREADS" };
+                                             "GMX_SETTLE_NUM_THREADS",
+                                             "GMX_SHAKE_NUM_THREADS" };
 
 /** Names of the modules. */
 static const char* mod_name[emntNR] = { "default",     "domain decomposition",
                                         "pair search", "non-bonded",
                                         "bonded",      "PME",
-                                        "update",      "LINCS",
-                                        "SETTLE" };
+                                        "update",      "virtual sites",
+                                        "LINCS",       "SETTLE",
+                                        "SHAKE" };
 
 /** Number of threads for each algorithmic module.
  *
@@ -338,6 +340,7 @@ static void manage_number_of_openmp_threads(const gmx::MDLogger& mdlog,
     pick_module_nthreads(mdlog, emntVSITE, bSepPME);
     pick_module_nthreads(mdlog, emntLINCS, bSepPME);
     pick_module_nthreads(mdlog, emntSETTLE, bSepPME);
+    pick_module_nthreads(mdlog, emntSHAKE, bSepPME);
 
     /* set the number of threads globally */
     if (bOMP)
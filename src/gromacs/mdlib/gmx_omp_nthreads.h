@@ -62,6 +62,7 @@ typedef enum module_nth
     emntVSITE,
     emntLINCS,
     emntSETTLE,
+    emntSHAKE,
     emntNR
 } module_nth_t;
 
@@ -36,6 +36,10 @@
 
 #include "mdoutf.h"
 
+#include <cstdlib>
+
+#include <exception>
+
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/collect.h"
 #include "gromacs/domdec/domdec_struct.h"
@@ -47,6 +51,7 @@
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/trajectory_writing.h"
+#include "gromacs/mdlib/trajectorywriterthread.h"
 #include "gromacs/mdrunutility/handlerestart.h"
 #include "gromacs/mdrunutility/multisim.h"
 #include "gromacs/mdtypes/commrec.h"
@@ -57,6 +62,7 @@
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/topology.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/smalloc.h"
@@ -85,9 +91,86 @@ struct gmx_mdoutf
     const gmx::MdModulesNotifier* mdModulesNotifier;
     bool                          simulationsShareState;
     MPI_Comm                      mpiCommMasters;
+    /* Writes TRR and XTC frames in the background, nullptr when writing inline */
+    gmx::TrajectoryWriterThread* writerThread;
 };
 
 
+//! Error message for failing to write or flush a frame to the TRR file
+static const char* const c_trrWriteError =
+        "Cannot write trajectory; maybe you are out of disk space?";
+
+//! Error message for failing to write a frame to the XTC file
+static const char* const c_xtcWriteError =
+        "XTC error. This indicates you are out of disk space, or a "
+        "simulation with major instabilities resulting in coordinates "
+        "that are NaN or too large to be represented in the XTC format.";
+
+/*! \brief Writes a frame to the full-precision TRR file and flushes it
+ *
+ * \returns whether writing and flushing succeeded.
+ */
+static bool write_trr_frame(gmx_mdoutf_t of,
+                            int64_t      step,
+                            double       t,
+                            real         lambda,
+                            const rvec*  box,
+                            int          natoms,
+                            const rvec*  x,
+                            const rvec*  v,
+                            const rvec*  f)
+{
+    return gmx_trr_try_write_frame(of->fp_trn, step, t, lambda, box, natoms, x, v, f)
+           && gmx_fio_flush(of->fp_trn) == 0;
+}
+
+/*! \brief Writes a frame to the compressed XTC file
+ *
+ * \returns whether writing succeeded.
+ */
+static bool write_xtc_frame(gmx_mdoutf_t of, int64_t step, double t, const rvec* box, const rvec* xxtc)
+{
+    return write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, box, xxtc,
+                     of->x_compression_precision)
+           != 0;
+}
+
+/*! \brief Writes a frame handed off to the writer thread
+ *
+ * Write errors are thrown as FileIOError, so that the writer thread can
+ * pass them on to the MD thread, instead of terminating the program.
+ */
+static void write_output_frame(gmx_mdoutf_t of, const gmx::TrajectoryOutputFrame& frame)
+{
+    if (frame.writeFullPrecision
+        && !write_trr_frame(of, frame.step, frame.time, frame.lambda, frame.box, frame.natoms,
+                            frame.x.empty() ? nullptr : as_rvec_array(frame.x.data()),
+                            frame.v.empty() ? nullptr : as_rvec_array(frame.v.data()),
+                            frame.f.empty() ? nullptr : as_rvec_array(frame.f.data())))
+    {
+        GMX_THROW(gmx::FileIOError(c_trrWriteError));
+    }
+    if (frame.writeCompressed
+        && !write_xtc_frame(of, frame.step, frame.time, frame.box,
+                            as_rvec_array(frame.xCompressed.data())))
+    {
+        GMX_THROW(gmx::FileIOError(c_xtcWriteError));
+    }
+}
+
+/*! \brief Copies \p n vectors from \p src to \p dest, or clears \p dest when \p src is nullptr */
+static void copy_output_vectors(const rvec* src, int n, std::vector<gmx::RVec>* dest)
+{
+    if (src == nullptr)
+    {
+        dest->clear();
+    }
+    else
+    {
+        dest->assign(src, src + n);
+    }
+}
+
 gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
                          int                           nfile,
                          const t_filenm                fnm[],
@@ -117,6 +200,7 @@ gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
     of->tng          = nullptr;
     of->tng_low_prec = nullptr;
     of->fp_dhdl      = nullptr;
+    of->writerThread = nullptr;
 
     of->eIntegrator             = ir->eI;
     of->bExpanded               = ir->bExpanded;
@@ -229,6 +313,17 @@ gmx_mdoutf_t init_mdoutf(FILE*                         fplog,
         {
             snew(of->f_global, top_global->natoms);
         }
+
+        /* Compress and write TRR and XTC frames on a separate thread,
+         * so the MD loop only needs to copy the output data.
+         * TNG output is always written inline.
+         */
+        if ((of->fp_trn || of->fp_xtc) && !of->tng && !of->tng_low_prec
+            && getenv("GMX_NO_ASYNC_TRAJECTORY_OUTPUT") == nullptr)
+        {
+            of->writerThread = new gmx::TrajectoryWriterThread(
+                    [of](const gmx::TrajectoryOutputFrame& frame) { write_output_frame(of, frame); });
+        }
     }
 
     if (bCiteTng)
@@ -306,6 +401,13 @@ void mdoutf_write_to_trajectory_files(FILE*                    fplog,
     {
         if (mdof_flags & MDOF_CPT)
         {
+            if (of->writerThread)
+            {
+                /* The checkpoint stores the output file positions,
+                 * so all frames submitted so far need to be written.
+                 */
+                of->writerThread->waitUntilIdle();
+            }
             fflush_tng(of->tng);
             fflush_tng(of->tng_low_prec);
             /* Write the checkpoint file.
@@ -322,78 +424,115 @@ void mdoutf_write_to_trajectory_files(FILE*                    fplog,
                              of->simulationsShareState, of->mpiCommMasters);
         }
 
-        if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
+        if (of->writerThread && (mdof_flags & (MDOF_X | MDOF_V | MDOF_F | MDOF_X_COMPRESSED)))
         {
-            const rvec* x = (mdof_flags & MDOF_X) ? state_global->x.rvec_array() : nullptr;
-            const rvec* v = (mdof_flags & MDOF_V) ? state_global->v.rvec_array() : nullptr;
-            const rvec* f = (mdof_flags & MDOF_F) ? f_global : nullptr;
-
-            if (of->fp_trn)
-            {
-                gmx_trr_write_frame(of->fp_trn, step, t, state_local->lambda[efptFEP],
-                                    state_local->box, natoms, x, v, f);
-                if (gmx_fio_flush(of->fp_trn) != 0)
-                {
-                    gmx_file("Cannot write trajectory; maybe you are out of disk space?");
-                }
-            }
-
-            /* If a TNG file is open for uncompressed coordinate output also write
-               velocities and forces to it. */
-            else if (of->tng)
+            /* Hand off copies of the data to the writer thread */
+            gmx::TrajectoryOutputFrame* frame = of->writerThread->frameToFill();
+            frame->step                       = step;
+            frame->time                       = t;
+            frame->lambda                     = state_local->lambda[efptFEP];
+            copy_mat(state_local->box, frame->box);
+            frame->natoms             = natoms;
+            frame->writeFullPrecision = (of->fp_trn && (mdof_flags & (MDOF_X | MDOF_V | MDOF_F)));
+            frame->writeCompressed    = ((mdof_flags & MDOF_X_COMPRESSED) != 0);
+            if (frame->writeFullPrecision)
             {
-                gmx_fwrite_tng(of->tng, FALSE, step, t, state_local->lambda[efptFEP],
-                               state_local->box, natoms, x, v, f);
+                copy_output_vectors((mdof_flags & MDOF_X) ? state_global->x.rvec_array() : nullptr,
+                                    natoms, &frame->x);
+                copy_output_vectors((mdof_flags & MDOF_V) ? state_global->v.rvec_array() : nullptr,
+                                    natoms, &frame->v);
+                copy_output_vectors((mdof_flags & MDOF_F) ? f_global : nullptr, natoms, &frame->f);
             }
-            /* If only a TNG file is open for compressed coordinate output (no uncompressed
-               coordinate output) also write forces and velocities to it. */
-            else if (of->tng_low_prec)
+            if (frame->writeCompressed)
             {
-                gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, state_local->lambda[efptFEP],
-                               state_local->box, natoms, x, v, f);
+                auto x = makeArrayRef(state_global->x);
+                if (of->natoms_x_compressed == of->natoms_global)
+                {
+                    frame->xCompressed.assign(x.begin(), x.begin() + of->natoms_global);
+                }
+                else
+                {
+                    frame->xCompressed.clear();
+                    for (int i = 0; i < of->natoms_global; i++)
+                    {
+                        if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
+                        {
+                            frame->xCompressed.push_back(x[i]);
+                        }
+                    }
+                }
             }
+            of->writerThread->submitFrame();
         }
-        if (mdof_flags & MDOF_X_COMPRESSED)
+        else
         {
-            rvec* xxtc = nullptr;
-
-            if (of->natoms_x_compressed == of->natoms_global)
+            if (mdof_flags & (MDOF_X | MDOF_V | MDOF_F))
             {
-                /* We are writing the positions of all of the atoms to
-                   the compressed output */
-                xxtc = state_global->x.rvec_array();
-            }
-            else
-            {
-                /* We are writing the positions of only a subset of
-                   the atoms to the compressed output, so we have to
-                   make a copy of the subset of coordinates. */
-                int i, j;
+                const rvec* x = (mdof_flags & MDOF_X) ? state_global->x.rvec_array() : nullptr;
+                const rvec* v = (mdof_flags & MDOF_V) ? state_global->v.rvec_array() : nullptr;
+                const rvec* f = (mdof_flags & MDOF_F) ? f_global : nullptr;
 
-                snew(xxtc, of->natoms_x_compressed);
-                auto x = makeArrayRef(state_global->x);
-                for (i = 0, j = 0; (i < of->natoms_global); i++)
+                if (of->fp_trn)
                 {
-                    if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
+                    if (!write_trr_frame(of, step, t, state_local->lambda[efptFEP],
+                                         state_local->box, natoms, x, v, f))
                     {
-                        copy_rvec(x[i], xxtc[j++]);
+                        gmx_file(c_trrWriteError);
                     }
                 }
+
+                /* If a TNG file is open for uncompressed coordinate output also write
+                   velocities and forces to it. */
+                else if (of->tng)
+                {
+                    gmx_fwrite_tng(of->tng, FALSE, step, t, state_local->lambda[efptFEP],
+                                   state_local->box, natoms, x, v, f);
+                }
+                /* If only a TNG file is open for compressed coordinate output (no uncompressed
+                   coordinate output) also write forces and velocities to it. */
+                else if (of->tng_low_prec)
+                {
+                    gmx_fwrite_tng(of->tng_low_prec, FALSE, step, t, state_local->lambda[efptFEP],
+                                   state_local->box, natoms, x, v, f);
+                }
             }
-            if (write_xtc(of->fp_xtc, of->natoms_x_compressed, step, t, state_local->box, xxtc,
-                          of->x_compression_precision)
-                == 0)
-            {
-                gmx_fatal(FARGS,
-                          "XTC error. This indicates you are out of disk space, or a "
-                          "simulation with major instabilities resulting in coordinates "
-                          "that are NaN or too large to be represented in the XTC format.\n");
-            }
-            gmx_fwrite_tng(of->tng_low_prec, TRUE, step, t, state_local->lambda[efptFEP],
-                           state_local->box, of->natoms_x_compressed, xxtc, nullptr, nullptr);
-            if (of->natoms_x_compressed != of->natoms_global)
+            if (mdof_flags & MDOF_X_COMPRESSED)
             {
-                sfree(xxtc);
+                rvec* xxtc = nullptr;
+
+                if (of->natoms_x_compressed == of->natoms_global)
+                {
+                    /* We are writing the positions of all of the atoms to
+                       the compressed output */
+                    xxtc = state_global->x.rvec_array();
+                }
+                else
+                {
+                    /* We are writing the positions of only a subset of
+                       the atoms to the compressed output, so we have to
+                       make a copy of the subset of coordinates. */
+                    int i, j;
+
+                    snew(xxtc, of->natoms_x_compressed);
+                    auto x = makeArrayRef(state_global->x);
+                    for (i = 0, j = 0; (i < of->natoms_global); i++)
+                    {
+                        if (getGroupType(*of->groups, SimulationAtomGroupType::CompressedPositionOutput, i) == 0)
+                        {
+                            copy_rvec(x[i], xxtc[j++]);
+                        }
+                    }
+                }
+                if (!write_xtc_frame(of, step, t, state_local->box, xxtc))
+                {
+                    gmx_fatal(FARGS, "%s", c_xtcWriteError);
+                }
+                gmx_fwrite_tng(of->tng_low_prec, TRUE, step, t, state_local->lambda[efptFEP],
+                               state_local->box, of->natoms_x_compressed, xxtc, nullptr, nullptr);
+                if (of->natoms_x_compressed != of->natoms_global)
+                {
+                    sfree(xxtc);
+                }
             }
         }
         if (mdof_flags & (MDOF_BOX | MDOF_LAMBDA) && !(mdof_flags & (MDOF_X | MDOF_V | MDOF_F)))
@@ -448,6 +587,20 @@ void mdoutf_tng_close(gmx_mdoutf_t of)
 
 void done_mdoutf(gmx_mdoutf_t of)
 {
+    /* A write error of the last frames is rethrown after all files are closed */
+    std::exception_ptr writeError;
+    if (of->writerThread)
+    {
+        try
+        {
+            of->writerThread->waitUntilIdle();
+        }
+        catch (...)
+        {
+            writeError = std::current_exception();
+        }
+        delete of->writerThread;
+    }
     if (of->fp_ene != nullptr)
     {
         done_ener_file(of->fp_ene);
@@ -474,6 +627,11 @@ void done_mdoutf(gmx_mdoutf_t of)
     gmx_tng_close(&of->tng_low_prec);
 
     sfree(of);
+
+    if (writeError)
+    {
+        std::rethrow_exception(writeError);
+    }
 }
 
 int mdoutf_get_tng_box_output_interval(gmx_mdoutf_t of)
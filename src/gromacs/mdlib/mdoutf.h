@@ -98,7 +98,11 @@ gmx_wallcycle_t mdoutf_get_wcycle(gmx_mdoutf_t of);
  */
 void mdoutf_tng_close(gmx_mdoutf_t of);
 
-/*! \brief Close all open output files and free the of pointer */
+/*! \brief Close all open output files and free the of pointer
+ *
+ * \throws FileIOError when the writer thread failed to write the last
+ * frames. This is thrown after all files have been closed.
+ */
 void done_mdoutf(gmx_mdoutf_t of);
 
 /*! \brief Routine that writes trajectory-like frames.
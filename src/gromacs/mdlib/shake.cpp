@@ -55,11 +55,13 @@
 #include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/constr.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdlib/splitter.h"
 #include "gromacs/mdtypes/inputrec.h"
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/mdtypes/mdatom.h"
 #include "gromacs/topology/invblock.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -80,6 +82,10 @@ struct shakedata
     int  nblocks;       /* The number of SHAKE blocks         */
     int* sblock;        /* The SHAKE blocks                   */
     int  sblock_nalloc; /* The allocation size of sblock      */
+    /* Thread parallelization */
+    int     nthreads;          /* The number of threads used for SHAKE          */
+    int*    thread_sblock;     /* The first SHAKE block of each thread, size nthreads+1 */
+    tensor* thread_vir_r_m_dr; /* Constraint virial for threads other than 0   */
     /*! \brief Scaled Lagrange multiplier for each constraint.
      *
      * Value is -2 * eta from p. 336 of the paper, divided by the
@@ -105,6 +111,11 @@ shakedata* shake_init()
     d->omega = 1.0;
     d->gamma = 1000000;
 
+    /* The SHAKE blocks are independent, so they can be distributed over threads */
+    d->nthreads = gmx_omp_nthreads_get(emntSHAKE);
+    snew(d->thread_sblock, d->nthreads + 1);
+    snew(d->thread_vir_r_m_dr, d->nthreads);
+
     return d;
 }
 
@@ -116,6 +127,8 @@ void done_shake(shakedata* d)
     sfree(d->constraint_distance_squared);
     sfree(d->sblock);
     sfree(d->scaled_lagrange_multiplier);
+    sfree(d->thread_sblock);
+    sfree(d->thread_vir_r_m_dr);
     sfree(d);
 }
 
@@ -168,14 +181,45 @@ static void pr_sortblock(FILE* fp, const char* title, int nsb, t_sortblock sb[])
     }
 }
 
-//! Reallocates a vector.
-static void resizeLagrangianData(shakedata* shaked, int ncons)
+//! Reallocates the per-constraint data.
+static void resizeConstraintData(shakedata* shaked, int ncons)
 {
     if (ncons > shaked->lagr_nalloc)
     {
         shaked->lagr_nalloc = over_alloc_dd(ncons);
         srenew(shaked->scaled_lagrange_multiplier, shaked->lagr_nalloc);
     }
+    if (ncons > shaked->nalloc)
+    {
+        shaked->nalloc = over_alloc_dd(ncons);
+        srenew(shaked->rij, shaked->nalloc);
+        srenew(shaked->half_of_reduced_mass, shaked->nalloc);
+        srenew(shaked->distance_squared_tolerance, shaked->nalloc);
+        srenew(shaked->constraint_distance_squared, shaked->nalloc);
+    }
+}
+
+/*! \brief Distributes the SHAKE blocks over the threads.
+ *
+ * Each thread gets a contiguous range of blocks with roughly the same
+ * number of constraints. As constraints in different blocks do not
+ * share atoms, no synchronization is needed between the threads.
+ */
+static void setThreadBlockRanges(shakedata* shaked, int ncons)
+{
+    int block                = 0;
+    shaked->thread_sblock[0] = 0;
+    for (int th = 1; th < shaked->nthreads; th++)
+    {
+        /* Start at the first block beyond the constraints of the earlier threads */
+        const int firstConstraint = (ncons * th) / shaked->nthreads;
+        while (block < shaked->nblocks && shaked->sblock[block] < 3 * firstConstraint)
+        {
+            block++;
+        }
+        shaked->thread_sblock[th] = block;
+    }
+    shaked->thread_sblock[shaked->nthreads] = shaked->nblocks;
 }
 
 void make_shake_sblock_serial(shakedata* shaked, const t_idef* idef, const t_mdatoms& md)
@@ -282,7 +326,8 @@ void make_shake_sblock_serial(shakedata* shaked, const t_idef* idef, const t_mda
     }
     sfree(sb);
     sfree(inv_sblock);
-    resizeLagrangianData(shaked, ncons);
+    resizeConstraintData(shaked, ncons);
+    setThreadBlockRanges(shaked, ncons);
 }
 
 // TODO: Check if this code is useful. It might never be called.
@@ -314,7 +359,8 @@ void make_shake_sblock_dd(shakedata* shaked, const t_ilist* ilcon, const gmx_dom
         iatom += 3;
     }
     shaked->sblock[shaked->nblocks] = 3 * ncons;
-    resizeLagrangianData(shaked, ncons);
+    resizeConstraintData(shaked, ncons);
+    setThreadBlockRanges(shaked, ncons);
 }
 
 /*! \brief Inner kernel for SHAKE constraints
@@ -536,9 +582,13 @@ static void crattle(const int  iatom[],
     *nerror = error;
 }
 
-//! Applies SHAKE
+/*! \brief Applies SHAKE to a single block of constraints.
+ *
+ * \p firstConstraint is the index of the first constraint of the block,
+ * which is used to find the block in the per-constraint work arrays. */
 static int vec_shakef(FILE*              fplog,
                       shakedata*         shaked,
+                      int                firstConstraint,
                       const real         invmass[],
                       int                ncon,
                       t_iparams          ip[],
@@ -566,18 +616,11 @@ static int vec_shakef(FILE*              fplog,
     int      error = 0;
     real     constraint_distance;
 
-    if (ncon > shaked->nalloc)
-    {
-        shaked->nalloc = over_alloc_dd(ncon);
-        srenew(shaked->rij, shaked->nalloc);
-        srenew(shaked->half_of_reduced_mass, shaked->nalloc);
-        srenew(shaked->distance_squared_tolerance, shaked->nalloc);
-        srenew(shaked->constraint_distance_squared, shaked->nalloc);
-    }
-    rij                         = shaked->rij;
-    half_of_reduced_mass        = shaked->half_of_reduced_mass;
-    distance_squared_tolerance  = shaked->distance_squared_tolerance;
-    constraint_distance_squared = shaked->constraint_distance_squared;
+    GMX_ASSERT(firstConstraint + ncon <= shaked->nalloc, "The work arrays should be large enough");
+    rij                         = shaked->rij + firstConstraint;
+    half_of_reduced_mass        = shaked->half_of_reduced_mass + firstConstraint;
+    distance_squared_tolerance  = shaked->distance_squared_tolerance + firstConstraint;
+    constraint_distance_squared = shaked->constraint_distance_squared + firstConstraint;
 
     L1 = 1.0 - lambda;
     ia = iatom;
@@ -767,10 +810,9 @@ static bool bshakef(FILE*              log,
                     bool               bDumpOnError,
                     ConstraintVariable econq)
 {
-    t_iatom* iatoms;
-    real *   lam, dt_2, dvdl;
-    int      i, n0, ncon, blen, type, ll;
-    int      tnit = 0, trij = 0;
+    real dt_2, dvdl;
+    int  ncon, type, ll;
+    int  tnit = 0, trij = 0;
 
     ncon = idef.il[F_CONSTR].nr / 3;
 
@@ -779,34 +821,63 @@ static bool bshakef(FILE*              log,
         shaked->scaled_lagrange_multiplier[ll] = 0;
     }
 
-    // TODO Rewrite this block so that it is obvious that i, iatoms
-    // and lam are all iteration variables. Is this easier if the
-    // sblock data structure is organized differently?
-    iatoms = &(idef.il[F_CONSTR].iatoms[shaked->sblock[0]]);
-    lam    = shaked->scaled_lagrange_multiplier;
-    for (i = 0; (i < shaked->nblocks);)
+    /* Each thread constrains its own range of blocks. When a block fails,
+     * the thread stops and we report the first failing block afterwards.
+     */
+    const int nthreads    = shaked->nthreads;
+    int       failedBlock = shaked->nblocks;
+#pragma omp parallel for num_threads(nthreads) schedule(static) reduction(+ : tnit, trij)
+    for (int th = 0; th < nthreads; th++)
     {
-        blen = (shaked->sblock[i + 1] - shaked->sblock[i]);
-        blen /= 3;
-        n0 = vec_shakef(log, shaked, invmass, blen, idef.iparams, iatoms, ir.shake_tol, x_s, prime,
-                        shaked->omega, ir.efep != efepNO, lambda, lam, invdt, v, bCalcVir,
-                        vir_r_m_dr, econq);
-
-        if (n0 == 0)
+        try
         {
-            if (bDumpOnError && log)
+            /* Thread 0 adds directly to the output virial, the others
+             * use their own buffer that is reduced below */
+            rvec* threadVirial = vir_r_m_dr;
+            if (th > 0)
+            {
+                threadVirial = shaked->thread_vir_r_m_dr[th];
+                clear_mat(threadVirial);
+            }
+            for (int b = shaked->thread_sblock[th]; b < shaked->thread_sblock[th + 1]; b++)
             {
+                const int c0   = shaked->sblock[b] / 3;
+                const int blen = shaked->sblock[b + 1] / 3 - c0;
+                const int n0   = vec_shakef(log, shaked, c0, invmass, blen, idef.iparams,
+                                          &idef.il[F_CONSTR].iatoms[3 * c0], ir.shake_tol, x_s,
+                                          prime, shaked->omega, ir.efep != efepNO, lambda,
+                                          &shaked->scaled_lagrange_multiplier[c0], invdt, v,
+                                          bCalcVir, threadVirial, econq);
+                if (n0 == 0)
                 {
-                    check_cons(log, blen, x_s, prime, v, idef.iparams, iatoms, invmass, econq);
+#pragma omp critical
+                    {
+                        failedBlock = std::min(failedBlock, b);
+                    }
+                    break;
                 }
+                tnit += n0 * blen;
+                trij += blen;
             }
-            return FALSE;
         }
-        tnit += n0 * blen;
-        trij += blen;
-        iatoms += 3 * blen; /* Increment pointer! */
-        lam += blen;
-        i++;
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+    if (failedBlock < shaked->nblocks)
+    {
+        if (bDumpOnError && log)
+        {
+            const int c0 = shaked->sblock[failedBlock] / 3;
+            check_cons(log, shaked->sblock[failedBlock + 1] / 3 - c0, x_s, prime, v, idef.iparams,
+                       &idef.il[F_CONSTR].iatoms[3 * c0], invmass, econq);
+        }
+        return FALSE;
+    }
+    if (bCalcVir)
+    {
+        for (int th = 1; th < nthreads; th++)
+        {
+            m_add(vir_r_m_dr, shaked->thread_vir_r_m_dr[th], vir_r_m_dr);
+        }
     }
     /* only for position part? */
     if (econq == ConstraintVariable::Positions)
@@ -1083,6 +1083,13 @@ void do_force(FILE*                               fplog,
                "Must use coordinate buffer ops with GPU halo exchange");
     const bool useGpuForcesHaloExchange =
             ddUsesGpuDirectCommunication && (useGpuFBufOps == BufferOpsUseGpu::True);
+    // With non-bonded work on the CPU, the first pulse of the CPU halo exchange
+    // can overlap with the local non-bonded work for coordinates and with
+    // long-range work for forces.
+    const bool overlapCpuHaloExchange = havePPDomainDecomposition(cr)
+                                        && ddUsesOverlappedHaloExchange(*cr->dd)
+                                        && !simulationWork.useGpuNonbonded
+                                        && !fr->nbv->emulateGpu() && !ddUsesGpuDirectCommunication;
 
     // Copy coordinate from the GPU if update is on the GPU and there
     // are forces to be computed on the CPU, or for the computation of
@@ -1326,7 +1333,15 @@ void do_force(FILE*                               fplog,
                 // a waitCoordinatesReadyOnHost() should be issued if it will be.
                 GMX_ASSERT(!simulationWork.useGpuUpdate,
                            "GPU update is not supported with CPU halo exchange");
-                dd_move_x(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+                if (overlapCpuHaloExchange)
+                {
+                    // Finished after the local non-bonded work below
+                    dd_move_x_begin(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+                }
+                else
+                {
+                    dd_move_x(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+                }
             }
 
             if (useGpuXBufOps == BufferOpsUseGpu::True)
@@ -1340,7 +1355,7 @@ void do_force(FILE*                               fplog,
                                            stateGpu->getCoordinatesReadyOnDeviceEvent(
                                                    AtomLocality::NonLocal, simulationWork, stepWork));
             }
-            else
+            else if (!overlapCpuHaloExchange)
             {
                 nbv->convertCoordinates(AtomLocality::NonLocal, false, x.unpaddedArrayRef());
             }
@@ -1479,6 +1494,17 @@ void do_force(FILE*                               fplog,
         do_nb_verlet(fr, ic, enerd, stepWork, InteractionLocality::Local, enbvClearFYes, step, nrnb, wcycle);
     }
 
+    if (overlapCpuHaloExchange && !stepWork.doNeighborSearch)
+    {
+        /* Complete the coordinate halo exchange that was in flight during
+         * the local non-bonded computation.
+         */
+        wallcycle_stop(wcycle, ewcFORCE);
+        dd_move_x_finish(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+        nbv->convertCoordinates(AtomLocality::NonLocal, false, x.unpaddedArrayRef());
+        wallcycle_start_nocount(wcycle, ewcFORCE);
+    }
+
     if (fr->efep != efepNO)
     {
         /* Calculate the local and non-local free energy interactions here.
@@ -1540,8 +1566,14 @@ void do_force(FILE*                               fplog,
         stateGpu->waitCoordinatesReadyOnHost(AtomLocality::NonLocal);
     }
     /* Compute the bonded and non-bonded energies and optionally forces */
-    do_force_lowlevel(fr, inputrec, &(top->idef), cr, ms, nrnb, wcycle, mdatoms, x, hist, &forceOut, enerd,
-                      fcd, box, lambda.data(), graph, fr->mu_tot, stepWork, ddBalanceRegionHandler);
+    /* With the CPU non-bonded path all forces on non-local atoms have
+     * been computed after the listed forces, so the force halo exchange
+     * can overlap with the long-range computation.
+     */
+    const bool startHaloForceExchange = overlapCpuHaloExchange && stepWork.computeForces;
+    do_force_lowlevel(fr, inputrec, &(top->idef), cr, ms, nrnb, wcycle, mdatoms, x, hist, &forceOut,
+                      enerd, fcd, box, lambda.data(), graph, fr->mu_tot, stepWork,
+                      startHaloForceExchange, ddBalanceRegionHandler);
 
     wallcycle_stop(wcycle, ewcFORCE);
 
@@ -1641,7 +1673,14 @@ void do_force(FILE*                               fplog,
                 {
                     stateGpu->waitForcesReadyOnHost(AtomLocality::NonLocal);
                 }
-                dd_move_f(cr->dd, &forceOut.forceWithShiftForces(), wcycle);
+                if (startHaloForceExchange)
+                {
+                    dd_move_f_finish(cr->dd, &forceOut.forceWithShiftForces(), wcycle);
+                }
+                else
+                {
+                    dd_move_f(cr->dd, &forceOut.forceWithShiftForces(), wcycle);
+                }
             }
         }
     }
@@ -77,7 +77,7 @@ namespace
  * The test will run for all possible combinations of accessible
  * values of the:
  * 1. PBC setup ("PBCNONE" or "PBCXYZ")
- * 2. The algorithm ("SHAKE", "LINCS" or "LINCS_GPU").
+ * 2. The algorithm ("SHAKE", "SHAKE_THREADS", "LINCS" or "LINCS_GPU").
  */
 typedef std::tuple<std::string, std::string> ConstraintsTestParameters;
 
@@ -88,6 +88,7 @@ std::vector<std::string> runnersNames;
 std::vector<std::string> getRunnersNames()
 {
     runnersNames.emplace_back("SHAKE");
+    runnersNames.emplace_back("SHAKE_THREADS");
     runnersNames.emplace_back("LINCS");
     if (GMX_GPU == GMX_GPU_CUDA && canComputeOnGpu())
     {
@@ -151,6 +152,8 @@ public:
         //
         // SHAKE
         algorithms_["SHAKE"] = applyShake;
+        // SHAKE with the blocks distributed over threads
+        algorithms_["SHAKE_THREADS"] = applyShakeThreads;
         // LINCS
         algorithms_["LINCS"] = applyLincs;
         // LINCS using CUDA (will only be called if CUDA is available)
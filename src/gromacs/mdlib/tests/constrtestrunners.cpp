@@ -81,13 +81,14 @@ namespace test
 {
 
 /*! \brief
- * Initialize and apply SHAKE constraints.
+ * Initialize and apply SHAKE constraints using a given number of threads.
  *
  * \param[in] testData        Test data structure.
- * \param[in] pbc             Periodic boundary data.
+ * \param[in] numThreads      Number of threads the SHAKE blocks are distributed over.
  */
-void applyShake(ConstraintsTestData* testData, t_pbc gmx_unused pbc)
+static void applyShakeWithThreads(ConstraintsTestData* testData, int numThreads)
 {
+    gmx_omp_nthreads_set(emntSHAKE, numThreads);
     shakedata* shaked = shake_init();
     make_shake_sblock_serial(shaked, &testData->idef_, testData->md_);
     bool success = constrain_shake(
@@ -100,6 +101,28 @@ void applyShake(ConstraintsTestData* testData, t_pbc gmx_unused pbc)
     done_shake(shaked);
 }
 
+/*! \brief
+ * Initialize and apply SHAKE constraints.
+ *
+ * \param[in] testData        Test data structure.
+ * \param[in] pbc             Periodic boundary data.
+ */
+void applyShake(ConstraintsTestData* testData, t_pbc gmx_unused pbc)
+{
+    applyShakeWithThreads(testData, 1);
+}
+
+/*! \brief
+ * Initialize and apply SHAKE constraints with the blocks distributed over two threads.
+ *
+ * \param[in] testData        Test data structure.
+ * \param[in] pbc             Periodic boundary data.
+ */
+void applyShakeThreads(ConstraintsTestData* testData, t_pbc gmx_unused pbc)
+{
+    applyShakeWithThreads(testData, 2);
+}
+
 /*! \brief
  * Initialize and apply LINCS constraints.
  *
@@ -58,6 +58,9 @@ namespace test
 /*! \brief Apply SHAKE constraints to the test data.
  */
 void applyShake(ConstraintsTestData* testData, t_pbc pbc);
+/*! \brief Apply SHAKE constraints to the test data, distributing the blocks over two threads.
+ */
+void applyShakeThreads(ConstraintsTestData* testData, t_pbc pbc);
 /*! \brief Apply LINCS constraints to the test data.
  */
 void applyLincs(ConstraintsTestData* testData, t_pbc pbc);
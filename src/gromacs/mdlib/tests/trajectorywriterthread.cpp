@@ -0,0 +1,112 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the background trajectory writer
+ *
+ * \ingroup module_mdlib
+ */
+#include "gmxpre.h"
+
+#include "gromacs/mdlib/trajectorywriterthread.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/exceptions.h"
+
+#include "testutils/testasserts.h"
+
+namespace gmx
+{
+
+namespace test
+{
+namespace
+{
+
+TEST(TrajectoryWriterThreadTest, WritesFramesInOrder)
+{
+    std::vector<int64_t> writtenSteps;
+    std::vector<real>    writtenX;
+    {
+        TrajectoryWriterThread writer([&writtenSteps, &writtenX](const TrajectoryOutputFrame& frame) {
+            writtenSteps.push_back(frame.step);
+            writtenX.push_back(frame.x[0][XX]);
+        });
+        for (int step = 0; step < 10; step++)
+        {
+            TrajectoryOutputFrame* frame = writer.frameToFill();
+            frame->step                  = step;
+            frame->x.assign(1, RVec(step, 0, 0));
+            writer.submitFrame();
+        }
+        writer.waitUntilIdle();
+        EXPECT_EQ(10, writtenSteps.size());
+    }
+    ASSERT_EQ(10, writtenSteps.size());
+    for (int step = 0; step < 10; step++)
+    {
+        EXPECT_EQ(step, writtenSteps[step]);
+        EXPECT_EQ(step, writtenX[step]);
+    }
+}
+
+TEST(TrajectoryWriterThreadTest, WritesPendingFrameOnDestruction)
+{
+    int writeCount = 0;
+    {
+        TrajectoryWriterThread writer([&writeCount](const TrajectoryOutputFrame& /*frame*/) {
+            writeCount++;
+        });
+        writer.submitFrame();
+    }
+    EXPECT_EQ(1, writeCount);
+}
+
+TEST(TrajectoryWriterThreadTest, RethrowsWriterExceptions)
+{
+    TrajectoryWriterThread writer([](const TrajectoryOutputFrame& /*frame*/) {
+        GMX_THROW(FileIOError("Cannot write frame"));
+    });
+    writer.submitFrame();
+    EXPECT_THROW_GMX(writer.waitUntilIdle(), FileIOError);
+    EXPECT_NO_THROW_GMX(writer.waitUntilIdle());
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,162 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Defines the background trajectory writer.
+ *
+ * \ingroup module_mdlib
+ */
+
+#include "gmxpre.h"
+
+#include "trajectorywriterthread.h"
+
+#include <utility>
+
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+
+TrajectoryWriterThread::TrajectoryWriterThread(WriteFunction writeFunction) :
+    writeFunction_(std::move(writeFunction))
+{
+    int ret = tMPI_Thread_cond_init(&condition_);
+    if (ret != 0)
+    {
+        GMX_THROW(InternalError(
+                formatString("Could not initialize a condition variable, error %d", ret)));
+    }
+    ret = tMPI_Thread_create(&thread_, &TrajectoryWriterThread::threadMain, this);
+    if (ret != 0)
+    {
+        tMPI_Thread_cond_destroy(&condition_);
+        GMX_THROW(InternalError(
+                formatString("Could not start the trajectory writer thread, error %d", ret)));
+    }
+}
+
+TrajectoryWriterThread::~TrajectoryWriterThread()
+{
+    {
+        lock_guard<Mutex> lock(mutex_);
+        stop_ = true;
+    }
+    tMPI_Thread_cond_broadcast(&condition_);
+    tMPI_Thread_join(thread_, nullptr);
+    tMPI_Thread_cond_destroy(&condition_);
+}
+
+template<typename Predicate>
+void TrajectoryWriterThread::waitFor(Predicate predicate)
+{
+    while (!predicate())
+    {
+        tMPI_Thread_cond_wait(&condition_, mutex_.native_handle());
+    }
+}
+
+void* TrajectoryWriterThread::threadMain(void* arg)
+{
+    try
+    {
+        static_cast<TrajectoryWriterThread*>(arg)->run();
+    }
+    GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    return nullptr;
+}
+
+void TrajectoryWriterThread::run()
+{
+    lock_guard<Mutex> lock(mutex_);
+    while (true)
+    {
+        waitFor([this]() { return busy_ || stop_; });
+        if (!busy_)
+        {
+            return;
+        }
+        // The caller does not touch the frame while it is being written,
+        // so the lock does not need to be held for writing.
+        const TrajectoryOutputFrame& frame = frames_[writeIndex_];
+        mutex_.unlock();
+        std::exception_ptr exception;
+        try
+        {
+            writeFunction_(frame);
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+        }
+        mutex_.lock();
+        exception_ = exception;
+        busy_      = false;
+        tMPI_Thread_cond_broadcast(&condition_);
+    }
+}
+
+void TrajectoryWriterThread::rethrowWriterException()
+{
+    if (exception_)
+    {
+        std::exception_ptr exception = exception_;
+        exception_                   = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+void TrajectoryWriterThread::submitFrame()
+{
+    {
+        lock_guard<Mutex> lock(mutex_);
+        waitFor([this]() { return !busy_; });
+        rethrowWriterException();
+        writeIndex_ = fillIndex_;
+        busy_       = true;
+    }
+    tMPI_Thread_cond_broadcast(&condition_);
+    fillIndex_ = 1 - fillIndex_;
+}
+
+void TrajectoryWriterThread::waitUntilIdle()
+{
+    lock_guard<Mutex> lock(mutex_);
+    waitFor([this]() { return !busy_; });
+    rethrowWriterException();
+}
+
+} // namespace gmx
@@ -0,0 +1,169 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \libinternal \file
+ * \brief
+ * Declares a helper class for writing trajectory frames from a background thread.
+ *
+ * \ingroup module_mdlib
+ * \inlibraryapi
+ */
+#ifndef GMX_MDLIB_TRAJECTORYWRITERTHREAD_H
+#define GMX_MDLIB_TRAJECTORYWRITERTHREAD_H
+
+#include <exception>
+#include <functional>
+#include <vector>
+
+#include "thread_mpi/threads.h"
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/classhelpers.h"
+#include "gromacs/utility/mutex.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+/*! \libinternal \brief
+ * Copy of the data for one output step, owned by TrajectoryWriterThread.
+ *
+ * Empty coordinate vectors mean that the corresponding data is not written.
+ */
+struct TrajectoryOutputFrame
+{
+    //! The MD step.
+    int64_t step = 0;
+    //! The time of the step.
+    double time = 0;
+    //! The FEP lambda value.
+    real lambda = 0;
+    //! The simulation box.
+    matrix box = { { 0 } };
+    //! Number of atoms in \p x, \p v and \p f.
+    int natoms = 0;
+    //! Coordinates for the full-precision trajectory.
+    std::vector<RVec> x;
+    //! Velocities for the full-precision trajectory.
+    std::vector<RVec> v;
+    //! Forces for the full-precision trajectory.
+    std::vector<RVec> f;
+    //! Whether to write a full-precision frame.
+    bool writeFullPrecision = false;
+    //! Coordinates for the compressed trajectory.
+    std::vector<RVec> xCompressed;
+    //! Whether to write a compressed frame.
+    bool writeCompressed = false;
+};
+
+/*! \libinternal \brief
+ * Writes trajectory frames from a background thread.
+ *
+ * The caller fills the frame returned by frameToFill() with copies of the
+ * data to write and hands it off with submitFrame(), after which the frame
+ * is written by a background thread using the function given to the
+ * constructor.  Two frame buffers are used, so that the next frame can be
+ * filled while the previous one is written; submitFrame() only waits if the
+ * previous frame has not been written yet.
+ *
+ * waitUntilIdle() needs to be called before anything that depends on the
+ * written data being in the files, e.g. when recording file positions for
+ * checkpointing.  Exceptions thrown by the write function, e.g. a
+ * FileIOError when the disk is full, are rethrown from submitFrame() or
+ * waitUntilIdle().  Errors that the write function reports through
+ * gmx_fatal() terminate the program from the writer thread.
+ *
+ * All methods should be called from the same thread.
+ */
+class TrajectoryWriterThread
+{
+public:
+    //! Function that writes a single frame.
+    typedef std::function<void(const TrajectoryOutputFrame&)> WriteFunction;
+
+    //! Starts the writer thread that uses \p writeFunction to write frames.
+    explicit TrajectoryWriterThread(WriteFunction writeFunction);
+    //! Writes any pending frame and stops the thread.
+    ~TrajectoryWriterThread();
+
+    //! Returns the frame buffer that the next frame should be stored in.
+    TrajectoryOutputFrame* frameToFill() { return &frames_[fillIndex_]; }
+    /*! \brief
+     * Hands off the frame from frameToFill() to the writer thread.
+     *
+     * Waits for the previously submitted frame to be written first.
+     */
+    void submitFrame();
+    //! Waits until all submitted frames have been written.
+    void waitUntilIdle();
+
+private:
+    //! Entry point of the writer thread, \p arg is the TrajectoryWriterThread.
+    static void* threadMain(void* arg);
+    //! Main loop of the writer thread.
+    void run();
+    //! Waits on \p condition_ until \p predicate returns true, \p mutex_ should be locked.
+    template<typename Predicate>
+    void waitFor(Predicate predicate);
+    //! Rethrows an exception from the writer thread, if any.
+    void rethrowWriterException();
+
+    //! Function used for writing the frames.
+    WriteFunction writeFunction_;
+    //! The two frame buffers.
+    TrajectoryOutputFrame frames_[2];
+    //! Index of the frame buffer that is filled by the caller.
+    int fillIndex_ = 0;
+    //! Index of the frame buffer that is written, valid when \p busy_ is set.
+    int writeIndex_ = 0;
+    //! Whether a frame has been submitted and not yet written.
+    bool busy_ = false;
+    //! Whether the writer thread should exit.
+    bool stop_ = false;
+    //! Exception thrown while writing, if any.
+    std::exception_ptr exception_;
+    //! Protects the state shared with the writer thread.
+    Mutex mutex_;
+    //! Signals changes to \p busy_ and \p stop_.
+    tMPI_Thread_cond_t condition_;
+    //! The writer thread.
+    tMPI_Thread_t thread_;
+
+    GMX_DISALLOW_COPY_AND_ASSIGN(TrajectoryWriterThread);
+};
+
+} // namespace gmx
+
+#endif
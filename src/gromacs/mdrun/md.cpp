@@ -768,6 +768,7 @@ void gmx::LegacySimulator::do_md()
                            &bPMETunePrinting, simulationWork.useGpuPmePpCommunication);
         }
 
+        wallcycle_set_step(wcycle, step);
         wallcycle_start(wcycle, ewcSTEP);
 
         bLastStep = (step_rel == ir->nsteps);
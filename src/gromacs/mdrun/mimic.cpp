@@ -365,6 +365,7 @@ void gmx::LegacySimulator::do_mimic()
     while (!isLastStep)
     {
         isLastStep = (isLastStep || (ir->nsteps >= 0 && step_rel == ir->nsteps));
+        wallcycle_set_step(wcycle, step);
         wallcycle_start(wcycle, ewcSTEP);
 
         t = step;
@@ -215,6 +215,7 @@ void ModularSimulator::preStep(Step step, Time gmx_unused time, bool isNeighborS
     stophandlerCurrentStep_ = step;
     stopHandler_->setSignal();
 
+    wallcycle_set_step(wcycle, step);
     wallcycle_start(wcycle, ewcSTEP);
 }
 
@@ -70,6 +70,8 @@
 #include "gromacs/utility/enumerationhelpers.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/logger.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textwriter.h"
 
 #include "bench_system.h"
 
@@ -165,9 +167,15 @@ static interaction_const_t setupInteractionConst(const KernelBenchOptions& optio
     return ic;
 }
 
-//! Sets up and returns a Nbnxm object for the given benchmark options and system
+/*! \brief Sets up and returns a Nbnxm object for the given benchmark options and system
+ *
+ * When \p outerListBuffer > 0, dynamic pruning is set up with an outer
+ * list with this buffer over the cut-off. Then the list needs to be
+ * pruned before calling a kernel.
+ */
 static std::unique_ptr<nonbonded_verlet_t> setupNbnxmForBenchInstance(const KernelBenchOptions& options,
-                                                                      const gmx::BenchmarkSystem& system)
+                                                                      const gmx::BenchmarkSystem& system,
+                                                                      const real outerListBuffer = 0)
 {
     const auto pinPolicy  = (options.useGpu ? gmx::PinningPolicy::PinnedIfSupported
                                            : gmx::PinningPolicy::CannotBePinned);
@@ -183,6 +191,12 @@ static std::unique_ptr<nonbonded_verlet_t> setupNbnxmForBenchInstance(const Kern
     Nbnxm::KernelSetup kernelSetup = getKernelSetup(options);
 
     PairlistParams pairlistParams(kernelSetup.kernelType, false, options.pairlistCutoff, false);
+    if (outerListBuffer > 0)
+    {
+        pairlistParams.useDynamicPruning = true;
+        pairlistParams.rlistOuter        = options.pairlistCutoff + outerListBuffer;
+        pairlistParams.nstlistPrune      = 1;
+    }
 
     GridSet gridSet(epbcXYZ, false, nullptr, nullptr, pairlistParams.pairlistType, false,
                     numThreads, pinPolicy);
@@ -263,14 +277,142 @@ static void expandSimdOptionAndPushBack(const KernelBenchOptions&        options
     }
 }
 
+
+//! The CPU stages of a non-bonded force step that can be timed by the benchmarks
+enum class PipelineStage : int
+{
+    PutOnGrid,
+    PairSearch,
+    ConvertCoordinates,
+    Prune,
+    Kernel,
+    ReduceForces,
+    Count
+};
+
+//! Short names of the pipeline stages, used in the output
+static const gmx::EnumerationArray<PipelineStage, const char*> c_pipelineStageNames = {
+    "grid", "search", "x-conv", "prune", "kernel", "f-reduce"
+};
+
+//! Names of the SIMD kernel types, used in the output
+static const gmx::EnumerationArray<BenchMarkKernels, const char*> c_kernelNames = { "auto", "no",
+                                                                                    "4xM", "2xMM" };
+
+//! Names of the combination rules, used in the output
+static const gmx::EnumerationArray<BenchMarkCombRule, const char*> c_combruleNames = { "geom.", "LB",
+                                                                                       "none" };
+
+/*! \internal \brief
+ * The results of one benchmark instance
+ */
+struct BenchResult
+{
+    //! The options for this instance
+    KernelBenchOptions options;
+    //! The total number of cycles spent in the timed kernel iterations
+    double kernelCycles = 0;
+    //! The number of atom pairs in the cluster pair list
+    double numPairs = 0;
+    //! The estimated number of atom pairs within the cut-off
+    double numUsefulPairs = 0;
+    //! The cycles per iteration for each pipeline stage, only set with benchmarkPipelineStages
+    gmx::EnumerationArray<PipelineStage, double> stageCyclesPerIteration = {};
+};
+
+/*! \brief Times all CPU stages of a non-bonded force step for the benchmark instance
+ *
+ * A separate Nbnxm object with a dynamically pruned pair list is used,
+ * so all stages that are run by mdrun at a pair-search step can be
+ * timed. The average cycles per iteration are stored in \p result.
+ */
+static void runPipelineStages(const gmx::BenchmarkSystem& system,
+                              const KernelBenchOptions&   options,
+                              const interaction_const_t&  ic,
+                              const gmx::StepWorkload&    stepWork,
+                              BenchResult*                result)
+{
+    std::unique_ptr<nonbonded_verlet_t> nbv =
+            setupNbnxmForBenchInstance(options, system, options.outerListBuffer);
+
+    const rvec lowerCorner = { 0, 0, 0 };
+    const rvec upperCorner = { system.box[XX][XX], system.box[YY][YY], system.box[ZZ][ZZ] };
+    const real atomDensity = system.coordinates.size() / det(system.box);
+
+    gmx::ArrayRef<const int> atomInfo = options.useHalfLJOptimization ? system.atomInfoOxygenVdw
+                                                                      : system.atomInfoAllVdw;
+
+    t_mdatoms mdatoms;
+    // We only use (read) the atom type and charge from mdatoms
+    mdatoms.typeA   = const_cast<int*>(system.atomTypes.data());
+    mdatoms.chargeA = const_cast<real*>(system.charges.data());
+
+    t_nrnb         nrnb = { 0 };
+    gmx_enerdata_t enerd(1, 0);
+
+    std::vector<gmx::RVec> forces(system.coordinates.size(), { 0, 0, 0 });
+
+    gmx::EnumerationArray<PipelineStage, gmx_cycles_t> cycles = {};
+    for (int iter = 0; iter < options.numIterations; iter++)
+    {
+        gmx_cycles_t start = gmx_cycles_read();
+        gmx_cycles_t end;
+
+        nbnxn_put_on_grid(nbv.get(), system.box, 0, lowerCorner, upperCorner, nullptr,
+                          { 0, int(system.coordinates.size()) }, atomDensity, atomInfo,
+                          system.coordinates, 0, nullptr);
+        nbv->setAtomProperties(mdatoms, atomInfo);
+        end = gmx_cycles_read();
+        cycles[PipelineStage::PutOnGrid] += end - start;
+        start = end;
+
+        nbv->constructPairlist(gmx::InteractionLocality::Local, &system.excls, 0, &nrnb);
+        end = gmx_cycles_read();
+        cycles[PipelineStage::PairSearch] += end - start;
+        start = end;
+
+        nbv->convertCoordinates(gmx::AtomLocality::Local, false, system.coordinates);
+        end = gmx_cycles_read();
+        cycles[PipelineStage::ConvertCoordinates] += end - start;
+        start = end;
+
+        nbv->dispatchPruneKernelCpu(gmx::InteractionLocality::Local, system.forceRec.shift_vec);
+        end = gmx_cycles_read();
+        cycles[PipelineStage::Prune] += end - start;
+        start = end;
+
+        nbv->dispatchNonbondedKernel(gmx::InteractionLocality::Local, ic, stepWork, enbvClearFYes,
+                                     system.forceRec, &enerd, &nrnb);
+        end = gmx_cycles_read();
+        cycles[PipelineStage::Kernel] += end - start;
+        start = end;
+
+        /* As in mdrun, reduce all atoms: with multiple threads the thread
+         * force buffers can only be reduced for all atoms at once.
+         */
+        nbv->atomdata_add_nbat_f_to_f(gmx::AtomLocality::All, forces);
+        end = gmx_cycles_read();
+        cycles[PipelineStage::ReduceForces] += end - start;
+    }
+
+    for (auto stage : gmx::keysOf(cycles))
+    {
+        result->stageCyclesPerIteration[stage] =
+                static_cast<double>(cycles[stage]) / std::max(options.numIterations, 1);
+    }
+}
+
 //! Sets up and runs the requested benchmark instance and prints the results
 //
 // When \p doWarmup is true runs the warmup iterations instead
 // of the normal ones and does not print any results
-static void setupAndRunInstance(const gmx::BenchmarkSystem& system,
-                                const KernelBenchOptions&   options,
-                                const bool                  doWarmup)
+static BenchResult setupAndRunInstance(const gmx::BenchmarkSystem& system,
+                                       const KernelBenchOptions&   options,
+                                       const bool                  doWarmup)
 {
+    BenchResult result;
+    result.options = options;
+
     // Generate an, accurate, estimate of the number of non-zero pair interactions
     const real atomDensity = system.coordinates.size() / det(system.box);
     const real numPairsWithinCutoff =
@@ -294,18 +436,12 @@ static void setupAndRunInstance(const gmx::BenchmarkSystem& system,
         stepWork.computeEnergy = true;
     }
 
-    const gmx::EnumerationArray<BenchMarkKernels, std::string> kernelNames = { "auto", "no", "4xM",
-                                                                               "2xMM" };
-
-    const gmx::EnumerationArray<BenchMarkCombRule, std::string> combruleNames = { "geom.", "LB",
-                                                                                  "none" };
-
     if (!doWarmup)
     {
         fprintf(stdout, "%-7s %-4s %-5s %-4s ",
                 options.coulombType == BenchMarkCoulomb::Pme ? "Ewald" : "RF",
                 options.useHalfLJOptimization ? "half" : "all",
-                combruleNames[options.ljCombinationRule].c_str(), kernelNames[options.nbnxmSimd].c_str());
+                c_combruleNames[options.ljCombinationRule], c_kernelNames[options.nbnxmSimd]);
     }
 
     // Run pre-iteration to avoid cache misses
@@ -326,6 +462,11 @@ static void setupAndRunInstance(const gmx::BenchmarkSystem& system,
                                      system.forceRec, &enerd, &nrnb);
     }
     cycles = gmx_cycles_read() - cycles;
+
+    result.kernelCycles   = static_cast<double>(cycles);
+    result.numPairs       = numPairs;
+    result.numUsefulPairs = numUsefulPairs;
+
     if (!doWarmup)
     {
         const double dCycles = static_cast<double>(cycles);
@@ -341,17 +482,115 @@ static void setupAndRunInstance(const gmx::BenchmarkSystem& system,
                     dCycles / options.numIterations * 1e-6, options.numIterations * numPairs / dCycles,
                     options.numIterations * numUsefulPairs / dCycles);
         }
+
+        if (options.benchmarkPipelineStages)
+        {
+            runPipelineStages(system, options, ic, stepWork, &result);
+        }
     }
+
+    return result;
 }
 
-void bench(const int sizeFactor, const KernelBenchOptions& options)
+//! Prints a table with the cycles per iteration for each pipeline stage
+//
+// The timings of \p otherStages, which do not depend on the kernel setup,
+// are printed for each kernel setup and are included in the total.
+static void printPipelineStages(gmx::ArrayRef<const BenchResult> results,
+                                gmx::ArrayRef<const StageTiming> otherStages)
 {
-    // We don't want to call gmx_omp_nthreads_init(), so we init what we need
-    gmx_omp_nthreads_set(emntPairsearch, options.numThreads);
-    gmx_omp_nthreads_set(emntNonbonded, options.numThreads);
+    fprintf(stdout, "\nMcycles per iteration for the %s stages\n",
+            otherStages.empty() ? "non-bonded pipeline" : "MD step");
+    fprintf(stdout, "Coulomb LJ   comb. SIMD ");
+    for (const char* name : c_pipelineStageNames)
+    {
+        fprintf(stdout, " %8s", name);
+    }
+    for (const StageTiming& stage : otherStages)
+    {
+        fprintf(stdout, " %8s", stage.name.c_str());
+    }
+    fprintf(stdout, "    total\n");
+    for (const BenchResult& result : results)
+    {
+        const KernelBenchOptions& options = result.options;
+        fprintf(stdout, "%-7s %-4s %-5s %-4s ",
+                options.coulombType == BenchMarkCoulomb::Pme ? "Ewald" : "RF",
+                options.useHalfLJOptimization ? "half" : "all",
+                c_combruleNames[options.ljCombinationRule], c_kernelNames[options.nbnxmSimd]);
+        double total = 0;
+        for (double stageCycles : result.stageCyclesPerIteration)
+        {
+            fprintf(stdout, " %8.4f", stageCycles * 1e-6);
+            total += stageCycles;
+        }
+        for (const StageTiming& stage : otherStages)
+        {
+            fprintf(stdout, " %8.4f", stage.cyclesPerIteration * 1e-6);
+            total += stage.cyclesPerIteration;
+        }
+        fprintf(stdout, " %8.4f\n", total * 1e-6);
+    }
+}
 
-    const gmx::BenchmarkSystem system(sizeFactor);
+//! Writes the results of all benchmark instances to \p fileName in CSV format
+static void writeResultsCsv(const std::string&               fileName,
+                            gmx::ArrayRef<const BenchResult> results,
+                            gmx::ArrayRef<const StageTiming> otherStages)
+{
+    gmx::TextWriter writer(fileName);
 
+    std::string header =
+            "coulomb,lj,combrule,simd,threads,cutoff,iterations,mcycles_per_iteration,"
+            "pairs,useful_pairs,pairs_per_cycle,useful_pairs_per_cycle";
+    const bool haveStages = results[0].options.benchmarkPipelineStages;
+    if (haveStages)
+    {
+        for (const char* name : c_pipelineStageNames)
+        {
+            header += gmx::formatString(",%s_mcycles_per_iteration", name);
+        }
+        for (const StageTiming& stage : otherStages)
+        {
+            header += gmx::formatString(",%s_mcycles_per_iteration", stage.name.c_str());
+        }
+    }
+    writer.writeLine(header);
+
+    for (const BenchResult& result : results)
+    {
+        const KernelBenchOptions& options = result.options;
+        const double cyclesPerIteration   = result.kernelCycles / options.numIterations;
+
+        std::string line = gmx::formatString(
+                "%s,%s,%s,%s,%d,%g,%d,%.6f,%.0f,%.0f,%.6f,%.6f",
+                options.coulombType == BenchMarkCoulomb::Pme ? "ewald" : "reaction-field",
+                options.useHalfLJOptimization ? "half" : "all",
+                c_combruleNames[options.ljCombinationRule], c_kernelNames[options.nbnxmSimd],
+                options.numThreads, options.pairlistCutoff, options.numIterations,
+                cyclesPerIteration * 1e-6, result.numPairs, result.numUsefulPairs,
+                result.numPairs / cyclesPerIteration, result.numUsefulPairs / cyclesPerIteration);
+        if (haveStages)
+        {
+            for (double stageCycles : result.stageCyclesPerIteration)
+            {
+                line += gmx::formatString(",%.6f", stageCycles * 1e-6);
+            }
+            for (const StageTiming& stage : otherStages)
+            {
+                line += gmx::formatString(",%.6f", stage.cyclesPerIteration * 1e-6);
+            }
+        }
+        writer.writeLine(line);
+    }
+    writer.close();
+}
+
+//! Runs all benchmark instances requested by \p options on \p system
+static void runBenchmarks(const gmx::BenchmarkSystem&      system,
+                          const KernelBenchOptions&        options,
+                          gmx::ArrayRef<const StageTiming> otherStages)
+{
     real minBoxSize = norm(system.box[XX]);
     for (int dim = YY; dim < DIM; dim++)
     {
@@ -361,6 +600,19 @@ void bench(const int sizeFactor, const KernelBenchOptions& options)
     {
         gmx_fatal(FARGS, "The cut-off should be shorter than half the box size");
     }
+    if (options.benchmarkPipelineStages)
+    {
+        if (options.outerListBuffer <= 0)
+        {
+            gmx_fatal(FARGS, "The outer pair-list buffer should be positive");
+        }
+        if (options.pairlistCutoff + options.outerListBuffer > 0.5 * minBoxSize)
+        {
+            gmx_fatal(FARGS,
+                      "The cut-off plus the outer pair-list buffer should be shorter than half the "
+                      "box size");
+        }
+    }
 
     std::vector<KernelBenchOptions> optionsList;
     if (options.doAll)
@@ -405,6 +657,10 @@ void bench(const int sizeFactor, const KernelBenchOptions& options)
     fprintf(stdout, "Number of threads:    %d\n", options.numThreads);
     fprintf(stdout, "Number of iterations: %d\n", options.numIterations);
     fprintf(stdout, "Compute energies:     %s\n", options.computeVirialAndEnergy ? "yes" : "no");
+    if (options.benchmarkPipelineStages)
+    {
+        fprintf(stdout, "Outer list buffer:    %g nm\n", options.outerListBuffer);
+    }
     if (options.coulombType != BenchMarkCoulomb::ReactionField)
     {
         fprintf(stdout, "Ewald excl. corr.:    %s\n",
@@ -423,10 +679,46 @@ void bench(const int sizeFactor, const KernelBenchOptions& options)
             options.cyclesPerPair ? "cycles/pair" : "pairs/cycle");
     fprintf(stdout, "                                                total    useful\n");
 
+    std::vector<BenchResult> results;
     for (const auto& optionsInstance : optionsList)
     {
-        setupAndRunInstance(system, optionsInstance, false);
+        results.push_back(setupAndRunInstance(system, optionsInstance, false));
     }
+
+    if (options.benchmarkPipelineStages)
+    {
+        printPipelineStages(results, otherStages);
+    }
+
+    if (!options.csvFileName.empty())
+    {
+        writeResultsCsv(options.csvFileName, results, otherStages);
+    }
+}
+
+void bench(const int sizeFactor, const KernelBenchOptions& options)
+{
+    // We don't want to call gmx_omp_nthreads_init(), so we init what we need
+    gmx_omp_nthreads_set(emntPairsearch, options.numThreads);
+    gmx_omp_nthreads_set(emntNonbonded, options.numThreads);
+
+    const gmx::BenchmarkSystem system(sizeFactor);
+
+    runBenchmarks(system, options, {});
+}
+
+void bench(const gmx_mtop_t&                mtop,
+           gmx::ArrayRef<const gmx::RVec>   coordinates,
+           const matrix                     box,
+           const KernelBenchOptions&        options,
+           gmx::ArrayRef<const StageTiming> otherStages)
+{
+    gmx_omp_nthreads_set(emntPairsearch, options.numThreads);
+    gmx_omp_nthreads_set(emntNonbonded, options.numThreads);
+
+    const gmx::BenchmarkSystem system(mtop, coordinates, box);
+
+    runBenchmarks(system, options, otherStages);
 }
 
 } // namespace Nbnxm
@@ -46,8 +46,14 @@
 #ifndef GMX_NBNXN_BENCH_SETUP_H
 #define GMX_NBNXN_BENCH_SETUP_H
 
+#include <string>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/real.h"
 
+struct gmx_mtop_t;
+
 namespace Nbnxm
 {
 
@@ -113,6 +119,23 @@ struct KernelBenchOptions
     int numWarmupIterations = 0;
     //! Print cycles/pair instead of pairs/cycle
     bool cyclesPerPair = false;
+    //! Whether to also time the other CPU stages of the non-bonded force pipeline
+    bool benchmarkPipelineStages = false;
+    //! The buffer of the outer pairlist over the cut-off for the pipeline stage benchmarks
+    real outerListBuffer = 0.1;
+    //! When not empty, the results are also written to this file in CSV format
+    std::string csvFileName;
+};
+
+/*! \internal \brief
+ * The timing of a stage of an MD step that is computed outside the Nbnxm module
+ */
+struct StageTiming
+{
+    //! Short name of the stage, used in the output
+    std::string name;
+    //! The average number of cycles per iteration
+    double cyclesPerIteration;
 };
 
 /*! \brief
@@ -122,12 +145,36 @@ struct KernelBenchOptions
  * by the factor \p sizeFactor, which has to be a power of 2.
  * One or more benchmarks are run, as specified by \p options.
  * Benchmark settings and timings are printed to stdout.
+ * When requested, the grid, search, coordinate conversion, pruning and
+ * force reduction stages are timed as well and all results are written
+ * to a CSV file.
  *
  * \param[in] sizeFactor How much should the system size be increased.
  * \param[in] options How the benchmark will be run.
  */
 void bench(int sizeFactor, const KernelBenchOptions& options);
 
+/*! \brief
+ * Sets up and runs one or more Nbnxm kernel benchmarks for a given system
+ *
+ * As bench() above, but for the system with topology \p mtop,
+ * \p coordinates and a rectangular \p box, usually read from
+ * a run input file. When pipeline stages are benchmarked, the timings
+ * in \p otherStages are reported along with the non-bonded stages,
+ * so the table and CSV output cover all CPU stages of an MD step.
+ *
+ * \param[in] mtop         The system topology
+ * \param[in] coordinates  The coordinates of all atoms
+ * \param[in] box          The unit cell
+ * \param[in] options      How the benchmark will be run.
+ * \param[in] otherStages  Timings of the MD step stages outside the Nbnxm module
+ */
+void bench(const gmx_mtop_t&              mtop,
+           gmx::ArrayRef<const gmx::RVec> coordinates,
+           const matrix                   box,
+           const KernelBenchOptions&      options,
+           gmx::ArrayRef<const StageTiming> otherStages);
+
 } // namespace Nbnxm
 
 #endif
@@ -53,6 +53,9 @@
 #include "gromacs/nbnxm/nbnxm.h"
 #include "gromacs/pbcutil/ishift.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/topology/mtop_util.h"
+#include "gromacs/topology/topology.h"
 #include "gromacs/utility/fatalerror.h"
 
 #include "bench_coords.h"
@@ -205,4 +208,72 @@ BenchmarkSystem::BenchmarkSystem(const int multiplicationFactor)
     calc_shifts(box, forceRec.shift_vec);
 }
 
+BenchmarkSystem::BenchmarkSystem(const gmx_mtop_t& mtop, ArrayRef<const RVec> coordinatesIn, const matrix boxIn)
+{
+    if (TRICLINIC(boxIn))
+    {
+        gmx_fatal(FARGS, "The benchmarks only support rectangular unit cells");
+    }
+    if (mtop.ffparams.functype[0] != F_LJ)
+    {
+        gmx_fatal(FARGS, "The benchmarks only support Lennard-Jones interactions");
+    }
+    GMX_RELEASE_ASSERT(coordinatesIn.ssize() == mtop.natoms,
+                       "Need coordinates for all atoms in the topology");
+
+    numAtomTypes = mtop.ffparams.atnr;
+    nonbondedParameters.resize(numAtomTypes * numAtomTypes * 2);
+    std::vector<bool> typeHasVdw(numAtomTypes, false);
+    for (int i = 0; i < numAtomTypes; i++)
+    {
+        for (int j = 0; j < numAtomTypes; j++)
+        {
+            const t_iparams& params                       = mtop.ffparams.iparams[i * numAtomTypes + j];
+            nonbondedParameters[(i * numAtomTypes + j) * 2]     = params.lj.c6;
+            nonbondedParameters[(i * numAtomTypes + j) * 2 + 1] = params.lj.c12;
+            if (params.lj.c6 != 0 || params.lj.c12 != 0)
+            {
+                typeHasVdw[i] = true;
+                typeHasVdw[j] = true;
+            }
+        }
+    }
+
+    copy_mat(boxIn, box);
+    coordinates.assign(coordinatesIn.begin(), coordinatesIn.end());
+    put_atoms_in_box(epbcXYZ, box, coordinates);
+
+    const int numAtoms = mtop.natoms;
+    atomTypes.resize(numAtoms);
+    charges.resize(numAtoms);
+    atomInfoAllVdw.resize(numAtoms);
+    atomInfoOxygenVdw.resize(numAtoms);
+    for (const AtomProxy atomP : AtomRange(mtop))
+    {
+        const t_atom& atom = atomP.atom();
+        const int     a    = atomP.globalAtomNumber();
+        atomTypes[a]       = atom.type;
+        charges[a]         = atom.q;
+        SET_CGINFO_HAS_VDW(atomInfoAllVdw[a]);
+        if (typeHasVdw[atom.type])
+        {
+            SET_CGINFO_HAS_VDW(atomInfoOxygenVdw[a]);
+        }
+        if (atom.q != 0)
+        {
+            SET_CGINFO_HAS_Q(atomInfoAllVdw[a]);
+            SET_CGINFO_HAS_Q(atomInfoOxygenVdw[a]);
+        }
+    }
+
+    gmx_localtop_t localTopology;
+    gmx_mtop_generate_local_top(mtop, &localTopology, false);
+    copy_blocka(&localTopology.excls, &excls);
+
+    forceRec.ntype = numAtomTypes;
+    forceRec.nbfp  = nonbondedParameters.data();
+    snew(forceRec.shift_vec, SHIFTS);
+    calc_shifts(box, forceRec.shift_vec);
+}
+
 } // namespace gmx
@@ -49,8 +49,11 @@
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/forcerec.h"
 #include "gromacs/topology/block.h"
+#include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/smalloc.h"
 
+struct gmx_mtop_t;
+
 namespace gmx
 {
 
@@ -67,6 +70,18 @@ struct BenchmarkSystem
      */
     BenchmarkSystem(int multiplicationFactor);
 
+    /*! \brief Constructor
+     *
+     * Sets up a benchmark system from the topology and coordinates
+     * of a run input file. Only rectangular boxes and plain LJ
+     * interactions are supported, a fatal error is generated otherwise.
+     *
+     * \param[in] mtop         The system topology
+     * \param[in] coordinates  The coordinates of all atoms in \p mtop
+     * \param[in] box          The unit cell
+     */
+    BenchmarkSystem(const gmx_mtop_t& mtop, ArrayRef<const RVec> coordinates, const matrix box);
+
     //! Number of different atom types in test system.
     int numAtomTypes;
     //! Storage for parameters for short range interactions.
@@ -77,7 +92,9 @@ struct BenchmarkSystem
     std::vector<real> charges;
     //! Atom info where all atoms are marked to have Van der Waals interactions
     std::vector<int> atomInfoAllVdw;
-    //! Atom info where only oxygen atoms are marked to have Van der Waals interactions
+    /*! \brief Atom info where only atoms with LJ parameters are marked to have Van der Waals interactions
+     *
+     * For the water system these are the oxygen atoms. */
     std::vector<int> atomInfoOxygenVdw;
     //! Information about exclusions.
     t_blocka excls;
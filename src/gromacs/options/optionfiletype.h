@@ -62,6 +62,7 @@ enum OptionFileType
     eftIndex,
     eftPlot,
     eftGenericData,
+    eftCsv,
     eftOptionFileType_NR
 };
 
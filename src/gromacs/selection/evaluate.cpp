@@ -1122,12 +1122,17 @@ void _gmx_sel_evaluate_or(gmx_sel_evaluate_t*                     data,
             child->evaluate(data, child, &tmp);
             gmx_ana_index_partition(&tmp, &tmp2, &tmp, child->v.u.g);
         }
+        /* Both the already selected atoms and the atoms selected by this
+         * child are sorted, and are stored consecutively in memory, so a merge
+         * is sufficient to keep the result sorted. */
+        int* const index   = sel->v.u.g->index;
+        const int  oldSize = sel->v.u.g->isize;
         sel->v.u.g->isize += tmp.isize;
+        std::inplace_merge(index, index + oldSize, index + sel->v.u.g->isize);
         tmp.isize = tmp2.isize;
         tmp.index = tmp2.index;
         child     = child->next;
     }
-    gmx_ana_index_sort(sel->v.u.g);
 }
 
 
@@ -1135,6 +1140,43 @@ void _gmx_sel_evaluate_or(gmx_sel_evaluate_t*                     data,
  * ARITHMETIC EVALUATION
  ********************************************************************/
 
+namespace
+{
+
+/*! \brief
+ * Evaluates an arithmetic operation for all values.
+ *
+ * \tparam     Operation    Functor that evaluates the operation.
+ * \param[in]  n            Number of values to compute.
+ * \param[in]  left         Left operand values.
+ * \param[in]  bLeftSingle  Whether \p left has only a single value.
+ * \param[in]  right        Right operand values.
+ * \param[in]  bRightSingle Whether \p right has only a single value.
+ * \param[in]  op           Operation to evaluate.
+ * \param[out] out          Output values.
+ *
+ * The operation is fixed at compile time, such that the compiler can
+ * vectorize the loop.
+ */
+template<class Operation>
+void evaluateArithmeticValues(int         n,
+                              const real* left,
+                              bool        bLeftSingle,
+                              const real* right,
+                              bool        bRightSingle,
+                              Operation   op,
+                              real*       out)
+{
+    const int leftStride  = bLeftSingle ? 0 : 1;
+    const int rightStride = bRightSingle ? 0 : 1;
+    for (int i = 0; i < n; ++i)
+    {
+        out[i] = op(left[i * leftStride], right[i * rightStride]);
+    }
+}
+
+} // namespace
+
 /*!
  * \param[in] data Data for the current frame.
  * \param[in] sel  Selection element being evaluated.
@@ -1145,9 +1187,6 @@ void _gmx_sel_evaluate_arithmetic(gmx_sel_evaluate_t*                     data,
                                   const gmx::SelectionTreeElementPointer& sel,
                                   gmx_ana_index_t*                        g)
 {
-    int  n, i, i1, i2;
-    real lval, rval = 0., val = 0.;
-
     const SelectionTreeElementPointer& left  = sel->child;
     const SelectionTreeElementPointer& right = left->next;
 
@@ -1167,35 +1206,42 @@ void _gmx_sel_evaluate_arithmetic(gmx_sel_evaluate_t*                     data,
     }
     _gmx_sel_evaluate_children(data, sel, g);
 
-    n         = (sel->flags & SEL_SINGLEVAL) ? 1 : g->isize;
-    sel->v.nr = n;
+    const int n = (sel->flags & SEL_SINGLEVAL) ? 1 : g->isize;
+    sel->v.nr   = n;
 
-    bool bArithNeg = (sel->u.arith.type == ARITH_NEG);
+    const bool bArithNeg = (sel->u.arith.type == ARITH_NEG);
     GMX_ASSERT(right || bArithNeg, "Right operand cannot be null except for negations");
-    for (i = i1 = i2 = 0; i < n; ++i)
+    const real* lval        = left->v.u.r;
+    const bool  bLeftSingle = (left->flags & SEL_SINGLEVAL) != 0;
+    // Negation does not use the right operand; use the left as a dummy.
+    const real* rval         = bArithNeg ? lval : right->v.u.r;
+    const bool  bRightSingle = bArithNeg ? bLeftSingle : (right->flags & SEL_SINGLEVAL) != 0;
+    real*       val          = sel->v.u.r;
+    switch (sel->u.arith.type)
     {
-        lval = left->v.u.r[i1];
-        if (!bArithNeg)
-        {
-            rval = right->v.u.r[i2];
-        }
-        switch (sel->u.arith.type)
-        {
-            case ARITH_PLUS: val = lval + rval; break;
-            case ARITH_MINUS: val = lval - rval; break;
-            case ARITH_NEG: val = -lval; break;
-            case ARITH_MULT: val = lval * rval; break;
-            case ARITH_DIV: val = lval / rval; break;
-            case ARITH_EXP: val = pow(lval, rval); break;
-        }
-        sel->v.u.r[i] = val;
-        if (!(left->flags & SEL_SINGLEVAL))
-        {
-            ++i1;
-        }
-        if (!bArithNeg && !(right->flags & SEL_SINGLEVAL))
-        {
-            ++i2;
-        }
+        case ARITH_PLUS:
+            evaluateArithmeticValues(n, lval, bLeftSingle, rval, bRightSingle,
+                                     [](real a, real b) { return a + b; }, val);
+            break;
+        case ARITH_MINUS:
+            evaluateArithmeticValues(n, lval, bLeftSingle, rval, bRightSingle,
+                                     [](real a, real b) { return a - b; }, val);
+            break;
+        case ARITH_NEG:
+            evaluateArithmeticValues(n, lval, bLeftSingle, rval, bRightSingle,
+                                     [](real a, real /*b*/) { return -a; }, val);
+            break;
+        case ARITH_MULT:
+            evaluateArithmeticValues(n, lval, bLeftSingle, rval, bRightSingle,
+                                     [](real a, real b) { return a * b; }, val);
+            break;
+        case ARITH_DIV:
+            evaluateArithmeticValues(n, lval, bLeftSingle, rval, bRightSingle,
+                                     [](real a, real b) { return a / b; }, val);
+            break;
+        case ARITH_EXP:
+            evaluateArithmeticValues(n, lval, bLeftSingle, rval, bRightSingle,
+                                     [](real a, real b) { return static_cast<real>(pow(a, b)); }, val);
+            break;
     }
 }
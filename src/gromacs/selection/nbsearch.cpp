@@ -45,6 +45,9 @@
  *   - A multi-level grid implementation could be used to be able to use small
  *     grids for short cutoffs with very inhomogeneous particle distributions
  *     without a memory cost.
+ *   - The test positions could be processed in cell order, such that the SIMD
+ *     filtering of reference positions could also be done for several test
+ *     positions at once.
  *
  * \author Teemu Murtola <teemu.murtola@gmail.com>
  * \ingroup module_selection
@@ -57,12 +60,16 @@
 #include <cstring>
 
 #include <algorithm>
+#include <array>
+#include <utility>
 #include <vector>
 
 #include "gromacs/math/functions.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/simd/simd.h"
 #include "gromacs/topology/block.h"
+#include "gromacs/utility/alignedallocator.h"
 #include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
@@ -107,6 +114,71 @@ void computeBoundingBox(int posCount, const rvec x[], rvec origin, rvec size)
     rvec_sub(maxBound, origin, size);
 }
 
+/*! \brief
+ * Initializes the PBC information used in the search.
+ *
+ * \param[in]  bXY        Whether to use 2D searching.
+ * \param[in]  pbc        PBC information for the frame (can be NULL).
+ * \param[out] searchPbc  PBC information to use in the search.
+ * \throws     NotImplementedError if \p bXY is not supported with \p pbc.
+ */
+void initSearchPbc(bool bXY, const t_pbc* pbc, t_pbc* searchPbc)
+{
+    if (bXY && pbc != nullptr && pbc->ePBC != epbcNONE)
+    {
+        if (pbc->ePBC != epbcXY && pbc->ePBC != epbcXYZ)
+        {
+            std::string message = formatString(
+                    "Computations in the XY plane are not supported with PBC type '%s'",
+                    epbc_names[pbc->ePBC]);
+            GMX_THROW(NotImplementedError(message));
+        }
+        if (pbc->ePBC == epbcXYZ
+            && (std::fabs(pbc->box[ZZ][XX]) > GMX_REAL_EPS * pbc->box[ZZ][ZZ]
+                || std::fabs(pbc->box[ZZ][YY]) > GMX_REAL_EPS * pbc->box[ZZ][ZZ]))
+        {
+            GMX_THROW(
+                    NotImplementedError("Computations in the XY plane are not supported when the "
+                                        "last box vector is not parallel to the Z axis"));
+        }
+        // Use a single grid cell in Z direction.
+        matrix box;
+        copy_mat(pbc->box, box);
+        clear_rvec(box[ZZ]);
+        set_pbc(searchPbc, epbcXY, box);
+    }
+    else if (pbc != nullptr)
+    {
+        *searchPbc = *pbc;
+    }
+    else
+    {
+        searchPbc->ePBC = epbcNONE;
+        clear_mat(searchPbc->box);
+    }
+}
+
+#if GMX_SIMD_HAVE_REAL
+//! Number of reference positions in a grid cell that are filtered at once with SIMD.
+constexpr int c_cellChunkSize = GMX_SIMD_REAL_WIDTH;
+
+/*! \brief
+ * Relative margin on the squared cutoff for filtering candidate pairs.
+ *
+ * The SIMD distances can differ from the ones computed for the found pairs
+ * in the last bits, so the filter needs to let through slightly more pairs.
+ */
+constexpr real c_cellFilterMargin = 16 * GMX_REAL_EPS;
+
+/*! \brief
+ * Coordinate used for padding the cells in the SIMD coordinate arrays.
+ *
+ * It is far enough from any position that the padding never passes the filter,
+ * yet its square is finite.
+ */
+constexpr real c_cellPaddingCoordinate = 1e10;
+#endif
+
 } // namespace
 
 namespace internal
@@ -122,6 +194,8 @@ public:
     typedef AnalysisNeighborhoodPairSearch::ImplPointer PairSearchImplPointer;
     typedef std::vector<PairSearchImplPointer>          PairSearchList;
     typedef std::vector<std::vector<int>>               CellList;
+    //! Aligned storage of reference coordinates for SIMD access.
+    typedef std::vector<real, AlignedAllocator<real>> CellCoordinates;
 
     explicit AnalysisNeighborhoodSearchImpl(real cutoff);
     ~AnalysisNeighborhoodSearchImpl();
@@ -205,6 +279,30 @@ private:
      * produces.
      */
     void addToGridCell(const rvec cell, int i);
+#if GMX_SIMD_HAVE_REAL
+    /*! \brief
+     * Packs the reference positions in the grid cells for filtering.
+     *
+     * Should be called after all reference positions are added to the grid.
+     */
+    void initCellCoordinates();
+    /*! \brief
+     * Finds reference positions in a chunk of a grid cell that may be within the cutoff.
+     *
+     * \param[in]  ci          Grid cell index.
+     * \param[in]  chunkStart  Index within the cell of the first position in
+     *     the chunk, a multiple of \c c_cellChunkSize.
+     * \param[in]  xtest       Test position.
+     * \param[in]  shift       Shift to subtract from the distance vectors.
+     * \param[out] bCandidate  For each position in the chunk, whether it
+     *     may be within the cutoff.
+     * \returns    Whether any position in the chunk may be within the cutoff.
+     *
+     * Positions that are within the cutoff are always marked as candidates,
+     * but a candidate may still be (slightly) outside the cutoff.
+     */
+    bool filterCellChunk(int ci, int chunkStart, const rvec xtest, const rvec shift, bool bCandidate[]) const;
+#endif
     /*! \brief
      * Initializes a cell pair loop for a dimension.
      *
@@ -317,6 +415,16 @@ private:
     ivec ncelldim_;
     //! Data structure to hold the grid cell contents.
     CellList cells_;
+#if GMX_SIMD_HAVE_REAL
+    /*! \brief
+     * Start of each grid cell in \p cellCoordinates_.
+     *
+     * Each cell is padded to a multiple of \c c_cellChunkSize.
+     */
+    std::vector<int> cellStart_;
+    //! Reference positions in the order of \p cells_, one array for each dimension.
+    std::array<CellCoordinates, DIM> cellCoordinates_;
+#endif
 
     Mutex          createPairSearchMutex_;
     PairSearchList pairSearchList_;
@@ -716,6 +824,71 @@ void AnalysisNeighborhoodSearchImpl::addToGridCell(const rvec cell, int i)
     cells_[ci].push_back(i);
 }
 
+#if GMX_SIMD_HAVE_REAL
+void AnalysisNeighborhoodSearchImpl::initCellCoordinates()
+{
+    const int cellCount = ncelldim_[XX] * ncelldim_[YY] * ncelldim_[ZZ];
+    cellStart_.resize(cellCount + 1);
+    cellStart_[0] = 0;
+    for (int ci = 0; ci < cellCount; ++ci)
+    {
+        const int paddedSize =
+                (ssize(cells_[ci]) + c_cellChunkSize - 1) / c_cellChunkSize * c_cellChunkSize;
+        cellStart_[ci + 1] = cellStart_[ci] + paddedSize;
+    }
+    for (int dd = 0; dd < DIM; ++dd)
+    {
+        cellCoordinates_[dd].assign(cellStart_[cellCount], c_cellPaddingCoordinate);
+    }
+    for (int ci = 0; ci < cellCount; ++ci)
+    {
+        for (int cai = 0; cai < ssize(cells_[ci]); ++cai)
+        {
+            const int i = cells_[ci][cai];
+            for (int dd = 0; dd < DIM; ++dd)
+            {
+                cellCoordinates_[dd][cellStart_[ci] + cai] = xref_[i][dd];
+            }
+        }
+    }
+}
+
+bool AnalysisNeighborhoodSearchImpl::filterCellChunk(int        ci,
+                                                     int        chunkStart,
+                                                     const rvec xtest,
+                                                     const rvec shift,
+                                                     bool       bCandidate[]) const
+{
+    const int  start         = cellStart_[ci] + chunkStart;
+    const real filterCutoff2 = cutoff2_ * (1 + c_cellFilterMargin);
+    // Same operation order as for the found pairs in searchNext()
+    const SimdReal dx = load<SimdReal>(cellCoordinates_[XX].data() + start) - SimdReal(xtest[XX])
+                        - SimdReal(shift[XX]);
+    const SimdReal dy = load<SimdReal>(cellCoordinates_[YY].data() + start) - SimdReal(xtest[YY])
+                        - SimdReal(shift[YY]);
+    SimdReal r2 = dx * dx + dy * dy;
+    if (!bXY_)
+    {
+        const SimdReal dz = load<SimdReal>(cellCoordinates_[ZZ].data() + start)
+                            - SimdReal(xtest[ZZ]) - SimdReal(shift[ZZ]);
+        r2 = r2 + dz * dz;
+    }
+    if (!anyTrue(r2 <= SimdReal(filterCutoff2)))
+    {
+        return false;
+    }
+    alignas(GMX_SIMD_ALIGNMENT) real r2Buffer[c_cellChunkSize];
+    store(r2Buffer, r2);
+    bool bAnyCandidate = false;
+    for (int k = 0; k < c_cellChunkSize; ++k)
+    {
+        bCandidate[k] = (r2Buffer[k] <= filterCutoff2);
+        bAnyCandidate = bAnyCandidate || bCandidate[k];
+    }
+    return bAnyCandidate;
+}
+#endif
+
 void AnalysisNeighborhoodSearchImpl::initCellRange(const rvec centerCell, ivec currCell, ivec upperBound, int dim) const
 {
     RVec shiftedCenter(centerCell);
@@ -869,38 +1042,7 @@ void AnalysisNeighborhoodSearchImpl::init(AnalysisNeighborhood::SearchMode     m
     GMX_RELEASE_ASSERT(positions.index_ == -1,
                        "Individual indexed positions not supported as reference");
     bXY_ = bXY;
-    if (bXY_ && pbc != nullptr && pbc->ePBC != epbcNONE)
-    {
-        if (pbc->ePBC != epbcXY && pbc->ePBC != epbcXYZ)
-        {
-            std::string message = formatString(
-                    "Computations in the XY plane are not supported with PBC type '%s'",
-                    epbc_names[pbc->ePBC]);
-            GMX_THROW(NotImplementedError(message));
-        }
-        if (pbc->ePBC == epbcXYZ
-            && (std::fabs(pbc->box[ZZ][XX]) > GMX_REAL_EPS * pbc->box[ZZ][ZZ]
-                || std::fabs(pbc->box[ZZ][YY]) > GMX_REAL_EPS * pbc->box[ZZ][ZZ]))
-        {
-            GMX_THROW(
-                    NotImplementedError("Computations in the XY plane are not supported when the "
-                                        "last box vector is not parallel to the Z axis"));
-        }
-        // Use a single grid cell in Z direction.
-        matrix box;
-        copy_mat(pbc->box, box);
-        clear_rvec(box[ZZ]);
-        set_pbc(&pbc_, epbcXY, box);
-    }
-    else if (pbc != nullptr)
-    {
-        pbc_ = *pbc;
-    }
-    else
-    {
-        pbc_.ePBC = epbcNONE;
-        clear_mat(pbc_.box);
-    }
+    initSearchPbc(bXY_, pbc, &pbc_);
     nref_ = positions.count_;
     if (mode == AnalysisNeighborhood::eSearchMode_Simple)
     {
@@ -924,6 +1066,9 @@ void AnalysisNeighborhoodSearchImpl::init(AnalysisNeighborhood::SearchMode     m
             mapPointToGridCell(positions.x_[ii], refcell, xrefAlloc_[i]);
             addToGridCell(refcell, i);
         }
+#if GMX_SIMD_HAVE_REAL
+        initCellCoordinates();
+#endif
     }
     else if (refIndices_ != nullptr)
     {
@@ -1046,9 +1191,9 @@ void AnalysisNeighborhoodPairSearchImpl::startSearch(const AnalysisNeighborhoodP
     }
     else
     {
-        // Somewhat of a hack: setup the array such that only the last position
-        // will be used.
-        testPosCount_ = positions.index_ + 1;
+        // Somewhat of a hack: setup the array such that only the positions
+        // in the selected range will be used.
+        testPosCount_ = positions.indexEnd_;
         reset(positions.index_);
     }
 }
@@ -1083,8 +1228,30 @@ bool AnalysisNeighborhoodPairSearchImpl::searchNext(Action action)
                     continue;
                 }
                 const int cellSize = ssize(search_.cells_[ci]);
+#if GMX_SIMD_HAVE_REAL
+                // Which positions in the current chunk may be within the cutoff
+                bool bCandidate[c_cellChunkSize];
+                bool bChunkFiltered = false;
+#endif
                 for (; cai < cellSize; ++cai)
                 {
+#if GMX_SIMD_HAVE_REAL
+                    const int chunkIndex = cai % c_cellChunkSize;
+                    if (chunkIndex == 0 || !bChunkFiltered)
+                    {
+                        bChunkFiltered = true;
+                        if (!search_.filterCellChunk(ci, cai - chunkIndex, xtest_, shift, bCandidate))
+                        {
+                            // Skip to the start of the next chunk
+                            cai += c_cellChunkSize - 1 - chunkIndex;
+                            continue;
+                        }
+                    }
+                    if (!bCandidate[chunkIndex])
+                    {
+                        continue;
+                    }
+#endif
                     const int i = search_.cells_[ci][cai];
                     if (selfSearchMode_ && ci == testCellIndex_ && i >= testIndex_)
                     {
@@ -1236,6 +1403,55 @@ private:
 
 } // namespace
 
+/********************************************************************
+ * AnalysisNeighborhoodPairList::Impl
+ */
+
+class AnalysisNeighborhoodPairList::Impl
+{
+public:
+    Impl(real cutoff, real buffer, AnalysisNeighborhood::SearchMode mode, bool bXY, const t_blocka* excls) :
+        search_(cutoff > 0 ? cutoff + buffer : 0),
+        cutoff2_(cutoff > 0 ? gmx::square(cutoff) : GMX_REAL_MAX),
+        buffer_(buffer),
+        mode_(mode),
+        bXY_(bXY),
+        excls_(excls),
+        bValid_(false),
+        buildCount_(0),
+        ePBC_(epbcNONE)
+    {
+        clear_mat(box_);
+    }
+
+    //! Search with the buffered cutoff, used to build the list.
+    internal::AnalysisNeighborhoodSearchImpl search_;
+    //! Square of the unbuffered cutoff.
+    real cutoff2_;
+    //! Buffer added to the cutoff when building the list.
+    real buffer_;
+    //! Search mode for building the list.
+    AnalysisNeighborhood::SearchMode mode_;
+    //! Whether to use 2D searching.
+    bool bXY_;
+    //! Exclusions for the search.
+    const t_blocka* excls_;
+    //! Whether the list has been built and not invalidated.
+    bool bValid_;
+    //! Number of times the list has been built.
+    int buildCount_;
+    //! Pairs (reference index, test index) within the buffered cutoff.
+    std::vector<std::pair<int, int>> pairs_;
+    //! Reference positions when the list was built.
+    std::vector<RVec> refX_;
+    //! Test positions when the list was built.
+    std::vector<RVec> testX_;
+    //! PBC type when the list was built.
+    int ePBC_;
+    //! Box when the list was built.
+    matrix box_;
+};
+
 /********************************************************************
  * AnalysisNeighborhood::Impl
  */
@@ -1329,6 +1545,13 @@ AnalysisNeighborhoodSearch AnalysisNeighborhood::initSearch(const t_pbc* pbc,
     return AnalysisNeighborhoodSearch(search);
 }
 
+AnalysisNeighborhoodPairList AnalysisNeighborhood::initPairList(real buffer) const
+{
+    GMX_RELEASE_ASSERT(buffer >= 0, "Pair list buffer cannot be negative");
+    return AnalysisNeighborhoodPairList(new AnalysisNeighborhoodPairList::Impl(
+            impl_->cutoff_, buffer, impl_->mode_, impl_->bXY_, impl_->excls_));
+}
+
 /********************************************************************
  * AnalysisNeighborhoodSearch
  */
@@ -1400,6 +1623,21 @@ AnalysisNeighborhoodSearch::startPairSearch(const AnalysisNeighborhoodPositions&
     return AnalysisNeighborhoodPairSearch(pairSearch);
 }
 
+void AnalysisNeighborhoodSearch::findAllPairs(const AnalysisNeighborhoodPositions&   positions,
+                                              std::vector<AnalysisNeighborhoodPair>* pairs) const
+{
+    GMX_RELEASE_ASSERT(impl_, "Accessing an invalid search object");
+    pairs->clear();
+    internal::AnalysisNeighborhoodPairSearchImpl pairSearch(*impl_);
+    pairSearch.startSearch(positions);
+    AnalysisNeighborhoodPair pair;
+    while (pairSearch.searchNext(&withinAction))
+    {
+        pairSearch.initFoundPair(&pair);
+        pairs->push_back(pair);
+    }
+}
+
 /********************************************************************
  * AnalysisNeighborhoodPairSearch
  */
@@ -1421,4 +1659,138 @@ void AnalysisNeighborhoodPairSearch::skipRemainingPairsForTestPosition()
     impl_->nextTestPosition();
 }
 
+/********************************************************************
+ * AnalysisNeighborhoodPairList
+ */
+
+AnalysisNeighborhoodPairList::AnalysisNeighborhoodPairList() : impl_(nullptr) {}
+
+AnalysisNeighborhoodPairList::AnalysisNeighborhoodPairList(Impl* impl) : impl_(impl) {}
+
+AnalysisNeighborhoodPairList::AnalysisNeighborhoodPairList(AnalysisNeighborhoodPairList&& other) noexcept = default;
+
+AnalysisNeighborhoodPairList& AnalysisNeighborhoodPairList::
+                              operator=(AnalysisNeighborhoodPairList&& other) noexcept = default;
+
+AnalysisNeighborhoodPairList::~AnalysisNeighborhoodPairList() {}
+
+void AnalysisNeighborhoodPairList::findAllPairs(const t_pbc*                           pbc,
+                                                const AnalysisNeighborhoodPositions&   refPositions,
+                                                const AnalysisNeighborhoodPositions&   testPositions,
+                                                std::vector<AnalysisNeighborhoodPair>* pairs)
+{
+    GMX_RELEASE_ASSERT(impl_, "Accessing an invalid pair list");
+    GMX_RELEASE_ASSERT(refPositions.index_ == -1 && testPositions.index_ == -1,
+                       "Individual indexed positions not supported with pair lists");
+    Impl& impl = *impl_;
+
+    // Returns the coordinates of the position with index i in the search.
+    auto positionX = [](const AnalysisNeighborhoodPositions& positions, int i) -> const rvec& {
+        return positions.x_[positions.indices_ != nullptr ? positions.indices_[i] : i];
+    };
+    t_pbc searchPbc;
+    initSearchPbc(impl.bXY_, pbc, &searchPbc);
+
+    // Returns the largest displacement of the positions since the list was
+    // built.  The periodic image does not matter, as the distances for the
+    // pairs are computed using the minimum image.
+    auto maxDisplacement = [positionX, &searchPbc](const AnalysisNeighborhoodPositions& positions,
+                                                   const std::vector<RVec>&             x) {
+        real maxDisplacement2 = 0;
+        for (int i = 0; i < positions.count_; ++i)
+        {
+            rvec dx;
+            if (searchPbc.ePBC != epbcNONE)
+            {
+                pbc_dx(&searchPbc, positionX(positions, i), x[i], dx);
+            }
+            else
+            {
+                rvec_sub(positionX(positions, i), x[i], dx);
+            }
+            maxDisplacement2 = std::max(maxDisplacement2, norm2(dx));
+        }
+        return std::sqrt(maxDisplacement2);
+    };
+
+    bool bRebuild = !impl.bValid_ || refPositions.count_ != ssize(impl.refX_)
+                    || testPositions.count_ != ssize(impl.testX_) || searchPbc.ePBC != impl.ePBC_;
+    // Without a cutoff, the list contains all pairs and only needs to be
+    // rebuilt if the positions change.
+    if (!bRebuild && impl.cutoff2_ < GMX_REAL_MAX)
+    {
+        // Each periodic image used for a pair within the cutoff is shifted
+        // by at most one of each box vector, so this bounds how much the
+        // box change can change the distance.
+        real boxChange = 0;
+        for (int d = 0; d < DIM; ++d)
+        {
+            boxChange += std::sqrt(distance2(searchPbc.box[d], impl.box_[d]));
+        }
+        bRebuild = (boxChange + maxDisplacement(refPositions, impl.refX_)
+                            + maxDisplacement(testPositions, impl.testX_)
+                    > impl.buffer_);
+    }
+    if (bRebuild)
+    {
+        impl.search_.init(impl.mode_, impl.bXY_, impl.excls_, pbc, refPositions);
+        internal::AnalysisNeighborhoodPairSearchImpl pairSearch(impl.search_);
+        pairSearch.startSearch(testPositions);
+        AnalysisNeighborhoodPair pair;
+        impl.pairs_.clear();
+        while (pairSearch.searchNext(&withinAction))
+        {
+            pairSearch.initFoundPair(&pair);
+            impl.pairs_.emplace_back(pair.refIndex(), pair.testIndex());
+        }
+        impl.refX_.resize(refPositions.count_);
+        for (int i = 0; i < refPositions.count_; ++i)
+        {
+            copy_rvec(positionX(refPositions, i), impl.refX_[i]);
+        }
+        impl.testX_.resize(testPositions.count_);
+        for (int i = 0; i < testPositions.count_; ++i)
+        {
+            copy_rvec(positionX(testPositions, i), impl.testX_[i]);
+        }
+        impl.ePBC_ = searchPbc.ePBC;
+        copy_mat(searchPbc.box, impl.box_);
+        impl.bValid_ = true;
+        ++impl.buildCount_;
+    }
+
+    pairs->clear();
+    for (const auto& listPair : impl.pairs_)
+    {
+        const rvec& xref  = positionX(refPositions, listPair.first);
+        const rvec& xtest = positionX(testPositions, listPair.second);
+        rvec        dx;
+        if (searchPbc.ePBC != epbcNONE)
+        {
+            pbc_dx(&searchPbc, xref, xtest, dx);
+        }
+        else
+        {
+            rvec_sub(xref, xtest, dx);
+        }
+        const real r2 = impl.bXY_ ? dx[XX] * dx[XX] + dx[YY] * dx[YY] : norm2(dx);
+        if (r2 <= impl.cutoff2_)
+        {
+            pairs->emplace_back(listPair.first, listPair.second, r2, dx);
+        }
+    }
+}
+
+void AnalysisNeighborhoodPairList::invalidate()
+{
+    GMX_RELEASE_ASSERT(impl_, "Accessing an invalid pair list");
+    impl_->bValid_ = false;
+}
+
+int AnalysisNeighborhoodPairList::buildCount() const
+{
+    GMX_RELEASE_ASSERT(impl_, "Accessing an invalid pair list");
+    return impl_->buildCount_;
+}
+
 } // namespace gmx
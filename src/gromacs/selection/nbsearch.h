@@ -73,6 +73,7 @@ class AnalysisNeighborhoodPairSearchImpl;
 
 class AnalysisNeighborhoodSearch;
 class AnalysisNeighborhoodPairSearch;
+class AnalysisNeighborhoodPairList;
 
 /*! \brief
  * Input positions for neighborhood searching.
@@ -112,6 +113,7 @@ public:
     AnalysisNeighborhoodPositions(const rvec& x) :
         count_(1),
         index_(-1),
+        indexEnd_(-1),
         x_(&x),
         exclusionIds_(nullptr),
         indices_(nullptr)
@@ -123,6 +125,7 @@ public:
     AnalysisNeighborhoodPositions(const rvec x[], int count) :
         count_(count),
         index_(-1),
+        indexEnd_(-1),
         x_(x),
         exclusionIds_(nullptr),
         indices_(nullptr)
@@ -134,6 +137,7 @@ public:
     AnalysisNeighborhoodPositions(const std::vector<RVec>& x) :
         count_(ssize(x)),
         index_(-1),
+        indexEnd_(-1),
         x_(as_rvec_array(x.data())),
         exclusionIds_(nullptr),
         indices_(nullptr)
@@ -183,13 +187,34 @@ public:
     AnalysisNeighborhoodPositions& selectSingleFromArray(int index)
     {
         GMX_ASSERT(index >= 0 && index < count_, "Invalid position index");
-        index_ = index;
+        index_    = index;
+        indexEnd_ = index + 1;
+        return *this;
+    }
+    /*! \brief
+     * Selects a contiguous range of positions to use from an array.
+     *
+     * If called, only positions \p begin to \p end - 1 from the array of
+     * positions passed to the constructor are used instead of the whole
+     * array.  AnalysisNeighborhoodPair objects return the same indices as
+     * without the range, so a pair search can be split over threads by
+     * giving each thread a separate range of test positions.
+     *
+     * If used together with indexed(), \p begin and \p end reference the
+     * index array passed to indexed() instead of the position array.
+     */
+    AnalysisNeighborhoodPositions& selectRangeFromArray(int begin, int end)
+    {
+        GMX_ASSERT(begin >= 0 && begin <= end && end <= count_, "Invalid position range");
+        index_    = begin;
+        indexEnd_ = end;
         return *this;
     }
 
 private:
     int         count_;
     int         index_;
+    int         indexEnd_;
     const rvec* x_;
     const int*  exclusionIds_;
     const int*  indices_;
@@ -198,6 +223,8 @@ private:
     friend class internal::AnalysisNeighborhoodSearchImpl;
     //! To access the positions for initialization.
     friend class internal::AnalysisNeighborhoodPairSearchImpl;
+    //! To access the positions for checking the displacements.
+    friend class AnalysisNeighborhoodPairList;
 };
 
 /*! \brief
@@ -312,6 +339,17 @@ public:
      * AnalysisNeighborhoodPositions::selectSingleFromArray().
      */
     AnalysisNeighborhoodSearch initSearch(const t_pbc* pbc, const AnalysisNeighborhoodPositions& positions);
+    /*! \brief
+     * Initializes a buffered pair list that can be reused over frames.
+     *
+     * \param[in] buffer  Buffer to add to the cutoff when the list is built.
+     * \returns   Pair list that uses the cutoff, exclusions, XY mode and
+     *     search mode set in this object at the time of the call.
+     * \throws    std::bad_alloc if out of memory.
+     *
+     * See AnalysisNeighborhoodPairList for details.
+     */
+    AnalysisNeighborhoodPairList initPairList(real buffer) const;
 
 private:
     class Impl;
@@ -533,6 +571,21 @@ public:
      */
     AnalysisNeighborhoodPairSearch startPairSearch(const AnalysisNeighborhoodPositions& positions) const;
 
+    /*! \brief
+     * Finds all reference positions within a cutoff in a single call.
+     *
+     * \param[in]  positions  Set of test positions to use.
+     * \param[out] pairs      All pairs within the configured cutoff.
+     * \throws     std::bad_alloc if out of memory.
+     *
+     * Returns the same pairs, in the same order, as looping over
+     * startPairSearch() with AnalysisNeighborhoodPairSearch::findNextPair().
+     * \p pairs is cleared first, but its memory is kept, such that calling
+     * this repeatedly with the same vector does not need to reallocate.
+     */
+    void findAllPairs(const AnalysisNeighborhoodPositions&   positions,
+                      std::vector<AnalysisNeighborhoodPair>* pairs) const;
+
 private:
     typedef internal::AnalysisNeighborhoodSearchImpl Impl;
 
@@ -619,6 +672,87 @@ private:
     ImplPointer impl_;
 };
 
+/*! \brief
+ * Buffered pair list for reusing a neighborhood search over several frames.
+ *
+ * The list is built with a search that uses the cutoff plus a buffer, and
+ * is reused in subsequent calls to findAllPairs() until the positions have
+ * moved far enough that a pair outside the buffered cutoff could have come
+ * within the cutoff.  This is similar to the Verlet buffer in mdrun: when
+ * the list is reused, only the distances for the pairs in the list are
+ * computed, which removes most of the search cost for closely spaced frames.
+ *
+ * The list is rebuilt when the largest displacement of the reference
+ * positions plus the largest displacement of the test positions since the
+ * last build, plus the change in the box vectors, exceeds the buffer (for
+ * identical reference and test positions, this means each has moved more
+ * than half the buffer).  Displacements and the distances for the pairs are
+ * computed using the minimum image, so positions that are put back into the
+ * box do not trigger a rebuild.
+ *
+ * The reference and test positions should be the same sets, in the same
+ * order, in each call.  A change in the number of positions is detected,
+ * but if the positions otherwise change (e.g., for dynamic selections),
+ * invalidate() needs to be called.
+ *
+ * The pairs are returned in the order in which they were found when the
+ * list was last built, which is not necessarily the order of a search over
+ * the current positions.
+ *
+ * The object is not thread-safe; use a separate list in each thread.
+ *
+ * Methods in this class do not throw unless otherwise indicated.
+ *
+ * \inpublicapi
+ * \ingroup module_selection
+ */
+class AnalysisNeighborhoodPairList
+{
+public:
+    //! Initializes an invalid pair list.
+    AnalysisNeighborhoodPairList();
+    //! Move constructor.
+    AnalysisNeighborhoodPairList(AnalysisNeighborhoodPairList&& other) noexcept;
+    //! Move assignment.
+    AnalysisNeighborhoodPairList& operator=(AnalysisNeighborhoodPairList&& other) noexcept;
+    ~AnalysisNeighborhoodPairList();
+
+    /*! \brief
+     * Finds all pairs within the cutoff, reusing the list if possible.
+     *
+     * \param[in]  pbc            PBC information for the frame.
+     * \param[in]  refPositions   Reference positions for the frame.
+     * \param[in]  testPositions  Test positions for the frame.
+     * \param[out] pairs          All pairs within the cutoff.
+     * \throws     std::bad_alloc if out of memory.
+     *
+     * \p pbc can be NULL, and has the same requirements as for
+     * AnalysisNeighborhood::initSearch().
+     * Selecting individual test positions with
+     * AnalysisNeighborhoodPositions::selectSingleFromArray() or
+     * AnalysisNeighborhoodPositions::selectRangeFromArray() is not supported.
+     * \p pairs is cleared first, but its memory is kept.
+     */
+    void findAllPairs(const t_pbc*                           pbc,
+                      const AnalysisNeighborhoodPositions&   refPositions,
+                      const AnalysisNeighborhoodPositions&   testPositions,
+                      std::vector<AnalysisNeighborhoodPair>* pairs);
+    //! Forces the list to be rebuilt in the next call to findAllPairs().
+    void invalidate();
+    //! Returns the number of times the list has been built.
+    int buildCount() const;
+
+private:
+    class Impl;
+
+    explicit AnalysisNeighborhoodPairList(Impl* impl);
+
+    PrivateImplPointer<Impl> impl_;
+
+    //! To construct the list.
+    friend class AnalysisNeighborhood;
+};
+
 } // namespace gmx
 
 #endif
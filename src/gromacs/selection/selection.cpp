@@ -43,6 +43,8 @@
 
 #include "selection.h"
 
+#include <cstring>
+
 #include <string>
 
 #include "gromacs/selection/nbsearch.h"
@@ -50,6 +52,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/textwriter.h"
 
@@ -124,6 +127,33 @@ SelectionData::SelectionData(SelectionTreeElement* elem, const char* selstr) :
 }
 
 
+SelectionData::SelectionData(const SelectionData& other) :
+    name_(other.name_),
+    selectionText_(other.selectionText_),
+    posMass_(other.posMass_),
+    posCharge_(other.posCharge_),
+    flags_(other.flags_),
+    rootElement_(other.rootElement_),
+    coveredFractionType_(other.coveredFractionType_),
+    coveredFraction_(other.coveredFraction_),
+    averageCoveredFraction_(other.averageCoveredFraction_),
+    bDynamic_(other.bDynamic_),
+    bDynamicCoveredFraction_(other.bDynamicCoveredFraction_)
+{
+    gmx_ana_pos_copy(&rawPositions_, const_cast<gmx_ana_pos_t*>(&other.rawPositions_), true);
+    // The atoms of the positions may point to memory owned by the
+    // evaluation tree, which changes when the next frame is evaluated.
+    t_blocka& mapb = rawPositions_.m.mapb;
+    if (mapb.nalloc_a == 0 && mapb.nra > 0)
+    {
+        int* atoms = mapb.a;
+        snew(mapb.a, mapb.nra);
+        std::memcpy(mapb.a, atoms, mapb.nra * sizeof(*mapb.a));
+        mapb.nalloc_a = mapb.nra;
+    }
+}
+
+
 SelectionData::~SelectionData() {}
 
 
@@ -257,6 +287,12 @@ void SelectionData::restoreOriginalPositions(const gmx_mtop_t* top)
     }
 }
 
+
+std::unique_ptr<SelectionData> SelectionData::createFrameCopy() const
+{
+    return std::unique_ptr<SelectionData>(new SelectionData(*this));
+}
+
 } // namespace internal
 
 /********************************************************************
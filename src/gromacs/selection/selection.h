@@ -43,6 +43,7 @@
 #ifndef GMX_SELECTION_SELECTION_H
 #define GMX_SELECTION_SELECTION_H
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -187,8 +188,29 @@ public:
      * Called by SelectionEvaluator::evaluateFinal().
      */
     void restoreOriginalPositions(const gmx_mtop_t* top);
+    /*! \brief
+     * Creates a copy of the current evaluated state of the selection.
+     *
+     * \throws    std::bad_alloc if out of memory.
+     *
+     * The copy contains the positions, masses, charges and other data
+     * from the most recent evaluation, and stays unchanged when the
+     * selection is evaluated for later frames.  The copy shares the
+     * evaluation tree with this object, and can only be used for
+     * accessing the data through Selection.
+     *
+     * Called by Selection::createFrameCopy().
+     */
+    std::unique_ptr<SelectionData> createFrameCopy() const;
 
 private:
+    /*! \brief
+     * Creates a frame copy of another selection.
+     *
+     * Used by createFrameCopy().
+     */
+    SelectionData(const SelectionData& other);
+
     //! Name of the selection.
     std::string name_;
     //! The actual selection string.
@@ -222,7 +244,7 @@ private:
      */
     friend class gmx::SelectionPosition;
 
-    GMX_DISALLOW_COPY_AND_ASSIGN(SelectionData);
+    GMX_DISALLOW_ASSIGN(SelectionData);
 };
 
 } // namespace internal
@@ -539,6 +561,24 @@ public:
      */
     void printDebugInfo(FILE* fp, int nmaxind) const;
 
+    /*! \brief
+     * Creates a frame-local copy of the selection data.
+     *
+     * \throws    std::bad_alloc if out of memory.
+     *
+     * The returned object contains the data from the most recent
+     * evaluation, and can be wrapped into a Selection object that stays
+     * valid and unchanged while this selection is evaluated for later
+     * frames.
+     *
+     * Only for internal use by the trajectory analysis framework, which
+     * uses this to analyze multiple frames concurrently.
+     */
+    std::unique_ptr<internal::SelectionData> createFrameCopy() const
+    {
+        return data().createFrameCopy();
+    }
+
 private:
     internal::SelectionData& data()
     {
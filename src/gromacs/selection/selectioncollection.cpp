@@ -873,6 +873,18 @@ void SelectionCollection::evaluateFinal(int nframes)
 }
 
 
+SelectionList SelectionCollection::selections() const
+{
+    SelectionList result;
+    result.reserve(impl_->sc_.sel.size());
+    for (const auto& sel : impl_->sc_.sel)
+    {
+        result.emplace_back(sel.get());
+    }
+    return result;
+}
+
+
 void SelectionCollection::printTree(FILE* fp, bool bValues) const
 {
     SelectionTreeElementPointer sel = impl_->sc_.root;
@@ -388,6 +388,16 @@ public:
      */
     void evaluateFinal(int nframes);
 
+    /*! \brief
+     * Returns all selections in the collection.
+     *
+     * \throws   std::bad_alloc if out of memory.
+     *
+     * Used by the trajectory analysis framework to create frame-local
+     * copies of the selections (see Selection::createFrameCopy()).
+     */
+    SelectionList selections() const;
+
     /*! \brief
      * Prints a human-readable version of the internal selection element
      * tree.
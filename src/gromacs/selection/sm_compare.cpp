@@ -496,96 +496,118 @@ static void free_data_compare(void* data)
 }
 
 /*! \brief
- * Implementation for evaluate_compare() for integer values.
- *
- * \param[in]  g     Evaluation index group.
- * \param[out] out   Output data structure (\p out->u.g is used).
- * \param[in]  data  Should point to a \c t_methoddata_compare.
+ * Returns whether two integer values are equal.
  */
-static void evaluate_compare_int(gmx_ana_index_t* g, gmx_ana_selvalue_t* out, void* data)
+static inline bool compare_equal(int a, int b)
 {
-    t_methoddata_compare* d = static_cast<t_methoddata_compare*>(data);
-    int                   i, i1, i2, ig;
-    int                   a, b;
-    bool                  bAccept;
+    return a == b;
+}
 
-    for (i = i1 = i2 = ig = 0; i < g->isize; ++i)
+/*! \brief
+ * Returns whether two real values are equal within rounding tolerance.
+ */
+static inline bool compare_equal(real a, real b)
+{
+    return gmx_within_tol(a, b, GMX_REAL_EPS);
+}
+
+/*! \brief
+ * Selects the atoms in an index group for which a comparison is true.
+ *
+ * \tparam     LeftType     Type of the left values.
+ * \tparam     RightType    Type of the right values.
+ * \tparam     Comparison   Functor that evaluates the comparison.
+ * \param[in]  g            Evaluation index group.
+ * \param[in]  left         Left values.
+ * \param[in]  bLeftSingle  Whether \p left has only a single value.
+ * \param[in]  right        Right values.
+ * \param[in]  bRightSingle Whether \p right has only a single value.
+ * \param[in]  cmp          Comparison to evaluate.
+ * \param[out] out          Output index group.
+ *
+ * The comparison operator is fixed at compile time and the loop body has no
+ * branches, such that the compiler can vectorize the comparisons.
+ */
+template<typename LeftType, typename RightType, class Comparison>
+static void select_comparison(const gmx_ana_index_t* g,
+                              const LeftType*        left,
+                              bool                   bLeftSingle,
+                              const RightType*       right,
+                              bool                   bRightSingle,
+                              Comparison             cmp,
+                              gmx_ana_index_t*       out)
+{
+    const int leftStride  = bLeftSingle ? 0 : 1;
+    const int rightStride = bRightSingle ? 0 : 1;
+    int*      outIndex    = out->index;
+    int       ig          = 0;
+    for (int i = 0; i < g->isize; ++i)
     {
-        a       = d->left.i[i1];
-        b       = d->right.i[i2];
-        bAccept = false;
-        switch (d->cmpt)
-        {
-            case CMP_INVALID: break;
-            case CMP_LESS: bAccept = a < b; break;
-            case CMP_LEQ: bAccept = a <= b; break;
-            case CMP_GTR: bAccept = a > b; break;
-            case CMP_GEQ: bAccept = a >= b; break;
-            case CMP_EQUAL: bAccept = a == b; break;
-            case CMP_NEQ: bAccept = a != b; break;
-        }
-        if (bAccept)
-        {
-            out->u.g->index[ig++] = g->index[i];
-        }
-        if (!(d->left.flags & CMP_SINGLEVAL))
-        {
-            ++i1;
-        }
-        if (!(d->right.flags & CMP_SINGLEVAL))
-        {
-            ++i2;
-        }
+        /* Always write the index and only advance the output position for
+         * accepted atoms.  Since ig <= i, this also works if out and g share
+         * the same memory. */
+        outIndex[ig] = g->index[i];
+        ig += cmp(left[i * leftStride], right[i * rightStride]) ? 1 : 0;
     }
-    out->u.g->isize = ig;
+    out->isize = ig;
 }
 
 /*! \brief
- * Implementation for evaluate_compare() if either value is non-integer.
+ * Implementation for evaluate_compare() for given value types.
  *
- * \param[in]  g     Evaluation index group.
- * \param[out] out   Output data structure (\p out->u.g is used).
- * \param[in]  data  Should point to a \c t_methoddata_compare.
+ * \param[in]  cmpt         Comparison operator type.
+ * \param[in]  g            Evaluation index group.
+ * \param[in]  left         Left values.
+ * \param[in]  bLeftSingle  Whether \p left has only a single value.
+ * \param[in]  right        Right values.
+ * \param[in]  bRightSingle Whether \p right has only a single value.
+ * \param[out] out          Output index group.
  *
- * Left value is assumed to be real-valued; right value can be either.
+ * If the types differ, the left value is real and the right value is
+ * converted to real for the comparison.
  * This is ensured by the initialization method.
  */
-static void evaluate_compare_real(gmx_ana_index_t* g, gmx_ana_selvalue_t* out, void* data)
+template<typename LeftType, typename RightType>
+static void evaluate_comparison(e_comparison_t         cmpt,
+                                const gmx_ana_index_t* g,
+                                const LeftType*        left,
+                                bool                   bLeftSingle,
+                                const RightType*       right,
+                                bool                   bRightSingle,
+                                gmx_ana_index_t*       out)
 {
-    t_methoddata_compare* d = static_cast<t_methoddata_compare*>(data);
-    int                   i, i1, i2, ig;
-    real                  a, b;
-    bool                  bAccept;
-
-    for (i = i1 = i2 = ig = 0; i < g->isize; ++i)
+    switch (cmpt)
     {
-        a       = d->left.r[i1];
-        b       = (d->right.flags & CMP_REALVAL) ? d->right.r[i2] : d->right.i[i2];
-        bAccept = false;
-        switch (d->cmpt)
-        {
-            case CMP_INVALID: break;
-            case CMP_LESS: bAccept = a < b; break;
-            case CMP_LEQ: bAccept = a <= b; break;
-            case CMP_GTR: bAccept = a > b; break;
-            case CMP_GEQ: bAccept = a >= b; break;
-            case CMP_EQUAL: bAccept = gmx_within_tol(a, b, GMX_REAL_EPS); break;
-            case CMP_NEQ: bAccept = !gmx_within_tol(a, b, GMX_REAL_EPS); break;
-        }
-        if (bAccept)
-        {
-            out->u.g->index[ig++] = g->index[i];
-        }
-        if (!(d->left.flags & CMP_SINGLEVAL))
-        {
-            ++i1;
-        }
-        if (!(d->right.flags & CMP_SINGLEVAL))
-        {
-            ++i2;
-        }
+        case CMP_INVALID: out->isize = 0; break;
+        case CMP_LESS:
+            select_comparison(g, left, bLeftSingle, right, bRightSingle,
+                              [](LeftType a, RightType b) { return a < b; }, out);
+            break;
+        case CMP_LEQ:
+            select_comparison(g, left, bLeftSingle, right, bRightSingle,
+                              [](LeftType a, RightType b) { return a <= b; }, out);
+            break;
+        case CMP_GTR:
+            select_comparison(g, left, bLeftSingle, right, bRightSingle,
+                              [](LeftType a, RightType b) { return a > b; }, out);
+            break;
+        case CMP_GEQ:
+            select_comparison(g, left, bLeftSingle, right, bRightSingle,
+                              [](LeftType a, RightType b) { return a >= b; }, out);
+            break;
+        case CMP_EQUAL:
+            select_comparison(
+                    g, left, bLeftSingle, right, bRightSingle,
+                    [](LeftType a, RightType b) { return compare_equal(a, static_cast<LeftType>(b)); },
+                    out);
+            break;
+        case CMP_NEQ:
+            select_comparison(
+                    g, left, bLeftSingle, right, bRightSingle,
+                    [](LeftType a, RightType b) { return !compare_equal(a, static_cast<LeftType>(b)); },
+                    out);
+            break;
     }
-    out->u.g->isize = ig;
 }
 
 static void evaluate_compare(const gmx::SelMethodEvalContext& /*context*/,
@@ -593,14 +615,20 @@ static void evaluate_compare(const gmx::SelMethodEvalContext& /*context*/,
                              gmx_ana_selvalue_t* out,
                              void*               data)
 {
-    t_methoddata_compare* d = static_cast<t_methoddata_compare*>(data);
+    t_methoddata_compare* d            = static_cast<t_methoddata_compare*>(data);
+    const bool            bLeftSingle  = (d->left.flags & CMP_SINGLEVAL) != 0;
+    const bool            bRightSingle = (d->right.flags & CMP_SINGLEVAL) != 0;
 
     if (!((d->left.flags | d->right.flags) & CMP_REALVAL))
     {
-        evaluate_compare_int(g, out, data);
+        evaluate_comparison(d->cmpt, g, d->left.i, bLeftSingle, d->right.i, bRightSingle, out->u.g);
+    }
+    else if (d->right.flags & CMP_REALVAL)
+    {
+        evaluate_comparison(d->cmpt, g, d->left.r, bLeftSingle, d->right.r, bRightSingle, out->u.g);
     }
     else
     {
-        evaluate_compare_real(g, out, data);
+        evaluate_comparison(d->cmpt, g, d->left.r, bLeftSingle, d->right.i, bRightSingle, out->u.g);
     }
 }
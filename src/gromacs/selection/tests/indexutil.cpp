@@ -78,6 +78,22 @@ TEST(IndexGroupTest, RemovesDuplicates)
     EXPECT_TRUE(gmx_ana_index_equals(&g, &e));
 }
 
+TEST(IndexGroupTest, PartitionsInPlace)
+{
+    int             index[]     = { 1, 2, 4, 5, 7, 8, 9 };
+    int             selected[]  = { 2, 5, 8, 9 };
+    int             remaining[] = { 1, 4, 7 };
+    gmx_ana_index_t g           = initGroup(index);
+    gmx_ana_index_t part        = initGroup(selected);
+    gmx_ana_index_t rest        = initGroup(remaining);
+    gmx_ana_index_t dest2;
+    gmx_ana_index_partition(&g, &dest2, &g, &part);
+    EXPECT_TRUE(gmx_ana_index_equals(&g, &part));
+    EXPECT_TRUE(gmx_ana_index_equals(&dest2, &rest));
+    // Evaluation of "or" relies on the two parts being stored consecutively.
+    EXPECT_EQ(g.index + g.isize, dest2.index);
+}
+
 //! Text fixture for index block operations
 class IndexBlockTest : public ::testing::Test
 {
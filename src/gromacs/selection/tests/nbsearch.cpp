@@ -408,6 +408,8 @@ public:
                              const NeighborhoodSearchTestData& data);
     void testNearestPoint(gmx::AnalysisNeighborhoodSearch* search, const NeighborhoodSearchTestData& data);
     void testPairSearch(gmx::AnalysisNeighborhoodSearch* search, const NeighborhoodSearchTestData& data);
+    void testFindAllPairs(gmx::AnalysisNeighborhoodSearch* search, const NeighborhoodSearchTestData& data);
+    void testPairList(const NeighborhoodSearchTestData& data);
     void testPairSearchIndexed(gmx::AnalysisNeighborhood*        nb,
                                const NeighborhoodSearchTestData& data,
                                uint64_t                          seed);
@@ -653,6 +655,132 @@ void NeighborhoodSearchTest::testPairSearchFull(gmx::AnalysisNeighborhoodSearch*
     }
 }
 
+//! Helper function to check that two pairs are identical.
+void checkPairsEqual(const gmx::AnalysisNeighborhoodPair& expected, const gmx::AnalysisNeighborhoodPair& actual)
+{
+    EXPECT_EQ(expected.testIndex(), actual.testIndex());
+    EXPECT_EQ(expected.refIndex(), actual.refIndex());
+    EXPECT_EQ(expected.distance2(), actual.distance2());
+}
+
+/*! \brief
+ * Checks that findAllPairs() and range-restricted searches match findNextPair().
+ */
+void NeighborhoodSearchTest::testFindAllPairs(gmx::AnalysisNeighborhoodSearch*  search,
+                                              const NeighborhoodSearchTestData& data)
+{
+    std::vector<gmx::AnalysisNeighborhoodPair> expected;
+    gmx::AnalysisNeighborhoodPairSearch pairSearch = search->startPairSearch(data.testPositions());
+    gmx::AnalysisNeighborhoodPair       pair;
+    while (pairSearch.findNextPair(&pair))
+    {
+        expected.push_back(pair);
+    }
+
+    std::vector<gmx::AnalysisNeighborhoodPair> pairs;
+    search->findAllPairs(data.testPositions(), &pairs);
+    ASSERT_EQ(expected.size(), pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        checkPairsEqual(expected[i], pairs[i]);
+    }
+
+    // Split the test positions into uneven ranges, as a thread-parallel
+    // caller would do, and check that together they give the full search.
+    const int              testPosCount = data.testPositions_.size();
+    const std::vector<int> rangeEnds    = {
+        0, testPosCount / 3, testPosCount / 3, testPosCount - 1, testPosCount
+    };
+    size_t expectedIndex = 0;
+    for (size_t r = 1; r < rangeEnds.size(); ++r)
+    {
+        search->findAllPairs(data.testPositions().selectRangeFromArray(rangeEnds[r - 1], rangeEnds[r]),
+                             &pairs);
+        for (const auto& rangePair : pairs)
+        {
+            EXPECT_LE(rangeEnds[r - 1], rangePair.testIndex());
+            EXPECT_GT(rangeEnds[r], rangePair.testIndex());
+            ASSERT_LT(expectedIndex, expected.size());
+            checkPairsEqual(expected[expectedIndex], rangePair);
+            ++expectedIndex;
+        }
+    }
+    EXPECT_EQ(expected.size(), expectedIndex);
+}
+
+//! Helper function for sorting pairs for comparison.
+bool pairIndicesLess(const gmx::AnalysisNeighborhoodPair& a, const gmx::AnalysisNeighborhoodPair& b)
+{
+    return a.testIndex() < b.testIndex()
+           || (a.testIndex() == b.testIndex() && a.refIndex() < b.refIndex());
+}
+
+/*! \brief
+ * Checks that a buffered pair list finds the same pairs as a search over
+ * moving positions, and that it is rebuilt only when needed.
+ */
+void NeighborhoodSearchTest::testPairList(const NeighborhoodSearchTestData& data)
+{
+    const real                        buffer   = 0.1;
+    gmx::AnalysisNeighborhoodPairList pairList = nb_.initPairList(buffer);
+    std::vector<gmx::RVec>            refPos(data.refPos_);
+    std::vector<gmx::RVec>            testPos;
+    for (const auto& testPosition : data.testPositions_)
+    {
+        testPos.emplace_back(testPosition.x);
+    }
+
+    gmx::DefaultRandomEngine           rng(12345);
+    gmx::UniformRealDistribution<real> dist;
+    // Each step moves each position by at most 0.005*sqrt(3), such that
+    // two steps stay within the buffer for both reference and test positions.
+    auto displace = [&rng, &dist](std::vector<gmx::RVec>* x) {
+        for (auto& pos : *x)
+        {
+            for (int d = 0; d < DIM; ++d)
+            {
+                pos[d] += 0.01 * dist(rng) - 0.005;
+            }
+        }
+    };
+
+    std::vector<gmx::AnalysisNeighborhoodPair> pairs;
+    std::vector<gmx::AnalysisNeighborhoodPair> expected;
+    for (int step = 0; step < 4; ++step)
+    {
+        if (step == 3)
+        {
+            // Moves further than the buffer, which requires a rebuild.
+            refPos[0][XX] += 2 * buffer;
+        }
+        else if (step > 0)
+        {
+            displace(&refPos);
+            displace(&testPos);
+        }
+        pairList.findAllPairs(&data.pbc_, refPos, testPos, &pairs);
+        gmx::AnalysisNeighborhoodSearch search = nb_.initSearch(&data.pbc_, refPos);
+        search.findAllPairs(testPos, &expected);
+        search.reset();
+        EXPECT_EQ(step < 3 ? 1 : 2, pairList.buildCount());
+
+        std::sort(pairs.begin(), pairs.end(), pairIndicesLess);
+        std::sort(expected.begin(), expected.end(), pairIndicesLess);
+        ASSERT_EQ(expected.size(), pairs.size());
+        for (size_t i = 0; i < pairs.size(); ++i)
+        {
+            EXPECT_EQ(expected[i].testIndex(), pairs[i].testIndex());
+            EXPECT_EQ(expected[i].refIndex(), pairs[i].refIndex());
+            EXPECT_REAL_EQ_TOL(std::sqrt(expected[i].distance2()), std::sqrt(pairs[i].distance2()),
+                               data.relativeTolerance());
+        }
+    }
+
+    pairList.invalidate();
+    pairList.findAllPairs(&data.pbc_, refPos, testPos, &pairs);
+    EXPECT_EQ(3, pairList.buildCount());
+}
+
 /********************************************************************
  * Test data generation
  */
@@ -901,6 +1029,7 @@ TEST_F(NeighborhoodSearchTest, SimpleSearch)
     testMinimumDistance(&search, data);
     testNearestPoint(&search, data);
     testPairSearch(&search, data);
+    testFindAllPairs(&search, data);
 
     search.reset();
     testPairSearchIndexed(&nb_, data, 123);
@@ -920,6 +1049,7 @@ TEST_F(NeighborhoodSearchTest, SimpleSearchXY)
     testMinimumDistance(&search, data);
     testNearestPoint(&search, data);
     testPairSearch(&search, data);
+    testFindAllPairs(&search, data);
 }
 
 TEST_F(NeighborhoodSearchTest, GridSearchBox)
@@ -935,6 +1065,7 @@ TEST_F(NeighborhoodSearchTest, GridSearchBox)
     testMinimumDistance(&search, data);
     testNearestPoint(&search, data);
     testPairSearch(&search, data);
+    testFindAllPairs(&search, data);
 
     search.reset();
     testPairSearchIndexed(&nb_, data, 456);
@@ -950,6 +1081,7 @@ TEST_F(NeighborhoodSearchTest, GridSearchTriclinic)
     ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
 
     testPairSearch(&search, data);
+    testFindAllPairs(&search, data);
 }
 
 TEST_F(NeighborhoodSearchTest, GridSearch2DPBC)
@@ -965,6 +1097,7 @@ TEST_F(NeighborhoodSearchTest, GridSearch2DPBC)
     testMinimumDistance(&search, data);
     testNearestPoint(&search, data);
     testPairSearch(&search, data);
+    testFindAllPairs(&search, data);
 }
 
 TEST_F(NeighborhoodSearchTest, GridSearchNoPBC)
@@ -977,6 +1110,7 @@ TEST_F(NeighborhoodSearchTest, GridSearchNoPBC)
     ASSERT_EQ(gmx::AnalysisNeighborhood::eSearchMode_Grid, search.mode());
 
     testPairSearch(&search, data);
+    testFindAllPairs(&search, data);
 }
 
 TEST_F(NeighborhoodSearchTest, GridSearchXYBox)
@@ -993,6 +1127,7 @@ TEST_F(NeighborhoodSearchTest, GridSearchXYBox)
     testMinimumDistance(&search, data);
     testNearestPoint(&search, data);
     testPairSearch(&search, data);
+    testFindAllPairs(&search, data);
 }
 
 TEST_F(NeighborhoodSearchTest, SimpleSelfPairsSearch)
@@ -1144,4 +1279,50 @@ TEST_F(NeighborhoodSearchTest, GridSearchExclusions)
                        helper.exclusions(), {}, {}, false);
 }
 
+TEST_F(NeighborhoodSearchTest, SimplePairList)
+{
+    const NeighborhoodSearchTestData& data = RandomBoxFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Simple);
+    testPairList(data);
+}
+
+TEST_F(NeighborhoodSearchTest, GridPairList)
+{
+    const NeighborhoodSearchTestData& data = RandomBoxFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    testPairList(data);
+}
+
+TEST_F(NeighborhoodSearchTest, GridPairListTriclinic)
+{
+    const NeighborhoodSearchTestData& data = RandomTriclinicFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    testPairList(data);
+}
+
+TEST_F(NeighborhoodSearchTest, GridPairListXY)
+{
+    const NeighborhoodSearchTestData& data = RandomBoxXYFullPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    nb_.setXYMode(true);
+    testPairList(data);
+}
+
+TEST_F(NeighborhoodSearchTest, GridPairListNoPBC)
+{
+    const NeighborhoodSearchTestData& data = RandomBoxNoPBCData::get();
+
+    nb_.setCutoff(data.cutoff_);
+    nb_.setMode(gmx::AnalysisNeighborhood::eSearchMode_Grid);
+    testPairList(data);
+}
+
 } // namespace
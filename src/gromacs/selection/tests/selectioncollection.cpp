@@ -1164,6 +1164,22 @@ TEST_F(SelectionCollectionDataTest, HandlesBasicBoolean)
 }
 
 
+TEST_F(SelectionCollectionDataTest, HandlesOrWithOverlappingChildren)
+{
+    static const char* const selections[] = {
+        "y < 2 or x > 3 or y > 3",
+        "x > 3 or y < 2 or atomnr 2 to 6",
+        "atomnr 12 to 15 or y > 3 or x < 2 or y < 2",
+        "x < 3 and (y > 3 or x < 2 or y < 2)",
+        "not (y < 2 or x > 3 or y > 3)",
+        "edges = y > 3 or x < 2 or y < 2",
+        "edges and x < 3"
+    };
+    setFlags(TestFlags() | efTestEvaluation);
+    runTest("simple.gro", selections);
+}
+
+
 TEST_F(SelectionCollectionDataTest, HandlesDynamicAtomValuedParameters)
 {
     static const char* const selections[] = {
@@ -1231,6 +1247,17 @@ TEST_F(SelectionCollectionDataTest, HandlesNumericComparisons)
 }
 
 
+TEST_F(SelectionCollectionDataTest, HandlesSingleValueAndPerAtomComparisons)
+{
+    static const char* const selections[] = { "x < y",      "y > 2.5",    "2.5 < y",
+                                              "y >= x",     "x + y < 5",  "x == 2",
+                                              "resnr != 2", "3 >= resnr", "resnr >= y",
+                                              "resnr < y - 1" };
+    setFlags(TestFlags() | efTestEvaluation | efTestPositionCoordinates);
+    runTest("simple.gro", selections);
+}
+
+
 TEST_F(SelectionCollectionDataTest, HandlesArithmeticExpressions)
 {
     static const char* const selections[] = { "x+1 > 3", "(y-1)^2 <= 1", "x+--1 > 3", "-x+-1 < -3" };
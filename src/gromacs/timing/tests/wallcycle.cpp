@@ -0,0 +1,117 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the wallcycle trace timeline.
+ *
+ * \ingroup module_timing
+ */
+#include "gmxpre.h"
+
+#include "gromacs/timing/wallcycle.h"
+
+#include <cinttypes>
+
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textreader.h"
+
+#include "testutils/setenv.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Returns a regular expression matching a complete counter event of \p name at \p step
+std::regex counterEventRegex(const std::string& name, int64_t step, bool isLastEvent)
+{
+    return std::regex(formatString(R"(\{"name":"%s","cat":"counter","ph":"X","ts":[0-9]+\.[0-9]{3},)"
+                                   R"("dur":[0-9]+\.[0-9]{3},"pid":0,"tid":0,"args":\{"step":%)" PRId64
+                                   R"(\}\}%s)",
+                                   name.c_str(), step, isLastEvent ? "" : ","));
+}
+
+TEST(WallcycleTraceTest, WritesChromeTraceEventsTaggedWithMdStep)
+{
+    if (!wallcycle_have_counter())
+    {
+        return;
+    }
+
+    TestFileManager   fileManager;
+    const std::string tracePrefix = fileManager.getTemporaryFilePath("trace");
+    // Also registers the trace file for removal after the test
+    const std::string traceFilename = fileManager.getTemporaryFilePath("trace_rank0.json");
+
+    gmxSetenv("GMX_CYCLE_TRACE", tracePrefix.c_str(), 1);
+    gmx_wallcycle_t wc = wallcycle_init(nullptr, 0, nullptr);
+    gmxUnsetenv("GMX_CYCLE_TRACE");
+    ASSERT_NE(nullptr, wc);
+
+    // Steps that do not start at zero, as with init-step or a checkpoint restart
+    wallcycle_set_step(wc, 5000);
+    wallcycle_start(wc, ewcSTEP);
+    wallcycle_start(wc, ewcFORCE);
+    wallcycle_stop(wc, ewcFORCE);
+    wallcycle_stop(wc, ewcSTEP);
+    wallcycle_set_step(wc, 5010);
+    wallcycle_start(wc, ewcSTEP);
+    wallcycle_stop(wc, ewcSTEP);
+    wallcycle_destroy(wc);
+
+    const std::vector<std::string> lines =
+            splitDelimitedString(stripString(TextReader::readFileToString(traceFilename)), '\n');
+    ASSERT_EQ(7U, lines.size());
+    EXPECT_EQ(R"({"displayTimeUnit":"ms","otherData":{"droppedEvents":0},)", lines[0]);
+    EXPECT_EQ(R"("traceEvents":[)", lines[1]);
+    EXPECT_EQ(R"({"name":"process_name","ph":"M","pid":0,"args":{"name":"rank 0"}},)", lines[2]);
+    EXPECT_TRUE(std::regex_match(lines[3], counterEventRegex("Force", 5000, false))) << lines[3];
+    EXPECT_TRUE(std::regex_match(lines[4], counterEventRegex("Step", 5000, false))) << lines[4];
+    EXPECT_TRUE(std::regex_match(lines[5], counterEventRegex("Step", 5010, true))) << lines[5];
+    EXPECT_EQ("]}", lines[6]);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -40,9 +40,12 @@
 
 #include "config.h"
 
+#include <cinttypes>
 #include <cstdlib>
 
+#include <algorithm>
 #include <array>
+#include <string>
 #include <vector>
 
 #include "gromacs/math/functions.h"
@@ -50,12 +53,15 @@
 #include "gromacs/timing/cyclecounter.h"
 #include "gromacs/timing/gpu_timing.h"
 #include "gromacs/timing/wallcyclereporting.h"
+#include "gromacs/timing/walltime_accounting.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/gmxmpi.h"
 #include "gromacs/utility/logger.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/snprintf.h"
+#include "gromacs/utility/stringutil.h"
 
 static const bool useCycleSubcounters = GMX_CYCLE_SUBCOUNTERS;
 
@@ -76,6 +82,36 @@ typedef struct
     gmx_cycles_t start;
 } wallcc_t;
 
+/* Interval of one counter, recorded for the trace timeline */
+struct WallcycleTraceEvent
+{
+    gmx_cycles_t start;
+    gmx_cycles_t duration;
+    int64_t      step;
+    int          counter; /* ewc, or ewcNR + ewcs for sub-counters */
+};
+
+/* Ring buffer with the most recent counter intervals of this rank,
+ * written as a Chrome trace event file at the end of the run.
+ * Recording an event is only a few stores, so this can be left
+ * enabled in production runs.
+ */
+struct WallcycleTrace
+{
+    std::string                      fileName;
+    int                              rank;
+    std::vector<WallcycleTraceEvent> events;
+    /* Total number of events recorded, including those overwritten */
+    int64_t numRecorded;
+    /* MD step set by the integrator, -1 before the first step */
+    int64_t      step;
+    gmx_cycles_t cycleStart;
+    double       timeStart;
+};
+
+/* Number of events kept in the trace ring buffer, 8 MB worth */
+static const int c_wallcycleTraceSize = 1 << 18;
+
 struct gmx_wallcycle
 {
     wallcc_t* wcc;
@@ -96,7 +132,8 @@ struct gmx_wallcycle
 #if GMX_MPI
     MPI_Comm mpi_comm_mygroup;
 #endif
-    wallcc_t* wcsc;
+    wallcc_t*       wcsc;
+    WallcycleTrace* trace;
 };
 
 /* Each name should not exceed 19 printing characters
@@ -208,7 +245,7 @@ gmx_wallcycle_t wallcycle_init(FILE* fplog, int resetstep, t_commrec gmx_unused*
     wc->reset_counters   = resetstep;
 
 #if GMX_MPI
-    if (PAR(cr) && getenv("GMX_CYCLE_BARRIER") != nullptr)
+    if (cr != nullptr && PAR(cr) && getenv("GMX_CYCLE_BARRIER") != nullptr)
     {
         if (fplog)
         {
@@ -234,6 +271,25 @@ gmx_wallcycle_t wallcycle_init(FILE* fplog, int resetstep, t_commrec gmx_unused*
         snew(wc->wcsc, ewcsNR);
     }
 
+    const char* traceFileName = getenv("GMX_CYCLE_TRACE");
+    if (traceFileName != nullptr)
+    {
+        wc->trace       = new WallcycleTrace;
+        wc->trace->rank = (cr != nullptr ? cr->sim_nodeid : 0);
+        wc->trace->fileName =
+                gmx::formatString("%s_rank%d.json", traceFileName, wc->trace->rank);
+        wc->trace->events.resize(c_wallcycleTraceSize);
+        wc->trace->numRecorded = 0;
+        wc->trace->step        = -1;
+        wc->trace->cycleStart  = gmx_cycles_read();
+        wc->trace->timeStart   = gmx_gettime();
+        if (fplog)
+        {
+            fprintf(fplog, "\nWill write a timeline of the last %d timed events to %s\n\n",
+                    c_wallcycleTraceSize, wc->trace->fileName.c_str());
+        }
+    }
+
 #ifdef DEBUG_WCYCLE
     wc->count_depth = 0;
 #endif
@@ -241,6 +297,54 @@ gmx_wallcycle_t wallcycle_init(FILE* fplog, int resetstep, t_commrec gmx_unused*
     return wc;
 }
 
+static void wallcycle_trace_record(WallcycleTrace* trace, int counter, gmx_cycles_t start, gmx_cycles_t duration)
+{
+    WallcycleTraceEvent& event = trace->events[trace->numRecorded % c_wallcycleTraceSize];
+
+    event.start    = start;
+    event.duration = duration;
+    event.step     = trace->step;
+    event.counter  = counter;
+    trace->numRecorded++;
+}
+
+/* Writes the recorded events in the Chrome trace event format,
+ * which can be viewed with e.g. chrome://tracing or Perfetto.
+ */
+static void wallcycle_trace_write(const WallcycleTrace& trace)
+{
+    const gmx_cycles_t cycleEnd = gmx_cycles_read();
+    const double       timeEnd  = gmx_gettime();
+    if (cycleEnd <= trace.cycleStart || timeEnd <= trace.timeStart)
+    {
+        return;
+    }
+    /* Convert cycles to microseconds */
+    const double c2us = 1e6 * (timeEnd - trace.timeStart) / (cycleEnd - trace.cycleStart);
+
+    FILE* fp = gmx_ffopen(trace.fileName, "w");
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%" PRId64 "},\n",
+            std::max<int64_t>(trace.numRecorded - c_wallcycleTraceSize, 0));
+    fprintf(fp, "\"traceEvents\":[\n");
+    fprintf(fp,
+            "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank "
+            "%d\"}}",
+            trace.rank, trace.rank);
+    const int64_t first = std::max<int64_t>(trace.numRecorded - c_wallcycleTraceSize, 0);
+    for (int64_t i = first; i < trace.numRecorded; i++)
+    {
+        const WallcycleTraceEvent& event = trace.events[i % c_wallcycleTraceSize];
+        const char* name = (event.counter < ewcNR ? wcn[event.counter] : wcsn[event.counter - ewcNR]);
+        fprintf(fp,
+                ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                "\"pid\":%d,\"tid\":0,\"args\":{\"step\":%" PRId64 "}}",
+                name, event.counter < ewcNR ? "counter" : "subcounter",
+                (event.start - trace.cycleStart) * c2us, event.duration * c2us, trace.rank, event.step);
+    }
+    fprintf(fp, "\n]}\n");
+    gmx_ffclose(fp);
+}
+
 void wallcycle_destroy(gmx_wallcycle_t wc)
 {
     if (wc == nullptr)
@@ -248,6 +352,12 @@ void wallcycle_destroy(gmx_wallcycle_t wc)
         return;
     }
 
+    if (wc->trace != nullptr)
+    {
+        wallcycle_trace_write(*wc->trace);
+        delete wc->trace;
+    }
+
     if (wc->wcc != nullptr)
     {
         sfree(wc->wcc);
@@ -404,6 +514,10 @@ double wallcycle_stop(gmx_wallcycle_t wc, int ewc)
     }
     wc->wcc[ewc].c += last;
     wc->wcc[ewc].n++;
+    if (wc->trace)
+    {
+        wallcycle_trace_record(wc->trace, ewc, wc->wcc[ewc].start, last);
+    }
     if (wc->wcc_all)
     {
         wc->wc_depth--;
@@ -1153,6 +1267,14 @@ extern void wcycle_set_reset_counters(gmx_wallcycle_t wc, int64_t reset_counters
     wc->reset_counters = reset_counters;
 }
 
+void wallcycle_set_step(gmx_wallcycle_t wc, int64_t step)
+{
+    if (wc != nullptr && wc->trace != nullptr)
+    {
+        wc->trace->step = step;
+    }
+}
+
 void wallcycle_sub_start(gmx_wallcycle_t wc, int ewcs)
 {
     if (useCycleSubcounters && wc != nullptr)
@@ -1174,7 +1296,12 @@ void wallcycle_sub_stop(gmx_wallcycle_t wc, int ewcs)
 {
     if (useCycleSubcounters && wc != nullptr)
     {
-        wc->wcsc[ewcs].c += gmx_cycles_read() - wc->wcsc[ewcs].start;
+        const gmx_cycles_t last = gmx_cycles_read() - wc->wcsc[ewcs].start;
+        wc->wcsc[ewcs].c += last;
         wc->wcsc[ewcs].n++;
+        if (wc->trace)
+        {
+            wallcycle_trace_record(wc->trace, ewcNR + ewcs, wc->wcsc[ewcs].start, last);
+        }
     }
 }
@@ -136,6 +136,7 @@ gmx_bool wallcycle_have_counter();
 gmx_wallcycle_t wallcycle_init(FILE* fplog, int resetstep, struct t_commrec* cr);
 /* Returns the wall cycle structure.
  * Returns NULL when cycle counting is not supported.
+ * cr can be NULL when not running in parallel.
  */
 
 /* cleans up wallcycle structure */
@@ -168,6 +169,9 @@ int64_t wcycle_get_reset_counters(gmx_wallcycle_t wc);
 void wcycle_set_reset_counters(gmx_wallcycle_t wc, int64_t reset_counters);
 /* Set reset_counters */
 
+void wallcycle_set_step(gmx_wallcycle_t wc, int64_t step);
+/* Set the MD step that events in the GMX_CYCLE_TRACE timeline are tagged with */
+
 void wallcycle_sub_start(gmx_wallcycle_t wc, int ewcs);
 /* Set the start sub cycle count for ewcs */
 
@@ -45,10 +45,13 @@
 #include "analysismodule.h"
 
 #include <map>
+#include <memory>
 #include <utility>
+#include <vector>
 
 #include "gromacs/analysisdata/analysisdata.h"
 #include "gromacs/selection/selection.h"
+#include "gromacs/selection/selectioncollection.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/gmxassert.h"
 
@@ -98,6 +101,8 @@ class TrajectoryAnalysisModuleData::Impl
 public:
     //! Container that associates a data handle to its AnalysisData object.
     typedef std::map<const AnalysisData*, AnalysisDataHandle> HandleContainer;
+    //! Smart pointer type to manage frame-local selection data.
+    typedef std::unique_ptr<internal::SelectionData> SelectionDataPointer;
 
     //! \copydoc TrajectoryAnalysisModuleData::TrajectoryAnalysisModuleData()
     Impl(TrajectoryAnalysisModule*          module,
@@ -111,6 +116,10 @@ public:
     HandleContainer handles_;
     //! Stores thread-local selections.
     const SelectionCollection& selections_;
+    //! Global selections that have frame-local copies.
+    SelectionList globalSelections_;
+    //! Frame-local copies of \a globalSelections_ (in the same order).
+    std::vector<SelectionDataPointer> frameSelections_;
 };
 
 TrajectoryAnalysisModuleData::Impl::Impl(TrajectoryAnalysisModule*          module,
@@ -185,7 +194,13 @@ AnalysisDataHandle TrajectoryAnalysisModuleData::dataHandle(const AnalysisData&
 
 Selection TrajectoryAnalysisModuleData::parallelSelection(const Selection& selection)
 {
-    // TODO: Implement properly.
+    for (size_t i = 0; i < impl_->globalSelections_.size(); ++i)
+    {
+        if (impl_->globalSelections_[i] == selection)
+        {
+            return Selection(impl_->frameSelections_[i].get());
+        }
+    }
     return selection;
 }
 
@@ -204,6 +219,22 @@ SelectionList TrajectoryAnalysisModuleData::parallelSelections(const SelectionLi
 }
 
 
+void TrajectoryAnalysisModuleData::copyFrameSelections()
+{
+    if (impl_->globalSelections_.empty())
+    {
+        impl_->globalSelections_ = impl_->selections_.selections();
+    }
+    std::vector<Impl::SelectionDataPointer> frameSelections;
+    frameSelections.reserve(impl_->globalSelections_.size());
+    for (const Selection& sel : impl_->globalSelections_)
+    {
+        frameSelections.push_back(sel.createFrameCopy());
+    }
+    impl_->frameSelections_ = std::move(frameSelections);
+}
+
+
 /********************************************************************
  * TrajectoryAnalysisModuleDataBasic
  */
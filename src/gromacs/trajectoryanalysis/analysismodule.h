@@ -141,6 +141,21 @@ public:
      */
     SelectionList parallelSelections(const SelectionList& selections);
 
+    /*! \brief
+     * Stores frame-local copies of the current state of all selections.
+     *
+     * \throws std::bad_alloc if out of memory.
+     *
+     * Called by the runner after the selections have been evaluated for
+     * the frame that is next analyzed with this object, when multiple
+     * frames are analyzed concurrently.  After this call,
+     * parallelSelection() returns the copies, so that the results are
+     * not affected by evaluating the selections for subsequent frames.
+     * If this method is never called, parallelSelection() returns the
+     * global selections.
+     */
+    void copyFrameSelections();
+
 protected:
     /*! \brief
      * Initializes thread-local storage for data handles and selections.
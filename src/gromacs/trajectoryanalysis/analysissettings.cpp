@@ -110,6 +110,12 @@ bool TrajectoryAnalysisSettings::hasRmPBC() const
 }
 
 
+int TrajectoryAnalysisSettings::frameThreadCount() const
+{
+    return impl_->frameThreadCount;
+}
+
+
 int TrajectoryAnalysisSettings::frflags() const
 {
     return impl_->frflags;
@@ -128,6 +128,23 @@ public:
          * \see setRmPBC()
          */
         efNoUserRmPBC = 1 << 5,
+        /*! \brief
+         * Allows analyzing multiple frames concurrently.
+         *
+         * If this flag is specified, a command-line option is provided for
+         * the user to set the number of threads, and
+         * TrajectoryAnalysisModule::analyzeFrame() may be called
+         * concurrently for different frames, each with its own
+         * TrajectoryAnalysisModuleData object from
+         * TrajectoryAnalysisModule::startFrames().
+         * The module should then only access selections through
+         * TrajectoryAnalysisModuleData::parallelSelection(), only write
+         * output through the data handles, and keep any other frame-local
+         * state in the TrajectoryAnalysisModuleData object.
+         *
+         * \see frameThreadCount()
+         */
+        efFrameParallel = 1 << 6,
     };
 
     //! Initializes default settings.
@@ -162,6 +179,13 @@ public:
      * user-provided value.
      */
     bool hasRmPBC() const;
+    /*! \brief
+     * Returns the number of frames to analyze concurrently.
+     *
+     * Always one unless \ref efFrameParallel has been set, in which case
+     * the value is provided by the user.
+     */
+    int frameThreadCount() const;
     //! Returns the currently set frame flags.
     int frflags() const;
 
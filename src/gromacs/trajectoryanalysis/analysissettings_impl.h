@@ -68,6 +68,7 @@ public:
         frflags(0),
         bRmPBC(true),
         bPBC(true),
+        frameThreadCount(1),
         optionsModuleSettings_(nullptr)
     {
     }
@@ -85,6 +86,8 @@ public:
     bool bRmPBC;
     //! Whether to pass PBC information to the analysis module.
     bool bPBC;
+    //! Number of frames to analyze concurrently.
+    int frameThreadCount;
 
     //! Lower-level settings object wrapped by these settings.
     ICommandLineOptionsModuleSettings* optionsModuleSettings_;
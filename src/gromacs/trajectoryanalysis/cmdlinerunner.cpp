@@ -44,9 +44,13 @@
 
 #include "cmdlinerunner.h"
 
+#include <exception>
+#include <vector>
+
 #include "gromacs/analysisdata/paralleloptions.h"
 #include "gromacs/commandline/cmdlinemodulemanager.h"
 #include "gromacs/commandline/cmdlineoptionsmodule.h"
+#include "gromacs/math/vectypes.h"
 #include "gromacs/options/ioptionscontainer.h"
 #include "gromacs/options/timeunitmanager.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -68,6 +72,78 @@ namespace gmx
 namespace
 {
 
+/********************************************************************
+ * ParallelFrameData
+ */
+
+/*! \brief
+ * Frame-local state for a frame that is analyzed concurrently with others.
+ *
+ * Keeps a private copy of the frame data and PBC information, so that the
+ * runner can proceed to read and evaluate selections for the next frames
+ * while this frame is still being analyzed.
+ */
+class ParallelFrameData
+{
+public:
+    //! Makes \a frame_ a copy of \p source that does not share any memory.
+    void copyFrame(const t_trxframe& source);
+
+    //! Copy of the frame passed to analyzeFrame().
+    t_trxframe frame_;
+    //! PBC information for \a frame_.
+    t_pbc pbc_;
+    //! Thread-local data for the module.
+    TrajectoryAnalysisModuleDataPointer pdata_;
+    //! Exception thrown during analysis of the frame, if any.
+    std::exception_ptr exception_;
+
+private:
+    //! Storage for coordinates in \a frame_.
+    std::vector<RVec> x_;
+    //! Storage for velocities in \a frame_.
+    std::vector<RVec> v_;
+    //! Storage for forces in \a frame_.
+    std::vector<RVec> f_;
+    //! Storage for the atom index in \a frame_.
+    std::vector<int> index_;
+};
+
+/*! \brief
+ * Copies an array of vectors from \p source into \p buffer.
+ *
+ * \returns \p buffer as an array, or NULL if \p source is NULL.
+ */
+rvec* copyFrameArray(const rvec* source, int count, std::vector<RVec>* buffer)
+{
+    if (source == nullptr)
+    {
+        return nullptr;
+    }
+    buffer->assign(source, source + count);
+    return as_rvec_array(buffer->data());
+}
+
+//! \copydoc copyFrameArray(const rvec*, int, std::vector<RVec>*)
+int* copyFrameArray(const int* source, int count, std::vector<int>* buffer)
+{
+    if (source == nullptr)
+    {
+        return nullptr;
+    }
+    buffer->assign(source, source + count);
+    return buffer->data();
+}
+
+void ParallelFrameData::copyFrame(const t_trxframe& source)
+{
+    frame_       = source;
+    frame_.x     = copyFrameArray(source.x, source.natoms, &x_);
+    frame_.v     = copyFrameArray(source.v, source.natoms, &v_);
+    frame_.f     = copyFrameArray(source.f, source.natoms, &f_);
+    frame_.index = copyFrameArray(source.index, source.natoms, &index_);
+}
+
 /********************************************************************
  * RunnerModule
  */
@@ -86,6 +162,23 @@ public:
     void optionsFinished() override;
     int  run() override;
 
+    /*! \brief
+     * Analyzes all frames one at a time.
+     *
+     * \returns Number of frames analyzed.
+     */
+    int analyzeFrames();
+    /*! \brief
+     * Analyzes all frames, with up to \p threadCount frames concurrently.
+     *
+     * \returns Number of frames analyzed.
+     *
+     * Frames are processed in batches: the frames of a batch are read and
+     * the selections evaluated for them serially, the frames are then
+     * analyzed in parallel, and finally finished in order.
+     */
+    int analyzeFramesInParallel(int threadCount);
+
     TrajectoryAnalysisModulePointer module_;
     TrajectoryAnalysisSettings      settings_;
     TrajectoryAnalysisRunnerCommon  common_;
@@ -126,6 +219,31 @@ int RunnerModule::run()
     common_.initFrameIndexGroup();
     module_->initAfterFirstFrame(settings_, common_.frame());
 
+    const int threadCount = settings_.frameThreadCount();
+    const int nframes = (threadCount > 1) ? analyzeFramesInParallel(threadCount) : analyzeFrames();
+
+    if (common_.hasTrajectory())
+    {
+        fprintf(stderr, "Analyzed %d frames, last time %.3f\n", nframes, common_.frame().time);
+    }
+    else
+    {
+        fprintf(stderr, "Analyzed topology coordinates\n");
+    }
+
+    // Restore the maximal groups for dynamic selections.
+    selections_.evaluateFinal(nframes);
+
+    module_->finishAnalysis(nframes);
+    module_->writeOutput();
+
+    return 0;
+}
+
+int RunnerModule::analyzeFrames()
+{
+    const TopologyInformation& topology = common_.topologyInformation();
+
     t_pbc  pbc;
     t_pbc* ppbc = settings_.hasPBC() ? &pbc : nullptr;
 
@@ -153,23 +271,81 @@ int RunnerModule::run()
         pdata->finish();
     }
     pdata.reset();
+    return nframes;
+}
 
-    if (common_.hasTrajectory())
-    {
-        fprintf(stderr, "Analyzed %d frames, last time %.3f\n", nframes, common_.frame().time);
-    }
-    else
+int RunnerModule::analyzeFramesInParallel(int threadCount)
+{
+    const TopologyInformation& topology = common_.topologyInformation();
+    const bool                 bPBC     = settings_.hasPBC();
+
+    AnalysisDataParallelOptions    dataOptions(threadCount);
+    std::vector<ParallelFrameData> frames(threadCount);
+    for (ParallelFrameData& frameData : frames)
     {
-        fprintf(stderr, "Analyzed topology coordinates\n");
+        frameData.pdata_ = module_->startFrames(dataOptions, selections_);
     }
 
-    // Restore the maximal groups for dynamic selections.
-    selections_.evaluateFinal(nframes);
+    int  nframes     = 0;
+    bool bMoreFrames = true;
+    while (bMoreFrames)
+    {
+        // Selection evaluation uses a single evaluation tree, so it needs
+        // to be done serially; each frame keeps a copy of the results.
+        int batchSize = 0;
+        while (batchSize < threadCount && bMoreFrames)
+        {
+            ParallelFrameData& frameData = frames[batchSize];
+            common_.initFrame();
+            t_trxframe& frame = common_.frame();
+            t_pbc*      ppbc  = nullptr;
+            if (bPBC)
+            {
+                ppbc = &frameData.pbc_;
+                set_pbc(ppbc, topology.ePBC(), frame.box);
+            }
+            selections_.evaluate(&frame, ppbc);
+            frameData.copyFrame(frame);
+            frameData.pdata_->copyFrameSelections();
+            ++batchSize;
+            bMoreFrames = common_.readNextFrame();
+        }
 
-    module_->finishAnalysis(nframes);
-    module_->writeOutput();
+#pragma omp parallel for num_threads(threadCount) schedule(static, 1)
+        for (int i = 0; i < batchSize; ++i)
+        {
+            ParallelFrameData& frameData = frames[i];
+            try
+            {
+                module_->analyzeFrame(nframes + i, frameData.frame_,
+                                      bPBC ? &frameData.pbc_ : nullptr, frameData.pdata_.get());
+            }
+            catch (...)
+            {
+                frameData.exception_ = std::current_exception();
+            }
+        }
 
-    return 0;
+        for (int i = 0; i < batchSize; ++i)
+        {
+            if (frames[i].exception_)
+            {
+                std::rethrow_exception(frames[i].exception_);
+            }
+            module_->finishFrameSerial(nframes + i);
+        }
+        nframes += batchSize;
+    }
+    for (ParallelFrameData& frameData : frames)
+    {
+        module_->finishFrames(frameData.pdata_.get());
+        if (frameData.pdata_ != nullptr)
+        {
+            frameData.pdata_->finish();
+        }
+        frameData.pdata_.reset();
+    }
+    return nframes;
 }
 
 } // namespace
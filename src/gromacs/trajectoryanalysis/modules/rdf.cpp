@@ -48,6 +48,7 @@
 #include <cmath>
 
 #include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <string>
 #include <vector>
@@ -72,6 +73,7 @@
 #include "gromacs/trajectoryanalysis/analysissettings.h"
 #include "gromacs/trajectoryanalysis/topologyinformation.h"
 #include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/stringutil.h"
 
 namespace gmx
@@ -130,40 +132,49 @@ public:
     void writeOutput() override;
 
 private:
+    //! Returns the index in `refSel_` of the reference for selection \p g.
+    size_t refIndex(size_t g) const { return refSel_.size() == 1 ? 0 : g; }
+    //! Returns the legend for the RDF of selection \p g in the output plots.
+    std::string legendForSelection(size_t g) const;
+
     std::string              fnRdf_;
     std::string              fnCumulative_;
     SurfaceType              surface_;
     AnalysisDataPlotSettings plotSettings_;
 
     /*! \brief
-     * Reference selection to compute RDFs around.
+     * Reference selections to compute RDFs around.
+     *
+     * Either a single selection used for all of `sel_`, or one selection
+     * for each selection in `sel_`.
      *
      * With -surf, Selection::originalIds() and Selection::mappedIds()
      * store the index of the surface group to which that position belongs.
      * The RDF is computed by finding the nearest position from each
      * surface group for each position, and then binning those distances.
      */
-    Selection refSel_;
+    SelectionList refSel_;
     /*! \brief
      * Selections to compute RDFs for.
      */
     SelectionList sel_;
 
     /*! \brief
-     * Raw pairwise distance data from which the RDF is computed.
+     * Binned pairwise distance data from which the RDF is computed.
      *
-     * There is a data set for each selection in `sel_`, with a single
-     * column.  Each point set will contain a single pairwise distance
-     * that contributes to the RDF.
+     * There is a data set for each selection in `sel_`, with two columns.
+     * Each point set contains the center of a histogram bin and the number
+     * of pairwise distances in that bin for the frame (only non-empty bins
+     * are present).
      */
     AnalysisData pairDist_;
     /*! \brief
      * Normalization factors for each frame.
      *
-     * The first column contains the number of positions in `refSel_` for
-     * that frame (with surface RDF, the number of groups).  There are
-     * `sel_.size()` more columns, each containing the number density of
-     * positions for one selection.
+     * The first `refSel_.size()` columns contain the number of positions in
+     * each reference selection for that frame (with surface RDF, the number
+     * of groups).  There are `sel_.size()` more columns, each containing the
+     * number density of positions for one selection.
      */
     AnalysisData normFactors_;
     /*! \brief
@@ -171,15 +182,17 @@ private:
      *
      * The per-frame histograms are raw pair counts in each bin;
      * the averager is normalized by the average number of reference
-     * positions (average of the first column of `normFactors_`).
+     * positions (average of the matching reference column of `normFactors_`).
      */
-    AnalysisDataSimpleHistogramModulePointer pairCounts_;
+    AnalysisDataWeightedHistogramModulePointer pairCounts_;
     /*! \brief
      * Average normalization factors.
      */
     AnalysisDataAverageModulePointer normAve_;
     //! Neighborhood search with `refSel_` as the reference positions.
     AnalysisNeighborhood nb_;
+    //! Number of surface groups in each reference selection (empty without -surf).
+    std::vector<int> surfaceGroupCount_;
     //! Topology exclusions used by neighborhood searching.
     const gmx_localtop_t* localTop_;
 
@@ -187,6 +200,7 @@ private:
     double        binwidth_;
     double        cutoff_;
     double        rmax_;
+    double        buffer_;
     Normalization normalization_;
     bool          bNormalizationSet_;
     bool          bXY_;
@@ -195,26 +209,25 @@ private:
     // Pre-computed values for faster access during analysis.
     real cut2_;
     real rmax2_;
-    int  surfaceGroupCount_;
 
     // Copy and assign disallowed by base.
 };
 
 Rdf::Rdf() :
     surface_(SurfaceType_None),
-    pairCounts_(new AnalysisDataSimpleHistogramModule()),
+    pairCounts_(new AnalysisDataWeightedHistogramModule()),
     normAve_(new AnalysisDataAverageModule()),
     localTop_(nullptr),
     binwidth_(0.002),
     cutoff_(0.0),
     rmax_(0.0),
+    buffer_(0.0),
     normalization_(Normalization_Rdf),
     bNormalizationSet_(false),
     bXY_(false),
     bExclusions_(false),
     cut2_(0.0),
-    rmax2_(0.0),
-    surfaceGroupCount_(0)
+    rmax2_(0.0)
 {
     pairDist_.setMultipoint(true);
     pairDist_.addModule(pairCounts_);
@@ -230,13 +243,16 @@ void Rdf::initOptions(IOptionsContainer* options, TrajectoryAnalysisSettings* se
     const char* const desc[] = {
         "[THISMODULE] calculates radial distribution functions from one",
         "reference set of position (set with [TT]-ref[tt]) to one or more",
-        "sets of positions (set with [TT]-sel[tt]).  To compute the RDF with",
-        "respect to the closest position in a set in [TT]-ref[tt] instead, use",
-        "[TT]-surf[tt]: if set, then [TT]-ref[tt] is partitioned into sets",
-        "based on the value of [TT]-surf[tt], and the closest position in each",
-        "set is used. To compute the RDF around axes parallel to the",
-        "[IT]z[it]-axis, i.e., only in the [IT]x[it]-[IT]y[it] plane, use",
-        "[TT]-xy[tt].",
+        "sets of positions (set with [TT]-sel[tt]).  To compute partial RDFs",
+        "for several reference/selection pairs in one pass, provide as many",
+        "selections to [TT]-ref[tt] as to [TT]-sel[tt]; the RDF for each",
+        "selection is then computed from the corresponding reference.",
+        "To compute the RDF with respect to the closest position in a set in",
+        "[TT]-ref[tt] instead, use [TT]-surf[tt]: if set, then [TT]-ref[tt]",
+        "is partitioned into sets based on the value of [TT]-surf[tt], and",
+        "the closest position in each set is used. To compute the RDF around",
+        "axes parallel to the [IT]z[it]-axis, i.e., only in the",
+        "[IT]x[it]-[IT]y[it] plane, use [TT]-xy[tt].",
         "",
         "To set the bin width and maximum distance to use in the RDF, use",
         "[TT]-bin[tt] and [TT]-rmax[tt], respectively. The latter can be",
@@ -244,6 +260,12 @@ void Rdf::initOptions(IOptionsContainer* options, TrajectoryAnalysisSettings* se
         "up to the default (half of the box size with PBC, three times the",
         "box size without PBC).",
         "",
+        "For closely spaced frames, [TT]-buffer[tt] can be set to reuse the",
+        "pairs found within [TT]-rmax[tt] plus the buffer over several",
+        "frames, until the positions have moved too much. This only affects",
+        "performance, and is only used for static selections without",
+        "[TT]-surf[tt].",
+        "",
         "To use exclusions from the topology ([TT]-s[tt]), set [TT]-excl[tt]",
         "and ensure that both [TT]-ref[tt] and [TT]-sel[tt] only select atoms.",
         "A rougher alternative to exclude intra-molecular peaks is to set",
@@ -279,6 +301,7 @@ void Rdf::initOptions(IOptionsContainer* options, TrajectoryAnalysisSettings* se
     };
 
     settings->setHelpText(desc);
+    settings->setFlag(TrajectoryAnalysisSettings::efFrameParallel);
 
     options->addOption(FileNameOption("o")
                                .filetype(eftPlot)
@@ -308,14 +331,19 @@ void Rdf::initOptions(IOptionsContainer* options, TrajectoryAnalysisSettings* se
             "Shortest distance (nm) to be considered"));
     options->addOption(
             DoubleOption("rmax").store(&rmax_).description("Largest distance (nm) to calculate"));
+    options->addOption(DoubleOption("buffer").store(&buffer_).description(
+            "Buffer (nm) for reusing the pair search over frames"));
 
     options->addOption(EnumOption<SurfaceType>("surf")
                                .enumValue(c_SurfaceEnum)
                                .store(&surface_)
                                .description("RDF with respect to the surface of the reference"));
 
-    options->addOption(SelectionOption("ref").store(&refSel_).required().description(
-            "Reference selection for RDF computation"));
+    options->addOption(SelectionOption("ref")
+                               .storeVector(&refSel_)
+                               .required()
+                               .multiValue()
+                               .description("Reference selections for RDF computation"));
     options->addOption(SelectionOption("sel").storeVector(&sel_).required().multiValue().description(
             "Selections to compute RDFs for from the reference"));
 }
@@ -344,38 +372,55 @@ void Rdf::optionsFinished(TrajectoryAnalysisSettings* settings)
     {
         cutoff_ = 0.0;
     }
+    if (buffer_ < 0.0)
+    {
+        GMX_THROW(InconsistentInputError("-buffer cannot be negative"));
+    }
 }
 
 void Rdf::initAnalysis(const TrajectoryAnalysisSettings& settings, const TopologyInformation& top)
 {
+    if (refSel_.size() != 1 && refSel_.size() != sel_.size())
+    {
+        GMX_THROW(InconsistentInputError(
+                "-ref should specify either a single selection or the same number of "
+                "selections as -sel"));
+    }
     pairDist_.setDataSetCount(sel_.size());
     for (size_t i = 0; i < sel_.size(); ++i)
     {
-        pairDist_.setColumnCount(i, 1);
+        pairDist_.setColumnCount(i, 2);
     }
     plotSettings_ = settings.plotSettings();
     nb_.setXYMode(bXY_);
 
-    normFactors_.setColumnCount(0, sel_.size() + 1);
+    normFactors_.setColumnCount(0, refSel_.size() + sel_.size());
 
     const bool bSurface = (surface_ != SurfaceType_None);
     if (bSurface)
     {
-        if (!refSel_.hasOnlyAtoms())
+        const e_index_t type = (surface_ == SurfaceType_Molecule ? INDEX_MOL : INDEX_RES);
+        for (Selection& refSel : refSel_)
         {
-            GMX_THROW(InconsistentInputError("-surf only works with -ref that consists of atoms"));
+            if (!refSel.hasOnlyAtoms())
+            {
+                GMX_THROW(InconsistentInputError(
+                        "-surf only works with -ref that consists of atoms"));
+            }
+            surfaceGroupCount_.push_back(refSel.initOriginalIdsToGroup(top.mtop(), type));
         }
-        const e_index_t type = (surface_ == SurfaceType_Molecule ? INDEX_MOL : INDEX_RES);
-        surfaceGroupCount_   = refSel_.initOriginalIdsToGroup(top.mtop(), type);
     }
 
     if (bExclusions_)
     {
-        if (!refSel_.hasOnlyAtoms() || !refSel_.hasSortedAtomIndices())
+        for (const Selection& refSel : refSel_)
         {
-            GMX_THROW(
-                    InconsistentInputError("-excl only works with a -ref selection that consist of "
-                                           "atoms in ascending (sorted) order"));
+            if (!refSel.hasOnlyAtoms() || !refSel.hasSortedAtomIndices())
+            {
+                GMX_THROW(InconsistentInputError(
+                        "-excl only works with a -ref selection that consist of "
+                        "atoms in ascending (sorted) order"));
+            }
         }
         for (size_t i = 0; i < sel_.size(); ++i)
         {
@@ -427,6 +472,71 @@ void Rdf::initAfterFirstFrame(const TrajectoryAnalysisSettings& settings, const
     pairCounts_->init(histogramFromRange(0.0, rmax_).binWidth(binwidth_ / 2.0));
 }
 
+/*! \brief
+ * Adds pairwise distances beyond a minimum distance to a pair count histogram.
+ *
+ * \param[in]     pairs     Pairs to bin.
+ * \param[in]     cut2      Square of the minimum distance.
+ * \param[in]     settings  Histogram bin settings.
+ * \param[in,out] counts    Pair count for each bin.
+ *
+ * Computes the bins the same way as AnalysisHistogramSettings::findBin(),
+ * but without branches, such that the compiler can vectorize the loop.
+ */
+void binPairDistances(ArrayRef<const AnalysisNeighborhoodPair> pairs,
+                      real                                     cut2,
+                      const AnalysisHistogramSettings&         settings,
+                      std::vector<int64_t>*                    counts)
+{
+    GMX_ASSERT(!settings.includeAll(), "Values outside the range are assumed to be ignored");
+    const real firstEdge       = settings.firstEdge();
+    const real inverseBinWidth = 1.0 / settings.binWidth();
+    const int  binCount        = settings.binCount();
+    // Pairs are binned in blocks to keep the bin indices in cache.
+    constexpr int c_blockSize = 256;
+    int           bins[c_blockSize];
+    for (size_t blockStart = 0; blockStart < pairs.size(); blockStart += c_blockSize)
+    {
+        const int blockCount = std::min<int>(c_blockSize, pairs.size() - blockStart);
+        for (int i = 0; i < blockCount; ++i)
+        {
+            const real r2  = pairs[blockStart + i].distance2();
+            const real r   = std::sqrt(r2);
+            const int  bin = static_cast<int>((r - firstEdge) * inverseBinWidth);
+            bins[i]        = (r2 > cut2 && r >= firstEdge && bin < binCount) ? bin : -1;
+        }
+        for (int i = 0; i < blockCount; ++i)
+        {
+            if (bins[i] >= 0)
+            {
+                ++(*counts)[bins[i]];
+            }
+        }
+    }
+}
+
+/*! \brief
+ * Adds the non-empty bins of a pair count histogram to a data handle.
+ *
+ * \param[in]     counts    Pair count for each bin.
+ * \param[in]     settings  Histogram bin settings.
+ * \param[in,out] dh        Data handle to add the bins to.
+ */
+void addPairCounts(const std::vector<int64_t>&      counts,
+                   const AnalysisHistogramSettings& settings,
+                   AnalysisDataHandle*              dh)
+{
+    for (size_t bin = 0; bin < counts.size(); ++bin)
+    {
+        if (counts[bin] > 0)
+        {
+            dh->setPoint(0, settings.firstEdge() + (bin + 0.5) * settings.binWidth());
+            dh->setPoint(1, counts[bin]);
+            dh->finishPointSet();
+        }
+    }
+}
+
 /*! \brief
  * Temporary memory for use within a single-frame calculation.
  */
@@ -436,24 +546,51 @@ public:
     /*! \brief
      * Reserves memory for the frame-local data.
      *
-     * `surfaceGroupCount` will be zero if -surf is not specified.
+     * `surfaceGroupCount` is the largest number of surface groups in a
+     * reference selection, and will be zero if -surf is not specified.
      */
     RdfModuleData(TrajectoryAnalysisModule*          module,
                   const AnalysisDataParallelOptions& opt,
                   const SelectionCollection&         selections,
-                  int                                surfaceGroupCount) :
-        TrajectoryAnalysisModuleData(module, opt, selections)
+                  int                                surfaceGroupCount,
+                  int                                binCount,
+                  int                                threadCount) :
+        TrajectoryAnalysisModuleData(module, opt, selections),
+        threadPairs_(threadCount),
+        threadCounts_(threadCount, std::vector<int64_t>(binCount))
     {
         surfaceDist2_.resize(surfaceGroupCount);
     }
 
     void finish() override { finishDataHandles(); }
 
+    /*! \brief
+     * Pairs found by each thread in the current frame.
+     *
+     * The first entry is also used when the search is not split over
+     * threads.
+     */
+    std::vector<std::vector<AnalysisNeighborhoodPair>> threadPairs_;
+    /*! \brief
+     * Pair count histogram for each thread for the current selection.
+     *
+     * After the pairs for a selection are binned, the histograms are
+     * summed into the first entry.
+     */
+    std::vector<std::vector<int64_t>> threadCounts_;
+
+    /*! \brief
+     * Buffered pair list for each selection.
+     *
+     * Empty if the pair search is done separately for each frame.
+     */
+    std::vector<AnalysisNeighborhoodPairList> pairLists_;
+
     /*! \brief
      * Minimum distance to each surface group.
      *
      * One entry for each group (residue/molecule, per -surf) in the
-     * reference selection.
+     * reference selection with the most groups.
      * This is needed to support neighborhood searching, which may not
      * return the reference positions in order: for each position, we need
      * to search through all the reference positions and update this array
@@ -463,17 +600,49 @@ public:
     std::vector<real> surfaceDist2_;
 };
 
+std::string Rdf::legendForSelection(size_t g) const
+{
+    if (refSel_.size() == 1)
+    {
+        return sel_[g].name();
+    }
+    return formatString("%s - %s", refSel_[g].name(), sel_[g].name());
+}
+
 TrajectoryAnalysisModuleDataPointer Rdf::startFrames(const AnalysisDataParallelOptions& opt,
                                                      const SelectionCollection&         selections)
 {
-    return TrajectoryAnalysisModuleDataPointer(new RdfModuleData(this, opt, selections, surfaceGroupCount_));
+    // The surface RDF searches separately for each position, so it is not
+    // split over threads.
+    const int threadCount = (surface_ == SurfaceType_None ? gmx_omp_get_max_threads() : 1);
+    const int surfaceGroupCount =
+            surfaceGroupCount_.empty()
+                    ? 0
+                    : *std::max_element(surfaceGroupCount_.begin(), surfaceGroupCount_.end());
+    RdfModuleData* pdata = new RdfModuleData(this, opt, selections, surfaceGroupCount,
+                                             pairCounts_->settings().binCount(), threadCount);
+    TrajectoryAnalysisModuleDataPointer result(pdata);
+
+    bool bStaticRef = true;
+    for (const Selection& refSel : refSel_)
+    {
+        bStaticRef = bStaticRef && !refSel.isDynamic();
+    }
+    if (buffer_ > 0.0 && surface_ == SurfaceType_None && bStaticRef)
+    {
+        for (size_t g = 0; g < sel_.size(); ++g)
+        {
+            pdata->pairLists_.push_back(nb_.initPairList(buffer_));
+        }
+    }
+    return result;
 }
 
 void Rdf::analyzeFrame(int frnr, const t_trxframe& fr, t_pbc* pbc, TrajectoryAnalysisModuleData* pdata)
 {
     AnalysisDataHandle   dh        = pdata->dataHandle(pairDist_);
     AnalysisDataHandle   nh        = pdata->dataHandle(normFactors_);
-    const Selection&     refSel    = pdata->parallelSelection(refSel_);
+    const SelectionList& refSel    = pdata->parallelSelections(refSel_);
     const SelectionList& sel       = pdata->parallelSelections(sel_);
     RdfModuleData&       frameData = *static_cast<RdfModuleData*>(pdata);
     const bool           bSurface  = !frameData.surfaceDist2_.empty();
@@ -489,42 +658,69 @@ void Rdf::analyzeFrame(int frnr, const t_trxframe& fr, t_pbc* pbc, TrajectoryAna
     const real inverseVolume = 1.0 / det(boxForVolume);
 
     nh.startFrame(frnr, fr.time);
-    // Compute the normalization factor for the number of reference positions.
-    if (bSurface)
+    // Compute the normalization factors for the number of reference positions.
+    for (size_t r = 0; r < refSel.size(); ++r)
     {
-        if (refSel.isDynamic())
+        if (bSurface)
         {
-            // Count the number of distinct groups.
-            // This assumes that each group is continuous, which is currently
-            // the case.
-            int count  = 0;
-            int prevId = -1;
-            for (int i = 0; i < refSel.posCount(); ++i)
+            if (refSel[r].isDynamic())
             {
-                const int id = refSel.position(i).mappedId();
-                if (id != prevId)
+                // Count the number of distinct groups.
+                // This assumes that each group is continuous, which is currently
+                // the case.
+                int count  = 0;
+                int prevId = -1;
+                for (int i = 0; i < refSel[r].posCount(); ++i)
                 {
-                    ++count;
-                    prevId = id;
+                    const int id = refSel[r].position(i).mappedId();
+                    if (id != prevId)
+                    {
+                        ++count;
+                        prevId = id;
+                    }
                 }
+                nh.setPoint(r, count);
+            }
+            else
+            {
+                nh.setPoint(r, surfaceGroupCount_[r]);
             }
-            nh.setPoint(0, count);
         }
         else
         {
-            nh.setPoint(0, surfaceGroupCount_);
+            nh.setPoint(r, refSel[r].posCount());
         }
     }
-    else
-    {
-        nh.setPoint(0, refSel.posCount());
-    }
 
     dh.startFrame(frnr, fr.time);
-    AnalysisNeighborhoodSearch nbsearch = nb_.initSearch(pbc, refSel);
+    // The search around a reference is only needed if some selection using
+    // that reference does not use a pair list.  The search is shared by all
+    // such selections.
+    std::vector<AnalysisNeighborhoodSearch> nbsearch(refSel.size());
+    std::vector<bool>                       bNeedSearch(refSel.size(), false);
+    for (size_t g = 0; g < sel.size(); ++g)
+    {
+        if (frameData.pairLists_.empty() || sel[g].isDynamic())
+        {
+            bNeedSearch[refIndex(g)] = true;
+        }
+    }
+    for (size_t r = 0; r < refSel.size(); ++r)
+    {
+        if (bNeedSearch[r])
+        {
+            nbsearch[r] = nb_.initSearch(pbc, refSel[r]);
+        }
+    }
+    const AnalysisHistogramSettings&       histogramSettings = pairCounts_->settings();
+    std::vector<int64_t>&                  counts            = frameData.threadCounts_[0];
+    std::vector<AnalysisNeighborhoodPair>& pairs             = frameData.threadPairs_[0];
     for (size_t g = 0; g < sel.size(); ++g)
     {
+        const Selection&                  currentRef      = refSel[refIndex(g)];
+        const AnalysisNeighborhoodSearch& currentNbsearch = nbsearch[refIndex(g)];
         dh.selectDataSet(g);
+        std::fill(counts.begin(), counts.end(), 0);
 
         if (bSurface)
         {
@@ -535,12 +731,13 @@ void Rdf::analyzeFrame(int frnr, const t_trxframe& fr, t_pbc* pbc, TrajectoryAna
             for (int i = 0; i < sel[g].posCount(); ++i)
             {
                 std::fill(surfaceDist2.begin(), surfaceDist2.end(), std::numeric_limits<real>::max());
-                AnalysisNeighborhoodPairSearch pairSearch = nbsearch.startPairSearch(sel[g].position(i));
+                AnalysisNeighborhoodPairSearch pairSearch =
+                        currentNbsearch.startPairSearch(sel[g].position(i));
                 AnalysisNeighborhoodPair       pair;
                 while (pairSearch.findNextPair(&pair))
                 {
                     const real r2    = pair.distance2();
-                    const int  refId = refSel.position(pair.refIndex()).mappedId();
+                    const int  refId = currentRef.position(pair.refIndex()).mappedId();
                     if (r2 < surfaceDist2[refId])
                     {
                         surfaceDist2[refId] = r2;
@@ -555,33 +752,60 @@ void Rdf::analyzeFrame(int frnr, const t_trxframe& fr, t_pbc* pbc, TrajectoryAna
                     // surface positions.
                     if (r2 > cut2_ && r2 <= rmax2_)
                     {
-                        dh.setPoint(0, std::sqrt(r2));
-                        dh.finishPointSet();
+                        const int bin = histogramSettings.findBin(std::sqrt(r2));
+                        if (bin != -1)
+                        {
+                            ++counts[bin];
+                        }
                     }
                 }
             }
         }
+        else if (!frameData.pairLists_.empty() && !sel[g].isDynamic())
+        {
+            // Same as below, but reusing the pairs from earlier frames.
+            frameData.pairLists_[g].findAllPairs(pbc, currentRef, sel[g], &pairs);
+            binPairDistances(pairs, cut2_, histogramSettings, &counts);
+        }
         else
         {
             // Standard neighborhood search over all pairs within the cutoff
-            // for the -surf no case.
-            AnalysisNeighborhoodPairSearch pairSearch = nbsearch.startPairSearch(sel[g]);
-            AnalysisNeighborhoodPair       pair;
-            while (pairSearch.findNextPair(&pair))
+            // for the -surf no case.  The positions are split over threads,
+            // each with a private histogram that is summed at the end.
+            const int threadCount = frameData.threadCounts_.size();
+            const int posCount    = sel[g].posCount();
+#pragma omp parallel for num_threads(threadCount) schedule(static)
+            for (int t = 0; t < threadCount; ++t)
             {
-                const real r2 = pair.distance2();
-                if (r2 > cut2_)
+                try
                 {
-                    // TODO: Consider whether the histogramming could be done with
-                    // less overhead (after first measuring the overhead).
-                    dh.setPoint(0, std::sqrt(r2));
-                    dh.finishPointSet();
+                    std::vector<int64_t>& threadCounts = frameData.threadCounts_[t];
+                    if (t > 0)
+                    {
+                        std::fill(threadCounts.begin(), threadCounts.end(), 0);
+                    }
+                    AnalysisNeighborhoodPositions positions(sel[g]);
+                    positions.selectRangeFromArray((posCount * t) / threadCount,
+                                                   (posCount * (t + 1)) / threadCount);
+                    currentNbsearch.findAllPairs(positions, &frameData.threadPairs_[t]);
+                    binPairDistances(frameData.threadPairs_[t], cut2_, histogramSettings,
+                                     &threadCounts);
+                }
+                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+            }
+            for (int t = 1; t < threadCount; ++t)
+            {
+                const std::vector<int64_t>& threadCounts = frameData.threadCounts_[t];
+                for (size_t bin = 0; bin < counts.size(); ++bin)
+                {
+                    counts[bin] += threadCounts[bin];
                 }
             }
         }
+        addPairCounts(counts, histogramSettings, &dh);
         // Normalization factor for the number density (only used without
         // -surf, but does not hurt to populate otherwise).
-        nh.setPoint(g + 1, sel[g].posCount() * inverseVolume);
+        nh.setPoint(refSel.size() + g, sel[g].posCount() * inverseVolume);
     }
     dh.finishFrame();
     nh.finishFrame();
@@ -591,8 +815,11 @@ void Rdf::finishAnalysis(int /*nframes*/)
 {
     // Normalize the averager with the number of reference positions,
     // from where the normalization propagates to all the output.
-    const real refPosCount = normAve_->average(0, 0);
-    pairCounts_->averager().scaleAll(1.0 / refPosCount);
+    for (size_t g = 0; g < sel_.size(); ++g)
+    {
+        const real refPosCount = normAve_->average(0, refIndex(g));
+        pairCounts_->averager().scaleSingle(g, 1.0 / refPosCount);
+    }
     pairCounts_->averager().done();
 
     // TODO: Consider how these could be exposed to the testing framework
@@ -630,7 +857,7 @@ void Rdf::finishAnalysis(int /*nframes*/)
             // Normalize by particle density.
             for (size_t g = 0; g < sel_.size(); ++g)
             {
-                finalRdf->scaleSingle(g, 1.0 / normAve_->average(0, g + 1));
+                finalRdf->scaleSingle(g, 1.0 / normAve_->average(0, refSel_.size() + g));
             }
         }
     }
@@ -648,12 +875,15 @@ void Rdf::finishAnalysis(int /*nframes*/)
         AnalysisDataPlotModulePointer plotm(new AnalysisDataPlotModule(plotSettings_));
         plotm->setFileName(fnRdf_);
         plotm->setTitle("Radial distribution");
-        plotm->setSubtitle(formatString("reference %s", refSel_.name()));
+        if (refSel_.size() == 1)
+        {
+            plotm->setSubtitle(formatString("reference %s", refSel_[0].name()));
+        }
         plotm->setXLabel("r (nm)");
         plotm->setYLabel("g(r)");
         for (size_t i = 0; i < sel_.size(); ++i)
         {
-            plotm->appendLegend(sel_[i].name());
+            plotm->appendLegend(legendForSelection(i));
         }
         finalRdf->addModule(plotm);
     }
@@ -667,12 +897,15 @@ void Rdf::finishAnalysis(int /*nframes*/)
         AnalysisDataPlotModulePointer plotm(new AnalysisDataPlotModule(plotSettings_));
         plotm->setFileName(fnCumulative_);
         plotm->setTitle("Cumulative Number RDF");
-        plotm->setSubtitle(formatString("reference %s", refSel_.name()));
+        if (refSel_.size() == 1)
+        {
+            plotm->setSubtitle(formatString("reference %s", refSel_[0].name()));
+        }
         plotm->setXLabel("r (nm)");
         plotm->setYLabel("number");
         for (size_t i = 0; i < sel_.size(); ++i)
         {
-            plotm->appendLegend(sel_[i].name());
+            plotm->appendLegend(legendForSelection(i));
         }
         cumulativeRdf->addModule(plotm);
     }
@@ -51,8 +51,12 @@
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/selection/nbsearch.h"
+#include "gromacs/simd/simd.h"
+#include "gromacs/utility/alignedallocator.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 using namespace gmx;
@@ -77,41 +81,41 @@ static real safe_asin(real f)
 /* routines for dot distributions on the surface of the unit sphere */
 static real icosaeder_vertices(real* xus)
 {
-    const real rh = std::sqrt(1. - 2. * cos(TORAD(72.))) / (1. - cos(TORAD(72.)));
-    const real rg = cos(TORAD(72.)) / (1. - cos(TORAD(72.)));
+    const real rh = std::sqrt(1. - 2. * std::cos(TORAD(72.))) / (1. - std::cos(TORAD(72.)));
+    const real rg = std::cos(TORAD(72.)) / (1. - std::cos(TORAD(72.)));
     /* icosaeder vertices */
     xus[0]  = 0.;
     xus[1]  = 0.;
     xus[2]  = 1.;
-    xus[3]  = rh * cos(TORAD(72.));
-    xus[4]  = rh * sin(TORAD(72.));
+    xus[3]  = rh * std::cos(TORAD(72.));
+    xus[4]  = rh * std::sin(TORAD(72.));
     xus[5]  = rg;
-    xus[6]  = rh * cos(TORAD(144.));
-    xus[7]  = rh * sin(TORAD(144.));
+    xus[6]  = rh * std::cos(TORAD(144.));
+    xus[7]  = rh * std::sin(TORAD(144.));
     xus[8]  = rg;
-    xus[9]  = rh * cos(TORAD(216.));
-    xus[10] = rh * sin(TORAD(216.));
+    xus[9]  = rh * std::cos(TORAD(216.));
+    xus[10] = rh * std::sin(TORAD(216.));
     xus[11] = rg;
-    xus[12] = rh * cos(TORAD(288.));
-    xus[13] = rh * sin(TORAD(288.));
+    xus[12] = rh * std::cos(TORAD(288.));
+    xus[13] = rh * std::sin(TORAD(288.));
     xus[14] = rg;
     xus[15] = rh;
     xus[16] = 0;
     xus[17] = rg;
-    xus[18] = rh * cos(TORAD(36.));
-    xus[19] = rh * sin(TORAD(36.));
+    xus[18] = rh * std::cos(TORAD(36.));
+    xus[19] = rh * std::sin(TORAD(36.));
     xus[20] = -rg;
-    xus[21] = rh * cos(TORAD(108.));
-    xus[22] = rh * sin(TORAD(108.));
+    xus[21] = rh * std::cos(TORAD(108.));
+    xus[22] = rh * std::sin(TORAD(108.));
     xus[23] = -rg;
     xus[24] = -rh;
     xus[25] = 0;
     xus[26] = -rg;
-    xus[27] = rh * cos(TORAD(252.));
-    xus[28] = rh * sin(TORAD(252.));
+    xus[27] = rh * std::cos(TORAD(252.));
+    xus[28] = rh * std::sin(TORAD(252.));
     xus[29] = -rg;
-    xus[30] = rh * cos(TORAD(324.));
-    xus[31] = rh * sin(TORAD(324.));
+    xus[30] = rh * std::cos(TORAD(324.));
+    xus[31] = rh * std::sin(TORAD(324.));
     xus[32] = -rg;
     xus[33] = 0.;
     xus[34] = 0.;
@@ -140,8 +144,8 @@ divarc(real x1, real y1, real z1, real x2, real y2, real z2, int div1, int div2,
 
     phi  = safe_asin(dd / std::sqrt(d1 * d2));
     phi  = phi * (static_cast<real>(div1)) / (static_cast<real>(div2));
-    sphi = sin(phi);
-    cphi = cos(phi);
+    sphi = std::sin(phi);
+    cphi = std::cos(phi);
     s    = (x1 * xd + y1 * yd + z1 * zd) / dd;
 
     x   = xd * s * (1. - cphi) / dd + x1 * cphi + (yd * z1 - y1 * zd) * sphi / dd;
@@ -175,7 +179,7 @@ static std::vector<real> ico_dot_arc(int densit)
     if (tess > 1)
     {
         tn = 12;
-        a  = rh * rh * 2. * (1. - cos(TORAD(72.)));
+        a  = rh * rh * 2. * (1. - std::cos(TORAD(72.)));
         /* calculate tessalation of icosaeder edges */
         for (i = 0; i < 11; i++)
         {
@@ -291,7 +295,7 @@ static std::vector<real> ico_dot_dod(int densit)
 
     tn = 12;
     /* square of the edge of an icosaeder */
-    a = rh * rh * 2. * (1. - cos(TORAD(72.)));
+    a = rh * rh * 2. * (1. - std::cos(TORAD(72.)));
     /* dodecaeder vertices */
     for (i = 0; i < 10; i++)
     {
@@ -339,7 +343,7 @@ static std::vector<real> ico_dot_dod(int densit)
     {
         tn = 32;
         /* square of the edge of an dodecaeder */
-        adod = 4. * (cos(TORAD(108.)) - cos(TORAD(120.))) / (1. - cos(TORAD(120.)));
+        adod = 4. * (std::cos(TORAD(108.)) - std::cos(TORAD(120.))) / (1. - std::cos(TORAD(120.)));
         /* square of the distance of two adjacent vertices of ico- and dodecaeder */
         ai_d = 2. * (1. - std::sqrt(1. - a / 3.));
 
@@ -580,6 +584,70 @@ static std::vector<real> make_unsp(int densit, int cubus)
     return xus;
 }
 
+#if GMX_SIMD_HAVE_REAL
+//! Number of surface dots that are processed at once.
+static constexpr int c_dotChunkSize = GMX_SIMD_REAL_WIDTH;
+#else
+//! Number of surface dots that are processed at once.
+static constexpr int c_dotChunkSize = 1;
+#endif
+
+//! Aligned storage for surface dot data.
+typedef std::vector<real, AlignedAllocator<real>> DotArray;
+
+/*! \brief
+ * Marks surface dots of an atom covered by a neighbor atom.
+ *
+ * \param[in]     dotX      X coordinates of the unit sphere dots.
+ * \param[in]     dotY      Y coordinates of the unit sphere dots.
+ * \param[in]     dotZ      Z coordinates of the unit sphere dots.
+ * \param[in]     dotCount  Number of dots, padded to a multiple of
+ *     \c c_dotChunkSize.
+ * \param[in]     dx        Vector from the atom to the neighbor.
+ * \param[in]     refdot    Dots with a larger projection on \p dx are
+ *     covered by the neighbor.
+ * \param[in,out] dotOpen   For each dot, 1 if it is not yet covered and 0
+ *     otherwise.
+ * \returns       Number of dots that remain uncovered.
+ */
+static int mark_covered_dots(const real* dotX,
+                             const real* dotY,
+                             const real* dotZ,
+                             int         dotCount,
+                             const rvec  dx,
+                             real        refdot,
+                             real*       dotOpen)
+{
+#if GMX_SIMD_HAVE_REAL
+    const SimdReal dx0(dx[XX]);
+    const SimdReal dx1(dx[YY]);
+    const SimdReal dx2(dx[ZZ]);
+    const SimdReal refdotS(refdot);
+    SimdReal       openCount = setZero();
+    for (int j = 0; j < dotCount; j += c_dotChunkSize)
+    {
+        // Same operation order as iprod()
+        const SimdReal proj =
+                load<SimdReal>(dotX + j) * dx0 + load<SimdReal>(dotY + j) * dx1 + load<SimdReal>(dotZ + j) * dx2;
+        const SimdReal open = selectByNotMask(load<SimdReal>(dotOpen + j), refdotS < proj);
+        store(dotOpen + j, open);
+        openCount = openCount + open;
+    }
+    return static_cast<int>(reduce(openCount));
+#else
+    int openCount = 0;
+    for (int j = 0; j < dotCount; ++j)
+    {
+        if (dotX[j] * dx[XX] + dotY[j] * dx[YY] + dotZ[j] * dx[ZZ] > refdot)
+        {
+            dotOpen[j] = 0;
+        }
+        openCount += static_cast<int>(dotOpen[j]);
+    }
+    return openCount;
+#endif
+}
+
 static void nsc_dclm_pbc(const rvec*                 coords,
                          const ArrayRef<const real>& radius,
                          int                         nat,
@@ -649,90 +717,112 @@ static void nsc_dclm_pbc(const rvec*                 coords,
     pos.indexed(constArrayRefFromArray(index, nat));
     AnalysisNeighborhoodSearch nbsearch(nb->initSearch(pbc, pos));
 
-    std::vector<int> wkdot(n_dot);
+    // Unit sphere dots as separate coordinate arrays for the covering loop.
+    // The padding dots are never open, so they do not contribute.
+    const int paddedDotCount = (n_dot + c_dotChunkSize - 1) / c_dotChunkSize * c_dotChunkSize;
+    DotArray  dotX(paddedDotCount, 0), dotY(paddedDotCount, 0), dotZ(paddedDotCount, 0);
+    DotArray  initialDotOpen(paddedDotCount, 0);
+    for (int j = 0; j < n_dot; ++j)
+    {
+        dotX[j]           = xus[3 * j];
+        dotY[j]           = xus[3 * j + 1];
+        dotZ[j]           = xus[3 * j + 2];
+        initialDotOpen[j] = 1;
+    }
 
-    for (int i = 0; i < nat; ++i)
+    // The contributions of each atom are computed in parallel and summed
+    // afterwards in atom order, such that the result does not depend on the
+    // number of threads.  The surface dots are collected in atom order, so
+    // a single thread is used if they are requested.
+    std::vector<real> atomAreaTerm(nat);
+    std::vector<real> atomVolumeTerm((mode & FLAG_VOLUME) ? nat : 0);
+    const int         nthreads = (mode & FLAG_DOTS) ? 1 : gmx_omp_get_max_threads();
+
+#pragma omp parallel num_threads(nthreads)
     {
-        const int                      iat  = index[i];
-        const real                     ai   = radius[iat];
-        const real                     aisq = ai * ai;
-        AnalysisNeighborhoodPairSearch pairSearch(nbsearch.startPairSearch(coords[iat]));
-        AnalysisNeighborhoodPair       pair;
-        std::fill(wkdot.begin(), wkdot.end(), 1);
-        int currDotCount = n_dot;
-        while (currDotCount > 0 && pairSearch.findNextPair(&pair))
+        try
         {
-            const int  jat = index[pair.refIndex()];
-            const real aj  = radius[jat];
-            const real d2  = pair.distance2();
-            if (iat == jat || d2 > gmx::square(ai + aj))
-            {
-                continue;
-            }
-            const rvec& dx     = pair.dx();
-            const real  refdot = (d2 + aisq - aj * aj) / (2 * ai);
-            // TODO: Consider whether micro-optimizations from the old
-            // implementation would be useful, compared to the complexity that
-            // they bring: instead of this direct loop, the neighbors were
-            // stored into a temporary array, the loop order was
-            // reversed (first over dots, then over neighbors), and for each
-            // dot, it was first checked whether the same neighbor that
-            // resulted in marking the previous dot covered would also cover
-            // this dot. This presumably plays together with sorting of the
-            // surface dots (done in make_unsp) to avoid some of the looping.
-            // Alternatively, we could keep a skip list here to avoid
-            // repeatedly looping over dots that have already marked as
-            // covered.
-            for (int j = 0; j < n_dot; ++j)
+            DotArray dotOpen(paddedDotCount);
+
+#pragma omp for schedule(dynamic, 64)
+            for (int i = 0; i < nat; ++i)
             {
-                if (wkdot[j] && iprod(&xus[3 * j], dx) > refdot)
+                const int  iat  = index[i];
+                const real ai   = radius[iat];
+                const real aisq = ai * ai;
+                std::copy(initialDotOpen.begin(), initialDotOpen.end(), dotOpen.begin());
+                // The search is stopped as soon as all dots are covered, so
+                // buried atoms do not need their full neighbor list.
+                AnalysisNeighborhoodPairSearch pairSearch(nbsearch.startPairSearch(coords[iat]));
+                AnalysisNeighborhoodPair       pair;
+                int                            currDotCount = n_dot;
+                while (currDotCount > 0 && pairSearch.findNextPair(&pair))
                 {
-                    --currDotCount;
-                    wkdot[j] = 0;
+                    const int  jat = index[pair.refIndex()];
+                    const real aj  = radius[jat];
+                    const real d2  = pair.distance2();
+                    if (iat == jat || d2 > gmx::square(ai + aj))
+                    {
+                        continue;
+                    }
+                    const real refdot = (d2 + aisq - aj * aj) / (2 * ai);
+                    currDotCount = mark_covered_dots(dotX.data(), dotY.data(), dotZ.data(),
+                                                     paddedDotCount, pair.dx(), refdot, dotOpen.data());
                 }
-            }
-        }
 
-        const real a = aisq * dotarea * currDotCount;
-        area         = area + a;
-        if (mode & FLAG_ATOM_AREA)
-        {
-            atom_area[i] = a;
-        }
-        const real xi = coords[iat][XX];
-        const real yi = coords[iat][YY];
-        const real zi = coords[iat][ZZ];
-        if (mode & FLAG_DOTS)
-        {
-            for (int l = 0; l < n_dot; l++)
-            {
-                if (wkdot[l])
+                atomAreaTerm[i] = aisq * dotarea * currDotCount;
+                const real xi   = coords[iat][XX];
+                const real yi   = coords[iat][YY];
+                const real zi   = coords[iat][ZZ];
+                if (mode & FLAG_DOTS)
                 {
-                    lfnr++;
-                    if (maxdots <= 3 * lfnr + 1)
+                    for (int l = 0; l < n_dot; l++)
                     {
-                        maxdots = maxdots + n_dot * 3;
-                        srenew(dots, maxdots);
+                        if (dotOpen[l] != 0)
+                        {
+                            lfnr++;
+                            if (maxdots <= 3 * lfnr + 1)
+                            {
+                                maxdots = maxdots + n_dot * 3;
+                                srenew(dots, maxdots);
+                            }
+                            dots[3 * lfnr - 3] = ai * dotX[l] + xi;
+                            dots[3 * lfnr - 2] = ai * dotY[l] + yi;
+                            dots[3 * lfnr - 1] = ai * dotZ[l] + zi;
+                        }
+                    }
+                }
+                if (mode & FLAG_VOLUME)
+                {
+                    real dx = 0.0, dy = 0.0, dz = 0.0;
+                    for (int l = 0; l < n_dot; l++)
+                    {
+                        if (dotOpen[l] != 0)
+                        {
+                            dx = dx + dotX[l];
+                            dy = dy + dotY[l];
+                            dz = dz + dotZ[l];
+                        }
                     }
-                    dots[3 * lfnr - 3] = ai * xus[3 * l] + xi;
-                    dots[3 * lfnr - 2] = ai * xus[1 + 3 * l] + yi;
-                    dots[3 * lfnr - 1] = ai * xus[2 + 3 * l] + zi;
+                    atomVolumeTerm[i] = dx * (xi - xs) + dy * (yi - ys) + dz * (zi - zs)
+                                        + ai * currDotCount;
                 }
             }
         }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    for (int i = 0; i < nat; ++i)
+    {
+        area = area + atomAreaTerm[i];
+        if (mode & FLAG_ATOM_AREA)
+        {
+            atom_area[i] = atomAreaTerm[i];
+        }
         if (mode & FLAG_VOLUME)
         {
-            real dx = 0.0, dy = 0.0, dz = 0.0;
-            for (int l = 0; l < n_dot; l++)
-            {
-                if (wkdot[l])
-                {
-                    dx = dx + xus[3 * l];
-                    dy = dy + xus[1 + 3 * l];
-                    dz = dz + xus[2 + 3 * l];
-                }
-            }
-            vol = vol + aisq * (dx * (xi - xs) + dy * (yi - ys) + dz * (zi - zs) + ai * currDotCount);
+            const real ai = radius[index[i]];
+            vol           = vol + ai * ai * atomVolumeTerm[i];
         }
     }
 
@@ -385,6 +385,12 @@ void TrajectoryAnalysisRunnerCommon::initOptions(IOptionsContainer* options, Tim
                         .store(&settings.impl_->bPBC)
                         .description("Use periodic boundary conditions for distance calculation"));
     }
+    if (settings.hasFlag(TrajectoryAnalysisSettings::efFrameParallel))
+    {
+        options->addOption(IntegerOption("nt")
+                                   .store(&settings.impl_->frameThreadCount)
+                                   .description("Number of threads for analyzing frames concurrently"));
+    }
 }
 
 
@@ -401,6 +407,11 @@ void TrajectoryAnalysisRunnerCommon::optionsFinished()
                 InconsistentInputError("-fgroup only makes sense together with a trajectory (-f)"));
     }
 
+    if (impl_->settings_.impl_->frameThreadCount < 1)
+    {
+        GMX_THROW(InconsistentInputError("Number of threads (-nt) must be at least one"));
+    }
+
     impl_->settings_.impl_->plotSettings.setTimeUnit(impl_->settings_.timeUnit());
 
     if (impl_->bStartTimeSet_)
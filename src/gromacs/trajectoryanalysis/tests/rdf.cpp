@@ -82,6 +82,26 @@ TEST_F(RdfModuleTest, BasicTest)
     runTest(CommandLine(cmdline));
 }
 
+TEST_F(RdfModuleTest, CalculatesWithBuffer)
+{
+    const char* const cmdline[] = { "rdf",  "-bin",    "0.05", "-buffer",     "0.1",
+                                    "-ref", "name OW", "-sel", "name OW", "not name OW" };
+    setTopology("spc216.gro");
+    setOutputFile("-o", ".xvg", NoTextMatch());
+    excludeDataset("pairdist");
+    runTest(CommandLine(cmdline));
+}
+
+TEST_F(RdfModuleTest, CalculatesWithMultipleReferences)
+{
+    const char* const cmdline[] = { "rdf",  "-bin",    "0.05",     "-ref",    "name OW",
+                                    "name HW1", "-sel", "name HW1", "name OW" };
+    setTopology("spc216.gro");
+    setOutputFile("-o", ".xvg", NoTextMatch());
+    excludeDataset("pairdist");
+    runTest(CommandLine(cmdline));
+}
+
 TEST_F(RdfModuleTest, SelectionsSolelyFromIndexFileWork)
 {
     const char* const cmdline[] = { "rdf", "-bin", "0.05",
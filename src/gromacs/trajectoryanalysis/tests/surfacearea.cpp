@@ -54,6 +54,7 @@
 #include "gromacs/random/uniformrealdistribution.h"
 #include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 #include "testutils/refdata.h"
@@ -151,6 +152,21 @@ public:
                                  index_.data(), flags, &area_, &volume_, &atomArea_, &dots_, &dotCount_);
         });
     }
+    /*! \brief
+     * Calculates with the given number of OpenMP threads.
+     *
+     * The work is only split over threads when \p flags does not include
+     * FLAG_DOTS, and the results should not depend on the number of threads.
+     * The maximum number of threads is raised for the call, such that several
+     * threads are also used on a single core.
+     */
+    void calculateWithThreads(int ndots, int flags, bool bPBC, int numThreads)
+    {
+        const int maxThreads = gmx_omp_get_max_threads();
+        gmx_omp_set_num_threads(numThreads);
+        calculate(ndots, flags, bPBC);
+        gmx_omp_set_num_threads(maxThreads);
+    }
     real resultArea() const { return area_; }
     real resultVolume() const { return volume_; }
     real atomArea(int index) const { return atomArea_[index]; }
@@ -298,6 +314,9 @@ TEST_F(SurfaceAreaTest, Computes100Points)
     generateRandomPositions(100);
     ASSERT_NO_FATAL_FAILURE(calculate(24, FLAG_VOLUME | FLAG_ATOM_AREA | FLAG_DOTS, false));
     checkReference(&checker, "100Points", false);
+
+    ASSERT_NO_FATAL_FAILURE(calculateWithThreads(24, FLAG_VOLUME | FLAG_ATOM_AREA, false, 4));
+    checkReference(&checker, "100Points", false);
 }
 
 TEST_F(SurfaceAreaTest, Computes100PointsWithRectangularPBC)
@@ -321,6 +340,9 @@ TEST_F(SurfaceAreaTest, Computes100PointsWithRectangularPBC)
     ASSERT_NO_FATAL_FAILURE(calculate(24, flags, true));
     checkReference(&checker, "100Points", false);
 
+    ASSERT_NO_FATAL_FAILURE(calculateWithThreads(24, FLAG_ATOM_AREA | FLAG_VOLUME, true, 4));
+    checkReference(&checker, "100Points", false);
+
     translatePoints(-15.0, 15.0, 0);
     ASSERT_NO_FATAL_FAILURE(calculate(24, flags, true));
     checkReference(&checker, "100Points", false);
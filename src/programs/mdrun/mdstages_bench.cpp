@@ -0,0 +1,353 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ *
+ * \brief This file defines the benchmark for the CPU stages of an MD step
+ * outside the non-bonded kernels.
+ */
+
+#include "gmxpre.h"
+
+#include "mdstages_bench.h"
+
+#include <climits>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "gromacs/domdec/domdec.h"
+#include "gromacs/domdec/mdsetup.h"
+#include "gromacs/ewald/pme.h"
+#include "gromacs/gmxlib/network.h"
+#include "gromacs/gmxlib/nrnb.h"
+#include "gromacs/hardware/detecthardware.h"
+#include "gromacs/hardware/hw_info.h"
+#include "gromacs/listed_forces/listed_forces.h"
+#include "gromacs/math/paddedvector.h"
+#include "gromacs/math/vec.h"
+#include "gromacs/mdlib/constr.h"
+#include "gromacs/mdlib/forcerec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
+#include "gromacs/mdlib/lincs.h"
+#include "gromacs/mdlib/makeconstraints.h"
+#include "gromacs/mdlib/mdatoms.h"
+#include "gromacs/mdlib/settle.h"
+#include "gromacs/mdtypes/commrec.h"
+#include "gromacs/mdtypes/enerdata.h"
+#include "gromacs/mdtypes/fcdata.h"
+#include "gromacs/mdtypes/forceoutput.h"
+#include "gromacs/mdtypes/forcerec.h"
+#include "gromacs/mdtypes/iforceprovider.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/interaction_const.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/mdatom.h"
+#include "gromacs/mdtypes/simulation_workload.h"
+#include "gromacs/pbcutil/mshift.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/timing/cyclecounter.h"
+#include "gromacs/timing/wallcycle.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/topology/mtop_util.h"
+#include "gromacs/topology/topology.h"
+#include "gromacs/utility/basenetwork.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxmpi.h"
+#include "gromacs/utility/logger.h"
+#include "gromacs/utility/physicalnodecommunicator.h"
+#include "gromacs/utility/smalloc.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! Returns the average cycles per iteration spent in wallcycle counter \p ewc
+double averageCycles(gmx_wallcycle_t wcycle, int ewc, int numIterations)
+{
+    int    count;
+    double cycles;
+    wallcycle_get(wcycle, ewc, &count, &cycles);
+
+    return cycles / std::max(numIterations, 1);
+}
+
+/*! \brief Returns the coordinates displaced by a few pm, as after an integration step
+ *
+ * This gives the constraint algorithms a realistic amount of work.
+ */
+std::vector<RVec> displacedCoordinates(ArrayRef<const RVec> coordinates)
+{
+    std::vector<RVec> displaced(coordinates.begin(), coordinates.end());
+    for (size_t a = 0; a < displaced.size(); a++)
+    {
+        for (int d = 0; d < DIM; d++)
+        {
+            displaced[a][d] += 0.002 * ((a + d) % 3 - 1);
+        }
+    }
+
+    return displaced;
+}
+
+} // namespace
+
+std::vector<Nbnxm::StageTiming> benchmarkMdStepStages(const gmx_mtop_t&    mtop,
+                                                      const t_inputrec&    ir,
+                                                      ArrayRef<const RVec> coordinates,
+                                                      const matrix         boxIn,
+                                                      const int            numThreads,
+                                                      const int            numIterations,
+                                                      const bool           computeVirialAndEnergy)
+{
+    if (gmx_mtop_ftype_count(mtop, F_DISRES) > 0 || gmx_mtop_ftype_count(mtop, F_ORIRES) > 0)
+    {
+        gmx_fatal(FARGS,
+                  "Distance and orientation restraints are not supported by the benchmarks");
+    }
+
+    // We don't want to call gmx_omp_nthreads_init(), so we init what we need
+    for (int module : { emntBonded, emntPME, emntLINCS, emntSETTLE })
+    {
+        gmx_omp_nthreads_set(module, numThreads);
+    }
+
+    CommrecHandle   crHandle = init_commrec(MPI_COMM_WORLD, nullptr);
+    t_commrec*      cr       = crHandle.get();
+    gmx_wallcycle_t wcycle   = wallcycle_init(nullptr, 0, cr);
+    if (wcycle == nullptr)
+    {
+        gmx_fatal(FARGS, "Timing the MD step stages requires cycle counters");
+    }
+
+    const MDLogger       mdlog;
+    const gmx_hw_info_t* hwinfo = gmx_detect_hardware(
+            mdlog, PhysicalNodeCommunicator(MPI_COMM_WORLD, gmx_physicalnode_id_hash()));
+
+    matrix box;
+    copy_mat(boxIn, box);
+
+    t_nrnb   nrnb = {};
+    t_fcdata fcd  = {};
+
+    // No MD modules are used, so there are no force providers
+    ForceProviders forceProviders;
+    t_forcerec*    fr = new t_forcerec;
+    fr->forceProviders = &forceProviders;
+    init_forcerec(nullptr, mdlog, fr, &fcd, &ir, &mtop, cr, box, nullptr, nullptr, {}, *hwinfo,
+                  nullptr, false, false, -1, wcycle);
+
+    const bool havePme = (EEL_PME(ir.coulombtype) || EVDW_PME(ir.vdwtype));
+    if (havePme)
+    {
+        fr->pmedata = gmx_pme_init(cr, getNumPmeDomains(nullptr), &ir, false, false, false,
+                                   fr->ic->ewaldcoeff_q, fr->ic->ewaldcoeff_lj, numThreads,
+                                   PmeRunMode::CPU, nullptr, nullptr, nullptr, mdlog);
+    }
+
+    std::unique_ptr<MDAtoms> mdAtoms = makeMDAtoms(nullptr, mtop, ir, false);
+    auto constr = makeConstraints(mtop, ir, nullptr, false, nullptr, *mdAtoms->mdatoms(), cr,
+                                  nullptr, &nrnb, wcycle, fr->bMolPBC);
+
+    gmx_localtop_t top;
+    t_graph*       graph = nullptr;
+    mdAlgorithmsSetupAtomData(cr, &ir, mtop, &top, fr, &graph, mdAtoms.get(), constr.get(),
+                              nullptr, nullptr);
+    const t_mdatoms& md = *mdAtoms->mdatoms();
+    if (havePme && !EEL_PME(ir.coulombtype))
+    {
+        // Only LJ-PME, the atoms have not been set up by mdAlgorithmsSetupAtomData()
+        gmx_pme_reinit_atoms(fr->pmedata, md.homenr, md.chargeA);
+    }
+
+    const rvec* x = as_rvec_array(coordinates.data());
+    if (graph != nullptr)
+    {
+        mk_mshift(nullptr, graph, ir.ePBC, box, x);
+    }
+    t_pbc pbc;
+    set_pbc(&pbc, ir.ePBC, box);
+    t_pbc* pbcNull = (fr->bMolPBC ? &pbc : nullptr);
+
+    std::vector<Nbnxm::StageTiming> stages;
+
+    if (havePme)
+    {
+        std::vector<RVec> xInBox(coordinates.begin(), coordinates.end());
+        put_atoms_in_box(ir.ePBC, box, xInBox);
+        std::vector<RVec> forces(xInBox.size(), { 0, 0, 0 });
+
+        int pmeFlags = GMX_PME_DO_ALL_F;
+        if (computeVirialAndEnergy)
+        {
+            pmeFlags |= GMX_PME_CALC_ENER_VIR;
+        }
+        matrix virialQ, virialLJ;
+        real   energyQ, energyLJ, dvdlQ, dvdlLJ;
+        for (int iter = 0; iter < numIterations; iter++)
+        {
+            gmx_pme_do(fr->pmedata, xInBox, forces, md.chargeA, md.chargeB, md.sqrt_c6A,
+                       md.sqrt_c6B, md.sigmaA, md.sigmaB, box, cr, 0, 0, &nrnb, wcycle, virialQ,
+                       virialLJ, &energyQ, &energyLJ, 0, 0, &dvdlQ, &dvdlLJ, pmeFlags);
+        }
+
+        stages.push_back({ "spread", averageCycles(wcycle, ewcPME_SPREAD, numIterations) });
+        stages.push_back({ "fft", averageCycles(wcycle, ewcPME_FFT, numIterations) });
+        if (EEL_PME(ir.coulombtype))
+        {
+            stages.push_back({ "solve", averageCycles(wcycle, ewcPME_SOLVE, numIterations) });
+        }
+        if (EVDW_PME(ir.vdwtype))
+        {
+            stages.push_back({ "lj-pme", averageCycles(wcycle, ewcLJPME, numIterations) });
+        }
+        stages.push_back({ "gather", averageCycles(wcycle, ewcPME_GATHER, numIterations) });
+    }
+
+    if (haveCpuListedForces(*fr, top.idef, fcd))
+    {
+        PaddedVector<RVec> forces(mtop.natoms, { 0, 0, 0 });
+        std::vector<RVec>  shiftForces(SHIFTS, { 0, 0, 0 });
+        ForceOutputs       forceOutputs(
+                ForceWithShiftForces(forces.arrayRefWithPadding(), computeVirialAndEnergy, shiftForces),
+                ForceWithVirial(forces.arrayRefWithPadding().unpaddedArrayRef(), computeVirialAndEnergy));
+
+        StepWorkload stepWork;
+        stepWork.computeForces = true;
+        stepWork.computeVirial = computeVirialAndEnergy;
+        stepWork.computeEnergy = computeVirialAndEnergy;
+
+        gmx_enerdata_t enerd(1, 0);
+        real           lambda[efptNR] = { 0 };
+
+        gmx_cycles_t cycles = gmx_cycles_read();
+        for (int iter = 0; iter < numIterations; iter++)
+        {
+            calc_listed(cr, nullptr, wcycle, &top.idef, x, nullptr, &forceOutputs, fr, &pbc, &pbc,
+                        graph, &enerd, &nrnb, lambda, &md, &fcd, nullptr, stepWork);
+        }
+        cycles = gmx_cycles_read() - cycles;
+
+        stages.push_back({ "listed", static_cast<double>(cycles) / std::max(numIterations, 1) });
+    }
+
+    const std::vector<RVec> xDisplaced = displacedCoordinates(coordinates);
+    std::vector<RVec>       xPrime(xDisplaced.size());
+    const real              invdt = 1 / ir.delta_t;
+    tensor                  constraintVirial;
+
+    const int numConstraints =
+            gmx_mtop_ftype_count(mtop, F_CONSTR) + gmx_mtop_ftype_count(mtop, F_CONSTRNC);
+    if (numConstraints > 0 && ir.eConstrAlg == econtLINCS)
+    {
+        Lincs* lincsd = init_lincs(nullptr, mtop, constr->numFlexibleConstraints(),
+                                   constr->atom2constraints_moltype(), false, ir.nLincsIter,
+                                   ir.nProjOrder);
+        set_lincs(top.idef, md, EI_DYNAMICS(ir.eI), cr, lincsd);
+
+        real         dvdlambda = 0;
+        int          warncount = 0;
+        gmx_cycles_t cycles    = 0;
+        for (int iter = 0; iter < numIterations; iter++)
+        {
+            std::copy(xDisplaced.begin(), xDisplaced.end(), xPrime.begin());
+
+            gmx_cycles_t start = gmx_cycles_read();
+            constrain_lincs(false, ir, 0, lincsd, md, cr, nullptr, x, as_rvec_array(xPrime.data()),
+                            nullptr, box, pbcNull, 0, &dvdlambda, invdt,
+                            nullptr, computeVirialAndEnergy, constraintVirial,
+                            ConstraintVariable::Positions, &nrnb, INT_MAX, &warncount);
+            cycles += gmx_cycles_read() - start;
+        }
+
+        stages.push_back({ "lincs", static_cast<double>(cycles) / std::max(numIterations, 1) });
+
+        done_lincs(lincsd);
+    }
+
+    if (gmx_mtop_ftype_count(mtop, F_SETTLE) > 0)
+    {
+        settledata* settled = settle_init(mtop);
+        settle_set_constraints(settled, &top.idef.il[F_SETTLE], md);
+
+        // With multiple threads, each thread needs its own virial buffer
+        tensor* threadVirial;
+        snew(threadVirial, numThreads);
+
+        gmx_cycles_t cycles = 0;
+        for (int iter = 0; iter < numIterations; iter++)
+        {
+            std::copy(xDisplaced.begin(), xDisplaced.end(), xPrime.begin());
+
+            gmx_cycles_t start = gmx_cycles_read();
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+            for (int th = 0; th < numThreads; th++)
+            {
+                try
+                {
+                    bool errorHasOccurred = false;
+                    csettle(settled, numThreads, th, pbcNull, x[0], as_rvec_array(xPrime.data())[0],
+                            invdt, nullptr, computeVirialAndEnergy, threadVirial[th], &errorHasOccurred);
+                }
+                GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+            }
+            cycles += gmx_cycles_read() - start;
+        }
+
+        stages.push_back({ "settle", static_cast<double>(cycles) / std::max(numIterations, 1) });
+
+        sfree(threadVirial);
+        settle_free(settled);
+    }
+
+    if (graph != nullptr)
+    {
+        done_graph(graph);
+        sfree(graph);
+    }
+    if (havePme)
+    {
+        gmx_pme_destroy(fr->pmedata);
+    }
+    done_forcerec(fr, mtop.molblock.size());
+    wallcycle_destroy(wcycle);
+
+    return stages;
+}
+
+} // namespace gmx
@@ -0,0 +1,80 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \file
+ * \brief
+ * Declares the benchmark for the CPU stages of an MD step outside the non-bonded kernels.
+ */
+
+#ifndef GMX_PROGRAMS_MDRUN_MDSTAGES_BENCH_H
+#define GMX_PROGRAMS_MDRUN_MDSTAGES_BENCH_H
+
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/nbnxm/benchmark/bench_setup.h"
+#include "gromacs/utility/arrayref.h"
+
+struct gmx_mtop_t;
+struct t_inputrec;
+
+namespace gmx
+{
+
+/*! \brief Times the CPU stages of an MD step that are not computed by the Nbnxm module
+ *
+ * Times the PME mesh stages (spread, FFT, solve, LJ-PME and gather),
+ * the listed forces and the LINCS and SETTLE constraints, as far as these
+ * are present in the system, by running each stage \p numIterations times.
+ *
+ * \param[in] mtop                    The system topology
+ * \param[in] ir                      The input record
+ * \param[in] coordinates             The coordinates of all atoms, molecules should be whole
+ * \param[in] box                     The unit cell
+ * \param[in] numThreads              The number of OpenMP threads to use
+ * \param[in] numIterations           The number of iterations for each stage
+ * \param[in] computeVirialAndEnergy  Whether to compute energies and the virial
+ * \returns the average cycles per iteration for each stage
+ */
+std::vector<Nbnxm::StageTiming> benchmarkMdStepStages(const gmx_mtop_t&    mtop,
+                                                      const t_inputrec&    ir,
+                                                      ArrayRef<const RVec> coordinates,
+                                                      const matrix         box,
+                                                      int                  numThreads,
+                                                      int                  numIterations,
+                                                      bool                 computeVirialAndEnergy);
+
+} // namespace gmx
+
+#endif
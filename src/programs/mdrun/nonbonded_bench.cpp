@@ -47,13 +47,21 @@
 
 #include "gromacs/commandline/cmdlineoptionsmodule.h"
 #include "gromacs/ewald/ewald_utils.h"
+#include "gromacs/fileio/tpxio.h"
+#include "gromacs/mdtypes/inputrec.h"
+#include "gromacs/mdtypes/md_enums.h"
+#include "gromacs/mdtypes/state.h"
 #include "gromacs/nbnxm/benchmark/bench_setup.h"
 #include "gromacs/options/basicoptions.h"
 #include "gromacs/options/filenameoption.h"
 #include "gromacs/options/ioptionscontainer.h"
 #include "gromacs/selection/selectionoptionbehavior.h"
+#include "gromacs/topology/topology.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/enumerationhelpers.h"
+#include "gromacs/utility/fatalerror.h"
+
+#include "mdstages_bench.h"
 
 namespace gmx
 {
@@ -75,6 +83,7 @@ public:
 
 private:
     int                       sizeFactor_ = 1;
+    std::string               tprFileName_;
     Nbnxm::KernelBenchOptions benchmarkOptions_;
 };
 
@@ -152,7 +161,26 @@ void NonbondedBenchmark::initOptions(IOptionsContainer* options, ICommandLineOpt
         "In the MD engine, any clusters where at most half of the atoms",
         "have LJ interactions will automatically use this kernel.",
         "And finally, the [TT]-energy[tt] option selects the computation",
-        "of energies, which are usually only needed infrequently."
+        "of energies, which are usually only needed infrequently.[PAR]",
+        "With [TT]-stages[tt] the other CPU stages of a non-bonded force",
+        "step at a pair-search step are timed as well, using a dynamically",
+        "pruned pair list with an outer buffer set by [TT]-rlistbuf[tt]:",
+        "putting atoms on the grid and setting atom properties, pair search,",
+        "coordinate conversion, list pruning, the kernel and the reduction",
+        "of the non-bonded forces into the force buffer.",
+        "The average cycles per iteration are reported for each stage.[PAR]",
+        "With [TT]-s[tt] the system is read from a run input file instead",
+        "of using a box of water. Only rectangular unit cells and plain",
+        "Lennard-Jones interactions are supported. The cut-off and",
+        "the Coulomb type are then taken from the run input file,",
+        "[TT]-all[tt] can still be used to run all setups.",
+        "In combination with [TT]-stages[tt], the other CPU stages of",
+        "an MD step present in the system are timed as well: the PME mesh",
+        "stages spread, FFT, solve, LJ-PME and gather, the listed forces",
+        "and the LINCS and SETTLE constraints, so all CPU stages of",
+        "an MD step are covered.[PAR]",
+        "With [TT]-csv[tt] all results are also written to a file in",
+        "comma-separated format, for processing by other tools."
     };
 
     settings->setHelpText(desc);
@@ -161,6 +189,12 @@ void NonbondedBenchmark::initOptions(IOptionsContainer* options, ICommandLineOpt
     const char* const cCombRuleStrings[]    = { "geometric", "lb", "none" };
     const char* const cCoulombTypeStrings[] = { "ewald", "reaction-field" };
 
+    options->addOption(FileNameOption("s")
+                               .filetype(eftRunInput)
+                               .inputFile()
+                               .store(&tprFileName_)
+                               .defaultBasename("topol")
+                               .description("Run input file with the system to use instead of water"));
     options->addOption(
             IntegerOption("size").store(&sizeFactor_).description("The system size is 3000 atoms times this value"));
     options->addOption(
@@ -202,6 +236,18 @@ void NonbondedBenchmark::initOptions(IOptionsContainer* options, ICommandLineOpt
     options->addOption(BooleanOption("cycles")
                                .store(&benchmarkOptions_.cyclesPerPair)
                                .description("Report cycles/pair instead of pairs/cycle"));
+    options->addOption(BooleanOption("stages")
+                               .store(&benchmarkOptions_.benchmarkPipelineStages)
+                               .description("Also time the other stages of the non-bonded pipeline"));
+    options->addOption(RealOption("rlistbuf")
+                               .store(&benchmarkOptions_.outerListBuffer)
+                               .description("Outer pair-list buffer for timing the stages"));
+    options->addOption(FileNameOption("csv")
+                               .filetype(eftCsv)
+                               .outputFile()
+                               .store(&benchmarkOptions_.csvFileName)
+                               .defaultBasename("nonbonded-benchmark")
+                               .description("Also write the results to this file in CSV format"));
 }
 
 void NonbondedBenchmark::optionsFinished()
@@ -213,7 +259,38 @@ void NonbondedBenchmark::optionsFinished()
 
 int NonbondedBenchmark::run()
 {
-    Nbnxm::bench(sizeFactor_, benchmarkOptions_);
+    if (tprFileName_.empty())
+    {
+        Nbnxm::bench(sizeFactor_, benchmarkOptions_);
+
+        return 0;
+    }
+
+    t_inputrec ir;
+    t_state    state;
+    gmx_mtop_t mtop;
+    read_tpx_state(tprFileName_.c_str(), &ir, &state, &mtop);
+
+    if (ir.cutoff_scheme != ecutsVERLET || ir.rcoulomb != ir.rvdw)
+    {
+        gmx_fatal(FARGS,
+                  "The benchmarks require the Verlet cut-off scheme with equal Coulomb and VdW "
+                  "cut-off distances");
+    }
+    benchmarkOptions_.pairlistCutoff = ir.rcoulomb;
+    benchmarkOptions_.coulombType    = (EEL_PME_EWALD(ir.coulombtype) ? Nbnxm::BenchMarkCoulomb::Pme
+                                                                   : Nbnxm::BenchMarkCoulomb::ReactionField);
+    benchmarkOptions_.ewaldcoeff_q = calc_ewaldcoeff_q(ir.rcoulomb, ir.ewald_rtol);
+
+    std::vector<Nbnxm::StageTiming> mdStepStages;
+    if (benchmarkOptions_.benchmarkPipelineStages)
+    {
+        mdStepStages = benchmarkMdStepStages(mtop, ir, makeConstArrayRef(state.x), state.box, benchmarkOptions_.numThreads,
+                                             benchmarkOptions_.numIterations,
+                                             benchmarkOptions_.computeVirialAndEnergy);
+    }
+
+    Nbnxm::bench(mtop, makeConstArrayRef(state.x), state.box, benchmarkOptions_, mdStepStages);
 
     return 0;
 }
@@ -35,7 +35,8 @@
 
 /*! \internal \file
  * \brief
- * Tests special cases in domain decomposition
+ * Tests special cases in domain decomposition, and that the overlapped
+ * CPU halo exchange gives the same results as the blocking one
  *
  * \author Mark Abraham <mark.j.abraham@gmail.com>
  * \ingroup module_mdrun_integration_tests
@@ -46,9 +47,21 @@
 
 #include <gtest/gtest.h>
 
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/trajectory/energyframe.h"
+#include "gromacs/utility/stringutil.h"
+
 #include "testutils/cmdlinetest.h"
+#include "testutils/mpitest.h"
+#include "testutils/setenv.h"
+#include "testutils/simulationdatabase.h"
 
+#include "energycomparison.h"
+#include "energyreader.h"
+#include "mdruncomparison.h"
 #include "moduletest.h"
+#include "trajectorycomparison.h"
+#include "trajectoryreader.h"
 
 namespace
 {
@@ -75,3 +88,120 @@ TEST_F(DomainDecompositionSpecialCasesTest, AnEmptyDomainWorks)
 }
 
 } // namespace
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+/*! \brief Test fixture for the overlapped CPU halo exchange
+ *
+ * Runs a simulation with the blocking halo exchange and with the
+ * overlapped one enabled by GMX_DD_OVERLAP_HALO, and checks that the
+ * energies and the coordinate, velocity and force trajectories match.
+ * Dynamic load balancing is turned off, so both runs use the same
+ * decomposition.
+ */
+class DomainDecompositionOverlappedHaloTest :
+    public MdrunTestFixture,
+    public ::testing::WithParamInterface<std::string>
+{
+};
+
+TEST_P(DomainDecompositionOverlappedHaloTest, MatchesBlockingHaloExchange)
+{
+    const std::string simulationName      = GetParam();
+    const char* const environmentVariable = "GMX_DD_OVERLAP_HALO";
+    const int         numRanks            = getNumberOfTestMpiRanks();
+    if (numRanks < 2 || !isNumberOfPpRanksSupported(simulationName, numRanks))
+    {
+        fprintf(stdout, "Test system '%s' needs domain decomposition with %d ranks, skipping.\n",
+                simulationName.c_str(), numRanks);
+        return;
+    }
+    SCOPED_TRACE(formatString("Comparing the halo exchanges for '%s' on %d ranks",
+                              simulationName.c_str(), numRanks));
+
+    const MdpFieldValues mdpFieldValues = prepareMdpFieldValues(simulationName, "md", "no", "no");
+    runner_.useTopGroAndNdxFromDatabase(simulationName);
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    const char*       environmentVariableValue = getenv(environmentVariable);
+    const std::string environmentVariableBackup =
+            (environmentVariableValue != nullptr) ? environmentVariableValue : "";
+
+    const std::string trajectoryFileNames[2] = { fileManager_.getTemporaryFilePath("blocking.trr"),
+                                                 fileManager_.getTemporaryFilePath("overlap.trr") };
+    const std::string edrFileNames[2]        = { fileManager_.getTemporaryFilePath("blocking.edr"),
+                                          fileManager_.getTemporaryFilePath("overlap.edr") };
+    for (int run = 0; run < 2; run++)
+    {
+        if (run == 0)
+        {
+            gmxUnsetenv(environmentVariable);
+        }
+        else
+        {
+            gmxSetenv(environmentVariable, "1", true);
+        }
+        runner_.fullPrecisionTrajectoryFileName_ = trajectoryFileNames[run];
+        runner_.edrFileName_                     = edrFileNames[run];
+        CommandLine caller;
+        caller.append("mdrun");
+        caller.addOption("-dlb", "no");
+        const int result = runner_.callMdrun(caller);
+        if (environmentVariableValue != nullptr)
+        {
+            gmxSetenv(environmentVariable, environmentVariableBackup.c_str(), true);
+        }
+        else
+        {
+            gmxUnsetenv(environmentVariable);
+        }
+        ASSERT_EQ(0, result);
+    }
+
+    /* Only the summation order of the halo forces could differ,
+     * so use the strict tolerances of the simulator comparison tests.
+     */
+    EnergyTermsToCompare energyTermsToCompare{ {
+            { interaction_function[F_EPOT].longname, relativeToleranceAsPrecisionDependentUlp(10.0, 24, 80) },
+            { interaction_function[F_EKIN].longname, relativeToleranceAsPrecisionDependentUlp(10.0, 24, 80) },
+            { interaction_function[F_PRES].longname,
+              relativeToleranceAsPrecisionDependentFloatingPoint(10.0, 0.001, 0.0001) },
+    } };
+    EnergyComparison energyComparison(energyTermsToCompare);
+    auto             namesOfEnergiesToMatch = energyComparison.getEnergyNames();
+    FramePairManager<EnergyFrameReader> energyManager(
+            openEnergyFileToReadTerms(edrFileNames[0], namesOfEnergiesToMatch),
+            openEnergyFileToReadTerms(edrFileNames[1], namesOfEnergiesToMatch));
+    energyManager.compareAllFramePairs<EnergyFrame>(energyComparison);
+
+    TrajectoryFrameMatchSettings trajectoryMatchSettings{ true,
+                                                          true,
+                                                          true,
+                                                          ComparisonConditions::MustCompare,
+                                                          ComparisonConditions::MustCompare,
+                                                          ComparisonConditions::MustCompare };
+    TrajectoryComparison trajectoryComparison{ trajectoryMatchSettings,
+                                               TrajectoryComparison::s_defaultTrajectoryTolerances };
+    FramePairManager<TrajectoryFrameReader> trajectoryManager(
+            std::make_unique<TrajectoryFrameReader>(trajectoryFileNames[0]),
+            std::make_unique<TrajectoryFrameReader>(trajectoryFileNames[1]));
+    trajectoryManager.compareAllFramePairs<TrajectoryFrame>(trajectoryComparison);
+}
+
+/* argon12 has only non-bonded interactions, tip3p5 adds SETTLE and
+ * alanine_vsite_solvated adds bondeds, constraints and virtual sites,
+ * which all use the halo atoms.
+ */
+INSTANTIATE_TEST_CASE_P(HaloExchangesAreEquivalent,
+                        DomainDecompositionOverlappedHaloTest,
+                        ::testing::Values("argon12", "tip3p5", "alanine_vsite_solvated"));
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -43,6 +43,10 @@
 
 #include "programs/mdrun/nonbonded_bench.h"
 
+#include <string>
+
+#include <gmock/gmock.h>
+
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/textreader.h"
 
@@ -67,6 +71,39 @@ TEST(NonbondedBenchTest, BasicEndToEndTest)
                          &gmx::NonbondedBenchmarkInfo::create, &cmdline));
 }
 
+//! Test fixture for benchmarks on a system from a run input file
+using NonbondedBenchTprTest = MdrunTestFixture;
+
+TEST_F(NonbondedBenchTprTest, TimesMdStepStagesAndWritesCsv)
+{
+    runner_.useStringAsMdpFile("coulombtype = PME\nconstraints = h-bonds\n");
+    runner_.useTopGroAndNdxFromDatabase("spc-and-methanol");
+    ASSERT_EQ(0, runner_.callGrompp());
+
+    const std::string csvFileName = fileManager_.getTemporaryFilePath("bench.csv");
+
+    const char* const command[] = { "nonbonded-benchmark" };
+    CommandLine       cmdline(command);
+    cmdline.addOption("-s", runner_.tprFileName_);
+    cmdline.addOption("-iter", 1);
+    cmdline.addOption("-simd", "no");
+    cmdline.append("-stages");
+    cmdline.addOption("-csv", csvFileName);
+    ASSERT_EQ(0, gmx::test::CommandLineTestHelper::runModuleFactory(
+                         &gmx::NonbondedBenchmarkInfo::create, &cmdline));
+
+    const std::vector<std::string> lines =
+            splitDelimitedString(stripString(TextReader::readFileToString(csvFileName)), '\n');
+    ASSERT_EQ(2U, lines.size());
+    const std::vector<std::string> columns = splitDelimitedString(lines[0], ',');
+    for (const char* stage : { "kernel", "spread", "fft", "solve", "gather", "listed", "lincs", "settle" })
+    {
+        EXPECT_THAT(columns, ::testing::Contains(formatString("%s_mcycles_per_iteration", stage)));
+    }
+    EXPECT_EQ(columns.size(), splitDelimitedString(lines[1], ',').size());
+    EXPECT_EQ("ewald", splitDelimitedString(lines[1], ',')[0]);
+}
+
 } // namespace
 } // namespace test
 } // namespace gmx